@@ -0,0 +1,78 @@
+#include "AllocationCounter.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+namespace
+{
+	std::atomic<uint64_t> s_AllocationCount{ 0 };
+
+	void* CountedAllocate(std::size_t size) noexcept
+	{
+		s_AllocationCount.fetch_add(1, std::memory_order_relaxed);
+		return std::malloc(size ? size : 1);
+	}
+
+	// over-aligned memory has to go back through the matching free
+	void* CountedAllocateAligned(std::size_t size, std::align_val_t alignment) noexcept
+	{
+		s_AllocationCount.fetch_add(1, std::memory_order_relaxed);
+		const std::size_t align = static_cast<std::size_t>(alignment);
+#ifdef _WIN32
+		return _aligned_malloc(size ? size : 1, align);
+#else
+		return std::aligned_alloc(align, ((size ? size : 1) + align - 1) & ~(align - 1));
+#endif
+	}
+
+	void FreeAligned(void* memory) noexcept
+	{
+#ifdef _WIN32
+		_aligned_free(memory);
+#else
+		std::free(memory);
+#endif
+	}
+
+	void* CheckedAllocation(void* memory)
+	{
+		if (!memory)
+			throw std::bad_alloc();
+		return memory;
+	}
+}
+
+// Replaces the global allocation functions for the benchmark executable only
+void* operator new(std::size_t size) { return CheckedAllocation(CountedAllocate(size)); }
+void* operator new[](std::size_t size) { return CheckedAllocation(CountedAllocate(size)); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return CountedAllocate(size); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return CountedAllocate(size); }
+void operator delete(void* memory) noexcept { std::free(memory); }
+void operator delete[](void* memory) noexcept { std::free(memory); }
+void operator delete(void* memory, std::size_t) noexcept { std::free(memory); }
+void operator delete[](void* memory, std::size_t) noexcept { std::free(memory); }
+void operator delete(void* memory, const std::nothrow_t&) noexcept { std::free(memory); }
+void operator delete[](void* memory, const std::nothrow_t&) noexcept { std::free(memory); }
+
+// alignas types above __STDCPP_DEFAULT_NEW_ALIGNMENT__, e.g. SIMD blocks
+void* operator new(std::size_t size, std::align_val_t alignment) { return CheckedAllocation(CountedAllocateAligned(size, alignment)); }
+void* operator new[](std::size_t size, std::align_val_t alignment) { return CheckedAllocation(CountedAllocateAligned(size, alignment)); }
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept { return CountedAllocateAligned(size, alignment); }
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept { return CountedAllocateAligned(size, alignment); }
+void operator delete(void* memory, std::align_val_t) noexcept { FreeAligned(memory); }
+void operator delete[](void* memory, std::align_val_t) noexcept { FreeAligned(memory); }
+void operator delete(void* memory, std::size_t, std::align_val_t) noexcept { FreeAligned(memory); }
+void operator delete[](void* memory, std::size_t, std::align_val_t) noexcept { FreeAligned(memory); }
+void operator delete(void* memory, std::align_val_t, const std::nothrow_t&) noexcept { FreeAligned(memory); }
+void operator delete[](void* memory, std::align_val_t, const std::nothrow_t&) noexcept { FreeAligned(memory); }
+
+namespace Benchmark {
+
+	uint64_t GetAllocationCount()
+	{
+		return s_AllocationCount.load(std::memory_order_relaxed);
+	}
+}
@@ -0,0 +1,8 @@
+#pragma once
+#include <cstdint>
+
+namespace Benchmark {
+
+	// Number of global operator new calls made by the process so far, from any thread
+	uint64_t GetAllocationCount();
+}
@@ -0,0 +1,88 @@
+#include "SortBenchmark.h"
+#include "FrameBenchmark.h"
+#include "renderer/Renderer.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+namespace
+{
+	void RunSortSuite()
+	{
+		const size_t sizes[] = { 1000, 10000, 100000 };
+
+		std::printf("=== Draw key sort: std::map + std::sort vs packed keys + radix sort ===\n");
+		for (size_t size : sizes)
+		{
+			// fewer repetitions for the big sets, keep each run short
+			int iterations = size >= 100000 ? 20 : 100;
+			Benchmark::SortBenchmarkResult result = Benchmark::RunSortBenchmark(size, iterations);
+			std::printf("%s\n", Benchmark::FormatSortResult(result).c_str());
+		}
+	}
+
+	// Whole frames through BeginScene/Submit/EndScene on the null backend, reported as JSON
+	bool RunFrameSuite(const char* jsonPath, bool uberShaders)
+	{
+		DXEngine::Renderer::Init(nullptr, 1920, 1080, DXEngine::RenderBackendType::Null);
+		DXEngine::Renderer::InitLightManager();
+
+		std::vector<Benchmark::FrameBenchmarkResult> results;
+		for (auto scene : Benchmark::GetDefaultFrameScenes())
+		{
+			scene.uberShaders = uberShaders;
+			results.push_back(Benchmark::RunFrameBenchmark(scene));
+		}
+
+		DXEngine::Renderer::Shutdown();
+
+		const std::string json = Benchmark::FrameResultsToJson(results);
+		if (!jsonPath)
+		{
+			std::printf("%s", json.c_str());
+			return true;
+		}
+
+		std::ofstream file(jsonPath, std::ios::binary);
+		if (!file)
+		{
+			std::fprintf(stderr, "Failed to open %s\n", jsonPath);
+			return false;
+		}
+		file << json;
+		std::printf("Frame results written to %s\n", jsonPath);
+		return true;
+	}
+}
+
+// Benchmark [--suite sort|frame|all] [--json <file>] [--uber-shaders]
+// The sort suite is CPU only. The frame suite creates a headless renderer and compiles the
+// engine shaders, so it runs from SandBox (the debug directory). Use --suite frame for JSON only.
+int main(int argc, char** argv)
+{
+	const char* suite = "all";
+	const char* jsonPath = nullptr;
+	bool uberShaders = false;
+	for (int i = 1; i < argc; ++i)
+	{
+		if (std::strcmp(argv[i], "--suite") == 0 && i + 1 < argc)
+			suite = argv[++i];
+		else if (std::strcmp(argv[i], "--json") == 0 && i + 1 < argc)
+			jsonPath = argv[++i];
+		else if (std::strcmp(argv[i], "--uber-shaders") == 0)
+			uberShaders = true;
+	}
+
+	const bool all = std::strcmp(suite, "all") == 0;
+	if (all || std::strcmp(suite, "sort") == 0)
+	{
+		RunSortSuite();
+	}
+	if (all || std::strcmp(suite, "frame") == 0)
+	{
+		if (!RunFrameSuite(jsonPath, uberShaders))
+			return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,537 @@
+#include "FrameBenchmark.h"
+#include "AllocationCounter.h"
+#include "renderer/Renderer.h"
+#include "renderer/NullRenderBackend.h"
+#include "renderer/SceneSpatialIndex.h"
+#include "models/Model.h"
+#include "utils/Mesh/Mesh.h"
+#include "utils/material/Material.h"
+#include "utils/Light.h"
+#include "camera/Camera.h"
+#include "Animation/AnimationClip.h"
+#include "shaders/ShaderVariantManager.h"
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <random>
+#include <sstream>
+
+namespace Benchmark {
+
+	namespace
+	{
+		using namespace DXEngine;
+		using Clock = std::chrono::steady_clock;
+
+		struct SyntheticScene
+		{
+			std::vector<std::shared_ptr<Mesh>> meshes;
+			std::vector<std::vector<std::shared_ptr<Mesh>>> lodChains;   // per unique mesh, finest first
+			std::vector<std::shared_ptr<Material>> materials;
+			std::vector<std::shared_ptr<Model>> models;
+			std::vector<std::shared_ptr<Model>> occluders;
+			std::vector<std::shared_ptr<Light>> lights;
+			std::shared_ptr<Skeleton> skeleton;
+			std::shared_ptr<Camera> camera;
+		};
+
+		static_assert(sizeof(FrameBenchmarkResult::lodTriangles) / sizeof(double) == SubmissionBucket::LODStatLevels,
+			"benchmark LOD columns must match the renderer's");
+
+		std::shared_ptr<Skeleton> CreateChainSkeleton(uint32_t boneCount)
+		{
+			auto skeleton = std::make_shared<Skeleton>();
+			for (uint32_t i = 0; i < boneCount; ++i)
+			{
+				Bone bone;
+				bone.Name = "bone_" + std::to_string(i);
+				bone.ParentIndex = static_cast<int>(i) - 1;
+				skeleton->AddBone(bone);
+			}
+			return skeleton;
+		}
+
+		std::shared_ptr<Material> CreateSceneMaterial(uint32_t index, std::mt19937& rng)
+		{
+			std::uniform_real_distribution<float> channel(0.1f, 1.0f);
+			const std::string name = "BenchMaterial_" + std::to_string(index);
+
+			// mostly lit surfaces with some PBR, unlit and a tenth transparent
+			std::shared_ptr<Material> material;
+			switch (index % 10)
+			{
+			case 0:  material = MaterialFactory::CreateTransparentMaterial(name); break;
+			case 1:
+			case 2:  material = MaterialFactory::CreatePBRMaterial(name); break;
+			case 3:  material = MaterialFactory::CreateUnlitMaterial(name); break;
+			default: material = MaterialFactory::CreateLitMaterial(name); break;
+			}
+			material->SetDiffuseColor({ channel(rng), channel(rng), channel(rng), 1.0f });
+			return material;
+		}
+
+		SyntheticScene BuildScene(const FrameBenchmarkConfig& config)
+		{
+			SyntheticScene scene;
+			std::mt19937 rng(config.seed);
+
+			const uint32_t meshCount = std::max(config.meshes, 1u);
+			const uint32_t materialCount = std::max(config.materials, 1u);
+
+			// unique geometry, spheres of different tessellation so vertex counts differ
+			for (uint32_t i = 0; i < meshCount; ++i)
+			{
+				scene.meshes.push_back(i % 4 == 0 ? Mesh::CreateCube(1.0f) : Mesh::CreateSphere(1.0f, 8 + (i % 24)));
+			}
+			for (uint32_t i = 0; i < materialCount; ++i)
+			{
+				scene.materials.push_back(CreateSceneMaterial(i, rng));
+			}
+
+			// each level roughly a quarter of the triangles of the one before
+			for (uint32_t i = 0; config.lodLevels > 0 && i < meshCount; ++i)
+			{
+				auto& chain = scene.lodChains.emplace_back();
+				for (uint32_t level = 0; level < config.lodLevels; ++level)
+				{
+					chain.push_back(Mesh::CreateSphere(1.0f, std::max(4u, (16 + (i % 24)) >> level)));
+				}
+			}
+
+			if (config.skinnedFraction > 0.0f)
+			{
+				scene.skeleton = CreateChainSkeleton(config.bonesPerSkeleton);
+			}
+
+			// a volume in front of the camera, wide enough that some models fall outside the frustum
+			std::uniform_real_distribution<float> spreadX(-150.0f * config.worldScale, 150.0f * config.worldScale);
+			std::uniform_real_distribution<float> spreadY(-20.0f, 40.0f);
+			std::uniform_real_distribution<float> spreadZ(-30.0f * config.worldScale, 400.0f * config.worldScale);
+			std::uniform_real_distribution<float> roll(0.0f, 1.0f);
+			std::uniform_int_distribution<uint32_t> pickMesh(0, meshCount - 1);
+			std::uniform_int_distribution<uint32_t> pickMaterial(0, materialCount - 1);
+
+			scene.models.reserve(config.models);
+			for (uint32_t i = 0; i < config.models; ++i)
+			{
+				const uint32_t meshIndex = pickMesh(rng);
+				const auto& mesh = scene.meshes[meshIndex];
+				const float kind = roll(rng);
+
+				std::shared_ptr<Model> model;
+				if (kind < config.instancedFraction)
+				{
+					model = Model::CreateInstancedModel(mesh);
+					std::vector<DirectX::XMFLOAT4X4> transforms(config.instancesPerModel);
+					for (auto& transform : transforms)
+					{
+						DirectX::XMStoreFloat4x4(&transform,
+							DirectX::XMMatrixTranslation(spreadX(rng) * 0.05f, spreadY(rng) * 0.05f, spreadZ(rng) * 0.05f));
+					}
+					model->SetInstanceTransform(transforms);
+				}
+				else if (kind < config.instancedFraction + config.skinnedFraction)
+				{
+					model = Model::CreateSkinnedModel(mesh, scene.skeleton);
+				}
+				else if (!scene.lodChains.empty())
+				{
+					model = ModelUtils::CreateLODModel(scene.lodChains[meshIndex]);
+				}
+				else
+				{
+					model = std::make_shared<Model>(mesh);
+				}
+
+				const auto& material = scene.materials[pickMaterial(rng)];
+				for (size_t meshSlot = 0; meshSlot < model->GetMeshCount(); ++meshSlot)
+				{
+					model->SetMaterial(meshSlot, 0, material);
+				}
+				model->SetTranslation({ spreadX(rng), spreadY(rng), spreadZ(rng) });
+				scene.models.push_back(model);
+			}
+
+			// a row of walls between the camera and most of the scene, with narrow gaps
+			if (config.occluderWalls > 0)
+			{
+				const auto wallMesh = Mesh::CreateCube(1.0f);
+				const float firstWall = -0.5f * static_cast<float>(config.occluderWalls - 1);
+				for (uint32_t i = 0; i < config.occluderWalls; ++i)
+				{
+					auto wall = std::make_shared<Model>(wallMesh);
+					wall->SetMaterial(scene.materials[std::min(4u, materialCount - 1)]);
+					wall->SetScale({ 36.0f, 80.0f, 1.0f });
+					wall->SetTranslation({ (firstWall + static_cast<float>(i)) * 40.0f, 10.0f, 40.0f });
+					scene.occluders.push_back(wall);
+					scene.models.push_back(wall);
+				}
+			}
+
+			if (auto lightManager = Renderer::GetLightManager())
+			{
+				for (uint32_t i = 0; i < config.lights; ++i)
+				{
+					auto light = lightManager->CreatePointLight();
+					if (!light)
+						break;
+					light->SetPosition({ spreadX(rng), spreadY(rng), spreadZ(rng) });
+					light->SetRadius(40.0f);
+					scene.lights.push_back(light);
+				}
+			}
+
+			scene.camera = std::make_shared<Camera>();
+			scene.camera->SetProjectionParams(DirectX::XM_PIDIV4, 16.0f / 9.0f, 0.5f, 1000.0f);
+			scene.camera->SetPosition({ 0.0f, 10.0f, -60.0f });
+			scene.camera->UpdateViewMatrix();
+			return scene;
+		}
+
+		void ReleaseScene(SyntheticScene& scene)
+		{
+			if (auto lightManager = Renderer::GetLightManager())
+			{
+				for (const auto& light : scene.lights)
+				{
+					lightManager->RemoveLight(light);
+				}
+			}
+			scene = SyntheticScene{};
+		}
+
+		double Microseconds(Clock::duration duration)
+		{
+			return std::chrono::duration<double, std::micro>(duration).count();
+		}
+
+		void WriteConfig(std::ostringstream& out, const FrameBenchmarkConfig& config)
+		{
+			out << "{\"models\": " << config.models
+				<< ", \"meshes\": " << config.meshes
+				<< ", \"materials\": " << config.materials
+				<< ", \"lights\": " << config.lights
+				<< ", \"instanced_fraction\": " << config.instancedFraction
+				<< ", \"skinned_fraction\": " << config.skinnedFraction
+				<< ", \"instances_per_model\": " << config.instancesPerModel
+				<< ", \"parallel_submit\": " << (config.parallelSubmit ? "true" : "false")
+				<< ", \"uber_shaders\": " << (config.uberShaders ? "true" : "false")
+				<< ", \"spatial_index\": " << (config.spatialIndex ? "true" : "false")
+				<< ", \"world_scale\": " << config.worldScale
+				<< ", \"occluder_walls\": " << config.occluderWalls
+				<< ", \"occlusion_culling\": " << (config.occlusionCulling ? "true" : "false")
+				<< ", \"lod_levels\": " << config.lodLevels
+				<< ", \"lod_bias\": " << config.lodBias
+				<< ", \"contribution_threshold\": " << config.contributionThreshold
+				<< ", \"frames\": " << config.frames
+				<< ", \"seed\": " << config.seed << "}";
+		}
+	}
+
+	FrameBenchmarkResult RunFrameBenchmark(const FrameBenchmarkConfig& config)
+	{
+		FrameBenchmarkResult result;
+		result.config = config;
+		result.headless = RenderCommand::GetBackendType() == RenderBackendType::Null;
+
+		auto& shaderVariants = ShaderVariantManager::Instance();
+		shaderVariants.SetFeaturePolicy(config.uberShaders ?
+			ShaderFeaturePolicy::RuntimeBranches : ShaderFeaturePolicy::CompileTimeVariants);
+
+		SyntheticScene scene = BuildScene(config);
+		const std::span<const std::shared_ptr<Model>> models(scene.models);
+		auto* nullBackend = result.headless ? static_cast<NullRenderBackend*>(RenderCommand::GetBackend()) : nullptr;
+
+		SceneSpatialIndex spatialIndex;
+		if (config.spatialIndex)
+		{
+			for (const auto& model : scene.models)
+			{
+				spatialIndex.Insert(model, model->IsSkinned() ? SpatialMobility::Dynamic : SpatialMobility::Static);
+			}
+			spatialIndex.Rebuild();
+		}
+
+		Renderer::EnablePhaseTimings(true);
+		Renderer::EnableOcclusionCulling(config.occlusionCulling);
+		Renderer::SetLODBias(config.lodBias);
+		Renderer::EnableContributionCulling(config.contributionThreshold > 0.0f);
+		for (RenderQueue queue : { RenderQueue::Background, RenderQueue::Opaque, RenderQueue::Transparent })
+		{
+			Renderer::SetContributionThreshold(queue, config.contributionThreshold);
+		}
+		Renderer::SetShadowCasterContributionThreshold(config.contributionThreshold);
+
+		uint64_t backendBinds = 0;
+		uint64_t backendDraws = 0;
+		const uint32_t totalFrames = config.warmupFrames + config.frames;
+		for (uint32_t frame = 0; frame < totalFrames; ++frame)
+		{
+			const bool measured = frame >= config.warmupFrames;
+			const uint64_t allocationsBefore = GetAllocationCount();
+			const auto frameStart = Clock::now();
+
+			Renderer::BeginScene(scene.camera);
+
+			const auto submitStart = Clock::now();
+			if (config.occlusionCulling)
+			{
+				Renderer::SubmitOccluders(scene.occluders);
+			}
+			if (config.spatialIndex)
+			{
+				spatialIndex.Update();
+				Renderer::SubmitScene(spatialIndex);
+			}
+			else if (config.parallelSubmit)
+			{
+				Renderer::SubmitRange(models);
+			}
+			else
+			{
+				for (const auto& model : scene.models)
+				{
+					Renderer::Submit(model);
+				}
+			}
+			const auto submitEnd = Clock::now();
+
+			Renderer::EndScene();
+
+			const auto frameEnd = Clock::now();
+			const uint64_t allocations = GetAllocationCount() - allocationsBefore;
+			if (!measured)
+				continue;
+
+			const double frameMicroseconds = Microseconds(frameEnd - frameStart);
+			result.frameMicroseconds += frameMicroseconds;
+			if (result.bestFrameMicroseconds == 0.0 || frameMicroseconds < result.bestFrameMicroseconds)
+				result.bestFrameMicroseconds = frameMicroseconds;
+			result.submitMicroseconds += Microseconds(submitEnd - submitStart);
+			result.heapAllocationsPerFrame += static_cast<double>(allocations);
+
+			const auto& stats = Renderer::GetStats();
+			result.cullMicroseconds += stats.cullNanoseconds / 1000.0;
+			result.sortMicroseconds += stats.sortNanoseconds / 1000.0;
+			result.batchMicroseconds += stats.batchNanoseconds / 1000.0;
+			result.encodeMicroseconds += stats.encodeNanoseconds / 1000.0;
+			result.rendererAllocationsPerFrame += stats.frameHeapAllocations;
+			result.modelsVisible += stats.modelsVisible;
+			result.modelsCulled += stats.modelsCulled;
+			result.instancesCulled += stats.instancesCulled;
+			result.submeshesCulled += stats.submeshesCulled;
+			result.modelsOccluded += stats.modelsOccluded;
+			result.occluderTriangles += stats.occluderTriangles;
+			result.occlusionMicroseconds += stats.occlusionNanoseconds / 1000.0;
+			for (uint32_t level = 0; level < SubmissionBucket::LODStatLevels; ++level)
+			{
+				result.lodTriangles[level] += stats.lodTriangles[level];
+			}
+			result.lodTransitions += stats.lodTransitions;
+			result.modelsTooSmall += stats.modelsTooSmall;
+			result.submeshesTooSmall += stats.submeshesTooSmall;
+			result.drawCalls += stats.drawCalls;
+			result.instanceDrawCalls += stats.instanceDrawCalls;
+			result.batches += stats.batchesProcessed;
+			result.stateCallsIssued += stats.stateCallsIssued;
+			result.stateCallsFiltered += stats.stateCallsFiltered;
+			result.pipelineCacheHits += stats.pipelineCacheHits;
+			result.pipelineCacheMisses += stats.pipelineCacheMisses;
+			result.pipelineCreationMicroseconds += stats.pipelineCreationNanoseconds / 1000.0;
+			result.shadersChanged += stats.shadersChanged;
+
+			if (nullBackend)
+			{
+				backendBinds += nullBackend->GetLastFrameStats().binds;
+				backendDraws += nullBackend->GetLastFrameStats().draws;
+			}
+			else
+			{
+				backendBinds += stats.stateCallsIssued;
+				backendDraws += stats.drawCalls;
+			}
+		}
+
+		Renderer::EnablePhaseTimings(false);
+		Renderer::EnableOcclusionCulling(false);
+		Renderer::SetLODBias(0.0f);
+		Renderer::EnableContributionCulling(true);
+		for (RenderQueue queue : { RenderQueue::Background, RenderQueue::Opaque, RenderQueue::Transparent })
+		{
+			Renderer::SetContributionThreshold(queue, 1.0f);
+		}
+		Renderer::SetShadowCasterContributionThreshold(1.0f);
+		shaderVariants.WaitForPendingVariants();
+		result.shaderVariants = shaderVariants.GetStats().totalVariants;
+		ReleaseScene(scene);
+
+		if (config.frames == 0)
+			return result;
+
+		const double frames = static_cast<double>(config.frames);
+		double* averaged[] = {
+			&result.frameMicroseconds, &result.submitMicroseconds,
+			&result.cullMicroseconds, &result.sortMicroseconds, &result.batchMicroseconds, &result.encodeMicroseconds,
+			&result.heapAllocationsPerFrame, &result.rendererAllocationsPerFrame,
+			&result.modelsVisible, &result.modelsCulled, &result.instancesCulled, &result.submeshesCulled,
+			&result.modelsOccluded, &result.occluderTriangles, &result.occlusionMicroseconds,
+			&result.lodTriangles[0], &result.lodTriangles[1], &result.lodTriangles[2], &result.lodTriangles[3],
+			&result.lodTransitions, &result.modelsTooSmall, &result.submeshesTooSmall,
+			&result.drawCalls, &result.instanceDrawCalls, &result.batches,
+			&result.stateCallsIssued, &result.stateCallsFiltered,
+			&result.pipelineCacheHits, &result.pipelineCacheMisses, &result.pipelineCreationMicroseconds,
+			&result.shadersChanged,
+		};
+		for (double* value : averaged)
+		{
+			*value /= frames;
+		}
+
+		if (config.models > 0)
+			result.nsPerSubmission = result.frameMicroseconds * 1000.0 / config.models;
+		if (backendDraws > 0)
+			result.stateChangesPerDraw = static_cast<double>(backendBinds) / static_cast<double>(backendDraws);
+		return result;
+	}
+
+	std::vector<FrameBenchmarkConfig> GetDefaultFrameScenes()
+	{
+		std::vector<FrameBenchmarkConfig> scenes;
+
+		FrameBenchmarkConfig config;
+		config.name = "static_1k";
+		config.models = 1000;
+		config.meshes = 32;
+		config.materials = 16;
+		config.lights = 4;
+		scenes.push_back(config);
+
+		config.name = "static_10k";
+		config.models = 10000;
+		config.meshes = 64;
+		config.materials = 64;
+		config.lights = 8;
+		scenes.push_back(config);
+
+		config.name = "material_heavy_10k";
+		config.meshes = 16;
+		config.materials = 1024;
+		scenes.push_back(config);
+
+		config.name = "mixed_10k";
+		config.meshes = 64;
+		config.materials = 64;
+		config.lights = 16;
+		config.instancedFraction = 0.25f;
+		config.skinnedFraction = 0.1f;
+		scenes.push_back(config);
+
+		config.name = "mixed_10k_parallel";
+		config.parallelSubmit = true;
+		scenes.push_back(config);
+
+		// a large world where the camera sees a small part, flat culling against the index
+		config.name = "world_100k_parallel";
+		config.models = 100000;
+		config.instancedFraction = 0.0f;
+		config.skinnedFraction = 0.05f;
+		config.worldScale = 10.0f;
+		scenes.push_back(config);
+
+		config.name = "world_100k_indexed";
+		config.spatialIndex = true;
+		scenes.push_back(config);
+
+		// most of the scene behind a row of walls, without and with software occlusion
+		config.name = "walled_10k_parallel";
+		config.models = 10000;
+		config.spatialIndex = false;
+		config.worldScale = 1.0f;
+		config.occluderWalls = 10;
+		scenes.push_back(config);
+
+		config.name = "walled_10k_occlusion";
+		config.occlusionCulling = true;
+		scenes.push_back(config);
+
+		// plain models as three level sphere chains, at the default and a coarser bias
+		config.name = "lod_10k_parallel";
+		config.occluderWalls = 0;
+		config.occlusionCulling = false;
+		config.lodLevels = 3;
+		scenes.push_back(config);
+
+		config.name = "lod_10k_bias";
+		config.lodBias = 1.0f;
+		scenes.push_back(config);
+
+		// a wide world of props, most far enough away to cover a few pixels, with and without contribution culling
+		config.name = "props_100k_parallel";
+		config.models = 100000;
+		config.worldScale = 10.0f;
+		config.lodLevels = 0;
+		config.lodBias = 0.0f;
+		scenes.push_back(config);
+
+		config.name = "props_100k_contribution";
+		config.contributionThreshold = 1.5f;
+		scenes.push_back(config);
+
+		return scenes;
+	}
+
+	std::string FrameResultsToJson(const std::vector<FrameBenchmarkResult>& results)
+	{
+		std::ostringstream out;
+		out << std::fixed << std::setprecision(3);
+		out << "{\n  \"benchmark\": \"renderer_frame\",\n  \"scenes\": [";
+
+		for (size_t i = 0; i < results.size(); ++i)
+		{
+			const auto& result = results[i];
+			out << (i == 0 ? "\n" : ",\n");
+			out << "    {\n      \"name\": \"" << result.config.name << "\",\n";
+			out << "      \"headless\": " << (result.headless ? "true" : "false") << ",\n";
+			out << "      \"config\": ";
+			WriteConfig(out, result.config);
+			out << ",\n";
+			out << "      \"ns_per_submission\": " << result.nsPerSubmission << ",\n";
+			out << "      \"frame_us\": " << result.frameMicroseconds << ",\n";
+			out << "      \"best_frame_us\": " << result.bestFrameMicroseconds << ",\n";
+			out << "      \"submit_us\": " << result.submitMicroseconds << ",\n";
+			out << "      \"phases_us\": {\"cull\": " << result.cullMicroseconds
+				<< ", \"sort\": " << result.sortMicroseconds
+				<< ", \"batch\": " << result.batchMicroseconds
+				<< ", \"encode\": " << result.encodeMicroseconds << "},\n";
+			out << "      \"models_visible\": " << result.modelsVisible << ",\n";
+			out << "      \"models_culled\": " << result.modelsCulled << ",\n";
+			out << "      \"instances_culled\": " << result.instancesCulled << ",\n";
+			out << "      \"submeshes_culled\": " << result.submeshesCulled << ",\n";
+			out << "      \"occlusion\": {\"models_occluded\": " << result.modelsOccluded
+				<< ", \"occluder_triangles\": " << result.occluderTriangles
+				<< ", \"raster_us\": " << result.occlusionMicroseconds << "},\n";
+			out << "      \"lod\": {\"triangles\": [" << result.lodTriangles[0] << ", " << result.lodTriangles[1]
+				<< ", " << result.lodTriangles[2] << ", " << result.lodTriangles[3]
+				<< "], \"transitions\": " << result.lodTransitions << "},\n";
+			out << "      \"contribution\": {\"models_too_small\": " << result.modelsTooSmall
+				<< ", \"submeshes_too_small\": " << result.submeshesTooSmall << "},\n";
+			out << "      \"allocations_per_frame\": " << result.heapAllocationsPerFrame << ",\n";
+			out << "      \"renderer_allocations_per_frame\": " << result.rendererAllocationsPerFrame << ",\n";
+			out << "      \"draw_calls\": " << result.drawCalls << ",\n";
+			out << "      \"instanced_draw_calls\": " << result.instanceDrawCalls << ",\n";
+			out << "      \"batches\": " << result.batches << ",\n";
+			out << "      \"state_calls_issued\": " << result.stateCallsIssued << ",\n";
+			out << "      \"state_calls_filtered\": " << result.stateCallsFiltered << ",\n";
+			out << "      \"state_changes_per_draw\": " << result.stateChangesPerDraw << ",\n";
+			out << "      \"pipeline_cache\": {\"hits\": " << result.pipelineCacheHits
+				<< ", \"misses\": " << result.pipelineCacheMisses
+				<< ", \"creation_us\": " << result.pipelineCreationMicroseconds << "},\n";
+			out << "      \"shaders_changed\": " << result.shadersChanged << ",\n";
+			out << "      \"shader_variants\": " << result.shaderVariants << "\n";
+			out << "    }";
+		}
+
+		out << "\n  ]\n}\n";
+		return out.str();
+	}
+}
@@ -0,0 +1,86 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Benchmark {
+
+	// Parameters of one synthetic scene. The same config and seed always build the same scene.
+	struct FrameBenchmarkConfig
+	{
+		std::string name = "scene";
+		uint32_t models = 1000;            // N
+		uint32_t meshes = 16;              // M unique meshes shared by the models
+		uint32_t materials = 16;           // K
+		uint32_t lights = 4;               // L point lights
+		float instancedFraction = 0.0f;    // models drawn with per-model instance data
+		float skinnedFraction = 0.0f;      // models with a skeleton and bone palette
+		uint32_t instancesPerModel = 16;
+		uint32_t bonesPerSkeleton = 32;
+		bool parallelSubmit = false;       // SubmitRange instead of one Submit per model
+		bool uberShaders = false;          // ShaderFeaturePolicy::RuntimeBranches
+		bool spatialIndex = false;         // SubmitScene over a SceneSpatialIndex, skinned models dynamic
+		float worldScale = 1.0f;           // horizontal spread of the scene, larger leaves more outside the frustum
+		uint32_t occluderWalls = 0;        // walls across the view in front of most of the scene
+		bool occlusionCulling = false;     // walls submitted as occluders, everything tested against them
+		uint32_t lodLevels = 0;            // plain models become sphere LOD chains of this many levels
+		float lodBias = 0.0f;              // Renderer::SetLODBias while the scene runs
+		float contributionThreshold = 0.0f;   // pixel radius for every world queue, 0 turns contribution culling off
+		uint32_t warmupFrames = 5;
+		uint32_t frames = 30;
+		unsigned seed = 1234;
+	};
+
+	// Averages over the measured frames
+	struct FrameBenchmarkResult
+	{
+		FrameBenchmarkConfig config;
+		bool headless = false;
+
+		double frameMicroseconds = 0.0;          // BeginScene through EndScene
+		double bestFrameMicroseconds = 0.0;
+		double submitMicroseconds = 0.0;         // Submit/SubmitRange calls only
+		double nsPerSubmission = 0.0;            // whole frame divided by models submitted
+
+		double cullMicroseconds = 0.0;           // summed over submission threads
+		double sortMicroseconds = 0.0;
+		double batchMicroseconds = 0.0;
+		double encodeMicroseconds = 0.0;
+
+		double modelsVisible = 0.0;
+		double modelsCulled = 0.0;
+		double instancesCulled = 0.0;
+		double submeshesCulled = 0.0;
+		double modelsOccluded = 0.0;
+		double occluderTriangles = 0.0;
+		double occlusionMicroseconds = 0.0;      // rasterizing the occluders
+		double lodTriangles[4] = {};             // submitted triangles per LOD level, as in the renderer stats
+		double lodTransitions = 0.0;
+		double modelsTooSmall = 0.0;             // dropped by contribution culling
+		double submeshesTooSmall = 0.0;
+
+		double heapAllocationsPerFrame = 0.0;    // every operator new during the frame
+		double rendererAllocationsPerFrame = 0.0;
+
+		double drawCalls = 0.0;
+		double instanceDrawCalls = 0.0;
+		double batches = 0.0;
+		double stateCallsIssued = 0.0;
+		double stateCallsFiltered = 0.0;
+		double stateChangesPerDraw = 0.0;        // binds that reached the backend per draw
+
+		double pipelineCacheHits = 0.0;
+		double pipelineCacheMisses = 0.0;        // nonzero only while the cache warms up
+		double pipelineCreationMicroseconds = 0.0;
+
+		double shadersChanged = 0.0;
+		size_t shaderVariants = 0;               // compiled variants after the last frame
+	};
+
+	// The renderer must already be initialized, preferably with the null backend
+	FrameBenchmarkResult RunFrameBenchmark(const FrameBenchmarkConfig& config);
+
+	std::vector<FrameBenchmarkConfig> GetDefaultFrameScenes();
+
+	std::string FrameResultsToJson(const std::vector<FrameBenchmarkResult>& results);
+}
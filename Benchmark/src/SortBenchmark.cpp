@@ -0,0 +1,203 @@
+#include "SortBenchmark.h"
+#include "renderer/RenderSort.h"
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <random>
+#include <sstream>
+#include <vector>
+
+namespace Benchmark {
+
+	namespace
+	{
+		using DXEngine::RenderQueue;
+
+		// The fields the renderer reads when it builds a draw key
+		struct SyntheticSubmission
+		{
+			RenderQueue queue = RenderQueue::Opaque;
+			uint32_t shaderID = 0;
+			uint32_t materialID = 0;
+			uint32_t meshID = 0;
+			uint32_t submeshIndex = 0;
+			float distance = 0.0f;
+		};
+
+		std::vector<SyntheticSubmission> GenerateSubmissions(size_t count, unsigned seed)
+		{
+			std::mt19937 rng(seed);
+			std::uniform_real_distribution<float> distance(0.5f, 2000.0f);
+			std::uniform_int_distribution<uint32_t> shader(1, 24);
+			std::uniform_int_distribution<uint32_t> material(1, 256);
+			std::uniform_int_distribution<uint32_t> mesh(1, 512);
+			std::uniform_int_distribution<uint32_t> submesh(0, 3);
+			std::uniform_int_distribution<int> queueRoll(0, 99);
+
+			std::vector<SyntheticSubmission> submissions(count);
+			for (auto& submission : submissions)
+			{
+				// roughly the mix of a game scene: mostly opaque, some transparent, a little of the rest
+				int roll = queueRoll(rng);
+				submission.queue = roll < 2 ? RenderQueue::Background :
+					roll < 85 ? RenderQueue::Opaque :
+					roll < 97 ? RenderQueue::Transparent : RenderQueue::UI;
+				submission.shaderID = shader(rng);
+				submission.materialID = material(rng);
+				submission.meshID = mesh(rng);
+				submission.submeshIndex = submesh(rng);
+				submission.distance = distance(rng);
+			}
+			return submissions;
+		}
+
+		// Mirrors the previous Renderer::SortSubmissions: per-frame map of queues and comparator sorts
+		size_t LegacySort(const std::vector<SyntheticSubmission>& submissions, std::vector<const SyntheticSubmission*>& outOrder)
+		{
+			std::map<RenderQueue, std::vector<const SyntheticSubmission*>> sortedQueues;
+			for (const auto& submission : submissions)
+			{
+				sortedQueues[submission.queue].push_back(&submission);
+			}
+
+			for (auto& [queue, queueSubmissions] : sortedQueues)
+			{
+				if (queue == RenderQueue::Background || queue == RenderQueue::Opaque)
+				{
+					std::sort(queueSubmissions.begin(), queueSubmissions.end(), [](const SyntheticSubmission* a, const SyntheticSubmission* b)
+						{ return a->distance < b->distance; });
+				}
+				else if (queue == RenderQueue::Transparent)
+				{
+					std::sort(queueSubmissions.begin(), queueSubmissions.end(), [](const SyntheticSubmission* a, const SyntheticSubmission* b)
+						{ return a->distance > b->distance; });
+				}
+			}
+
+			outOrder.clear();
+			for (auto& [queue, queueSubmissions] : sortedQueues)
+			{
+				outOrder.insert(outOrder.end(), queueSubmissions.begin(), queueSubmissions.end());
+			}
+			return outOrder.size();
+		}
+
+		void RadixSort(const std::vector<SyntheticSubmission>& submissions,
+			std::vector<DXEngine::DrawSortEntry>& entries, std::vector<DXEngine::DrawSortEntry>& scratch)
+		{
+			entries.clear();
+			entries.reserve(submissions.size());
+
+			for (size_t i = 0; i < submissions.size(); ++i)
+			{
+				const auto& submission = submissions[i];
+				const uint32_t queueIndex = DXEngine::DrawKey::QueueIndex(submission.queue);
+
+				uint64_t key = 0;
+				if (submission.queue == RenderQueue::Transparent)
+				{
+					key = DXEngine::DrawKey::MakeTransparent(queueIndex, submission.shaderID,
+						submission.materialID, submission.meshID, submission.distance);
+				}
+				else if (submission.queue == RenderQueue::UI || submission.queue == RenderQueue::Overlay)
+				{
+					key = DXEngine::DrawKey::MakeSequential(queueIndex, static_cast<uint32_t>(i));
+				}
+				else
+				{
+					key = DXEngine::DrawKey::MakeOpaque(queueIndex, submission.shaderID, submission.materialID,
+						submission.meshID, submission.submeshIndex, submission.distance);
+				}
+				entries.push_back({ key, static_cast<uint32_t>(i) });
+			}
+
+			DXEngine::RadixSortDrawKeys(entries, scratch);
+		}
+
+		bool ValidateOrder(const std::vector<SyntheticSubmission>& submissions, const std::vector<DXEngine::DrawSortEntry>& entries)
+		{
+			for (size_t i = 1; i < entries.size(); ++i)
+			{
+				const auto& previous = submissions[entries[i - 1].index];
+				const auto& current = submissions[entries[i].index];
+
+				const uint32_t previousQueue = DXEngine::DrawKey::QueueIndex(previous.queue);
+				const uint32_t currentQueue = DXEngine::DrawKey::QueueIndex(current.queue);
+				if (previousQueue > currentQueue)
+					return false;
+				if (previousQueue != currentQueue)
+					continue;
+
+				if (current.queue == RenderQueue::Transparent &&
+					DXEngine::DrawKey::QuantizeDepth(previous.distance, 24) < DXEngine::DrawKey::QuantizeDepth(current.distance, 24))
+					return false;
+
+				if (current.queue == RenderQueue::UI && entries[i - 1].index > entries[i].index)
+					return false;
+
+				// opaque draws sharing shader, material and mesh must be front to back
+				if ((current.queue == RenderQueue::Opaque || current.queue == RenderQueue::Background) &&
+					previous.shaderID == current.shaderID && previous.materialID == current.materialID &&
+					previous.meshID == current.meshID && previous.submeshIndex == current.submeshIndex &&
+					DXEngine::DrawKey::QuantizeDepth(previous.distance, 21) > DXEngine::DrawKey::QuantizeDepth(current.distance, 21))
+					return false;
+			}
+			return true;
+		}
+
+		template<typename Fn>
+		double BestNanoseconds(int iterations, Fn&& fn)
+		{
+			double best = 0.0;
+			for (int i = 0; i < iterations; ++i)
+			{
+				auto start = std::chrono::steady_clock::now();
+				fn();
+				auto end = std::chrono::steady_clock::now();
+
+				double elapsed = std::chrono::duration<double, std::nano>(end - start).count();
+				if (i == 0 || elapsed < best)
+					best = elapsed;
+			}
+			return best;
+		}
+	}
+
+	SortBenchmarkResult RunSortBenchmark(size_t submissionCount, int iterations, unsigned seed)
+	{
+		SortBenchmarkResult result;
+		result.submissions = submissionCount;
+		if (submissionCount == 0 || iterations <= 0)
+			return result;
+
+		auto submissions = GenerateSubmissions(submissionCount, seed);
+
+		std::vector<const SyntheticSubmission*> legacyOrder;
+		legacyOrder.reserve(submissionCount);
+		double legacyNs = BestNanoseconds(iterations, [&]() { LegacySort(submissions, legacyOrder); });
+
+		std::vector<DXEngine::DrawSortEntry> entries;
+		std::vector<DXEngine::DrawSortEntry> scratch;
+		double radixNs = BestNanoseconds(iterations, [&]() { RadixSort(submissions, entries, scratch); });
+
+		result.legacyNsPerSubmission = legacyNs / static_cast<double>(submissionCount);
+		result.radixNsPerSubmission = radixNs / static_cast<double>(submissionCount);
+		result.orderValid = legacyOrder.size() == entries.size() && ValidateOrder(submissions, entries);
+		return result;
+	}
+
+	std::string FormatSortResult(const SortBenchmarkResult& result)
+	{
+		std::ostringstream oss;
+		oss << "submissions=" << result.submissions
+			<< " legacy_ns_per_submission=" << result.legacyNsPerSubmission
+			<< " radix_ns_per_submission=" << result.radixNsPerSubmission;
+
+		if (result.radixNsPerSubmission > 0.0)
+		{
+			oss << " speedup=" << result.legacyNsPerSubmission / result.radixNsPerSubmission;
+		}
+		oss << " order=" << (result.orderValid ? "ok" : "INVALID");
+		return oss.str();
+	}
+}
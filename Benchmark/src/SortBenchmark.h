@@ -0,0 +1,19 @@
+#pragma once
+#include <cstddef>
+#include <string>
+
+namespace Benchmark {
+
+	struct SortBenchmarkResult
+	{
+		size_t submissions = 0;
+		double legacyNsPerSubmission = 0.0;   // std::map queues + comparator sorts
+		double radixNsPerSubmission = 0.0;    // packed 64-bit keys + LSD radix sort
+		bool orderValid = false;              // radix output respects queue and depth ordering
+	};
+
+	// Sorts a deterministic synthetic submission set with both paths and times them
+	SortBenchmarkResult RunSortBenchmark(size_t submissionCount, int iterations, unsigned seed = 1234);
+
+	std::string FormatSortResult(const SortBenchmarkResult& result);
+}
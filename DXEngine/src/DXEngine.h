@@ -19,6 +19,7 @@
 #include "Core/Input.h"
 
 #include "renderer/Renderer.h"
+#include "renderer/SceneSpatialIndex.h"
 
 
 #define DX_BIND_EVENT_FN(fn) std::bind(&fn, this, std::placeholders::_1)
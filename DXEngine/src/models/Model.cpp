@@ -6,6 +6,7 @@
 #include <utils/Mesh/Utils/InputManager.h>
 #include <algorithm>
 #include "FrameTime.h"
+#include "utils/InstanceBuffer.h"
 
 namespace DXEngine {
 
@@ -69,10 +70,11 @@ namespace DXEngine {
 		OnMeshChanged(index);
 	}
 
-	std::shared_ptr<Mesh> Model::GetMesh(size_t index)const
+	const std::shared_ptr<Mesh>& Model::GetMesh(size_t index)const
 	{
+		static const std::shared_ptr<Mesh> s_NullMesh;
 		if (index >= m_Meshes.size())
-			return nullptr;
+			return s_NullMesh;
 		return m_Meshes[index].Mesh;
 	}
 
@@ -199,6 +201,13 @@ namespace DXEngine {
 		return m_Transform->GetTransform();
 	}
 
+	DirectX::XMMATRIX Model::GetNormalMatrix() const
+	{
+		if (!m_Transform)
+			return DirectX::XMMatrixIdentity();
+		return m_Transform->GetInverseTranspose();
+	}
+
 	void Model::SetTransform(std::shared_ptr<Transform> transform)
 	{
 		if (m_Transform != transform)
@@ -245,17 +254,36 @@ namespace DXEngine {
 
 	BoundingBox Model::GetWorldBoundingBox()const
 	{
-		BoundingBox localBox = GetLocalBoundingBox();
-
 		//Handle diffrent features
 		if (IsInstanced() && m_InstanceData && !m_InstanceData->transforms.empty())
 		{
 			UpdateInstanceBounds();
-			return m_LocalBoundingBox; //Already updated to world space
+			return m_InstanceUnionBounds;
 		}
 
 		if (!m_Transform)
-			return localBox;
+			return GetLocalBoundingBox();
+
+		//static models reuse the bounds from the last change
+		if (m_WorldBoundsVersion != GetBoundsVersion())
+			UpdateWorldBounds();
+		return m_WorldBoundingBox;
+	}
+
+	BoundingSphere Model::GetWorldBoundingSphere()const
+	{
+		if (!m_Transform)
+			return GetLocalBoundingSphere();
+
+		if (m_WorldBoundsVersion != GetBoundsVersion())
+			UpdateWorldBounds();
+		return m_WorldBoundingSphere;
+	}
+
+	void Model::UpdateWorldBounds() const
+	{
+		const BoundingBox localBox = GetLocalBoundingBox();
+		const BoundingSphere localSphere = GetLocalBoundingSphere();
 
 		// Standard world space transform
 		DirectX::XMMATRIX wordlMatrix = GetModelMatrix();
@@ -282,19 +310,10 @@ namespace DXEngine {
 			}
 
 		}
-		return worldBox;
-	}
+		m_WorldBoundingBox = worldBox;
 
-	BoundingSphere Model::GetWorldBoundingSphere()const
-	{
-		BoundingSphere localSphere = GetLocalBoundingSphere();
-
-		if (!m_Transform)
-			return localSphere;
-
-		DirectX::XMMATRIX worldMatrix = GetModelMatrix();
 		DirectX::XMVECTOR centerVec = DirectX::XMLoadFloat3(&localSphere.center);
-		DirectX::XMVECTOR worldCenter = DirectX::XMVector3Transform(centerVec, worldMatrix);
+		DirectX::XMVECTOR worldCenter = DirectX::XMVector3Transform(centerVec, wordlMatrix);
 
 		//calculate maximum scale to adjust radius
 		DirectX::XMVECTOR scale = GetScale();
@@ -304,7 +323,15 @@ namespace DXEngine {
 		DirectX::XMFLOAT3 worldCenterFloat;
 		DirectX::XMStoreFloat3(&worldCenterFloat, worldCenter);
 
-		return BoundingSphere(worldCenterFloat, localSphere.radius * maxScale);
+		m_WorldBoundingSphere = BoundingSphere(worldCenterFloat, localSphere.radius * maxScale);
+		m_WorldBoundsVersion = GetBoundsVersion();
+	}
+
+	uint64_t Model::GetBoundsVersion() const
+	{
+		//model edits in the high half, SetTransform counts as one so a swapped transform always differs
+		const uint32_t transformVersion = m_Transform ? m_Transform->GetVersion() : 0;
+		return (static_cast<uint64_t>(m_BoundsVersion) << 32) | transformVersion;
 	}
 
 	//Rendering Data access
@@ -405,6 +432,15 @@ namespace DXEngine {
 		InvalidateBounds();
 	}
 
+	void Model::UpdateInstance(size_t index, const DirectX::XMFLOAT4X4& transform)
+	{
+		if (!m_InstanceData || index >= m_InstanceData->GetInstanceCount())
+			return;
+
+		m_InstanceData->SetInstance(index, transform);
+		InvalidateBounds();
+	}
+
 	void Model::ClearInstances()
 	{
 		if (m_InstanceData)
@@ -419,6 +455,34 @@ namespace DXEngine {
 		return m_InstanceData ? m_InstanceData->GetInstanceCount() : 0;
 	}
 
+	InstanceBuffer* Model::EnsureInstanceBuffer(UINT* outBytesUploaded) const
+	{
+		if (outBytesUploaded)
+			*outBytesUploaded = 0;
+
+		if (!m_InstanceData || m_InstanceData->transforms.empty())
+			return nullptr;
+
+		if (!m_InstanceBuffer)
+		{
+			m_InstanceBuffer = std::make_unique<InstanceBuffer>();
+			m_InstanceData->MarkAllDirty();
+		}
+
+		if (m_InstanceData->dirty)
+		{
+			const auto& transforms = m_InstanceData->transforms;
+			if (!m_InstanceBuffer->Update(transforms.data(), transforms.size(),
+				m_InstanceData->dirtyBegin, m_InstanceData->dirtyEnd, outBytesUploaded))
+			{
+				return nullptr;
+			}
+			m_InstanceData->ClearDirty();
+		}
+
+		return m_InstanceBuffer.get();
+	}
+
 	void Model::EnableSkinning(std::shared_ptr<Skeleton> skeleton)
 	{
 		if (!HasFeature(ModelFeature::Skinned))
@@ -600,23 +664,25 @@ namespace DXEngine {
 		}
 	}
 
-	void Model::AddLODLevel(float distance, size_t meshIndex)
+	void Model::AddLODLevel(float screenSize, size_t meshIndex, size_t meshCount)
 	{
 		if (!m_LODData)
 			EnableLOD();
 
-		m_LODData->levels.push_back({ distance, meshIndex });
+		m_LODData->levels.push_back({ screenSize, meshIndex, meshCount });
 
-		// Sort by distance
+		// Finest level first
 		std::sort(m_LODData->levels.begin(), m_LODData->levels.end(),
 			[](const LODData::LODLevel& a, const LODData::LODLevel& b) {
-				return a.distance < b.distance;
+				return a.screenSize > b.screenSize;
 			});
+		m_LODData->currentLevel = 0;
+		m_LODData->fadeProgress = 1.0f;
 	}
 
-	size_t Model::SelectLOD(float distance) const
+	size_t Model::SelectLOD(float screenSize) const
 	{
-		return m_LODData ? m_LODData->SelectLOD(distance) : 0;
+		return m_LODData ? m_LODData->SelectLOD(screenSize) : 0;
 	}
 
 	// ====== MORPH TARGETS FEATURE ======
@@ -684,6 +750,7 @@ namespace DXEngine {
 	void Model::InvalidateBounds()
 	{
 		m_BoundsDirty = true;
+		m_BoundsVersion++;
 	}
 
 	void Model::ComputeBounds() const
@@ -767,42 +834,73 @@ namespace DXEngine {
 
 	void Model::UpdateInstanceBounds() const
 	{
-		if (!m_InstanceData || m_InstanceData->transforms.empty())
+		if (!m_InstanceData)
+			return;
+
+		InstanceData& data = *m_InstanceData;
+		const size_t count = data.transforms.size();
+		const BoundingBox localBox = GetLocalBoundingBox();
+
+		//a new local box or instance count invalidates everything, otherwise only the dirty range
+		size_t begin = data.boundsDirtyBegin;
+		size_t end = std::min(data.boundsDirtyEnd, count);
+		const bool localChanged =
+			localBox.min.x != m_InstanceLocalBounds.min.x || localBox.min.y != m_InstanceLocalBounds.min.y || localBox.min.z != m_InstanceLocalBounds.min.z ||
+			localBox.max.x != m_InstanceLocalBounds.max.x || localBox.max.y != m_InstanceLocalBounds.max.y || localBox.max.z != m_InstanceLocalBounds.max.z;
+		if (m_InstanceBounds.Size() != count || localChanged || (data.boundsDirty && begin >= end))
+		{
+			begin = 0;
+			end = count;
+			m_InstanceBounds.Resize(count);
+			m_InstanceLocalBounds = localBox;
+		}
+		else if (!data.boundsDirty)
 		{
-			OutputDebugStringA("cannot update Instance Bounds");
 			return;
 		}
+		data.ClearBoundsDirty();
 
-		BoundingBox localBox = GetLocalBoundingBox();
-		BoundingBox combinedBox;
-		bool first = true;
-
-		for (const auto& instanceTransform : m_InstanceData->transforms)
+		for (size_t i = begin; i < end; ++i)
 		{
-			DirectX::XMMATRIX instanceMatrix = DirectX::XMLoadFloat4x4(&instanceTransform);
-			DirectX::XMMATRIX worldMatrix = DirectX::XMMatrixMultiply(GetModelMatrix(), instanceMatrix);
-
-			DirectX::XMVECTOR corners[8];
-			localBox.GetCorners(corners);
+			//instance transforms are full world matrices, the vertex shader never applies the model matrix
+			const BoundingBox box = TransformBoundingBox(localBox, DirectX::XMLoadFloat4x4(&data.transforms[i]));
+			m_InstanceBounds.Set(static_cast<uint32_t>(i), BoundingSphere(box.GetCenter(), box.GetRadius()), box);
+		}
 
-			for (int i = 0; i < 8; i++)
+		//only the chunks covering the dirty range are re-unioned, the total is a union of chunks
+		const size_t chunkCount = (count + InstanceChunkSize - 1) / InstanceChunkSize;
+		m_InstanceChunkBounds.resize(chunkCount);
+		if (begin < end)
+		{
+			for (size_t chunk = begin / InstanceChunkSize; chunk <= (end - 1) / InstanceChunkSize; ++chunk)
 			{
-				DirectX::XMVECTOR worldCorner = DirectX::XMVector3Transform(corners[i], worldMatrix);
-				DirectX::XMFLOAT3 cornerPos;
-				DirectX::XMStoreFloat3(&cornerPos, worldCorner);
-
-				if (first)
+				BoundingBox chunkBounds;
+				const size_t chunkEnd = std::min(count, (chunk + 1) * InstanceChunkSize);
+				for (size_t i = chunk * InstanceChunkSize; i < chunkEnd; ++i)
 				{
-					combinedBox = BoundingBox(cornerPos, cornerPos);
-					first = false;
-				}
-				else
-				{
-					combinedBox.Expand(cornerPos);
+					chunkBounds.Expand(m_InstanceBounds.GetBox(static_cast<uint32_t>(i)));
 				}
+				m_InstanceChunkBounds[chunk] = chunkBounds;
 			}
 		}
-		m_LocalBoundingBox = combinedBox;
+
+		m_InstanceUnionBounds = BoundingBox();
+		for (const BoundingBox& chunkBounds : m_InstanceChunkBounds)
+		{
+			m_InstanceUnionBounds.Expand(chunkBounds);
+		}
+	}
+
+	const CullingBounds& Model::GetInstanceCullBounds() const
+	{
+		UpdateInstanceBounds();
+		return m_InstanceBounds;
+	}
+
+	const std::vector<BoundingBox>& Model::GetInstanceChunkBounds() const
+	{
+		UpdateInstanceBounds();
+		return m_InstanceChunkBounds;
 	}
 
 	void Model::UpdateSkinnedBounds() const
@@ -942,12 +1040,16 @@ namespace DXEngine {
 				return nullptr;
 			auto model = std::make_shared<Model>();
 			
+			//each level is used down to half the screen size of the one before it
+			float screenSize = 0.5f;
 			for (size_t i = 0; i < lodMeshes.size(); i++)
 			{
 				if (lodMeshes[i] && lodMeshes[i]->IsValid())
 				{
 					std::string lodName = "LOD_" + std::to_string(i);
 					model->AddMesh(lodMeshes[i], lodName);
+					model->AddLODLevel(screenSize, model->GetMeshCount() - 1);
+					screenSize *= 0.5f;
 				}
 			}
 
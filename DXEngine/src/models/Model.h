@@ -6,12 +6,14 @@
 #include <optional>
 #include <DirectXMath.h>
 #include "utils/mesh/Resource/MeshResource.h"
+#include "renderer/FrustumCulling.h"
 
 namespace DXEngine {
 
 	class Mesh;
 	class Material;
 	class FrameTime;
+	class InstanceBuffer;
 
 	class Model : public InterfacePickable
 	{
@@ -40,7 +42,7 @@ namespace DXEngine {
 		void SetMesh(std::shared_ptr<Mesh> mesh);//primary
 		const std::shared_ptr<Mesh>& GetMesh()const { return m_PrimaryMesh; }
 		void AddMesh(std::shared_ptr<Mesh> mesh, const std::string& name = "");// secondary meshes
-		std::shared_ptr<Mesh> GetMesh(size_t index)const;
+		const std::shared_ptr<Mesh>& GetMesh(size_t index)const;
 		std::shared_ptr<Mesh> GetMesh(const std::string& name)const;
 		size_t GetMeshCount()const { return m_Meshes.size(); }
 		void ClearMeshes();
@@ -63,6 +65,7 @@ namespace DXEngine {
 		void SetRotation(float pitch, float yaw, float roll);
 		const DirectX::XMVECTOR& GetRotation() const;
 		DirectX::XMMATRIX GetModelMatrix() const override;
+		DirectX::XMMATRIX GetNormalMatrix() const;   //inverse transpose of the model matrix, cached by the transform
 
 		// Transform management
 		void SetTransform(std::shared_ptr<Transform> transform);
@@ -73,6 +76,8 @@ namespace DXEngine {
 		BoundingSphere GetLocalBoundingSphere() const;
 		virtual BoundingBox GetWorldBoundingBox()const;
 		virtual BoundingSphere GetWorldBoundingSphere()const;
+		//changes whenever the world bounds may have, transform edits included
+		uint64_t GetBoundsVersion() const;
 
 		//rendering data access
 		size_t GetTotalSubmeshCount()const;
@@ -86,6 +91,12 @@ namespace DXEngine {
 		void setCastsShadows(bool casts) { m_CastsShadows = casts; }
 		bool ReceivesShadows()const { return m_ReceivesShadows; }
 		void SetReceivesShadows(bool receives){ m_ReceivesShadows = receives; }
+		//hero objects opt out of contribution culling and stay drawn however small they get
+		bool IsContributionCullable() const { return m_ContributionCullable; }
+		void SetContributionCullable(bool cullable) { m_ContributionCullable = cullable; }
+		//simplified geometry rasterized in place of the meshes when submitted as an occluder
+		void SetOccluderProxy(std::shared_ptr<MeshResource> proxy) { m_OccluderProxy = std::move(proxy); }
+		const std::shared_ptr<MeshResource>& GetOccluderProxy() const { return m_OccluderProxy; }
 
 		//picking
 		bool IsSelected()const { return m_IsSelected; }
@@ -100,8 +111,16 @@ namespace DXEngine {
 		//instance managment (automaticaly enables instancing)
 		void SetInstanceTransform(const std::vector<DirectX::XMFLOAT4X4>& transforms);
 		void AddInstance(const DirectX::XMFLOAT4X4& transform);
+		void UpdateInstance(size_t index, const DirectX::XMFLOAT4X4& transform);
 		void ClearInstances();
 		size_t GetInstanceCount()const;
+		//persistent GPU instance stream, re-uploaded only when the instance data is dirty
+		InstanceBuffer* EnsureInstanceBuffer(UINT* outBytesUploaded = nullptr) const;
+		//world bounds of every instance for CullBounds, plus the union of each run of
+		//InstanceChunkSize instances; only instances changed since the last call are recomputed
+		static constexpr uint32_t InstanceChunkSize = 64;
+		const CullingBounds& GetInstanceCullBounds() const;
+		const std::vector<BoundingBox>& GetInstanceChunkBounds() const;
 
 					// ====== SKINNING FEATURE ======
 		 // Check if model has skinning
@@ -143,8 +162,9 @@ namespace DXEngine {
 		void EnableLOD();
 		LODData* GetLODData() { return m_LODData.get(); }
 		const LODData* GetLODData() const { return m_LODData.get(); }
-		void AddLODLevel(float distance, size_t meshIndex);
-		size_t SelectLOD(float distance) const;
+		// meshCount meshes from meshIndex on make up the level, meshes outside every level always draw
+		void AddLODLevel(float screenSize, size_t meshIndex, size_t meshCount = 1);
+		size_t SelectLOD(float screenSize) const;
 
 					// ====== MORPH TARGETS FEATURE ======
 		bool HasMorphTargets() const { return HasFeature(ModelFeature::Morph); }
@@ -179,6 +199,7 @@ namespace DXEngine {
 		void EnsureMaterialSlots();
 		void UpdateAnimation(FrameTime deltatime);
 		void UpdateInstanceBounds() const;
+		void UpdateWorldBounds() const;
 		void UpdateSkinnedBounds() const;
 
 
@@ -199,21 +220,33 @@ namespace DXEngine {
 		std::shared_ptr<Mesh> m_PrimaryMesh;
 		std::shared_ptr<Transform> m_Transform;
 
-		//cache Bounds ( mutable for lazy computations)
+		//cache Bounds ( mutable for lazy computations), filled on one thread before the renderer slices read them
 		mutable BoundingBox m_LocalBoundingBox;
 		mutable BoundingSphere m_LocalBoundingSphere;
 		mutable bool m_BoundsDirty = true;
+		uint32_t m_BoundsVersion = 0;
+		//world bounds, valid while m_WorldBoundsVersion matches GetBoundsVersion()
+		mutable BoundingBox m_WorldBoundingBox;
+		mutable BoundingSphere m_WorldBoundingSphere;
+		mutable uint64_t m_WorldBoundsVersion = ~0ull;
 
 		//render State
 		bool m_Visible = true;
 		bool m_CastsShadows = true;
 		bool m_ReceivesShadows = true;
+		bool m_ContributionCullable = true;
 		bool m_IsSelected = false;
+		std::shared_ptr<MeshResource> m_OccluderProxy;
 
 		ModelFeature m_Features;
 
 		//optional fetures based on flags
 		std::unique_ptr<InstanceData> m_InstanceData;
+		mutable std::unique_ptr<InstanceBuffer> m_InstanceBuffer;
+		mutable CullingBounds m_InstanceBounds;
+		mutable std::vector<BoundingBox> m_InstanceChunkBounds;
+		mutable BoundingBox m_InstanceUnionBounds;
+		mutable BoundingBox m_InstanceLocalBounds;   // local box the cache was built from
 		std::unique_ptr<SkinningData> m_SkinningData;
 		std::unique_ptr<LODData> m_LODData;
 		std::unique_ptr<MorphData> m_MorphData;
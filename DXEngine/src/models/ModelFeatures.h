@@ -3,6 +3,7 @@
 #include <DirectXMath.h>
 #include <vector>
 #include <memory>
+#include <algorithm>
 #include "Animation/AnimationController.h"
 
 namespace DXEngine
@@ -52,23 +53,81 @@ namespace DXEngine
     {
         std::vector<DirectX::XMFLOAT4X4> transforms;
         bool dirty = false;
+        //instances changed since the last GPU upload, [dirtyBegin, dirtyEnd)
+        //an empty range while dirty means everything needs uploading
+        size_t dirtyBegin = 0;
+        size_t dirtyEnd = 0;
+        //instances whose cached world bounds are stale, same convention, cleared by Model
+        bool boundsDirty = false;
+        size_t boundsDirtyBegin = 0;
+        size_t boundsDirtyEnd = 0;
 
         size_t GetInstanceCount()const { return transforms.size(); }
 
         void AddInstance(const DirectX::XMFLOAT4X4& transform)
         {
             transforms.push_back(transform);
-            dirty = true;
+            MarkDirty(transforms.size() - 1, 1);
+        }
+        void SetInstance(size_t index, const DirectX::XMFLOAT4X4& transform)
+        {
+            if (index >= transforms.size())
+                return;
+            transforms[index] = transform;
+            MarkDirty(index, 1);
         }
         void SetInstances(const std::vector<DirectX::XMFLOAT4X4>& newTransfoms)
         {
             transforms = newTransfoms;
-            dirty = true;
+            MarkAllDirty();
         }
         void ClearInstances()
         {
             transforms.clear();
+            MarkAllDirty();
+        }
+
+        void MarkDirty(size_t begin, size_t count)
+        {
+            GrowRange(dirty, dirtyBegin, dirtyEnd, begin, count);
+            GrowRange(boundsDirty, boundsDirtyBegin, boundsDirtyEnd, begin, count);
+        }
+        void MarkAllDirty()
+        {
+            dirtyBegin = 0;
+            dirtyEnd = 0;
             dirty = true;
+            boundsDirtyBegin = 0;
+            boundsDirtyEnd = 0;
+            boundsDirty = true;
+        }
+        void ClearDirty()
+        {
+            dirtyBegin = 0;
+            dirtyEnd = 0;
+            dirty = false;
+        }
+        void ClearBoundsDirty()
+        {
+            boundsDirtyBegin = 0;
+            boundsDirtyEnd = 0;
+            boundsDirty = false;
+        }
+
+    private:
+        static void GrowRange(bool& isDirty, size_t& rangeBegin, size_t& rangeEnd, size_t begin, size_t count)
+        {
+            if (!isDirty)
+            {
+                rangeBegin = begin;
+                rangeEnd = begin + count;
+            }
+            else if (rangeBegin < rangeEnd)
+            {
+                rangeBegin = std::min(rangeBegin, begin);
+                rangeEnd = std::max(rangeEnd, begin + count);
+            }
+            isDirty = true;
         }
     };
 
@@ -222,27 +281,68 @@ namespace DXEngine
         }
     };
 
-    // Component for LOD data
+    // Component for LOD data. Levels are picked by screen size: the height of the model's
+    // bounding sphere on screen as a fraction of the viewport height.
     struct LODData
     {
+        static constexpr size_t NoLevel = static_cast<size_t>(-1);
+
         struct LODLevel
         {
-            float distance;
-            size_t meshIndex;
+            float screenSize;       // smallest screen size the level is used at
+            size_t meshIndex;       // first mesh of the level
+            size_t meshCount = 1;
         };
 
-        std::vector<LODLevel> levels;
+        std::vector<LODLevel> levels;   // finest first, screenSize descending
         size_t currentLevel = 0;
 
-        size_t SelectLOD(float distance) const
+        // dithered cross-fade from previousLevel, done once fadeProgress reaches 1
+        size_t previousLevel = 0;
+        float fadeProgress = 1.0f;
+        uint32_t lastUpdateFrame = 0;
+
+        // First level the screen size reaches, the coarsest when it reaches none
+        size_t SelectLevel(float screenSize) const
+        {
+            for (size_t i = 0; i < levels.size(); ++i)
+            {
+                if (screenSize >= levels[i].screenSize)
+                    return i;
+            }
+            return levels.empty() ? 0 : levels.size() - 1;
+        }
+
+        // Same, but the current level is kept until the size leaves its range by more than
+        // the relative hysteresis band, so a size resting on a threshold doesn't flicker
+        size_t SelectLevel(float screenSize, float hysteresis) const
+        {
+            const size_t target = SelectLevel(screenSize);
+            if (currentLevel >= levels.size() || target == currentLevel)
+                return target;
+
+            if (target > currentLevel)
+                return screenSize < levels[currentLevel].screenSize * (1.0f - hysteresis) ? target : currentLevel;
+            return screenSize >= levels[currentLevel - 1].screenSize * (1.0f + hysteresis) ? target : currentLevel;
+        }
+
+        size_t SelectLOD(float screenSize) const
+        {
+            return levels.empty() ? 0 : levels[SelectLevel(screenSize)].meshIndex;
+        }
+
+        // Level owning a mesh, NoLevel for meshes drawn at every level
+        size_t FindLevel(size_t meshIndex) const
         {
             for (size_t i = 0; i < levels.size(); ++i)
             {
-                if (distance < levels[i].distance)
-                    return levels[i].meshIndex;
+                if (meshIndex >= levels[i].meshIndex && meshIndex < levels[i].meshIndex + levels[i].meshCount)
+                    return i;
             }
-            return levels.empty() ? 0 : levels.back().meshIndex;
+            return NoLevel;
         }
+
+        bool IsFading() const { return fadeProgress < 1.0f && previousLevel != currentLevel; }
     };
 
     // Component for morph target data
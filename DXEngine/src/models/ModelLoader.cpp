@@ -425,7 +425,8 @@ namespace DXEngine
         const ModelLoadOptions& options)
     {
         return filePath + "_" + std::to_string(
-            options.generateNormals + options.generateTangents * 2 + options.flipUVs * 4);
+            options.generateNormals + options.generateTangents * 2 + options.flipUVs * 4) +
+            "_lod" + std::to_string(options.lodLevelCount);
     }
 
     void ModelLoader::SetError(const std::string& error)
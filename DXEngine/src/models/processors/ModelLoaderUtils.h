@@ -29,6 +29,10 @@ namespace DXEngine
         bool fixInfacingNormals = true;
         bool limitBoneWeights = true;
         uint32_t maxBoneWeights = 4;
+
+        // LOD generation, levels beyond the ratio list halve the previous ratio again
+        uint32_t lodLevelCount = 0;
+        std::vector<float> lodTriangleRatios = { 0.5f, 0.25f, 0.125f, 0.0625f };
     };
 
 
@@ -4,6 +4,9 @@
 #include "utils/Mesh/Mesh.h"
 #include "utils/Mesh/Resource/MeshResource.h"
 #include "utils/material/Material.h"
+#include "utils/WorkerPool.h"
+#include "renderer/Renderer.h"
+#include <cmath>
 
 namespace DXEngine {
 
@@ -29,6 +32,10 @@ namespace DXEngine {
             OptimizeModel(model);
         }
 
+        if (options.lodLevelCount > 0) {
+            GenerateLODs(model, options);
+        }
+
         // Validate if requested
         if (options.validateDataStructure) {
             ValidateModel(model);
@@ -161,6 +168,121 @@ namespace DXEngine {
         m_LastError.clear();
     }
 
+    void ModelPostProcessor::GenerateLODs(std::shared_ptr<Model> model, const ModelLoadOptions& options)
+    {
+        if (!model || options.lodLevelCount == 0 || model->GetMeshCount() == 0)
+            return;
+
+        if (model->HasLOD()) {
+            OutputDebugStringA("ModelPostProcessor: Model already has LOD levels, skipping generation\n");
+            return;
+        }
+        //simplification drops and reorders vertices, morph target deltas would no longer line up
+        if (model->HasMorphTargets()) {
+            OutputDebugStringA("ModelPostProcessor: Skipping LOD generation for model with morph targets\n");
+            return;
+        }
+
+        const size_t meshCount = model->GetMeshCount();
+        const uint32_t levelCount = options.lodLevelCount;
+
+        //triangle ratio of every level against the source meshes
+        std::vector<float> ratios(levelCount);
+        for (uint32_t level = 0; level < levelCount; level++) {
+            if (level < options.lodTriangleRatios.size())
+                ratios[level] = std::clamp(options.lodTriangleRatios[level], 0.0f, 1.0f);
+            else
+                ratios[level] = (level > 0 ? ratios[level - 1] : 1.0f) * 0.5f;
+        }
+
+        //each chain simplifies from the level before it, chains run in parallel across meshes;
+        //a null entry means the level reuses the previous mesh
+        std::vector<std::vector<std::shared_ptr<MeshResource>>> chains(meshCount,
+            std::vector<std::shared_ptr<MeshResource>>(levelCount));
+
+        const std::function<void(uint32_t)> simplifyChain = [&](uint32_t meshIndex) {
+            const auto& mesh = model->GetMesh(meshIndex);
+            if (!mesh || !mesh->IsValid() || !mesh->GetResource())
+                return;
+
+            std::shared_ptr<MeshResource> previous = mesh->GetResource();
+            float previousRatio = 1.0f;
+            for (uint32_t level = 0; level < levelCount; level++) {
+                if (ratios[level] >= previousRatio)
+                    continue;
+
+                //coarser levels are seen smaller, so they may deviate more
+                MeshUtils::SimplifyOptions simplify;
+                simplify.targetRatio = ratios[level] / previousRatio;
+                simplify.maxError = 0.01f / std::sqrt(std::max(ratios[level], 1e-4f));
+
+                auto simplified = MeshUtils::SimplifyMesh(*previous, simplify);
+                if (!simplified)
+                    return;
+
+                //not worth a level when the error bound stopped it almost immediately
+                const size_t before = previous->GetIndexData()->GetIndexCount();
+                const size_t after = simplified->GetIndexData() ? simplified->GetIndexData()->GetIndexCount() : 0;
+                if (after == 0 || after > before * 95 / 100)
+                    return;
+
+                chains[meshIndex][level] = simplified;
+                previous = simplified;
+                previousRatio = ratios[level];
+            }
+        };
+
+        //borrows the renderer's workers instead of starting threads for every load
+        if (WorkerPool* pool = Renderer::GetWorkerPool()) {
+            pool->ParallelFor(static_cast<uint32_t>(meshCount), simplifyChain);
+        }
+        else {
+            for (uint32_t meshIndex = 0; meshIndex < meshCount; meshIndex++)
+                simplifyChain(meshIndex);
+        }
+
+        //levels where no mesh got any coarser are dropped along with everything after them
+        uint32_t usedLevels = 0;
+        while (usedLevels < levelCount) {
+            bool reduced = false;
+            for (size_t i = 0; i < meshCount && !reduced; i++)
+                reduced = chains[i][usedLevels] != nullptr;
+            if (!reduced)
+                break;
+            usedLevels++;
+        }
+        if (usedLevels == 0) {
+            OutputDebugStringA("ModelPostProcessor: Meshes could not be simplified, no LOD levels generated\n");
+            return;
+        }
+
+        //level 0 is the source meshes, level n occupies meshes [n * meshCount, (n + 1) * meshCount)
+        model->AddLODLevel(0.5f, 0, meshCount);
+        std::vector<std::shared_ptr<Mesh>> previous(meshCount);
+        for (size_t i = 0; i < meshCount; i++)
+            previous[i] = model->GetMesh(i);
+
+        for (uint32_t level = 0; level < usedLevels; level++) {
+            const size_t firstMesh = model->GetMeshCount();
+            for (size_t i = 0; i < meshCount; i++) {
+                if (chains[i][level]) {
+                    auto lodMesh = std::make_shared<Mesh>(chains[i][level]);
+                    const auto& source = model->GetMesh(i);
+                    for (size_t j = 0; j < source->GetMaterials().size(); j++)
+                        lodMesh->SetMaterial(j, source->GetMaterial(j));
+                    previous[i] = lodMesh;
+                }
+                model->AddMesh(previous[i], "LOD_" + std::to_string(level + 1) + "_" + std::to_string(i));
+            }
+
+            //triangle density on screen stays level when the size falls with the square root of the ratio
+            model->AddLODLevel(0.5f * std::sqrt(ratios[level]), firstMesh, meshCount);
+        }
+
+        OutputDebugStringA(("ModelPostProcessor: Generated " + std::to_string(usedLevels) +
+            " LOD levels for " + std::to_string(meshCount) + " meshes\n").c_str());
+    }
+
     void ModelPostProcessor::ApplyGlobalScale(std::shared_ptr<Model> model, float scale)
     {
         if (!model || scale == 1.0f)
@@ -17,6 +17,8 @@ namespace DXEngine
 		void ValidateModel(std::shared_ptr<Model> model);
 		void EnsureDefaultMaterials(std::shared_ptr<Model> model);
 		void ApplyGlobalScale(std::shared_ptr<Model> model, float scale);
+		// Appends simplified copies of every mesh per level and registers them as LOD levels
+		void GenerateLODs(std::shared_ptr<Model> model, const ModelLoadOptions& options);
 	private:
 		std::string m_LastError;
 		
@@ -0,0 +1,161 @@
+#include "dxpch.h"
+#include "D3D11RenderBackend.h"
+
+namespace DXEngine
+{
+	D3D11RenderBackend::D3D11RenderBackend(const Microsoft::WRL::ComPtr<ID3D11DeviceContext>& context)
+		: m_Context(context)
+	{
+		// optional, used for constant buffer ranges
+		if (m_Context)
+		{
+			m_Context.As(&m_Context1);
+		}
+	}
+
+	void D3D11RenderBackend::SetRenderTargets(ID3D11RenderTargetView* target, ID3D11DepthStencilView* depth)
+	{
+		m_Context->OMSetRenderTargets(target ? 1u : 0u, target ? &target : nullptr, depth);
+	}
+
+	void D3D11RenderBackend::ClearRenderTarget(ID3D11RenderTargetView* target, const float color[4])
+	{
+		m_Context->ClearRenderTargetView(target, color);
+	}
+
+	void D3D11RenderBackend::ClearDepthStencil(ID3D11DepthStencilView* depth, float depthValue, UINT8 stencil)
+	{
+		m_Context->ClearDepthStencilView(depth, D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, depthValue, stencil);
+	}
+
+	void D3D11RenderBackend::SetViewport(const D3D11_VIEWPORT& viewport)
+	{
+		m_Context->RSSetViewports(1u, &viewport);
+	}
+
+	void D3D11RenderBackend::SetVertexBuffers(UINT startSlot, UINT count, ID3D11Buffer* const* buffers, const UINT* strides, const UINT* offsets)
+	{
+		m_Context->IASetVertexBuffers(startSlot, count, buffers, strides, offsets);
+	}
+
+	void D3D11RenderBackend::SetIndexBuffer(ID3D11Buffer* buffer, DXGI_FORMAT format, UINT offset)
+	{
+		m_Context->IASetIndexBuffer(buffer, format, offset);
+	}
+
+	void D3D11RenderBackend::SetInputLayout(ID3D11InputLayout* layout)
+	{
+		m_Context->IASetInputLayout(layout);
+	}
+
+	void D3D11RenderBackend::SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY topology)
+	{
+		m_Context->IASetPrimitiveTopology(topology);
+	}
+
+	void D3D11RenderBackend::SetVertexShader(ID3D11VertexShader* shader)
+	{
+		m_Context->VSSetShader(shader, nullptr, 0);
+	}
+
+	void D3D11RenderBackend::SetPixelShader(ID3D11PixelShader* shader)
+	{
+		m_Context->PSSetShader(shader, nullptr, 0);
+	}
+
+	void D3D11RenderBackend::SetConstantBuffer(ShaderStage stage, UINT slot, ID3D11Buffer* buffer)
+	{
+		if (stage == ShaderStage::Vertex)
+			m_Context->VSSetConstantBuffers(slot, 1, &buffer);
+		else
+			m_Context->PSSetConstantBuffers(slot, 1, &buffer);
+	}
+
+	bool D3D11RenderBackend::SetConstantBufferRange(ShaderStage stage, UINT slot, ID3D11Buffer* buffer, UINT firstConstant, UINT numConstants)
+	{
+		if (!m_Context1)
+			return false;
+
+		if (stage == ShaderStage::Vertex)
+			m_Context1->VSSetConstantBuffers1(slot, 1, &buffer, &firstConstant, &numConstants);
+		else
+			m_Context1->PSSetConstantBuffers1(slot, 1, &buffer, &firstConstant, &numConstants);
+		return true;
+	}
+
+	void D3D11RenderBackend::SetShaderResource(ShaderStage stage, UINT slot, ID3D11ShaderResourceView* view)
+	{
+		if (stage == ShaderStage::Vertex)
+			m_Context->VSSetShaderResources(slot, 1, &view);
+		else
+			m_Context->PSSetShaderResources(slot, 1, &view);
+	}
+
+	void D3D11RenderBackend::SetSamplers(ShaderStage stage, UINT startSlot, UINT count, ID3D11SamplerState* const* samplers)
+	{
+		if (stage == ShaderStage::Vertex)
+			m_Context->VSSetSamplers(startSlot, count, samplers);
+		else
+			m_Context->PSSetSamplers(startSlot, count, samplers);
+	}
+
+	void D3D11RenderBackend::SetRasterizerState(ID3D11RasterizerState* state)
+	{
+		m_Context->RSSetState(state);
+	}
+
+	void D3D11RenderBackend::SetDepthStencilState(ID3D11DepthStencilState* state, UINT stencilRef)
+	{
+		m_Context->OMSetDepthStencilState(state, stencilRef);
+	}
+
+	void D3D11RenderBackend::SetBlendState(ID3D11BlendState* state)
+	{
+		m_Context->OMSetBlendState(state, nullptr, 0xffffffff);
+	}
+
+	void D3D11RenderBackend::Draw(UINT vertexCount, UINT startVertex)
+	{
+		m_Context->Draw(vertexCount, startVertex);
+	}
+
+	void D3D11RenderBackend::DrawIndexed(UINT indexCount, UINT startIndex, INT baseVertex)
+	{
+		m_Context->DrawIndexed(indexCount, startIndex, baseVertex);
+	}
+
+	void D3D11RenderBackend::DrawInstanced(UINT vertexCount, UINT instanceCount, UINT startVertex, UINT startInstance)
+	{
+		m_Context->DrawInstanced(vertexCount, instanceCount, startVertex, startInstance);
+	}
+
+	void D3D11RenderBackend::DrawIndexedInstanced(UINT indexCount, UINT instanceCount, UINT startIndex, INT baseVertex, UINT startInstance)
+	{
+		m_Context->DrawIndexedInstanced(indexCount, instanceCount, startIndex, baseVertex, startInstance);
+	}
+
+	HRESULT D3D11RenderBackend::Map(ID3D11Buffer* buffer, D3D11_MAP mapType, D3D11_MAPPED_SUBRESOURCE& mapped)
+	{
+		return m_Context->Map(buffer, 0, mapType, 0, &mapped);
+	}
+
+	void D3D11RenderBackend::Unmap(ID3D11Buffer* buffer, UINT bytesWritten)
+	{
+		m_Context->Unmap(buffer, 0);
+	}
+
+	void D3D11RenderBackend::UpdateSubresource(ID3D11Buffer* buffer, const D3D11_BOX* box, const void* data, UINT bytes)
+	{
+		m_Context->UpdateSubresource(buffer, 0, box, data, 0, 0);
+	}
+
+	void D3D11RenderBackend::EndQuery(ID3D11Query* query)
+	{
+		m_Context->End(query);
+	}
+
+	HRESULT D3D11RenderBackend::GetQueryData(ID3D11Query* query, UINT flags)
+	{
+		return m_Context->GetData(query, nullptr, 0, flags);
+	}
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include "RenderBackend.h"
+
+namespace DXEngine {
+
+	// Forwards every call straight to the immediate context
+	class D3D11RenderBackend : public RenderBackend
+	{
+	public:
+		explicit D3D11RenderBackend(const Microsoft::WRL::ComPtr<ID3D11DeviceContext>& context);
+
+		RenderBackendType GetType() const override { return RenderBackendType::D3D11; }
+
+		void SetRenderTargets(ID3D11RenderTargetView* target, ID3D11DepthStencilView* depth) override;
+		void ClearRenderTarget(ID3D11RenderTargetView* target, const float color[4]) override;
+		void ClearDepthStencil(ID3D11DepthStencilView* depth, float depthValue, UINT8 stencil) override;
+		void SetViewport(const D3D11_VIEWPORT& viewport) override;
+
+		void SetVertexBuffers(UINT startSlot, UINT count, ID3D11Buffer* const* buffers, const UINT* strides, const UINT* offsets) override;
+		void SetIndexBuffer(ID3D11Buffer* buffer, DXGI_FORMAT format, UINT offset) override;
+		void SetInputLayout(ID3D11InputLayout* layout) override;
+		void SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY topology) override;
+		void SetVertexShader(ID3D11VertexShader* shader) override;
+		void SetPixelShader(ID3D11PixelShader* shader) override;
+		void SetConstantBuffer(ShaderStage stage, UINT slot, ID3D11Buffer* buffer) override;
+		bool SetConstantBufferRange(ShaderStage stage, UINT slot, ID3D11Buffer* buffer, UINT firstConstant, UINT numConstants) override;
+		bool SupportsConstantBufferRanges() const override { return m_Context1 != nullptr; }
+		void SetShaderResource(ShaderStage stage, UINT slot, ID3D11ShaderResourceView* view) override;
+		void SetSamplers(ShaderStage stage, UINT startSlot, UINT count, ID3D11SamplerState* const* samplers) override;
+		void SetRasterizerState(ID3D11RasterizerState* state) override;
+		void SetDepthStencilState(ID3D11DepthStencilState* state, UINT stencilRef) override;
+		void SetBlendState(ID3D11BlendState* state) override;
+
+		void Draw(UINT vertexCount, UINT startVertex) override;
+		void DrawIndexed(UINT indexCount, UINT startIndex, INT baseVertex) override;
+		void DrawInstanced(UINT vertexCount, UINT instanceCount, UINT startVertex, UINT startInstance) override;
+		void DrawIndexedInstanced(UINT indexCount, UINT instanceCount, UINT startIndex, INT baseVertex, UINT startInstance) override;
+
+		HRESULT Map(ID3D11Buffer* buffer, D3D11_MAP mapType, D3D11_MAPPED_SUBRESOURCE& mapped) override;
+		void Unmap(ID3D11Buffer* buffer, UINT bytesWritten) override;
+		void UpdateSubresource(ID3D11Buffer* buffer, const D3D11_BOX* box, const void* data, UINT bytes) override;
+
+		void EndQuery(ID3D11Query* query) override;
+		HRESULT GetQueryData(ID3D11Query* query, UINT flags) override;
+
+	private:
+		Microsoft::WRL::ComPtr<ID3D11DeviceContext> m_Context;
+		Microsoft::WRL::ComPtr<ID3D11DeviceContext1> m_Context1;   // null before D3D11.1
+	};
+}
@@ -0,0 +1,286 @@
+#include "dxpch.h"
+#include "FrustumCullingKernels.h"
+#include <bit>
+#include <cmath>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <xmmintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+namespace DXEngine {
+
+	using CullKernels::PlaneCorner;
+
+	namespace
+	{
+		bool DetectAVX()
+		{
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+			//the CPU has AVX and the OS saves the upper halves of the ymm registers
+			int info[4];
+			__cpuid(info, 1);
+			const bool avx = (info[2] & (1 << 28)) != 0;
+			const bool osSavesState = (info[2] & (1 << 27)) != 0;
+			return avx && osSavesState && (_xgetbv(0) & 0x6) == 0x6;
+#elif defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+			return __builtin_cpu_supports("avx");
+#else
+			return false;
+#endif
+		}
+
+		bool IsVisibleScalar(const PlaneCorner (&corners)[FrustumPlanes::Count],
+			float x, float y, float z, float radius,
+			float minX, float minY, float minZ, float maxX, float maxY, float maxZ)
+		{
+			for (const PlaneCorner& plane : corners)
+			{
+				if ((plane.a * x + plane.b * y) + (plane.c * z + plane.d) < -radius)
+					return false;
+
+				const float px = plane.maxX ? maxX : minX;
+				const float py = plane.maxY ? maxY : minY;
+				const float pz = plane.maxZ ? maxZ : minZ;
+				if ((plane.a * px + plane.b * py) + (plane.c * pz + plane.d) < 0.0f)
+					return false;
+			}
+			return true;
+		}
+	}
+
+	namespace CullKernels
+	{
+		void GetPlaneCorners(const FrustumPlanes& frustum, PlaneCorner (&corners)[FrustumPlanes::Count])
+		{
+			for (int i = 0; i < FrustumPlanes::Count; ++i)
+			{
+				const DirectX::XMFLOAT4& plane = frustum.planes[i];
+				corners[i] = { plane.x, plane.y, plane.z, plane.w, plane.x >= 0.0f, plane.y >= 0.0f, plane.z >= 0.0f };
+			}
+		}
+
+		bool HasAVX()
+		{
+			static const bool supported = DetectAVX();
+			return supported;
+		}
+	}
+
+	FrustumPlanes FrustumPlanes::FromViewProjection(DirectX::FXMMATRIX viewProjection)
+	{
+		// row vectors, clip = p * M, so each clip component is a column of M
+		DirectX::XMFLOAT4X4 m;
+		DirectX::XMStoreFloat4x4(&m, viewProjection);
+		auto column = [&m](int c) { return DirectX::XMFLOAT4(m.m[0][c], m.m[1][c], m.m[2][c], m.m[3][c]); };
+		const DirectX::XMFLOAT4 x = column(0), y = column(1), z = column(2), w = column(3);
+
+		FrustumPlanes frustum;
+		frustum.planes[Left] = { w.x + x.x, w.y + x.y, w.z + x.z, w.w + x.w };
+		frustum.planes[Right] = { w.x - x.x, w.y - x.y, w.z - x.z, w.w - x.w };
+		frustum.planes[Bottom] = { w.x + y.x, w.y + y.y, w.z + y.z, w.w + y.w };
+		frustum.planes[Top] = { w.x - y.x, w.y - y.y, w.z - y.z, w.w - y.w };
+		frustum.planes[Near] = z;
+		frustum.planes[Far] = { w.x - z.x, w.y - z.y, w.z - z.z, w.w - z.w };
+
+		// unit normals so plane distances compare against sphere radii
+		for (DirectX::XMFLOAT4& plane : frustum.planes)
+		{
+			const float length = std::sqrt(plane.x * plane.x + plane.y * plane.y + plane.z * plane.z);
+			if (length > 0.0f)
+			{
+				const float scale = 1.0f / length;
+				plane = { plane.x * scale, plane.y * scale, plane.z * scale, plane.w * scale };
+			}
+		}
+		return frustum;
+	}
+
+	bool FrustumPlanes::IsVisible(const BoundingSphere& sphere, const BoundingBox& box) const
+	{
+		PlaneCorner corners[Count];
+		CullKernels::GetPlaneCorners(*this, corners);
+		return IsVisibleScalar(corners, sphere.center.x, sphere.center.y, sphere.center.z, sphere.radius,
+			box.min.x, box.min.y, box.min.z, box.max.x, box.max.y, box.max.z);
+	}
+
+	CullResult FrustumPlanes::Classify(const BoundingBox& box, uint32_t& planeMask) const
+	{
+		for (int i = 0; i < Count; ++i)
+		{
+			const uint32_t bit = 1u << i;
+			if ((planeMask & bit) == 0)
+				continue;
+
+			const DirectX::XMFLOAT4& plane = planes[i];
+			const bool maxX = plane.x >= 0.0f, maxY = plane.y >= 0.0f, maxZ = plane.z >= 0.0f;
+
+			// corner furthest along the normal outside means the whole box is
+			const float farthest = (plane.x * (maxX ? box.max.x : box.min.x) + plane.y * (maxY ? box.max.y : box.min.y)) +
+				(plane.z * (maxZ ? box.max.z : box.min.z) + plane.w);
+			if (farthest < 0.0f)
+				return CullResult::Outside;
+
+			// nearest corner inside means every child is inside this plane too
+			const float nearest = (plane.x * (maxX ? box.min.x : box.max.x) + plane.y * (maxY ? box.min.y : box.max.y)) +
+				(plane.z * (maxZ ? box.min.z : box.max.z) + plane.w);
+			if (nearest >= 0.0f)
+				planeMask &= ~bit;
+		}
+		return planeMask == 0 ? CullResult::Inside : CullResult::Intersects;
+	}
+
+	BoundingBox TransformBoundingBox(const BoundingBox& box, DirectX::FXMMATRIX matrix)
+	{
+		const DirectX::XMVECTOR localMin = DirectX::XMLoadFloat3(&box.min);
+		const DirectX::XMVECTOR localMax = DirectX::XMLoadFloat3(&box.max);
+		const DirectX::XMVECTOR localCenter = DirectX::XMVectorScale(DirectX::XMVectorAdd(localMin, localMax), 0.5f);
+		const DirectX::XMVECTOR localExtents = DirectX::XMVectorScale(DirectX::XMVectorSubtract(localMax, localMin), 0.5f);
+
+		const DirectX::XMVECTOR center = DirectX::XMVector3Transform(localCenter, matrix);
+		DirectX::XMVECTOR extents = DirectX::XMVectorMultiply(DirectX::XMVectorAbs(matrix.r[0]), DirectX::XMVectorSplatX(localExtents));
+		extents = DirectX::XMVectorMultiplyAdd(DirectX::XMVectorAbs(matrix.r[1]), DirectX::XMVectorSplatY(localExtents), extents);
+		extents = DirectX::XMVectorMultiplyAdd(DirectX::XMVectorAbs(matrix.r[2]), DirectX::XMVectorSplatZ(localExtents), extents);
+
+		BoundingBox result;
+		DirectX::XMStoreFloat3(&result.min, DirectX::XMVectorSubtract(center, extents));
+		DirectX::XMStoreFloat3(&result.max, DirectX::XMVectorAdd(center, extents));
+		return result;
+	}
+
+	void CullingBounds::Clear()
+	{
+		for (auto* values : { &m_CenterX, &m_CenterY, &m_CenterZ, &m_Radius, &m_MinX, &m_MinY, &m_MinZ, &m_MaxX, &m_MaxY, &m_MaxZ })
+		{
+			values->clear();
+		}
+	}
+
+	void CullingBounds::Reserve(size_t count)
+	{
+		for (auto* values : { &m_CenterX, &m_CenterY, &m_CenterZ, &m_Radius, &m_MinX, &m_MinY, &m_MinZ, &m_MaxX, &m_MaxY, &m_MaxZ })
+		{
+			values->reserve(count);
+		}
+	}
+
+	uint32_t CullingBounds::Add(const BoundingSphere& sphere, const BoundingBox& box)
+	{
+		const uint32_t index = static_cast<uint32_t>(m_CenterX.size());
+		m_CenterX.push_back(sphere.center.x);
+		m_CenterY.push_back(sphere.center.y);
+		m_CenterZ.push_back(sphere.center.z);
+		m_Radius.push_back(sphere.radius);
+		m_MinX.push_back(box.min.x);
+		m_MinY.push_back(box.min.y);
+		m_MinZ.push_back(box.min.z);
+		m_MaxX.push_back(box.max.x);
+		m_MaxY.push_back(box.max.y);
+		m_MaxZ.push_back(box.max.z);
+		return index;
+	}
+
+	void CullingBounds::Resize(size_t count)
+	{
+		for (auto* values : { &m_CenterX, &m_CenterY, &m_CenterZ, &m_Radius, &m_MinX, &m_MinY, &m_MinZ, &m_MaxX, &m_MaxY, &m_MaxZ })
+		{
+			values->resize(count);
+		}
+	}
+
+	void CullingBounds::Set(uint32_t index, const BoundingSphere& sphere, const BoundingBox& box)
+	{
+		m_CenterX[index] = sphere.center.x;
+		m_CenterY[index] = sphere.center.y;
+		m_CenterZ[index] = sphere.center.z;
+		m_Radius[index] = sphere.radius;
+		m_MinX[index] = box.min.x;
+		m_MinY[index] = box.min.y;
+		m_MinZ[index] = box.min.z;
+		m_MaxX[index] = box.max.x;
+		m_MaxY[index] = box.max.y;
+		m_MaxZ[index] = box.max.z;
+	}
+
+	BoundingBox CullingBounds::GetBox(uint32_t index) const
+	{
+		return BoundingBox(DirectX::XMFLOAT3(m_MinX[index], m_MinY[index], m_MinZ[index]),
+			DirectX::XMFLOAT3(m_MaxX[index], m_MaxY[index], m_MaxZ[index]));
+	}
+
+	BoundingSphere CullingBounds::GetSphere(uint32_t index) const
+	{
+		return BoundingSphere(DirectX::XMFLOAT3(m_CenterX[index], m_CenterY[index], m_CenterZ[index]), m_Radius[index]);
+	}
+
+	uint32_t CullBounds(const FrustumPlanes& frustum, const CullingBounds& bounds,
+		uint32_t begin, uint32_t end, uint32_t* visible)
+	{
+		PlaneCorner corners[FrustumPlanes::Count];
+		CullKernels::GetPlaneCorners(frustum, corners);
+
+		const float* cx = bounds.m_CenterX.data();
+		const float* cy = bounds.m_CenterY.data();
+		const float* cz = bounds.m_CenterZ.data();
+		const float* radius = bounds.m_Radius.data();
+		const float* minX = bounds.m_MinX.data();
+		const float* minY = bounds.m_MinY.data();
+		const float* minZ = bounds.m_MinZ.data();
+		const float* maxX = bounds.m_MaxX.data();
+		const float* maxY = bounds.m_MaxY.data();
+		const float* maxZ = bounds.m_MaxZ.data();
+
+		uint32_t visibleCount = 0;
+		uint32_t i = begin;
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+		//8 at a time where the CPU has AVX, what is left of a batch goes 4 wide
+		if (CullKernels::HasAVX())
+		{
+			const CullKernels::BoundsArrays arrays = { cx, cy, cz, radius, minX, minY, minZ, maxX, maxY, maxZ };
+			i = CullKernels::CullBoundsAVX(corners, arrays, i, end, visible, visibleCount);
+		}
+
+		for (; i + 4 <= end; i += 4)
+		{
+			const __m128 x = _mm_loadu_ps(cx + i), y = _mm_loadu_ps(cy + i), z = _mm_loadu_ps(cz + i);
+			const __m128 negRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(radius + i));
+			const __m128 loX = _mm_loadu_ps(minX + i), loY = _mm_loadu_ps(minY + i), loZ = _mm_loadu_ps(minZ + i);
+			const __m128 hiX = _mm_loadu_ps(maxX + i), hiY = _mm_loadu_ps(maxY + i), hiZ = _mm_loadu_ps(maxZ + i);
+
+			__m128 inside = _mm_cmpeq_ps(_mm_setzero_ps(), _mm_setzero_ps());
+			for (const PlaneCorner& plane : corners)
+			{
+				const __m128 a = _mm_set1_ps(plane.a), b = _mm_set1_ps(plane.b);
+				const __m128 c = _mm_set1_ps(plane.c), d = _mm_set1_ps(plane.d);
+
+				const __m128 centerDistance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a, x), _mm_mul_ps(b, y)),
+					_mm_add_ps(_mm_mul_ps(c, z), d));
+				const __m128 cornerDistance = _mm_add_ps(
+					_mm_add_ps(_mm_mul_ps(a, plane.maxX ? hiX : loX), _mm_mul_ps(b, plane.maxY ? hiY : loY)),
+					_mm_add_ps(_mm_mul_ps(c, plane.maxZ ? hiZ : loZ), d));
+
+				inside = _mm_and_ps(inside, _mm_cmpnlt_ps(centerDistance, negRadius));
+				inside = _mm_and_ps(inside, _mm_cmpnlt_ps(cornerDistance, _mm_setzero_ps()));
+			}
+
+			for (uint32_t mask = static_cast<uint32_t>(_mm_movemask_ps(inside)); mask != 0; mask &= mask - 1)
+			{
+				visible[visibleCount++] = i + static_cast<uint32_t>(std::countr_zero(mask));
+			}
+		}
+#endif
+
+		// tail, or everything without SIMD. NaN bounds pass like they do in the SIMD path
+		for (; i < end; ++i)
+		{
+			if (IsVisibleScalar(corners, cx[i], cy[i], cz[i], radius[i], minX[i], minY[i], minZ[i], maxX[i], maxY[i], maxZ[i]))
+			{
+				visible[visibleCount++] = i;
+			}
+		}
+		return visibleCount;
+	}
+}
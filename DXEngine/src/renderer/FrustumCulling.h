@@ -0,0 +1,70 @@
+#pragma once
+#include <DirectXMath.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "utils/Mesh/Resource/MeshResource.h"
+
+namespace DXEngine {
+
+	// Widest batch CullBounds tests at once (8 with AVX, picked at run time). Ranges split on
+	// multiples of it keep every batch full whichever kernel runs; the same in every build.
+	constexpr uint32_t CullBatchWidth = 8;
+
+	enum class CullResult : uint8_t { Outside, Intersects, Inside };
+
+	// World space frustum as six inward facing planes (a, b, c, d), a point p is inside
+	// a plane when a*p.x + b*p.y + c*p.z + d >= 0. Extracted once per camera, no inverse.
+	struct FrustumPlanes
+	{
+		enum Plane { Left, Right, Bottom, Top, Near, Far, Count };
+		static constexpr uint32_t AllPlanes = (1u << Count) - 1;
+
+		DirectX::XMFLOAT4 planes[Count];
+
+		// D3D clip space (0 <= z <= w), viewProjection = view * projection
+		static FrustumPlanes FromViewProjection(DirectX::FXMMATRIX viewProjection);
+
+		// Single object test, same result as running it through CullBounds
+		bool IsVisible(const BoundingSphere& sphere, const BoundingBox& box) const;
+
+		// Hierarchical test, only planes set in planeMask are tested. Planes the box is fully
+		// inside of are cleared from the mask so the box's children can skip them.
+		CullResult Classify(const BoundingBox& box, uint32_t& planeMask) const;
+	};
+
+	// World bounds in structure of arrays layout, the kernel loads one field of several
+	// objects per instruction. An object is visible when both its sphere and box are.
+	class CullingBounds
+	{
+	public:
+		void Clear();
+		void Reserve(size_t count);
+		uint32_t Add(const BoundingSphere& sphere, const BoundingBox& box);   // returns the index
+		void Resize(size_t count);
+		void Set(uint32_t index, const BoundingSphere& sphere, const BoundingBox& box);
+		BoundingBox GetBox(uint32_t index) const;
+		BoundingSphere GetSphere(uint32_t index) const;
+
+		size_t Size() const { return m_CenterX.size(); }
+		bool Empty() const { return m_CenterX.empty(); }
+
+	private:
+		friend uint32_t CullBounds(const FrustumPlanes& frustum, const CullingBounds& bounds,
+			uint32_t begin, uint32_t end, uint32_t* visible);
+
+		std::vector<float> m_CenterX, m_CenterY, m_CenterZ, m_Radius;
+		std::vector<float> m_MinX, m_MinY, m_MinZ;
+		std::vector<float> m_MaxX, m_MaxY, m_MaxZ;
+	};
+
+	// Local box under an affine row vector matrix: the transformed centre plus |M| * extents.
+	// Tighter than boxing the eight transformed corners and a fraction of the work.
+	BoundingBox TransformBoundingBox(const BoundingBox& box, DirectX::FXMMATRIX matrix);
+
+	// Tests objects [begin, end) and writes the indices of the visible ones, in order, to
+	// visible (room for end - begin). Returns the visible count. Disjoint ranges may run
+	// on different threads at once.
+	uint32_t CullBounds(const FrustumPlanes& frustum, const CullingBounds& bounds,
+		uint32_t begin, uint32_t end, uint32_t* visible);
+}
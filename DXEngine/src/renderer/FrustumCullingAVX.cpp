@@ -0,0 +1,58 @@
+#include "dxpch.h"
+#include "FrustumCullingKernels.h"
+#include <bit>
+
+// the only file built with AVX enabled (see premake5.lua), the rest of the engine stays on the
+// SSE2 baseline and CullBounds only calls in here after CullKernels::HasAVX()
+#if defined(__AVX__)
+#include <immintrin.h>
+#endif
+
+namespace DXEngine {
+
+	namespace CullKernels
+	{
+		uint32_t CullBoundsAVX(const PlaneCorner (&corners)[FrustumPlanes::Count], const BoundsArrays& bounds,
+			uint32_t begin, uint32_t end, uint32_t* visible, uint32_t& visibleCount)
+		{
+			uint32_t i = begin;
+#if defined(__AVX__)
+			for (; i + 8 <= end; i += 8)
+			{
+				const __m256 x = _mm256_loadu_ps(bounds.centerX + i), y = _mm256_loadu_ps(bounds.centerY + i), z = _mm256_loadu_ps(bounds.centerZ + i);
+				const __m256 negRadius = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(bounds.radius + i));
+				const __m256 loX = _mm256_loadu_ps(bounds.minX + i), loY = _mm256_loadu_ps(bounds.minY + i), loZ = _mm256_loadu_ps(bounds.minZ + i);
+				const __m256 hiX = _mm256_loadu_ps(bounds.maxX + i), hiY = _mm256_loadu_ps(bounds.maxY + i), hiZ = _mm256_loadu_ps(bounds.maxZ + i);
+
+				__m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+				for (const PlaneCorner& plane : corners)
+				{
+					const __m256 a = _mm256_set1_ps(plane.a), b = _mm256_set1_ps(plane.b);
+					const __m256 c = _mm256_set1_ps(plane.c), d = _mm256_set1_ps(plane.d);
+
+					const __m256 centerDistance = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(a, x), _mm256_mul_ps(b, y)),
+						_mm256_add_ps(_mm256_mul_ps(c, z), d));
+					const __m256 cornerDistance = _mm256_add_ps(
+						_mm256_add_ps(_mm256_mul_ps(a, plane.maxX ? hiX : loX), _mm256_mul_ps(b, plane.maxY ? hiY : loY)),
+						_mm256_add_ps(_mm256_mul_ps(c, plane.maxZ ? hiZ : loZ), d));
+
+					inside = _mm256_and_ps(inside, _mm256_cmp_ps(centerDistance, negRadius, _CMP_NLT_UQ));
+					inside = _mm256_and_ps(inside, _mm256_cmp_ps(cornerDistance, _mm256_setzero_ps(), _CMP_NLT_UQ));
+				}
+
+				for (uint32_t mask = static_cast<uint32_t>(_mm256_movemask_ps(inside)); mask != 0; mask &= mask - 1)
+				{
+					visible[visibleCount++] = i + static_cast<uint32_t>(std::countr_zero(mask));
+				}
+			}
+#else
+			(void)corners;
+			(void)bounds;
+			(void)end;
+			(void)visible;
+			(void)visibleCount;
+#endif
+			return i;
+		}
+	}
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include "FrustumCulling.h"
+
+namespace DXEngine {
+
+	// Pieces of CullBounds shared with kernels that are built with their own instruction set
+	// flags. Not part of the culling interface, use CullBounds.
+	namespace CullKernels
+	{
+		// plane plus which box corner lies furthest along its normal, false = min, true = max
+		struct PlaneCorner
+		{
+			float a, b, c, d;
+			bool maxX, maxY, maxZ;
+		};
+
+		struct BoundsArrays
+		{
+			const float* centerX;
+			const float* centerY;
+			const float* centerZ;
+			const float* radius;
+			const float* minX;
+			const float* minY;
+			const float* minZ;
+			const float* maxX;
+			const float* maxY;
+			const float* maxZ;
+		};
+
+		void GetPlaneCorners(const FrustumPlanes& frustum, PlaneCorner (&corners)[FrustumPlanes::Count]);
+
+		// true when the CPU and the OS both support AVX, detected on the first call
+		bool HasAVX();
+
+		// Tests objects from begin in steps of 8 while 8 remain and appends the visible ones to
+		// visible[visibleCount]. Returns the first index left untested. Only valid when HasAVX()
+		// is true; a build of FrustumCullingAVX.cpp without AVX enabled tests nothing.
+		uint32_t CullBoundsAVX(const PlaneCorner (&corners)[FrustumPlanes::Count], const BoundsArrays& bounds,
+			uint32_t begin, uint32_t end, uint32_t* visible, uint32_t& visibleCount);
+	}
+}
@@ -0,0 +1,444 @@
+#include "dxpch.h"
+#include "NullDevice.h"
+#include <atomic>
+
+namespace DXEngine
+{
+	namespace
+	{
+		// Reference counting and ID3D11DeviceChild for every handle. Bases lists the
+		// interfaces between ID3D11DeviceChild and Interface, QueryInterface answers those too.
+		template<typename Interface, typename... Bases>
+		class NullDeviceChild : public Interface
+		{
+		public:
+			explicit NullDeviceChild(ID3D11Device* device)
+				: m_Device(device)
+			{
+			}
+
+			virtual ~NullDeviceChild() = default;
+
+			HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void** object) override
+			{
+				if (!object)
+					return E_POINTER;
+
+				if (riid == __uuidof(IUnknown) || riid == __uuidof(ID3D11DeviceChild) ||
+					riid == __uuidof(Interface) || ((riid == __uuidof(Bases)) || ...))
+				{
+					*object = static_cast<Interface*>(this);
+					AddRef();
+					return S_OK;
+				}
+
+				*object = nullptr;
+				return E_NOINTERFACE;
+			}
+
+			ULONG STDMETHODCALLTYPE AddRef() override
+			{
+				return ++m_RefCount;
+			}
+
+			ULONG STDMETHODCALLTYPE Release() override
+			{
+				const ULONG count = --m_RefCount;
+				if (count == 0)
+					delete this;
+				return count;
+			}
+
+			void STDMETHODCALLTYPE GetDevice(ID3D11Device** device) override
+			{
+				m_Device.CopyTo(device);
+			}
+
+			HRESULT STDMETHODCALLTYPE GetPrivateData(REFGUID guid, UINT* dataSize, void* data) override { return DXGI_ERROR_NOT_FOUND; }
+			HRESULT STDMETHODCALLTYPE SetPrivateData(REFGUID guid, UINT dataSize, const void* data) override { return S_OK; }
+			HRESULT STDMETHODCALLTYPE SetPrivateDataInterface(REFGUID guid, const IUnknown* data) override { return S_OK; }
+
+		private:
+			std::atomic<ULONG> m_RefCount{ 1 };
+			Microsoft::WRL::ComPtr<ID3D11Device> m_Device;
+		};
+
+		// Handle that hands back the description it was created with
+		template<typename Interface, typename Desc, typename... Bases>
+		class NullDescribed : public NullDeviceChild<Interface, Bases...>
+		{
+		public:
+			NullDescribed(ID3D11Device* device, const Desc& desc)
+				: NullDeviceChild<Interface, Bases...>(device), m_Desc(desc)
+			{
+			}
+
+			void STDMETHODCALLTYPE GetDesc(Desc* desc) override { *desc = m_Desc; }
+
+		protected:
+			Desc m_Desc;
+		};
+
+		template<typename Interface, typename Desc, D3D11_RESOURCE_DIMENSION Dimension>
+		class NullResource : public NullDescribed<Interface, Desc, ID3D11Resource>
+		{
+		public:
+			using NullDescribed<Interface, Desc, ID3D11Resource>::NullDescribed;
+
+			void STDMETHODCALLTYPE GetType(D3D11_RESOURCE_DIMENSION* dimension) override { *dimension = Dimension; }
+			void STDMETHODCALLTYPE SetEvictionPriority(UINT priority) override { m_EvictionPriority = priority; }
+			UINT STDMETHODCALLTYPE GetEvictionPriority() override { return m_EvictionPriority; }
+
+		private:
+			UINT m_EvictionPriority = DXGI_RESOURCE_PRIORITY_NORMAL;
+		};
+
+		class NullBuffer : public NullResource<ID3D11Buffer, D3D11_BUFFER_DESC, D3D11_RESOURCE_DIMENSION_BUFFER>
+		{
+		public:
+			using NullResource::NullResource;
+
+			// allocated on the first Map, most buffers are never mapped
+			uint8_t* GetStorage()
+			{
+				if (m_Storage.size() < m_Desc.ByteWidth)
+				{
+					m_Storage.resize(m_Desc.ByteWidth);
+				}
+				return m_Storage.data();
+			}
+
+		private:
+			std::vector<uint8_t> m_Storage;
+		};
+
+		using NullTexture1D = NullResource<ID3D11Texture1D, D3D11_TEXTURE1D_DESC, D3D11_RESOURCE_DIMENSION_TEXTURE1D>;
+		using NullTexture2D = NullResource<ID3D11Texture2D, D3D11_TEXTURE2D_DESC, D3D11_RESOURCE_DIMENSION_TEXTURE2D>;
+		using NullTexture3D = NullResource<ID3D11Texture3D, D3D11_TEXTURE3D_DESC, D3D11_RESOURCE_DIMENSION_TEXTURE3D>;
+
+		template<typename Interface, typename Desc>
+		class NullView : public NullDescribed<Interface, Desc, ID3D11View>
+		{
+		public:
+			NullView(ID3D11Device* device, ID3D11Resource* resource, const Desc& desc)
+				: NullDescribed<Interface, Desc, ID3D11View>(device, desc), m_Resource(resource)
+			{
+			}
+
+			void STDMETHODCALLTYPE GetResource(ID3D11Resource** resource) override { m_Resource.CopyTo(resource); }
+
+		private:
+			Microsoft::WRL::ComPtr<ID3D11Resource> m_Resource;
+		};
+
+		class NullQuery : public NullDescribed<ID3D11Query, D3D11_QUERY_DESC, ID3D11Asynchronous>
+		{
+		public:
+			using NullDescribed::NullDescribed;
+
+			// GetData goes through the backend and never copies anything out
+			UINT STDMETHODCALLTYPE GetDataSize() override { return 0; }
+		};
+
+		template<typename Desc>
+		Desc DescOrDefault(const Desc* desc)
+		{
+			return desc ? *desc : Desc{};
+		}
+
+		// A null out pointer only validates the arguments, D3D11 answers S_FALSE then
+		template<typename Handle, typename Interface, typename... Args>
+		HRESULT CreateHandle(Interface** out, Args&&... args)
+		{
+			if (!out)
+				return S_FALSE;
+
+			*out = new Handle(std::forward<Args>(args)...);
+			return S_OK;
+		}
+
+		class NullDevice : public ID3D11Device
+		{
+		public:
+			virtual ~NullDevice() = default;
+
+			HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void** object) override
+			{
+				if (!object)
+					return E_POINTER;
+
+				if (riid == __uuidof(IUnknown) || riid == __uuidof(ID3D11Device))
+				{
+					*object = static_cast<ID3D11Device*>(this);
+					AddRef();
+					return S_OK;
+				}
+
+				*object = nullptr;
+				return E_NOINTERFACE;
+			}
+
+			ULONG STDMETHODCALLTYPE AddRef() override
+			{
+				return ++m_RefCount;
+			}
+
+			ULONG STDMETHODCALLTYPE Release() override
+			{
+				const ULONG count = --m_RefCount;
+				if (count == 0)
+					delete this;
+				return count;
+			}
+
+			// Resources
+			HRESULT STDMETHODCALLTYPE CreateBuffer(const D3D11_BUFFER_DESC* desc, const D3D11_SUBRESOURCE_DATA* initialData, ID3D11Buffer** buffer) override
+			{
+				if (!desc || desc->ByteWidth == 0)
+					return E_INVALIDARG;
+				return CreateHandle<NullBuffer>(buffer, this, *desc);
+			}
+
+			HRESULT STDMETHODCALLTYPE CreateTexture1D(const D3D11_TEXTURE1D_DESC* desc, const D3D11_SUBRESOURCE_DATA* initialData, ID3D11Texture1D** texture) override
+			{
+				if (!desc)
+					return E_INVALIDARG;
+				return CreateHandle<NullTexture1D>(texture, this, *desc);
+			}
+
+			HRESULT STDMETHODCALLTYPE CreateTexture2D(const D3D11_TEXTURE2D_DESC* desc, const D3D11_SUBRESOURCE_DATA* initialData, ID3D11Texture2D** texture) override
+			{
+				if (!desc)
+					return E_INVALIDARG;
+				return CreateHandle<NullTexture2D>(texture, this, *desc);
+			}
+
+			HRESULT STDMETHODCALLTYPE CreateTexture3D(const D3D11_TEXTURE3D_DESC* desc, const D3D11_SUBRESOURCE_DATA* initialData, ID3D11Texture3D** texture) override
+			{
+				if (!desc)
+					return E_INVALIDARG;
+				return CreateHandle<NullTexture3D>(texture, this, *desc);
+			}
+
+			// Views
+			HRESULT STDMETHODCALLTYPE CreateShaderResourceView(ID3D11Resource* resource, const D3D11_SHADER_RESOURCE_VIEW_DESC* desc, ID3D11ShaderResourceView** view) override
+			{
+				if (!resource)
+					return E_INVALIDARG;
+				return CreateHandle<NullView<ID3D11ShaderResourceView, D3D11_SHADER_RESOURCE_VIEW_DESC>>(view, this, resource, DescOrDefault(desc));
+			}
+
+			HRESULT STDMETHODCALLTYPE CreateUnorderedAccessView(ID3D11Resource* resource, const D3D11_UNORDERED_ACCESS_VIEW_DESC* desc, ID3D11UnorderedAccessView** view) override
+			{
+				if (!resource)
+					return E_INVALIDARG;
+				return CreateHandle<NullView<ID3D11UnorderedAccessView, D3D11_UNORDERED_ACCESS_VIEW_DESC>>(view, this, resource, DescOrDefault(desc));
+			}
+
+			HRESULT STDMETHODCALLTYPE CreateRenderTargetView(ID3D11Resource* resource, const D3D11_RENDER_TARGET_VIEW_DESC* desc, ID3D11RenderTargetView** view) override
+			{
+				if (!resource)
+					return E_INVALIDARG;
+				return CreateHandle<NullView<ID3D11RenderTargetView, D3D11_RENDER_TARGET_VIEW_DESC>>(view, this, resource, DescOrDefault(desc));
+			}
+
+			HRESULT STDMETHODCALLTYPE CreateDepthStencilView(ID3D11Resource* resource, const D3D11_DEPTH_STENCIL_VIEW_DESC* desc, ID3D11DepthStencilView** view) override
+			{
+				if (!resource)
+					return E_INVALIDARG;
+				return CreateHandle<NullView<ID3D11DepthStencilView, D3D11_DEPTH_STENCIL_VIEW_DESC>>(view, this, resource, DescOrDefault(desc));
+			}
+
+			// Shaders, the bytecode is not looked at
+			HRESULT STDMETHODCALLTYPE CreateInputLayout(const D3D11_INPUT_ELEMENT_DESC* elements, UINT numElements, const void* bytecode, SIZE_T bytecodeLength, ID3D11InputLayout** layout) override
+			{
+				if (!elements || numElements == 0 || !bytecode || bytecodeLength == 0)
+					return E_INVALIDARG;
+				return CreateHandle<NullDeviceChild<ID3D11InputLayout>>(layout, this);
+			}
+
+			HRESULT STDMETHODCALLTYPE CreateVertexShader(const void* bytecode, SIZE_T bytecodeLength, ID3D11ClassLinkage* linkage, ID3D11VertexShader** shader) override
+			{
+				if (!bytecode || bytecodeLength == 0)
+					return E_INVALIDARG;
+				return CreateHandle<NullDeviceChild<ID3D11VertexShader>>(shader, this);
+			}
+
+			HRESULT STDMETHODCALLTYPE CreateGeometryShader(const void* bytecode, SIZE_T bytecodeLength, ID3D11ClassLinkage* linkage, ID3D11GeometryShader** shader) override
+			{
+				if (!bytecode || bytecodeLength == 0)
+					return E_INVALIDARG;
+				return CreateHandle<NullDeviceChild<ID3D11GeometryShader>>(shader, this);
+			}
+
+			HRESULT STDMETHODCALLTYPE CreateGeometryShaderWithStreamOutput(const void* bytecode, SIZE_T bytecodeLength,
+				const D3D11_SO_DECLARATION_ENTRY* declaration, UINT numEntries, const UINT* bufferStrides, UINT numStrides,
+				UINT rasterizedStream, ID3D11ClassLinkage* linkage, ID3D11GeometryShader** shader) override
+			{
+				return CreateGeometryShader(bytecode, bytecodeLength, linkage, shader);
+			}
+
+			HRESULT STDMETHODCALLTYPE CreatePixelShader(const void* bytecode, SIZE_T bytecodeLength, ID3D11ClassLinkage* linkage, ID3D11PixelShader** shader) override
+			{
+				if (!bytecode || bytecodeLength == 0)
+					return E_INVALIDARG;
+				return CreateHandle<NullDeviceChild<ID3D11PixelShader>>(shader, this);
+			}
+
+			HRESULT STDMETHODCALLTYPE CreateHullShader(const void* bytecode, SIZE_T bytecodeLength, ID3D11ClassLinkage* linkage, ID3D11HullShader** shader) override
+			{
+				if (!bytecode || bytecodeLength == 0)
+					return E_INVALIDARG;
+				return CreateHandle<NullDeviceChild<ID3D11HullShader>>(shader, this);
+			}
+
+			HRESULT STDMETHODCALLTYPE CreateDomainShader(const void* bytecode, SIZE_T bytecodeLength, ID3D11ClassLinkage* linkage, ID3D11DomainShader** shader) override
+			{
+				if (!bytecode || bytecodeLength == 0)
+					return E_INVALIDARG;
+				return CreateHandle<NullDeviceChild<ID3D11DomainShader>>(shader, this);
+			}
+
+			HRESULT STDMETHODCALLTYPE CreateComputeShader(const void* bytecode, SIZE_T bytecodeLength, ID3D11ClassLinkage* linkage, ID3D11ComputeShader** shader) override
+			{
+				if (!bytecode || bytecodeLength == 0)
+					return E_INVALIDARG;
+				return CreateHandle<NullDeviceChild<ID3D11ComputeShader>>(shader, this);
+			}
+
+			HRESULT STDMETHODCALLTYPE CreateClassLinkage(ID3D11ClassLinkage** linkage) override { return E_NOTIMPL; }
+
+			// States
+			HRESULT STDMETHODCALLTYPE CreateBlendState(const D3D11_BLEND_DESC* desc, ID3D11BlendState** state) override
+			{
+				if (!desc)
+					return E_INVALIDARG;
+				return CreateHandle<NullDescribed<ID3D11BlendState, D3D11_BLEND_DESC>>(state, this, *desc);
+			}
+
+			HRESULT STDMETHODCALLTYPE CreateDepthStencilState(const D3D11_DEPTH_STENCIL_DESC* desc, ID3D11DepthStencilState** state) override
+			{
+				if (!desc)
+					return E_INVALIDARG;
+				return CreateHandle<NullDescribed<ID3D11DepthStencilState, D3D11_DEPTH_STENCIL_DESC>>(state, this, *desc);
+			}
+
+			HRESULT STDMETHODCALLTYPE CreateRasterizerState(const D3D11_RASTERIZER_DESC* desc, ID3D11RasterizerState** state) override
+			{
+				if (!desc)
+					return E_INVALIDARG;
+				return CreateHandle<NullDescribed<ID3D11RasterizerState, D3D11_RASTERIZER_DESC>>(state, this, *desc);
+			}
+
+			HRESULT STDMETHODCALLTYPE CreateSamplerState(const D3D11_SAMPLER_DESC* desc, ID3D11SamplerState** state) override
+			{
+				if (!desc)
+					return E_INVALIDARG;
+				return CreateHandle<NullDescribed<ID3D11SamplerState, D3D11_SAMPLER_DESC>>(state, this, *desc);
+			}
+
+			HRESULT STDMETHODCALLTYPE CreateQuery(const D3D11_QUERY_DESC* desc, ID3D11Query** query) override
+			{
+				if (!desc)
+					return E_INVALIDARG;
+				return CreateHandle<NullQuery>(query, this, *desc);
+			}
+
+			HRESULT STDMETHODCALLTYPE CreatePredicate(const D3D11_QUERY_DESC* desc, ID3D11Predicate** predicate) override { return E_NOTIMPL; }
+			HRESULT STDMETHODCALLTYPE CreateCounter(const D3D11_COUNTER_DESC* desc, ID3D11Counter** counter) override { return E_NOTIMPL; }
+			HRESULT STDMETHODCALLTYPE CreateDeferredContext(UINT contextFlags, ID3D11DeviceContext** context) override { return E_NOTIMPL; }
+			HRESULT STDMETHODCALLTYPE OpenSharedResource(HANDLE resource, REFIID returnedInterface, void** object) override { return E_NOTIMPL; }
+
+			// Capabilities, reported like a D3D11.1 driver so the same engine paths run
+			HRESULT STDMETHODCALLTYPE CheckFormatSupport(DXGI_FORMAT format, UINT* formatSupport) override { return E_NOTIMPL; }
+
+			HRESULT STDMETHODCALLTYPE CheckMultisampleQualityLevels(DXGI_FORMAT format, UINT sampleCount, UINT* numQualityLevels) override
+			{
+				if (!numQualityLevels)
+					return E_INVALIDARG;
+				*numQualityLevels = sampleCount == 1 ? 1 : 0;
+				return S_OK;
+			}
+
+			void STDMETHODCALLTYPE CheckCounterInfo(D3D11_COUNTER_INFO* counterInfo) override
+			{
+				if (counterInfo)
+					*counterInfo = {};
+			}
+
+			HRESULT STDMETHODCALLTYPE CheckCounter(const D3D11_COUNTER_DESC* desc, D3D11_COUNTER_TYPE* type, UINT* activeCounters,
+				LPSTR name, UINT* nameLength, LPSTR units, UINT* unitsLength, LPSTR description, UINT* descriptionLength) override
+			{
+				return E_NOTIMPL;
+			}
+
+			HRESULT STDMETHODCALLTYPE CheckFeatureSupport(D3D11_FEATURE feature, void* data, UINT dataSize) override
+			{
+				if (!data)
+					return E_INVALIDARG;
+
+				switch (feature)
+				{
+				case D3D11_FEATURE_THREADING:
+				{
+					if (dataSize != sizeof(D3D11_FEATURE_DATA_THREADING))
+						return E_INVALIDARG;
+					auto* threading = static_cast<D3D11_FEATURE_DATA_THREADING*>(data);
+					threading->DriverConcurrentCreates = TRUE;
+					threading->DriverCommandLists = FALSE;
+					return S_OK;
+				}
+				case D3D11_FEATURE_D3D11_OPTIONS:
+				{
+					if (dataSize != sizeof(D3D11_FEATURE_DATA_D3D11_OPTIONS))
+						return E_INVALIDARG;
+					auto* options = static_cast<D3D11_FEATURE_DATA_D3D11_OPTIONS*>(data);
+					*options = {};
+					options->ConstantBufferOffsetting = TRUE;
+					options->ConstantBufferPartialUpdate = TRUE;
+					options->MapNoOverwriteOnDynamicConstantBuffer = TRUE;
+					return S_OK;
+				}
+				default:
+					return E_INVALIDARG;
+				}
+			}
+
+			HRESULT STDMETHODCALLTYPE GetPrivateData(REFGUID guid, UINT* dataSize, void* data) override { return DXGI_ERROR_NOT_FOUND; }
+			HRESULT STDMETHODCALLTYPE SetPrivateData(REFGUID guid, UINT dataSize, const void* data) override { return S_OK; }
+			HRESULT STDMETHODCALLTYPE SetPrivateDataInterface(REFGUID guid, const IUnknown* data) override { return S_OK; }
+
+			D3D_FEATURE_LEVEL STDMETHODCALLTYPE GetFeatureLevel() override { return D3D_FEATURE_LEVEL_11_1; }
+			UINT STDMETHODCALLTYPE GetCreationFlags() override { return 0; }
+			HRESULT STDMETHODCALLTYPE GetDeviceRemovedReason() override { return S_OK; }
+
+			// there is no immediate context, context work goes through the backend
+			void STDMETHODCALLTYPE GetImmediateContext(ID3D11DeviceContext** context) override
+			{
+				if (context)
+					*context = nullptr;
+			}
+
+			HRESULT STDMETHODCALLTYPE SetExceptionMode(UINT raiseFlags) override { return S_OK; }
+			UINT STDMETHODCALLTYPE GetExceptionMode() override { return 0; }
+
+		private:
+			std::atomic<ULONG> m_RefCount{ 1 };
+		};
+	}
+
+	HRESULT CreateNullDevice(ID3D11Device** device)
+	{
+		if (!device)
+			return E_INVALIDARG;
+
+		*device = new NullDevice();
+		return S_OK;
+	}
+
+	uint8_t* GetNullBufferStorage(ID3D11Buffer* buffer)
+	{
+		auto* nullBuffer = dynamic_cast<NullBuffer*>(buffer);
+		return nullBuffer ? nullBuffer->GetStorage() : nullptr;
+	}
+}
@@ -0,0 +1,14 @@
+#pragma once
+#include "dxpch.h"
+
+namespace DXEngine {
+
+	// Device behind the null backend. Everything it creates is a handle that only keeps its
+	// description, no driver is loaded and nothing is allocated on a GPU. There is no
+	// immediate context, context work goes through NullRenderBackend instead.
+	HRESULT CreateNullDevice(ID3D11Device** device);
+
+	// Memory a null device buffer hands out on Map, ByteWidth bytes owned by that buffer.
+	// nullptr for buffers that did not come from the null device.
+	uint8_t* GetNullBufferStorage(ID3D11Buffer* buffer);
+}
@@ -0,0 +1,195 @@
+#include "dxpch.h"
+#include "NullRenderBackend.h"
+#include "NullDevice.h"
+
+namespace DXEngine
+{
+	namespace
+	{
+		constexpr size_t InitialCommandCapacity = 4096;
+	}
+
+	NullRenderBackend::NullRenderBackend()
+	{
+		m_Commands.reserve(InitialCommandCapacity);
+	}
+
+	void NullRenderBackend::BeginFrame()
+	{
+		// keeps the capacity, steady state frames do not allocate
+		m_Commands.clear();
+		m_Stats = FrameStats{};
+	}
+
+	void NullRenderBackend::EndFrame()
+	{
+		m_LastStats = m_Stats;
+	}
+
+	void NullRenderBackend::Record(RenderCommandOp op, ShaderStage stage, UINT slot, UINT count, UINT instances, const void* object)
+	{
+		m_Stats.commands++;
+		if (m_Recording)
+		{
+			m_Commands.push_back({ op, stage, static_cast<uint16_t>(slot), count, instances, object });
+		}
+	}
+
+	void NullRenderBackend::RecordBind(RenderCommandOp op, ShaderStage stage, UINT slot, UINT count, const void* object)
+	{
+		m_Stats.binds++;
+		Record(op, stage, slot, count, 0, object);
+	}
+
+	void NullRenderBackend::SetRenderTargets(ID3D11RenderTargetView* target, ID3D11DepthStencilView* depth)
+	{
+		RecordBind(RenderCommandOp::SetRenderTargets, ShaderStage::Pixel, 0, target ? 1 : 0, target);
+	}
+
+	void NullRenderBackend::ClearRenderTarget(ID3D11RenderTargetView* target, const float color[4])
+	{
+		Record(RenderCommandOp::ClearRenderTarget, ShaderStage::Pixel, 0, 0, 0, target);
+	}
+
+	void NullRenderBackend::ClearDepthStencil(ID3D11DepthStencilView* depth, float depthValue, UINT8 stencil)
+	{
+		Record(RenderCommandOp::ClearDepthStencil, ShaderStage::Pixel, 0, 0, 0, depth);
+	}
+
+	void NullRenderBackend::SetViewport(const D3D11_VIEWPORT& viewport)
+	{
+		RecordBind(RenderCommandOp::SetViewport, ShaderStage::Pixel, 0, 1, nullptr);
+	}
+
+	void NullRenderBackend::SetVertexBuffers(UINT startSlot, UINT count, ID3D11Buffer* const* buffers, const UINT* strides, const UINT* offsets)
+	{
+		RecordBind(RenderCommandOp::SetVertexBuffers, ShaderStage::Vertex, startSlot, count, buffers[0]);
+	}
+
+	void NullRenderBackend::SetIndexBuffer(ID3D11Buffer* buffer, DXGI_FORMAT format, UINT offset)
+	{
+		RecordBind(RenderCommandOp::SetIndexBuffer, ShaderStage::Vertex, 0, 1, buffer);
+	}
+
+	void NullRenderBackend::SetInputLayout(ID3D11InputLayout* layout)
+	{
+		RecordBind(RenderCommandOp::SetInputLayout, ShaderStage::Vertex, 0, 1, layout);
+	}
+
+	void NullRenderBackend::SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY topology)
+	{
+		RecordBind(RenderCommandOp::SetPrimitiveTopology, ShaderStage::Vertex, 0, static_cast<UINT>(topology), nullptr);
+	}
+
+	void NullRenderBackend::SetVertexShader(ID3D11VertexShader* shader)
+	{
+		RecordBind(RenderCommandOp::SetVertexShader, ShaderStage::Vertex, 0, 1, shader);
+	}
+
+	void NullRenderBackend::SetPixelShader(ID3D11PixelShader* shader)
+	{
+		RecordBind(RenderCommandOp::SetPixelShader, ShaderStage::Pixel, 0, 1, shader);
+	}
+
+	void NullRenderBackend::SetConstantBuffer(ShaderStage stage, UINT slot, ID3D11Buffer* buffer)
+	{
+		RecordBind(RenderCommandOp::SetConstantBuffer, stage, slot, 1, buffer);
+	}
+
+	bool NullRenderBackend::SetConstantBufferRange(ShaderStage stage, UINT slot, ID3D11Buffer* buffer, UINT firstConstant, UINT numConstants)
+	{
+		// behaves like a D3D11.1 context so the ring path is exercised
+		RecordBind(RenderCommandOp::SetConstantBuffer, stage, slot, 1, buffer);
+		return true;
+	}
+
+	void NullRenderBackend::SetShaderResource(ShaderStage stage, UINT slot, ID3D11ShaderResourceView* view)
+	{
+		RecordBind(RenderCommandOp::SetShaderResource, stage, slot, 1, view);
+	}
+
+	void NullRenderBackend::SetSamplers(ShaderStage stage, UINT startSlot, UINT count, ID3D11SamplerState* const* samplers)
+	{
+		RecordBind(RenderCommandOp::SetSamplers, stage, startSlot, count, samplers[0]);
+	}
+
+	void NullRenderBackend::SetRasterizerState(ID3D11RasterizerState* state)
+	{
+		RecordBind(RenderCommandOp::SetRasterizerState, ShaderStage::Pixel, 0, 1, state);
+	}
+
+	void NullRenderBackend::SetDepthStencilState(ID3D11DepthStencilState* state, UINT stencilRef)
+	{
+		RecordBind(RenderCommandOp::SetDepthStencilState, ShaderStage::Pixel, 0, 1, state);
+	}
+
+	void NullRenderBackend::SetBlendState(ID3D11BlendState* state)
+	{
+		RecordBind(RenderCommandOp::SetBlendState, ShaderStage::Pixel, 0, 1, state);
+	}
+
+	void NullRenderBackend::Draw(UINT vertexCount, UINT startVertex)
+	{
+		m_Stats.draws++;
+		m_Stats.elements += vertexCount;
+		m_Stats.instances++;
+		Record(RenderCommandOp::Draw, ShaderStage::Vertex, 0, vertexCount, 1, nullptr);
+	}
+
+	void NullRenderBackend::DrawIndexed(UINT indexCount, UINT startIndex, INT baseVertex)
+	{
+		m_Stats.draws++;
+		m_Stats.elements += indexCount;
+		m_Stats.instances++;
+		Record(RenderCommandOp::DrawIndexed, ShaderStage::Vertex, 0, indexCount, 1, nullptr);
+	}
+
+	void NullRenderBackend::DrawInstanced(UINT vertexCount, UINT instanceCount, UINT startVertex, UINT startInstance)
+	{
+		m_Stats.draws++;
+		m_Stats.elements += static_cast<uint64_t>(vertexCount) * instanceCount;
+		m_Stats.instances += instanceCount;
+		Record(RenderCommandOp::DrawInstanced, ShaderStage::Vertex, 0, vertexCount, instanceCount, nullptr);
+	}
+
+	void NullRenderBackend::DrawIndexedInstanced(UINT indexCount, UINT instanceCount, UINT startIndex, INT baseVertex, UINT startInstance)
+	{
+		m_Stats.draws++;
+		m_Stats.elements += static_cast<uint64_t>(indexCount) * instanceCount;
+		m_Stats.instances += instanceCount;
+		Record(RenderCommandOp::DrawIndexedInstanced, ShaderStage::Vertex, 0, indexCount, instanceCount, nullptr);
+	}
+
+	HRESULT NullRenderBackend::Map(ID3D11Buffer* buffer, D3D11_MAP mapType, D3D11_MAPPED_SUBRESOURCE& mapped)
+	{
+		if (!buffer)
+			return E_INVALIDARG;
+
+		// each buffer keeps its own memory, so NO_OVERWRITE maps see earlier writes
+		uint8_t* storage = GetNullBufferStorage(buffer);
+		if (!storage)
+			return E_INVALIDARG;
+
+		D3D11_BUFFER_DESC desc = {};
+		buffer->GetDesc(&desc);
+
+		mapped.pData = storage;
+		mapped.RowPitch = desc.ByteWidth;
+		mapped.DepthPitch = desc.ByteWidth;
+		return S_OK;
+	}
+
+	void NullRenderBackend::Unmap(ID3D11Buffer* buffer, UINT bytesWritten)
+	{
+		m_Stats.uploads++;
+		m_Stats.uploadBytes += bytesWritten;
+		Record(RenderCommandOp::Upload, ShaderStage::Vertex, 0, bytesWritten, 0, buffer);
+	}
+
+	void NullRenderBackend::UpdateSubresource(ID3D11Buffer* buffer, const D3D11_BOX* box, const void* data, UINT bytes)
+	{
+		m_Stats.uploads++;
+		m_Stats.uploadBytes += bytes;
+		Record(RenderCommandOp::Upload, ShaderStage::Vertex, 0, bytes, 0, buffer);
+	}
+}
@@ -0,0 +1,118 @@
+#pragma once
+#include "RenderBackend.h"
+
+namespace DXEngine {
+
+	enum class RenderCommandOp : uint8_t
+	{
+		SetRenderTargets,
+		ClearRenderTarget,
+		ClearDepthStencil,
+		SetViewport,
+		SetVertexBuffers,
+		SetIndexBuffer,
+		SetInputLayout,
+		SetPrimitiveTopology,
+		SetVertexShader,
+		SetPixelShader,
+		SetConstantBuffer,
+		SetShaderResource,
+		SetSamplers,
+		SetRasterizerState,
+		SetDepthStencilState,
+		SetBlendState,
+		Draw,
+		DrawIndexed,
+		DrawInstanced,
+		DrawIndexedInstanced,
+		Upload,
+	};
+
+	// One recorded context call. object is the bound or written resource, only ever compared.
+	struct RecordedCommand
+	{
+		RenderCommandOp op;
+		ShaderStage stage;
+		uint16_t slot;
+		uint32_t count;       // vertices/indices for draws, bindings for binds, bytes for uploads
+		uint32_t instances;
+		const void* object;
+	};
+
+	// Records the filtered command stream instead of executing it, so the whole renderer
+	// can run without a GPU. Resources are handles from CreateNullDevice, mapping a buffer
+	// hands out memory owned by that buffer.
+	class NullRenderBackend : public RenderBackend
+	{
+	public:
+		struct FrameStats
+		{
+			uint32_t commands = 0;
+			uint32_t draws = 0;
+			uint32_t binds = 0;
+			uint32_t uploads = 0;
+			uint64_t uploadBytes = 0;
+			uint64_t elements = 0;    // indices or vertices submitted
+			uint64_t instances = 0;
+		};
+
+		NullRenderBackend();
+
+		RenderBackendType GetType() const override { return RenderBackendType::Null; }
+
+		void BeginFrame() override;
+		void EndFrame() override;
+
+		void SetRenderTargets(ID3D11RenderTargetView* target, ID3D11DepthStencilView* depth) override;
+		void ClearRenderTarget(ID3D11RenderTargetView* target, const float color[4]) override;
+		void ClearDepthStencil(ID3D11DepthStencilView* depth, float depthValue, UINT8 stencil) override;
+		void SetViewport(const D3D11_VIEWPORT& viewport) override;
+
+		void SetVertexBuffers(UINT startSlot, UINT count, ID3D11Buffer* const* buffers, const UINT* strides, const UINT* offsets) override;
+		void SetIndexBuffer(ID3D11Buffer* buffer, DXGI_FORMAT format, UINT offset) override;
+		void SetInputLayout(ID3D11InputLayout* layout) override;
+		void SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY topology) override;
+		void SetVertexShader(ID3D11VertexShader* shader) override;
+		void SetPixelShader(ID3D11PixelShader* shader) override;
+		void SetConstantBuffer(ShaderStage stage, UINT slot, ID3D11Buffer* buffer) override;
+		bool SetConstantBufferRange(ShaderStage stage, UINT slot, ID3D11Buffer* buffer, UINT firstConstant, UINT numConstants) override;
+		bool SupportsConstantBufferRanges() const override { return true; }
+		void SetShaderResource(ShaderStage stage, UINT slot, ID3D11ShaderResourceView* view) override;
+		void SetSamplers(ShaderStage stage, UINT startSlot, UINT count, ID3D11SamplerState* const* samplers) override;
+		void SetRasterizerState(ID3D11RasterizerState* state) override;
+		void SetDepthStencilState(ID3D11DepthStencilState* state, UINT stencilRef) override;
+		void SetBlendState(ID3D11BlendState* state) override;
+
+		void Draw(UINT vertexCount, UINT startVertex) override;
+		void DrawIndexed(UINT indexCount, UINT startIndex, INT baseVertex) override;
+		void DrawInstanced(UINT vertexCount, UINT instanceCount, UINT startVertex, UINT startInstance) override;
+		void DrawIndexedInstanced(UINT indexCount, UINT instanceCount, UINT startIndex, INT baseVertex, UINT startInstance) override;
+
+		HRESULT Map(ID3D11Buffer* buffer, D3D11_MAP mapType, D3D11_MAPPED_SUBRESOURCE& mapped) override;
+		void Unmap(ID3D11Buffer* buffer, UINT bytesWritten) override;
+		void UpdateSubresource(ID3D11Buffer* buffer, const D3D11_BOX* box, const void* data, UINT bytes) override;
+
+		void EndQuery(ID3D11Query* query) override {}
+		HRESULT GetQueryData(ID3D11Query* query, UINT flags) override { return S_OK; }
+
+		// Commands since the last BeginFrame
+		const std::vector<RecordedCommand>& GetCommands() const { return m_Commands; }
+		const FrameStats& GetFrameStats() const { return m_Stats; }
+		// Stats of the last frame closed by EndFrame
+		const FrameStats& GetLastFrameStats() const { return m_LastStats; }
+
+		// Off by default keeps only the counters, useful for long benchmark runs
+		void SetRecording(bool enabled) { m_Recording = enabled; }
+		bool IsRecording() const { return m_Recording; }
+
+	private:
+		void Record(RenderCommandOp op, ShaderStage stage, UINT slot, UINT count, UINT instances, const void* object);
+		void RecordBind(RenderCommandOp op, ShaderStage stage, UINT slot, UINT count, const void* object);
+
+	private:
+		std::vector<RecordedCommand> m_Commands;
+		FrameStats m_Stats;
+		FrameStats m_LastStats;
+		bool m_Recording = true;
+	};
+}
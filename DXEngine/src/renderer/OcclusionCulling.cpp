@@ -0,0 +1,534 @@
+#include "dxpch.h"
+#include "OcclusionCulling.h"
+#include "utils/WorkerPool.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <functional>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <xmmintrin.h>
+#endif
+
+namespace DXEngine {
+
+	namespace
+	{
+		// point where the edge a-b crosses the near plane z = 0
+		DirectX::XMFLOAT4 NearPlaneIntersection(const DirectX::XMFLOAT4& a, const DirectX::XMFLOAT4& b)
+		{
+			const float t = a.z / (a.z - b.z);
+			return { a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t, 0.0f, a.w + (b.w - a.w) * t };
+		}
+	}
+
+	OcclusionBuffer::OcclusionBuffer(const OcclusionConfig& config)
+		: m_Config(config)
+	{
+		m_TilesX = std::max(1u, (config.width + TileWidth - 1) / TileWidth);
+		m_TilesY = std::max(1u, (config.height + TileHeight - 1) / TileHeight);
+		m_Width = m_TilesX * TileWidth;
+		m_Height = m_TilesY * TileHeight;
+		m_TileBins.resize(static_cast<size_t>(m_TilesX) * m_TilesY);
+
+		for (uint32_t width = m_Width, height = m_Height; ; width = (width + 1) / 2, height = (height + 1) / 2)
+		{
+			m_Pyramid.emplace_back(static_cast<size_t>(width) * height, 1.0f);
+			m_LevelWidths.push_back(width);
+			m_LevelHeights.push_back(height);
+			if (width == 1 && height == 1)
+				break;
+		}
+		DirectX::XMStoreFloat4x4(&m_ViewProjection, DirectX::XMMatrixIdentity());
+	}
+
+	void OcclusionBuffer::BeginFrame(DirectX::FXMMATRIX viewProjection)
+	{
+		DirectX::XMStoreFloat4x4(&m_ViewProjection, viewProjection);
+		m_Queue.clear();
+		m_TrianglesAccepted = 0;
+		m_Stats = Stats{};
+
+		//nothing to clear when the last frame never rasterized
+		if (m_HasDepth)
+		{
+			for (std::vector<float>& level : m_Pyramid)
+			{
+				std::fill(level.begin(), level.end(), 1.0f);
+			}
+			m_HasDepth = false;
+		}
+	}
+
+	void OcclusionBuffer::AddOccluder(const MeshResource& mesh, DirectX::FXMMATRIX world)
+	{
+		const VertexData* vertices = mesh.GetVertexData();
+		if (!vertices || vertices->GetVertexCount() < 3 || mesh.GetTopology() != PrimitiveTopology::TriangleList)
+			return;
+
+		const VertexAttribute* position = vertices->GetLayout().FindAttribute(VertexAttributeType::Position);
+		if (!position || position->Format != DataFormat::Float3)
+			return;
+
+		Occluder occluder;
+		occluder.mesh = &mesh;
+		const DirectX::XMMATRIX worldViewProjection = DirectX::XMMatrixMultiply(world, DirectX::XMLoadFloat4x4(&m_ViewProjection));
+		DirectX::XMStoreFloat4x4(&occluder.worldViewProjection, worldViewProjection);
+
+		const BoundingBox& box = mesh.GetBoundingBox();
+		if (box.min.x <= box.max.x)
+		{
+			const DirectX::XMFLOAT3 center = box.GetCenter();
+			const DirectX::XMVECTOR clip = DirectX::XMVector3Transform(DirectX::XMLoadFloat3(&center), worldViewProjection);
+			occluder.distance = std::max(0.0f, DirectX::XMVectorGetW(clip));
+		}
+
+		const size_t indexCount = mesh.HasIndices() ? mesh.GetIndexData()->GetIndexCount() : vertices->GetVertexCount();
+		occluder.triangleCount = static_cast<uint32_t>(indexCount / 3);
+		m_Queue.push_back(occluder);
+	}
+
+	void OcclusionBuffer::Rasterize(WorkerPool* pool)
+	{
+		if (m_Queue.empty())
+			return;
+
+		//nearest first, whatever does not fit the budget is the least likely to hide anything
+		std::stable_sort(m_Queue.begin(), m_Queue.end(),
+			[](const Occluder& a, const Occluder& b) { return a.distance < b.distance; });
+
+		size_t accepted = 0;
+		for (const Occluder& occluder : m_Queue)
+		{
+			if (m_TrianglesAccepted + occluder.triangleCount > m_Config.maxTriangles)
+			{
+				m_Stats.trianglesSkipped += occluder.triangleCount;
+				continue;
+			}
+			m_TrianglesAccepted += occluder.triangleCount;
+			m_Queue[accepted++] = occluder;
+		}
+		m_Queue.resize(accepted);
+		m_Stats.occluders += static_cast<uint32_t>(accepted);
+
+		if (m_OccluderTriangles.size() < accepted)
+		{
+			m_OccluderTriangles.resize(accepted);
+		}
+		const std::function<void(uint32_t)> setup = [this](uint32_t index)
+			{
+				SetupOccluder(m_Queue[index], m_OccluderTriangles[index]);
+			};
+		if (pool)
+		{
+			pool->ParallelFor(static_cast<uint32_t>(accepted), setup);
+		}
+		else
+		{
+			for (uint32_t i = 0; i < accepted; ++i)
+			{
+				setup(i);
+			}
+		}
+		m_Queue.clear();
+
+		m_Triangles.clear();
+		for (size_t i = 0; i < accepted; ++i)
+		{
+			m_Triangles.insert(m_Triangles.end(), m_OccluderTriangles[i].begin(), m_OccluderTriangles[i].end());
+		}
+		if (m_Triangles.empty())
+			return;
+		m_Stats.triangles += static_cast<uint32_t>(m_Triangles.size());
+
+		//each tile owns its pixels, so tiles rasterize in parallel without sharing anything
+		for (std::vector<uint32_t>& bin : m_TileBins)
+		{
+			bin.clear();
+		}
+		for (uint32_t i = 0; i < m_Triangles.size(); ++i)
+		{
+			const ScreenTriangle& triangle = m_Triangles[i];
+			for (int32_t ty = triangle.minY / static_cast<int32_t>(TileHeight); ty <= triangle.maxY / static_cast<int32_t>(TileHeight); ++ty)
+			{
+				for (int32_t tx = triangle.minX / static_cast<int32_t>(TileWidth); tx <= triangle.maxX / static_cast<int32_t>(TileWidth); ++tx)
+				{
+					m_TileBins[static_cast<size_t>(ty) * m_TilesX + tx].push_back(i);
+				}
+			}
+		}
+
+		const std::function<void(uint32_t)> rasterizeTile = [this](uint32_t tile) { RasterizeTile(tile); };
+		const uint32_t tileCount = m_TilesX * m_TilesY;
+		if (pool)
+		{
+			pool->ParallelFor(tileCount, rasterizeTile);
+		}
+		else
+		{
+			for (uint32_t tile = 0; tile < tileCount; ++tile)
+			{
+				rasterizeTile(tile);
+			}
+		}
+
+		BuildPyramid();
+		m_HasDepth = true;
+	}
+
+	void OcclusionBuffer::SetupOccluder(const Occluder& occluder, std::vector<ScreenTriangle>& out) const
+	{
+		out.clear();
+
+		const MeshResource& mesh = *occluder.mesh;
+		const VertexData* vertices = mesh.GetVertexData();
+		const VertexLayout& layout = vertices->GetLayout();
+		const VertexAttribute* position = layout.FindAttribute(VertexAttributeType::Position);
+		const uint8_t* positions = static_cast<const uint8_t*>(vertices->GetVertexData(position->Slot)) + position->Offset;
+		const size_t stride = layout.GetStride(position->Slot);
+		const size_t vertexCount = vertices->GetVertexCount();
+
+		//every vertex to clip space once, triangles share them through the indices
+		thread_local std::vector<DirectX::XMFLOAT4> t_Clip;
+		t_Clip.resize(vertexCount);
+		const DirectX::XMMATRIX matrix = DirectX::XMLoadFloat4x4(&occluder.worldViewProjection);
+		for (size_t i = 0; i < vertexCount; ++i)
+		{
+			DirectX::XMFLOAT3 point;
+			std::memcpy(&point, positions + i * stride, sizeof(point));
+			DirectX::XMStoreFloat4(&t_Clip[i], DirectX::XMVector3Transform(DirectX::XMLoadFloat3(&point), matrix));
+		}
+
+		if (!mesh.HasIndices())
+		{
+			for (size_t i = 0; i + 2 < vertexCount; i += 3)
+			{
+				ClipTriangle(t_Clip[i], t_Clip[i + 1], t_Clip[i + 2], out);
+			}
+			return;
+		}
+
+		//submesh indices are relative to their vertexStart, a mesh without submeshes is one range at 0
+		const IndexData& indices = *mesh.GetIndexData();
+		const size_t indexCount = indices.GetIndexCount();
+		const bool wide = indices.GetIndexType() == IndexType::UInt32;
+		const void* indexData = indices.GetData();
+		auto drawRange = [&](size_t indexStart, size_t rangeCount, size_t vertexStart)
+			{
+				const size_t indexEnd = std::min(indexCount, indexStart + rangeCount);
+				for (size_t i = indexStart; i + 2 < indexEnd; i += 3)
+				{
+					size_t corner[3];
+					for (size_t k = 0; k < 3; ++k)
+					{
+						corner[k] = vertexStart + (wide ? static_cast<const uint32_t*>(indexData)[i + k] : static_cast<const uint16_t*>(indexData)[i + k]);
+					}
+					if (corner[0] < vertexCount && corner[1] < vertexCount && corner[2] < vertexCount)
+					{
+						ClipTriangle(t_Clip[corner[0]], t_Clip[corner[1]], t_Clip[corner[2]], out);
+					}
+				}
+			};
+
+		if (mesh.HasSubmeshes())
+		{
+			for (const SubMesh& submesh : mesh.GetSubMeshes())
+			{
+				drawRange(submesh.indexStart, submesh.indexCount, submesh.vertexStart);
+			}
+		}
+		else
+		{
+			drawRange(0, indexCount, 0);
+		}
+	}
+
+	void OcclusionBuffer::ClipTriangle(const DirectX::XMFLOAT4& a, const DirectX::XMFLOAT4& b, const DirectX::XMFLOAT4& c,
+		std::vector<ScreenTriangle>& out) const
+	{
+		const DirectX::XMFLOAT4* input[3] = { &a, &b, &c };
+		uint32_t insideCount = 0;
+		for (const DirectX::XMFLOAT4* vertex : input)
+		{
+			insideCount += vertex->z >= 0.0f ? 1 : 0;
+		}
+
+		if (insideCount == 3)
+		{
+			EmitTriangle(a, b, c, out);
+			return;
+		}
+		if (insideCount == 0)
+			return;
+
+		//only the near plane is clipped, the sides are handled by the pixel bounds
+		DirectX::XMFLOAT4 polygon[4];
+		uint32_t count = 0;
+		for (uint32_t i = 0; i < 3; ++i)
+		{
+			const DirectX::XMFLOAT4& current = *input[i];
+			const DirectX::XMFLOAT4& next = *input[(i + 1) % 3];
+			const bool currentInside = current.z >= 0.0f;
+			if (currentInside)
+			{
+				polygon[count++] = current;
+			}
+			if (currentInside != (next.z >= 0.0f))
+			{
+				polygon[count++] = NearPlaneIntersection(current, next);
+			}
+		}
+
+		for (uint32_t i = 2; i < count; ++i)
+		{
+			EmitTriangle(polygon[0], polygon[i - 1], polygon[i], out);
+		}
+	}
+
+	void OcclusionBuffer::EmitTriangle(const DirectX::XMFLOAT4& a, const DirectX::XMFLOAT4& b, const DirectX::XMFLOAT4& c,
+		std::vector<ScreenTriangle>& out) const
+	{
+		//pixel space, y down, depth in [0, 1]
+		float x[3], y[3], z[3];
+		const DirectX::XMFLOAT4* vertices[3] = { &a, &b, &c };
+		for (int i = 0; i < 3; ++i)
+		{
+			const DirectX::XMFLOAT4& vertex = *vertices[i];
+			if (vertex.w <= 0.0f)
+				return;
+			const float invW = 1.0f / vertex.w;
+			x[i] = (vertex.x * invW * 0.5f + 0.5f) * static_cast<float>(m_Width);
+			y[i] = (0.5f - vertex.y * invW * 0.5f) * static_cast<float>(m_Height);
+			z[i] = vertex.z * invW;
+		}
+
+		//behind the far plane everywhere, the cleared buffer is already nearer
+		if (z[0] >= 1.0f && z[1] >= 1.0f && z[2] >= 1.0f)
+			return;
+
+		const float area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+		if (std::fabs(area) < 1e-6f)
+			return;
+
+		//pixel centres at i + 0.5 inside the triangle's bounds
+		ScreenTriangle triangle;
+		const float minX = std::min({ x[0], x[1], x[2] }), maxX = std::max({ x[0], x[1], x[2] });
+		const float minY = std::min({ y[0], y[1], y[2] }), maxY = std::max({ y[0], y[1], y[2] });
+		if (maxX < 0.0f || maxY < 0.0f || minX > static_cast<float>(m_Width) || minY > static_cast<float>(m_Height))
+			return;
+		triangle.minX = std::max(0, static_cast<int32_t>(std::ceil(minX - 0.5f)));
+		triangle.minY = std::max(0, static_cast<int32_t>(std::ceil(minY - 0.5f)));
+		triangle.maxX = std::min(static_cast<int32_t>(m_Width) - 1, static_cast<int32_t>(std::floor(maxX - 0.5f)));
+		triangle.maxY = std::min(static_cast<int32_t>(m_Height) - 1, static_cast<int32_t>(std::floor(maxY - 0.5f)));
+		if (triangle.minX > triangle.maxX || triangle.minY > triangle.maxY)
+			return;
+
+		//edge i runs from vertex i to i + 1, flipped so the inside is positive for either winding
+		const float sign = area > 0.0f ? 1.0f : -1.0f;
+		for (int i = 0; i < 3; ++i)
+		{
+			const int j = (i + 1) % 3;
+			triangle.edgeA[i] = (y[i] - y[j]) * sign;
+			triangle.edgeB[i] = (x[j] - x[i]) * sign;
+			triangle.edgeC[i] = (x[i] * y[j] - x[j] * y[i]) * sign;
+		}
+
+		triangle.depthA = ((z[1] - z[0]) * (y[2] - y[0]) - (z[2] - z[0]) * (y[1] - y[0])) / area;
+		triangle.depthB = ((x[1] - x[0]) * (z[2] - z[0]) - (x[2] - x[0]) * (z[1] - z[0])) / area;
+		triangle.depthC = z[0] - triangle.depthA * x[0] - triangle.depthB * y[0];
+		triangle.minDepth = std::min({ z[0], z[1], z[2] });
+		out.push_back(triangle);
+	}
+
+	void OcclusionBuffer::RasterizeTile(uint32_t tile)
+	{
+		const int32_t tileMinX = static_cast<int32_t>((tile % m_TilesX) * TileWidth);
+		const int32_t tileMinY = static_cast<int32_t>((tile / m_TilesX) * TileHeight);
+		const int32_t tileMaxX = tileMinX + static_cast<int32_t>(TileWidth) - 1;
+		const int32_t tileMaxY = tileMinY + static_cast<int32_t>(TileHeight) - 1;
+		float* depth = m_Pyramid[0].data();
+
+		//occluders arrive near to far, so a triangle behind everything already in the tile is skipped
+		float tileFarthest = 1.0f;
+		uint32_t sinceRefresh = 0;
+
+		for (uint32_t index : m_TileBins[tile])
+		{
+			const ScreenTriangle& triangle = m_Triangles[index];
+			if (triangle.minDepth >= tileFarthest)
+				continue;
+
+			const int32_t minY = std::max(triangle.minY, tileMinY);
+			const int32_t maxY = std::min(triangle.maxY, tileMaxY);
+			const int32_t maxX = std::min(triangle.maxX, tileMaxX);
+			int32_t minX = std::max(triangle.minX, tileMinX);
+
+			for (int32_t py = minY; py <= maxY; ++py)
+			{
+				const float centerY = static_cast<float>(py) + 0.5f;
+				const float rowEdge0 = triangle.edgeB[0] * centerY + triangle.edgeC[0];
+				const float rowEdge1 = triangle.edgeB[1] * centerY + triangle.edgeC[1];
+				const float rowEdge2 = triangle.edgeB[2] * centerY + triangle.edgeC[2];
+				const float rowDepth = triangle.depthB * centerY + triangle.depthC;
+				float* row = depth + static_cast<size_t>(py) * m_Width;
+				int32_t px = minX;
+
+#if defined(__AVX__)
+				//rows of 8 pixels from an aligned start, tiles are a multiple of 8 wide
+				px &= ~7;
+				const __m256 offsets = _mm256_setr_ps(0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f);
+				const __m256 a0 = _mm256_set1_ps(triangle.edgeA[0]), a1 = _mm256_set1_ps(triangle.edgeA[1]), a2 = _mm256_set1_ps(triangle.edgeA[2]);
+				const __m256 r0 = _mm256_set1_ps(rowEdge0), r1 = _mm256_set1_ps(rowEdge1), r2 = _mm256_set1_ps(rowEdge2);
+				const __m256 depthA = _mm256_set1_ps(triangle.depthA), depthRow = _mm256_set1_ps(rowDepth);
+				const __m256 zero = _mm256_setzero_ps();
+				for (; px <= maxX; px += 8)
+				{
+					const __m256 centerX = _mm256_add_ps(_mm256_set1_ps(static_cast<float>(px)), offsets);
+					const __m256 inside = _mm256_and_ps(
+						_mm256_and_ps(_mm256_cmp_ps(_mm256_add_ps(_mm256_mul_ps(a0, centerX), r0), zero, _CMP_GE_OQ),
+							_mm256_cmp_ps(_mm256_add_ps(_mm256_mul_ps(a1, centerX), r1), zero, _CMP_GE_OQ)),
+						_mm256_cmp_ps(_mm256_add_ps(_mm256_mul_ps(a2, centerX), r2), zero, _CMP_GE_OQ));
+					if (_mm256_movemask_ps(inside) == 0)
+						continue;
+
+					const __m256 z = _mm256_add_ps(_mm256_mul_ps(depthA, centerX), depthRow);
+					const __m256 stored = _mm256_loadu_ps(row + px);
+					_mm256_storeu_ps(row + px, _mm256_blendv_ps(stored, _mm256_min_ps(stored, z), inside));
+				}
+#elif defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+				px &= ~3;
+				const __m128 offsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+				const __m128 a0 = _mm_set1_ps(triangle.edgeA[0]), a1 = _mm_set1_ps(triangle.edgeA[1]), a2 = _mm_set1_ps(triangle.edgeA[2]);
+				const __m128 r0 = _mm_set1_ps(rowEdge0), r1 = _mm_set1_ps(rowEdge1), r2 = _mm_set1_ps(rowEdge2);
+				const __m128 depthA = _mm_set1_ps(triangle.depthA), depthRow = _mm_set1_ps(rowDepth);
+				const __m128 zero = _mm_setzero_ps();
+				for (; px <= maxX; px += 4)
+				{
+					const __m128 centerX = _mm_add_ps(_mm_set1_ps(static_cast<float>(px)), offsets);
+					const __m128 inside = _mm_and_ps(
+						_mm_and_ps(_mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(a0, centerX), r0), zero),
+							_mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(a1, centerX), r1), zero)),
+						_mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(a2, centerX), r2), zero));
+					if (_mm_movemask_ps(inside) == 0)
+						continue;
+
+					const __m128 z = _mm_add_ps(_mm_mul_ps(depthA, centerX), depthRow);
+					const __m128 stored = _mm_loadu_ps(row + px);
+					const __m128 nearest = _mm_min_ps(stored, z);
+					_mm_storeu_ps(row + px, _mm_or_ps(_mm_and_ps(inside, nearest), _mm_andnot_ps(inside, stored)));
+				}
+#else
+				for (; px <= maxX; ++px)
+				{
+					const float centerX = static_cast<float>(px) + 0.5f;
+					if (triangle.edgeA[0] * centerX + rowEdge0 < 0.0f ||
+						triangle.edgeA[1] * centerX + rowEdge1 < 0.0f ||
+						triangle.edgeA[2] * centerX + rowEdge2 < 0.0f)
+						continue;
+
+					row[px] = std::min(row[px], triangle.depthA * centerX + rowDepth);
+				}
+#endif
+			}
+
+			if (++sinceRefresh == TileRefreshInterval)
+			{
+				sinceRefresh = 0;
+				tileFarthest = 0.0f;
+				for (int32_t py = tileMinY; py <= tileMaxY; ++py)
+				{
+					const float* row = depth + static_cast<size_t>(py) * m_Width;
+					tileFarthest = std::max(tileFarthest, *std::max_element(row + tileMinX, row + tileMaxX + 1));
+				}
+			}
+		}
+	}
+
+	void OcclusionBuffer::BuildPyramid()
+	{
+		for (size_t level = 1; level < m_Pyramid.size(); ++level)
+		{
+			const std::vector<float>& below = m_Pyramid[level - 1];
+			const uint32_t belowWidth = m_LevelWidths[level - 1];
+			const uint32_t belowHeight = m_LevelHeights[level - 1];
+			std::vector<float>& current = m_Pyramid[level];
+			const uint32_t width = m_LevelWidths[level];
+			const uint32_t height = m_LevelHeights[level];
+
+			//odd sizes repeat the last row or column
+			for (uint32_t y = 0; y < height; ++y)
+			{
+				const size_t row0 = static_cast<size_t>(std::min(y * 2, belowHeight - 1)) * belowWidth;
+				const size_t row1 = static_cast<size_t>(std::min(y * 2 + 1, belowHeight - 1)) * belowWidth;
+				for (uint32_t x = 0; x < width; ++x)
+				{
+					const uint32_t x0 = std::min(x * 2, belowWidth - 1);
+					const uint32_t x1 = std::min(x * 2 + 1, belowWidth - 1);
+					current[static_cast<size_t>(y) * width + x] =
+						std::max(std::max(below[row0 + x0], below[row0 + x1]), std::max(below[row1 + x0], below[row1 + x1]));
+				}
+			}
+		}
+	}
+
+	bool OcclusionBuffer::IsOccluded(const BoundingBox& worldBox) const
+	{
+		if (!m_HasDepth || worldBox.min.x > worldBox.max.x)
+			return false;
+
+		//screen rectangle and nearest depth of the eight corners
+		const DirectX::XMMATRIX viewProjection = DirectX::XMLoadFloat4x4(&m_ViewProjection);
+		float minX = FLT_MAX, minY = FLT_MAX, maxX = -FLT_MAX, maxY = -FLT_MAX, minZ = FLT_MAX;
+		for (int i = 0; i < 8; ++i)
+		{
+			const DirectX::XMVECTOR corner = DirectX::XMVectorSet(
+				(i & 1) ? worldBox.max.x : worldBox.min.x,
+				(i & 2) ? worldBox.max.y : worldBox.min.y,
+				(i & 4) ? worldBox.max.z : worldBox.min.z, 1.0f);
+			DirectX::XMFLOAT4 clip;
+			DirectX::XMStoreFloat4(&clip, DirectX::XMVector3Transform(corner, viewProjection));
+			if (clip.z < 0.0f || clip.w <= 0.0f)
+				return false;
+
+			const float invW = 1.0f / clip.w;
+			const float x = (clip.x * invW * 0.5f + 0.5f) * static_cast<float>(m_Width);
+			const float y = (0.5f - clip.y * invW * 0.5f) * static_cast<float>(m_Height);
+			minX = std::min(minX, x);
+			maxX = std::max(maxX, x);
+			minY = std::min(minY, y);
+			maxY = std::max(maxY, y);
+			minZ = std::min(minZ, clip.z * invW);
+		}
+
+		//every pixel the rectangle touches, not just the covered centres
+		if (maxX < 0.0f || maxY < 0.0f || minX >= static_cast<float>(m_Width) || minY >= static_cast<float>(m_Height))
+			return false;
+		const uint32_t x0 = static_cast<uint32_t>(std::max(0.0f, std::floor(minX)));
+		const uint32_t y0 = static_cast<uint32_t>(std::max(0.0f, std::floor(minY)));
+		const uint32_t x1 = std::min(m_Width - 1, static_cast<uint32_t>(std::floor(maxX)));
+		const uint32_t y1 = std::min(m_Height - 1, static_cast<uint32_t>(std::floor(maxY)));
+
+		//coarsest level where the rectangle still spans at most four texels each way, coarser
+		//levels are cheaper but blur occluder edges into the box
+		uint32_t level = 0;
+		while (level + 1 < m_Pyramid.size() && ((x1 >> level) - (x0 >> level) > 3 || (y1 >> level) - (y0 >> level) > 3))
+		{
+			++level;
+		}
+
+		const std::vector<float>& texels = m_Pyramid[level];
+		const uint32_t width = m_LevelWidths[level];
+		const float testDepth = minZ - m_Config.depthBias;
+		for (uint32_t y = y0 >> level; y <= (y1 >> level); ++y)
+		{
+			for (uint32_t x = x0 >> level; x <= (x1 >> level); ++x)
+			{
+				if (texels[static_cast<size_t>(y) * width + x] >= testDepth)
+					return false;
+			}
+		}
+		return true;
+	}
+}
@@ -0,0 +1,110 @@
+#pragma once
+#include <DirectXMath.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "utils/Mesh/Resource/MeshResource.h"
+
+namespace DXEngine {
+
+	class WorkerPool;
+
+	struct OcclusionConfig
+	{
+		uint32_t width = 256;               // depth buffer resolution, rounded up to whole tiles
+		uint32_t height = 128;
+		uint32_t maxTriangles = 64 * 1024;  // per frame, the nearest occluders are rasterized first
+		float depthBias = 1e-5f;            // an occludee must be this far behind the occluders
+	};
+
+	// Low resolution CPU depth buffer for occlusion culling. Occluder triangles are queued,
+	// then rasterized tile by tile (tiles in parallel, pixels with SSE/AVX) keeping the nearest
+	// depth. A max depth pyramid over the result lets a world box be tested against a few
+	// texels. IsOccluded is const and may run on several threads at once, queueing and
+	// Rasterize may not overlap it.
+	class OcclusionBuffer
+	{
+	public:
+		static constexpr uint32_t TileWidth = 64;   // a multiple of the widest SIMD row
+		static constexpr uint32_t TileHeight = 16;
+
+		struct Stats
+		{
+			uint32_t occluders = 0;
+			uint32_t triangles = 0;         // screen triangles after near clipping, binned to tiles
+			uint32_t trianglesSkipped = 0;  // source triangles of occluders over the budget
+		};
+
+		explicit OcclusionBuffer(const OcclusionConfig& config = {});
+
+		// Clears depth and the queue, viewProjection = view * projection (D3D, 0 <= z <= w)
+		void BeginFrame(DirectX::FXMMATRIX viewProjection);
+		// Triangle lists with float3 positions only, anything else is ignored. The mesh must
+		// stay alive until the next Rasterize.
+		void AddOccluder(const MeshResource& mesh, DirectX::FXMMATRIX world);
+		// Rasterizes everything queued since the last call and rebuilds the pyramid
+		void Rasterize(WorkerPool* pool = nullptr);
+
+		// True when every texel the box's screen rectangle touches is nearer than the box.
+		// Boxes crossing the near plane or off screen are never occluded.
+		bool IsOccluded(const BoundingBox& worldBox) const;
+		bool HasOccluders() const { return m_HasDepth; }
+
+		uint32_t GetWidth() const { return m_Width; }
+		uint32_t GetHeight() const { return m_Height; }
+		float GetDepth(uint32_t x, uint32_t y) const { return m_Pyramid[0][static_cast<size_t>(y) * m_Width + x]; }
+		const Stats& GetStats() const { return m_Stats; }
+
+	private:
+		struct Occluder
+		{
+			const MeshResource* mesh = nullptr;
+			DirectX::XMFLOAT4X4 worldViewProjection;
+			float distance = 0.0f;          // clip w of the mesh box centre, sorts near to far
+			uint32_t triangleCount = 0;
+		};
+
+		// edges and depth as planes in pixel space, a pixel centre is covered when every
+		// edge is >= 0 and its depth is depthA * x + depthB * y + depthC
+		struct ScreenTriangle
+		{
+			float edgeA[3], edgeB[3], edgeC[3];
+			float depthA, depthB, depthC;
+			float minDepth;
+			int32_t minX, minY, maxX, maxY;  // covered pixels, inclusive and on screen
+		};
+
+		// triangles rasterized into a tile between rescans of its farthest depth
+		static constexpr uint32_t TileRefreshInterval = 8;
+
+		void SetupOccluder(const Occluder& occluder, std::vector<ScreenTriangle>& out) const;
+		void ClipTriangle(const DirectX::XMFLOAT4& a, const DirectX::XMFLOAT4& b, const DirectX::XMFLOAT4& c,
+			std::vector<ScreenTriangle>& out) const;
+		void EmitTriangle(const DirectX::XMFLOAT4& a, const DirectX::XMFLOAT4& b, const DirectX::XMFLOAT4& c,
+			std::vector<ScreenTriangle>& out) const;
+		void RasterizeTile(uint32_t tile);
+		void BuildPyramid();
+
+	private:
+		OcclusionConfig m_Config;
+		uint32_t m_Width = 0;
+		uint32_t m_Height = 0;
+		uint32_t m_TilesX = 0;
+		uint32_t m_TilesY = 0;
+
+		DirectX::XMFLOAT4X4 m_ViewProjection;
+		std::vector<Occluder> m_Queue;
+		uint32_t m_TrianglesAccepted = 0;   // source triangles counted against the budget this frame
+		std::vector<std::vector<ScreenTriangle>> m_OccluderTriangles;   // per queued occluder, kept for capacity
+		std::vector<ScreenTriangle> m_Triangles;
+		std::vector<std::vector<uint32_t>> m_TileBins;
+
+		// level 0 is the depth buffer, every further level holds the max of 2x2 texels below
+		std::vector<std::vector<float>> m_Pyramid;
+		std::vector<uint32_t> m_LevelWidths;
+		std::vector<uint32_t> m_LevelHeights;
+		bool m_HasDepth = false;
+
+		Stats m_Stats;
+	};
+}
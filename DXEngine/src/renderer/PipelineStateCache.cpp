@@ -0,0 +1,109 @@
+#include "dxpch.h"
+#include "PipelineStateCache.h"
+#include "shaders/ShaderProgram.h"
+#include "utils/Mesh/Utils/InputManager.h"
+#include <chrono>
+
+namespace DXEngine {
+
+	PipelineStateCache& PipelineStateCache::Instance()
+	{
+		static PipelineStateCache instance;
+		return instance;
+	}
+
+	PipelineHandle PipelineStateCache::GetOrCreate(const PipelineStateKey& key, const VertexLayout& layout, const ShaderProgram& program)
+	{
+		auto it = m_Lookup.find(key);
+		if (it != m_Lookup.end())
+		{
+			m_Stats.hits++;
+			return it->second;
+		}
+
+		m_Stats.misses++;
+		const auto start = std::chrono::steady_clock::now();
+
+		PipelineHandle handle = InvalidPipelineHandle;
+		VertexShader* vertexShader = program.GetVertexShader();
+		PixelShader* pixelShader = program.GetPixelShader();
+		ID3DBlob* byteCode = vertexShader ? vertexShader->GetByteCode() : nullptr;
+		if (byteCode && pixelShader)
+		{
+			ID3D11InputLayout* inputLayout = InputLayoutCache::Instance().GetInputLayout(
+				layout, vertexShader->GetByteCodeID(), byteCode->GetBufferPointer(), byteCode->GetBufferSize());
+
+			if (inputLayout)
+			{
+				PipelineState state;
+				state.inputLayout = inputLayout;
+				state.vertexShader = vertexShader->GetShader();
+				state.pixelShader = pixelShader->GetShader();
+				state.rasterizerState = RenderCommand::GetRasterizerState(key.rasterizer);
+				state.blendState = RenderCommand::GetBlendState(key.blend);
+				state.depthStencilState = RenderCommand::GetDepthStencilState(key.depth);
+
+				if (!m_FreeHandles.empty())
+				{
+					handle = m_FreeHandles.back();
+					m_FreeHandles.pop_back();
+					m_States[handle] = std::move(state);
+				}
+				else
+				{
+					handle = static_cast<PipelineHandle>(m_States.size());
+					m_States.push_back(std::move(state));
+				}
+			}
+			else
+			{
+				OutputDebugStringA(("Warning: No pipeline state, vertex layout doesn't match shader: " + layout.GetDebugString() + "\n").c_str());
+			}
+		}
+
+		m_Lookup.emplace(key, handle);
+		m_Stats.creationNanoseconds += static_cast<uint64_t>(
+			std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+		return handle;
+	}
+
+	void PipelineStateCache::BeginFrame()
+	{
+		m_Stats = Stats{};
+
+		// nothing from last frame refers to these anymore, release the shaders they hold
+		for (PipelineHandle handle : m_RetiredHandles)
+		{
+			m_States[handle] = PipelineState{};
+			m_FreeHandles.push_back(handle);
+		}
+		m_RetiredHandles.clear();
+	}
+
+	void PipelineStateCache::EvictProgram(uint64_t programID)
+	{
+		for (auto it = m_Lookup.begin(); it != m_Lookup.end();)
+		{
+			if (it->first.programID != programID)
+			{
+				++it;
+				continue;
+			}
+
+			if (it->second != InvalidPipelineHandle)
+			{
+				m_RetiredHandles.push_back(it->second);
+			}
+			it = m_Lookup.erase(it);
+		}
+	}
+
+	void PipelineStateCache::Clear()
+	{
+		m_Lookup.clear();
+		m_States.clear();
+		m_RetiredHandles.clear();
+		m_FreeHandles.clear();
+		m_Stats = Stats{};
+	}
+}
@@ -0,0 +1,96 @@
+#pragma once
+#include "RendererCommand.h"
+#include "utils/Hash.h"
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace DXEngine {
+
+	class VertexLayout;
+	class ShaderProgram;
+
+	// Index into the pipeline state cache, stable until the cache is cleared or the
+	// program it was built from is evicted
+	using PipelineHandle = uint32_t;
+	constexpr PipelineHandle InvalidPipelineHandle = 0xFFFFFFFF;
+
+	struct PipelineStateKey
+	{
+		uint64_t layoutID;     // VertexLayout::GetID
+		uint64_t programID;    // ShaderProgram::GetProgramID
+		RasterizerMode rasterizer;
+		BlendMode blend;
+		DepthMode depth;
+
+		bool operator==(const PipelineStateKey& other) const
+		{
+			return layoutID == other.layoutID && programID == other.programID &&
+				rasterizer == other.rasterizer && blend == other.blend && depth == other.depth;
+		}
+	};
+
+	// Everything a draw needs bound besides buffers and resources. D3D11 has no pipeline
+	// objects, so this is the set of state objects RenderCommand::SetPipelineState binds.
+	struct PipelineState
+	{
+		Microsoft::WRL::ComPtr<ID3D11InputLayout> inputLayout;
+		Microsoft::WRL::ComPtr<ID3D11VertexShader> vertexShader;
+		Microsoft::WRL::ComPtr<ID3D11PixelShader> pixelShader;
+		Microsoft::WRL::ComPtr<ID3D11RasterizerState> rasterizerState;
+		Microsoft::WRL::ComPtr<ID3D11BlendState> blendState;
+		Microsoft::WRL::ComPtr<ID3D11DepthStencilState> depthStencilState;
+		UINT stencilRef = 1;
+	};
+
+	class PipelineStateCache
+	{
+	public:
+		static PipelineStateCache& Instance();
+
+		// Hashes the key, builds the state on a miss. Returns InvalidPipelineHandle when the
+		// layout does not match the vertex shader, the failure is cached as well.
+		PipelineHandle GetOrCreate(const PipelineStateKey& key, const VertexLayout& layout, const ShaderProgram& program);
+
+		const PipelineState* Get(PipelineHandle handle) const
+		{
+			return handle < m_States.size() ? &m_States[handle] : nullptr;
+		}
+
+		struct Stats
+		{
+			uint32_t hits = 0;
+			uint32_t misses = 0;
+			uint64_t creationNanoseconds = 0;
+		};
+		const Stats& GetFrameStats() const { return m_Stats; }
+		size_t GetPipelineCount() const { return m_States.size() - m_FreeHandles.size() - m_RetiredHandles.size(); }
+
+		// Resets the frame stats and recycles the handles evicted during the last frame
+		void BeginFrame();
+
+		// Drops every pipeline built from the program, called when a variant is replaced or
+		// pruned. Handles stay valid until the next BeginFrame, then they are reused.
+		void EvictProgram(uint64_t programID);
+
+		void Clear();
+
+	private:
+		PipelineStateCache() = default;
+
+		struct KeyHasher
+		{
+			size_t operator()(const PipelineStateKey& key) const
+			{
+				const uint64_t modes = (uint64_t(key.rasterizer) << 16) | (uint64_t(key.blend) << 8) | uint64_t(key.depth);
+				return static_cast<size_t>(HashCombine(HashCombine(key.layoutID, key.programID), modes));
+			}
+		};
+
+		std::unordered_map<PipelineStateKey, PipelineHandle, KeyHasher> m_Lookup;
+		std::vector<PipelineState> m_States;
+		std::vector<PipelineHandle> m_RetiredHandles;   // evicted, may still be bound this frame
+		std::vector<PipelineHandle> m_FreeHandles;
+		Stats m_Stats;
+	};
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include "dxpch.h"
+#include <d3d11_1.h>
+
+namespace DXEngine {
+
+	enum class RenderBackendType
+	{
+		D3D11,      // hardware device, window and swap chain
+		Null,       // no GPU work, resources are handles from NullDevice and commands are recorded
+	};
+
+	enum class ShaderStage
+	{
+		Vertex,
+		Pixel,
+	};
+
+	// Everything RenderCommand sends to the device context after redundant state is filtered.
+	// Resource creation stays on the ID3D11Device, only context work goes through a backend.
+	class RenderBackend
+	{
+	public:
+		virtual ~RenderBackend() = default;
+
+		virtual RenderBackendType GetType() const = 0;
+
+		virtual void BeginFrame() {}
+		virtual void EndFrame() {}
+
+		// Output
+		virtual void SetRenderTargets(ID3D11RenderTargetView* target, ID3D11DepthStencilView* depth) = 0;
+		virtual void ClearRenderTarget(ID3D11RenderTargetView* target, const float color[4]) = 0;
+		virtual void ClearDepthStencil(ID3D11DepthStencilView* depth, float depthValue, UINT8 stencil) = 0;
+		virtual void SetViewport(const D3D11_VIEWPORT& viewport) = 0;
+
+		// Pipeline bindings
+		virtual void SetVertexBuffers(UINT startSlot, UINT count, ID3D11Buffer* const* buffers, const UINT* strides, const UINT* offsets) = 0;
+		virtual void SetIndexBuffer(ID3D11Buffer* buffer, DXGI_FORMAT format, UINT offset) = 0;
+		virtual void SetInputLayout(ID3D11InputLayout* layout) = 0;
+		virtual void SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY topology) = 0;
+		virtual void SetVertexShader(ID3D11VertexShader* shader) = 0;
+		virtual void SetPixelShader(ID3D11PixelShader* shader) = 0;
+		virtual void SetConstantBuffer(ShaderStage stage, UINT slot, ID3D11Buffer* buffer) = 0;
+		virtual bool SetConstantBufferRange(ShaderStage stage, UINT slot, ID3D11Buffer* buffer, UINT firstConstant, UINT numConstants) = 0;
+		virtual bool SupportsConstantBufferRanges() const = 0;
+		virtual void SetShaderResource(ShaderStage stage, UINT slot, ID3D11ShaderResourceView* view) = 0;
+		virtual void SetSamplers(ShaderStage stage, UINT startSlot, UINT count, ID3D11SamplerState* const* samplers) = 0;
+		virtual void SetRasterizerState(ID3D11RasterizerState* state) = 0;
+		virtual void SetDepthStencilState(ID3D11DepthStencilState* state, UINT stencilRef) = 0;
+		virtual void SetBlendState(ID3D11BlendState* state) = 0;
+
+		// Draws
+		virtual void Draw(UINT vertexCount, UINT startVertex) = 0;
+		virtual void DrawIndexed(UINT indexCount, UINT startIndex, INT baseVertex) = 0;
+		virtual void DrawInstanced(UINT vertexCount, UINT instanceCount, UINT startVertex, UINT startInstance) = 0;
+		virtual void DrawIndexedInstanced(UINT indexCount, UINT instanceCount, UINT startIndex, INT baseVertex, UINT startInstance) = 0;
+
+		// Uploads, bytesWritten is what the caller actually copied into the mapping
+		virtual HRESULT Map(ID3D11Buffer* buffer, D3D11_MAP mapType, D3D11_MAPPED_SUBRESOURCE& mapped) = 0;
+		virtual void Unmap(ID3D11Buffer* buffer, UINT bytesWritten) = 0;
+		virtual void UpdateSubresource(ID3D11Buffer* buffer, const D3D11_BOX* box, const void* data, UINT bytes) = 0;
+
+		// GPU progress queries, S_OK once the query has completed
+		virtual void EndQuery(ID3D11Query* query) = 0;
+		virtual HRESULT GetQueryData(ID3D11Query* query, UINT flags) = 0;
+	};
+}
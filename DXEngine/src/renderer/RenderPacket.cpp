@@ -0,0 +1,161 @@
+#include "dxpch.h"
+#include "RenderPacket.h"
+
+namespace DXEngine
+{
+	namespace
+	{
+		constexpr uint32_t MinSlots = 256;
+	}
+
+	uint64_t FrameHashMap::Mix(uint64_t key)
+	{
+		// splitmix64 finalizer, pointers have their low bits mostly zero
+		key ^= key >> 30;
+		key *= 0xbf58476d1ce4e5b9ull;
+		key ^= key >> 27;
+		key *= 0x94d049bb133111ebull;
+		key ^= key >> 31;
+		return key;
+	}
+
+	uint32_t FrameHashMap::Find(uint64_t key) const
+	{
+		if (m_Slots.empty())
+			return NotFound;
+
+		const size_t mask = m_Slots.size() - 1;
+		for (size_t i = Mix(key) & mask;; i = (i + 1) & mask)
+		{
+			const Slot& slot = m_Slots[i];
+			if (slot.generation != m_Generation)
+				return NotFound;
+			if (slot.key == key)
+				return slot.value;
+		}
+	}
+
+	uint32_t FrameHashMap::FindOrAdd(uint64_t key, uint32_t value)
+	{
+		// keep the load factor at or below one half
+		if ((m_Count + 1) * 2 > m_Slots.size())
+		{
+			Grow();
+		}
+
+		const size_t mask = m_Slots.size() - 1;
+		for (size_t i = Mix(key) & mask;; i = (i + 1) & mask)
+		{
+			Slot& slot = m_Slots[i];
+			if (slot.generation != m_Generation)
+			{
+				slot.key = key;
+				slot.value = value;
+				slot.generation = m_Generation;
+				m_Count++;
+				return value;
+			}
+			if (slot.key == key)
+				return slot.value;
+		}
+	}
+
+	void FrameHashMap::Reset()
+	{
+		m_Count = 0;
+		m_HeapAllocations = 0;
+
+		// stale slots are recognised by their generation, only a wrap needs a real clear
+		if (++m_Generation == 0)
+		{
+			for (auto& slot : m_Slots)
+			{
+				slot.generation = 0;
+			}
+			m_Generation = 1;
+		}
+	}
+
+	void FrameHashMap::Grow()
+	{
+		std::vector<Slot> oldSlots;
+		oldSlots.swap(m_Slots);
+
+		m_Slots.resize(std::max<size_t>(MinSlots, oldSlots.size() * 2));
+		m_HeapAllocations++;
+
+		const uint32_t generation = m_Generation;
+		m_Count = 0;
+		for (const auto& slot : oldSlots)
+		{
+			if (slot.generation == generation)
+			{
+				FindOrAdd(slot.key, slot.value);
+			}
+		}
+	}
+
+	uint32_t RenderPacketList::Push(const RenderPacket& packet, FrameArena& arena)
+	{
+		const uint32_t chunk = m_Count >> ChunkShift;
+		if (chunk == m_Chunks.size())
+		{
+			RenderPacket* storage = arena.AllocateArray<RenderPacket>(ChunkSize);
+			if (!storage)
+				return InvalidRenderHandle;
+
+			if (m_Chunks.size() == m_Chunks.capacity())
+				m_HeapAllocations++;
+			m_Chunks.push_back(storage);
+		}
+
+		m_Chunks[chunk][m_Count & (ChunkSize - 1)] = packet;
+		return m_Count++;
+	}
+
+	void RenderPacketList::Reset()
+	{
+		// chunk memory belongs to the arena, which is rewound separately
+		m_Chunks.clear();
+		m_Count = 0;
+		m_HeapAllocations = 0;
+	}
+
+	void PacketTables::Reset()
+	{
+		meshes.Reset();
+		materials.Reset();
+		models.Reset();
+		uiElements.Reset();
+	}
+
+	uint32_t PacketTables::GetHeapAllocations() const
+	{
+		return meshes.GetHeapAllocations() + materials.GetHeapAllocations() +
+			models.GetHeapAllocations() + uiElements.GetHeapAllocations();
+	}
+
+	void SubmissionBucket::Reset()
+	{
+		packets.Reset();
+		arena.Reset();
+		tables.Reset();
+		modelsSubmitted = 0;
+		instancesSubmitted = 0;
+		instancesCulled = 0;
+		submeshesCulled = 0;
+		modelsVisible = 0;
+		modelsCulled = 0;
+		modelsOccluded = 0;
+		modelsTooSmall = 0;
+		submeshesTooSmall = 0;
+		std::fill(std::begin(lodTriangles), std::end(lodTriangles), 0u);
+		lodTransitions = 0;
+		cullNanoseconds = 0;
+	}
+
+	uint32_t SubmissionBucket::GetHeapAllocations() const
+	{
+		return arena.GetHeapAllocations() + packets.GetHeapAllocations() + tables.GetHeapAllocations();
+	}
+}
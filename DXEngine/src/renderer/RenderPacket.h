@@ -0,0 +1,205 @@
+#pragma once
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+#include <DirectXMath.h>
+#include "utils/material/MaterialTypes.h"
+#include "utils/FrameArena.h"
+
+namespace DXEngine {
+
+	class Mesh;
+	class Material;
+	class Model;
+	class UIElement;
+
+	// Index into one of the renderer's per-frame resource tables
+	using RenderHandle = uint32_t;
+	constexpr RenderHandle InvalidRenderHandle = 0xFFFFFFFF;
+
+	enum RenderPacketFlags : uint16_t
+	{
+		PacketVisible = 1 << 0,
+		PacketCastsShadow = 1 << 1,
+		PacketReceivesShadows = 1 << 2,
+		PacketUIElement = 1 << 3,
+	};
+
+	// One draw as the renderer sees it for a frame. Plain data only: resources are referenced
+	// through frame handles, so packets copy with memcpy and never touch a reference count.
+	struct RenderPacket
+	{
+		DirectX::XMFLOAT4X4 modelMatrix;
+		DirectX::XMFLOAT4X4 normalMatrix;
+
+		uint64_t drawKey;            // packed key, see DrawKey
+		float sortKey;               // distance to camera
+		float lodFade;               // dithered LOD cross-fade: > 0 fading in, < 0 fading out, 0 opaque
+
+		RenderHandle mesh;
+		RenderHandle material;       // effective material, overrides already applied
+		RenderHandle shader;         // resolved while sorting
+		RenderHandle pipeline;       // PipelineStateCache handle, resolved while sorting
+		RenderHandle model;
+		RenderHandle uiElement;
+
+		uint32_t meshIndex;
+		uint32_t submeshIndex;
+
+		// owned by the source model, or the visible subset in the bucket arena; valid until EndScene
+		const DirectX::XMFLOAT4X4* instanceTransforms;
+		uint32_t instanceCount;
+		const std::vector<DirectX::XMFLOAT4X4>* boneMatrices;
+
+		RenderQueue queue;
+		uint16_t flags;
+
+		bool IsUIElement() const { return (flags & PacketUIElement) != 0; }
+		bool IsInstanced() const { return instanceTransforms != nullptr && instanceCount > 0; }
+		bool IsSkinned() const { return boneMatrices != nullptr; }
+	};
+	static_assert(std::is_trivially_copyable_v<RenderPacket>, "render packets must stay plain data");
+
+	// Open addressing 64-bit key -> 32-bit value map. Reset() is O(1) through a generation
+	// stamp and keeps the slot storage, so a steady frame never allocates.
+	class FrameHashMap
+	{
+	public:
+		static constexpr uint32_t NotFound = 0xFFFFFFFF;
+
+		uint32_t Find(uint64_t key) const;
+		// Returns the stored value, inserting value first when the key is new
+		uint32_t FindOrAdd(uint64_t key, uint32_t value);
+
+		void Reset();
+		uint32_t GetCount() const { return m_Count; }
+		uint32_t GetHeapAllocations() const { return m_HeapAllocations; }
+
+	private:
+		void Grow();
+		static uint64_t Mix(uint64_t key);
+
+	private:
+		struct Slot
+		{
+			uint64_t key = 0;
+			uint32_t value = 0;
+			uint32_t generation = 0;
+		};
+
+		std::vector<Slot> m_Slots;
+		uint32_t m_Count = 0;
+		uint32_t m_Generation = 1;
+		uint32_t m_HeapAllocations = 0;
+	};
+
+	// Interns raw resource pointers into dense per-frame handles
+	template<typename T>
+	class FrameHandleTable
+	{
+	public:
+		RenderHandle Register(T* item)
+		{
+			if (!item)
+				return InvalidRenderHandle;
+
+			const uint32_t next = static_cast<uint32_t>(m_Items.size());
+			const uint32_t handle = m_Lookup.FindOrAdd(reinterpret_cast<uintptr_t>(item), next);
+			if (handle == next)
+			{
+				if (m_Items.size() == m_Items.capacity())
+					m_HeapAllocations++;
+				m_Items.push_back(item);
+			}
+			return handle;
+		}
+
+		T* Get(RenderHandle handle) const
+		{
+			return handle < m_Items.size() ? m_Items[handle] : nullptr;
+		}
+
+		void Reset()
+		{
+			m_Items.clear();
+			m_Lookup.Reset();
+			m_HeapAllocations = 0;
+		}
+
+		size_t Size() const { return m_Items.size(); }
+		uint32_t GetHeapAllocations() const { return m_HeapAllocations + m_Lookup.GetHeapAllocations(); }
+
+	private:
+		std::vector<T*> m_Items;
+		FrameHashMap m_Lookup;
+		uint32_t m_HeapAllocations = 0;
+	};
+
+	// Packets stored in fixed size chunks carved from the frame arena; indices stay stable
+	// while the list grows, so sort entries and batches refer to packets by index.
+	class RenderPacketList
+	{
+	public:
+		static constexpr uint32_t ChunkShift = 8;
+		static constexpr uint32_t ChunkSize = 1u << ChunkShift;
+
+		// Returns the index of the new packet, or InvalidRenderHandle when the arena is exhausted
+		uint32_t Push(const RenderPacket& packet, FrameArena& arena);
+
+		RenderPacket& operator[](uint32_t index) { return m_Chunks[index >> ChunkShift][index & (ChunkSize - 1)]; }
+		const RenderPacket& operator[](uint32_t index) const { return m_Chunks[index >> ChunkShift][index & (ChunkSize - 1)]; }
+
+		uint32_t Size() const { return m_Count; }
+		bool Empty() const { return m_Count == 0; }
+
+		void Reset();
+		uint32_t GetHeapAllocations() const { return m_HeapAllocations; }
+
+	private:
+		std::vector<RenderPacket*> m_Chunks;
+		uint32_t m_Count = 0;
+		uint32_t m_HeapAllocations = 0;
+	};
+
+	// The handle tables packets are built against
+	struct PacketTables
+	{
+		FrameHandleTable<Mesh> meshes;
+		FrameHandleTable<Material> materials;
+		FrameHandleTable<const Model> models;
+		FrameHandleTable<UIElement> uiElements;
+
+		void Reset();
+		uint32_t GetHeapAllocations() const;
+	};
+
+	// Packets recorded by one submitting thread, or one slice of a parallel submit, during a frame.
+	// Handles index the bucket's own tables and are remapped when the renderer merges the bucket.
+	struct SubmissionBucket
+	{
+		static constexpr size_t ArenaBlockSize = 64 * 1024;
+		static constexpr uint32_t LODStatLevels = 4;   // coarser levels count towards the last
+
+		FrameArena arena{ ArenaBlockSize };
+		RenderPacketList packets;
+		PacketTables tables;
+
+		// folded into the frame statistics on merge
+		uint32_t modelsSubmitted = 0;
+		uint32_t instancesSubmitted = 0;
+		uint32_t instancesCulled = 0;
+		uint32_t submeshesCulled = 0;
+		uint32_t modelsVisible = 0;
+		uint32_t modelsCulled = 0;
+		uint32_t modelsOccluded = 0;
+		uint32_t modelsTooSmall = 0;
+		uint32_t submeshesTooSmall = 0;
+		uint32_t lodTriangles[LODStatLevels] = {};   // submitted triangles per LOD level
+		uint32_t lodTransitions = 0;
+		uint64_t cullNanoseconds = 0;
+
+		bool Push(const RenderPacket& packet) { return packets.Push(packet, arena) != InvalidRenderHandle; }
+		void Reset();
+		uint32_t GetHeapAllocations() const;
+	};
+}
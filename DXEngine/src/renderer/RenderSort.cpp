@@ -0,0 +1,138 @@
+#include "dxpch.h"
+#include "RenderSort.h"
+#include <cstring>
+#include <algorithm>
+
+namespace DXEngine
+{
+	namespace DrawKey
+	{
+		namespace
+		{
+			constexpr uint64_t Mask(uint32_t bits) { return (uint64_t(1) << bits) - 1; }
+		}
+
+		uint32_t QueueIndex(RenderQueue queue)
+		{
+			// queues are spaced by 1000, Background = 1000 maps to 0
+			uint32_t value = static_cast<uint32_t>(queue) / 1000;
+			value = value > 0 ? value - 1 : 0;
+			return value < QueueCount ? value : QueueCount - 1;
+		}
+
+		RenderQueue QueueFromKey(uint64_t key)
+		{
+			return static_cast<RenderQueue>((static_cast<uint32_t>(key >> QueueShift) + 1) * 1000);
+		}
+
+		uint32_t QuantizeDepth(float depth, uint32_t bits)
+		{
+			// IEEE bit patterns of non-negative floats sort like the floats themselves,
+			// so the top bits give a range independent quantization
+			if (!(depth > 0.0f))
+				return 0;
+
+			uint32_t asBits;
+			std::memcpy(&asBits, &depth, sizeof(asBits));
+			return asBits >> (31 - bits);
+		}
+
+		uint64_t MakeOpaque(uint32_t queueIndex, uint32_t shaderID, uint32_t materialID,
+			uint32_t meshID, uint32_t submeshIndex, float depth)
+		{
+			const uint64_t meshField = ((uint64_t(meshID) & Mask(10)) << 4) | (uint64_t(submeshIndex) & Mask(4));
+
+			return (uint64_t(queueIndex) << QueueShift)
+				| ((uint64_t(shaderID) & Mask(12)) << 49)
+				| ((uint64_t(materialID) & Mask(14)) << 35)
+				| (meshField << 21)
+				| (uint64_t(QuantizeDepth(depth, 21)) & Mask(21));
+		}
+
+		uint64_t MakeTransparent(uint32_t queueIndex, uint32_t shaderID, uint32_t materialID,
+			uint32_t meshID, float depth)
+		{
+			const uint64_t invertedDepth = Mask(24) - (uint64_t(QuantizeDepth(depth, 24)) & Mask(24));
+
+			return (uint64_t(queueIndex) << QueueShift)
+				| (invertedDepth << 37)
+				| ((uint64_t(shaderID) & Mask(12)) << 25)
+				| ((uint64_t(materialID) & Mask(14)) << 11)
+				| (uint64_t(meshID) & Mask(11));
+		}
+
+		uint64_t MakeSequential(uint32_t queueIndex, uint32_t sequence)
+		{
+			return (uint64_t(queueIndex) << QueueShift) | uint64_t(sequence);
+		}
+	}
+
+	namespace
+	{
+		constexpr size_t ComparisonSortThreshold = 2048;
+	}
+
+	void RadixSortDrawKeys(std::vector<DrawSortEntry>& entries, std::vector<DrawSortEntry>& scratch)
+	{
+		const size_t count = entries.size();
+		if (count < 2)
+			return;
+
+		// below this the histogram setup costs more than a comparison sort;
+		// ties are broken on the index so the result matches the stable radix order
+		if (count <= ComparisonSortThreshold)
+		{
+			std::sort(entries.begin(), entries.end(), [](const DrawSortEntry& a, const DrawSortEntry& b)
+				{ return a.key != b.key ? a.key < b.key : a.index < b.index; });
+			return;
+		}
+
+		scratch.resize(count);
+
+		// one read of the keys builds the histograms for all eight passes
+		uint32_t histograms[8][256] = {};
+		for (const auto& entry : entries)
+		{
+			uint64_t key = entry.key;
+			for (int pass = 0; pass < 8; ++pass)
+			{
+				histograms[pass][key & 0xFF]++;
+				key >>= 8;
+			}
+		}
+
+		DrawSortEntry* src = entries.data();
+		DrawSortEntry* dst = scratch.data();
+
+		for (int pass = 0; pass < 8; ++pass)
+		{
+			uint32_t* histogram = histograms[pass];
+			const uint32_t shift = pass * 8;
+
+			// every key has the same byte here, the pass would be a plain copy
+			if (histogram[(src[0].key >> shift) & 0xFF] == count)
+				continue;
+
+			uint32_t offset = 0;
+			for (int bucket = 0; bucket < 256; ++bucket)
+			{
+				const uint32_t bucketCount = histogram[bucket];
+				histogram[bucket] = offset;
+				offset += bucketCount;
+			}
+
+			for (size_t i = 0; i < count; ++i)
+			{
+				const uint32_t bucket = static_cast<uint32_t>((src[i].key >> shift) & 0xFF);
+				dst[histogram[bucket]++] = src[i];
+			}
+
+			std::swap(src, dst);
+		}
+
+		if (src != entries.data())
+		{
+			entries.swap(scratch);
+		}
+	}
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "utils/material/MaterialTypes.h"
+
+namespace DXEngine {
+
+	// Packed 64-bit draw key. The queue always occupies the top bits so a single
+	// ascending sort orders queues and the draws inside them.
+	//
+	//  Opaque / Background (state first, then front to back)
+	//    [63..61] queue | [60..49] shader | [48..35] material | [34..21] mesh | [20..0] depth
+	//  Transparent (back to front, state only breaks ties)
+	//    [63..61] queue | [60..37] ~depth | [36..25] shader | [24..11] material | [10..0] mesh
+	//  UI / Overlay (submission order)
+	//    [63..61] queue | [31..0] sequence
+	namespace DrawKey
+	{
+		constexpr uint32_t QueueShift = 61;
+		constexpr uint32_t QueueCount = 8;
+
+		uint32_t QueueIndex(RenderQueue queue);
+		RenderQueue QueueFromKey(uint64_t key);
+
+		// Monotonic quantization of a non-negative view distance into the given bit count
+		uint32_t QuantizeDepth(float depth, uint32_t bits);
+
+		uint64_t MakeOpaque(uint32_t queueIndex, uint32_t shaderID, uint32_t materialID,
+			uint32_t meshID, uint32_t submeshIndex, float depth);
+		uint64_t MakeTransparent(uint32_t queueIndex, uint32_t shaderID, uint32_t materialID,
+			uint32_t meshID, float depth);
+		uint64_t MakeSequential(uint32_t queueIndex, uint32_t sequence);
+	}
+
+	struct DrawSortEntry
+	{
+		uint64_t key = 0;
+		uint32_t index = 0; // index into the frame's submission array
+	};
+
+	// Stable LSD radix sort on the full 64-bit key, 8 passes of 8 bits.
+	// Passes where every key shares the same byte are skipped.
+	void RadixSortDrawKeys(std::vector<DrawSortEntry>& entries, std::vector<DrawSortEntry>& scratch);
+}
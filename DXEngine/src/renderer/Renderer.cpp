@@ -12,6 +12,15 @@
 #include <DirectXCollision.h>
 #include "utils/Light.h"
 #include "utils/Sampler.h"
+#include "utils/ConstantBufferRing.h"
+#include "utils/InstanceBuffer.h"
+#include "utils/InstanceStream.h"
+#include "utils/WorkerPool.h"
+#include "utils/Mesh/Utils/InputManager.h"
+#include "PipelineStateCache.h"
+#include "SceneSpatialIndex.h"
+#include <chrono>
+#include <cmath>
 
 
 namespace DXEngine {
@@ -19,19 +28,31 @@ namespace DXEngine {
     // Static member definitions
     Renderer::RenderStatistics Renderer::s_Stats;
     std::shared_ptr<ShaderManager> Renderer::s_ShaderManager = nullptr;
-    std::vector<RenderSubmission> Renderer::s_RenderSubmissions;
-    const DXEngine::RenderSubmission* Renderer::s_CurrentRenderSubmission = nullptr;
-    std::map<RenderQueue, std::vector<RenderSubmission*>> Renderer::s_SortedQueues;
+    FrameArena Renderer::s_FrameArena;
+    RenderPacketList Renderer::s_Packets;
+    PacketTables Renderer::s_Tables;
+    FrameHandleTable<ShaderProgram> Renderer::s_ShaderTable;
+    FrameHashMap Renderer::s_ShaderLookup;
+    FrameHashMap Renderer::s_PipelineLookup;
+    std::vector<std::unique_ptr<SubmissionBucket>> Renderer::s_BucketPool;
+    size_t Renderer::s_BucketsInUse = 0;
+    std::mutex Renderer::s_BucketMutex;
+    std::atomic<uint32_t> Renderer::s_BucketGeneration{ 1 };
+    std::vector<RenderHandle> Renderer::s_HandleRemap;
+    std::unique_ptr<WorkerPool> Renderer::s_WorkerPool;
+    std::vector<DrawSortEntry> Renderer::s_SortEntries;
+    std::vector<DrawSortEntry> Renderer::s_SortScratch;
     std::vector<RenderBatch> Renderer::s_RenderBatches;
-    std::shared_ptr<Material> Renderer::s_CurrentMaterial = nullptr;
-    std::shared_ptr<ShaderProgram> Renderer::s_CurrentShader = nullptr;
+    Material* Renderer::s_CurrentMaterial = nullptr;
+    ShaderProgram* Renderer::s_CurrentShader = nullptr;
     MaterialType Renderer::s_CurrentMaterialType = MaterialType::Unlit;
-    std::shared_ptr<TransfomBufferData> Renderer::s_TransformBufferData = nullptr;
+    std::shared_ptr<ConstantBufferRing> Renderer::s_ConstantBufferRing = nullptr;
+    std::shared_ptr<InstanceStream> Renderer::s_InstanceStream = nullptr;
+    std::vector<DirectX::XMFLOAT4X4> Renderer::s_BatchTransforms;
 
     std::shared_ptr<Model> Renderer::s_UIQuadModel = nullptr;
     std::shared_ptr<Material> Renderer::s_DefaultUIMaterial = nullptr;
     DirectX::XMMATRIX Renderer::s_UIProjectionMatrix = DirectX::XMMatrixIdentity();
-    std::shared_ptr<UIConstantBuffer> Renderer::s_UIBufferData = nullptr;
     std::vector<Renderer::RenderState> Renderer::s_RenderStateStack;
 
     std::shared_ptr<LightManager> Renderer::s_LightManager = nullptr;
@@ -41,50 +62,144 @@ namespace DXEngine {
     bool Renderer::sDX_DEBUGInfoEnabled = false;
     bool Renderer::s_InstanceEnabled = true;
     bool Renderer::s_FrustumCullingEnabled = true;
-    size_t Renderer::s_InstanceBatchSize = 100;
+    FrustumPlanes Renderer::s_FrustumPlanes = {};
+    bool Renderer::s_FrustumValid = false;
+    std::unique_ptr<OcclusionBuffer> Renderer::s_OcclusionBuffer;
+    bool Renderer::s_PhaseTimingsEnabled = false;
+    float Renderer::s_LODBias = 0.0f;
+    float Renderer::s_LODHysteresis = 0.1f;
+    uint32_t Renderer::s_LODFadeFrames = 0;
+    DirectX::XMFLOAT4 Renderer::s_ViewDepthPlane = { 0.0f, 0.0f, 1.0f, 0.0f };
+    float Renderer::s_ProjectionScaleY = 1.0f;
+    float Renderer::s_ViewportHalfHeight = 360.0f;
+    bool Renderer::s_ContributionCullingEnabled = true;
+    float Renderer::s_ContributionThresholds[3] = { 1.0f, 1.0f, 1.0f };
+    float Renderer::s_ShadowContributionThreshold = 1.0f;
+    float Renderer::s_MinContributionThreshold = 1.0f;
+    float Renderer::s_MaxContributionThreshold = 1.0f;
+    size_t Renderer::s_InstanceBatchSize = 512;
     uint32_t Renderer::s_FrameCount = 0;
     float Renderer::s_Time = 0.0f;
 
-    RenderSubmission RenderSubmission::CreateFromModel(const Model* model, size_t meshIndex, size_t submeshIndex)
+    namespace
     {
-        RenderSubmission submission;
+        //grows a frame container ahead of use and counts the reallocation
+        template<typename T>
+        void ReserveTracked(std::vector<T>& container, size_t count, uint32_t& allocations)
+        {
+            if (container.capacity() < count)
+            {
+                container.reserve(std::max(count, container.capacity() * 2));
+                allocations++;
+            }
+        }
 
-        if (!model || !model->IsValid())
-            return submission;
+        using PhaseClock = std::chrono::steady_clock;
 
-        submission.sourceModel = model;
-        submission.meshIndex = meshIndex;
-        submission.submeshIndex = submeshIndex;
-        submission.mesh = model->GetMesh(meshIndex);
-        
-        if (submission.mesh)
+        uint64_t ElapsedNanoseconds(PhaseClock::time_point start)
+        {
+            return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(PhaseClock::now() - start).count());
+        }
+
+        //slot in the contribution thresholds, screen space queues have none
+        int ContributionQueueIndex(RenderQueue queue)
+        {
+            switch (queue)
+            {
+            case RenderQueue::Background: return 0;
+            case RenderQueue::Opaque: return 1;
+            case RenderQueue::Transparent: return 2;
+            default: return -1;
+            }
+        }
+
+        //a model drawing into a screen space queue is never dropped whole, its submeshes are judged one by one
+        bool HasUncullableQueue(const Model* model)
+        {
+            for (size_t meshIndex = 0; meshIndex < model->GetMeshCount(); ++meshIndex)
+            {
+                const auto& mesh = model->GetMesh(meshIndex);
+                const size_t submeshCount = mesh ? std::max(size_t(1), mesh->GetSubmeshCount()) : 0;
+                for (size_t submeshIndex = 0; submeshIndex < submeshCount; ++submeshIndex)
+                {
+                    const auto& material = model->GetMaterial(meshIndex, submeshIndex);
+                    if (material && ContributionQueueIndex(material->GetRenderQueue()) < 0)
+                        return true;
+                }
+            }
+            return false;
+        }
+
+        //models handed to one SubmitRange task, fixed so the merged order never depends on the thread count
+        constexpr size_t SubmitSliceSize = 256;
+
+        //fills everything a slice reads lazily (default materials, matrices, world bounds) while still on one thread,
+        //meshes and transforms may be shared by models that land in different slices
+        void PrepareForSlices(Model* model)
+        {
+            model->EnsureDefaultMaterials();
+            model->GetModelMatrix();
+            model->GetNormalMatrix();
+            model->GetWorldBoundingBox();
+            model->GetWorldBoundingSphere();
+        }
+
+        //appends the frame handle of every item in a bucket table, indexed by the bucket handle
+        template<typename T>
+        void AppendRemap(const FrameHandleTable<T>& from, FrameHandleTable<T>& to, std::vector<RenderHandle>& remap)
         {
-            submission.material = submission.mesh->GetMaterial(submeshIndex);
-            if (submission.material)
+            for (size_t i = 0; i < from.Size(); ++i)
             {
-                submission.queue = submission.material->GetRenderQueue();
+                remap.push_back(to.Register(from.Get(static_cast<RenderHandle>(i))));
             }
         }
 
+        RenderHandle RemapHandle(RenderHandle handle, const std::vector<RenderHandle>& remap, size_t base)
+        {
+            return handle == InvalidRenderHandle ? InvalidRenderHandle : remap[base + handle];
+        }
+    }
+
+    bool Renderer::BuildModelPacket(const Model* model, size_t meshIndex, size_t submeshIndex, Material* materialOverride, PacketTables& tables, RenderPacket& packet)
+    {
+        if (!model || !model->IsValid())
+            return false;
+
+        const auto& mesh = model->GetMesh(meshIndex);
+        if (!mesh)
+            return false;
+
+        Material* material = materialOverride ? materialOverride : mesh->GetMaterial(submeshIndex).get();
+
+        packet = RenderPacket{};
+        packet.mesh = tables.meshes.Register(mesh.get());
+        packet.material = tables.materials.Register(material);
+        packet.shader = InvalidRenderHandle;
+        packet.pipeline = InvalidRenderHandle;
+        packet.model = tables.models.Register(model);
+        packet.uiElement = InvalidRenderHandle;
+        packet.meshIndex = static_cast<uint32_t>(meshIndex);
+        packet.submeshIndex = static_cast<uint32_t>(submeshIndex);
+        packet.queue = material ? material->GetRenderQueue() : RenderQueue::Opaque;
+
         // Store transform
         DirectX::XMMATRIX  modelMatrix = model->GetModelMatrix();
-        DirectX::XMStoreFloat4x4(&submission.modelMatrix, modelMatrix);
+        DirectX::XMStoreFloat4x4(&packet.modelMatrix, modelMatrix);
 
-        // Calculate normal matrix
-        DirectX::XMMATRIX normalMatrix = DirectX::XMMatrixTranspose(DirectX::XMMatrixInverse(nullptr, modelMatrix));
-        DirectX::XMStoreFloat4x4(&submission.normalMatrix, normalMatrix);
+        //normal matrix is cached by the transform, static models never invert
+        DirectX::XMStoreFloat4x4(&packet.normalMatrix, model->GetNormalMatrix());
 
-        submission.visible = model->IsVisible();
-        submission.castsShadow = model->CastsShadows();
-        submission.receivesShadows = model->ReceivesShadows();
+        packet.flags = (model->IsVisible() ? PacketVisible : 0) |
+            (model->CastsShadows() ? PacketCastsShadow : 0) |
+            (model->ReceivesShadows() ? PacketReceivesShadows : 0);
 
         if (model->IsInstanced())
         {
             const InstanceData* instanceData = model->GetInstanceData();
             if (instanceData && instanceData->GetInstanceCount() > 0)
             {
-                submission.instanceTransforms = &instanceData->transforms;
-                submission.instanceCount = instanceData->GetInstanceCount();
+                packet.instanceTransforms = instanceData->transforms.data();
+                packet.instanceCount = static_cast<uint32_t>(instanceData->GetInstanceCount());
             }
         }
 
@@ -93,43 +208,170 @@ namespace DXEngine {
             const SkinningData* skinData = model->GetSkinningData();
             if (skinData && !skinData->boneMatrices.empty())
             {
-                submission.boneMatrices = &skinData->boneMatrices;
+                packet.boneMatrices = &skinData->boneMatrices;
             }
         }
-        
-        return submission;
+
+        return IsPacketValid(packet, tables);
     }
 
-    RenderSubmission RenderSubmission::CreateFromUIElement(std::shared_ptr<UIElement> element, std::shared_ptr<Material> material)
+    bool Renderer::BuildUIPacket(UIElement* element, Material* material, PacketTables& tables, RenderPacket& packet)
     {
-        RenderSubmission submission;
-        submission.uiElement = element;
-        submission.material = material;
-        submission.queue = RenderQueue::UI;
-        submission.isUIElement = true;
-        submission.visible = element ? element->IsVisible() : false;
+        packet = RenderPacket{};
+        packet.mesh = InvalidRenderHandle;
+        packet.material = tables.materials.Register(material);
+        packet.shader = InvalidRenderHandle;
+        packet.pipeline = InvalidRenderHandle;
+        packet.model = InvalidRenderHandle;
+        packet.uiElement = tables.uiElements.Register(element);
+        packet.queue = RenderQueue::UI;
+        packet.flags = PacketUIElement | (element && element->IsVisible() ? PacketVisible : 0);
+
+        DirectX::XMStoreFloat4x4(&packet.modelMatrix, DirectX::XMMatrixIdentity());
+        DirectX::XMStoreFloat4x4(&packet.normalMatrix, DirectX::XMMatrixIdentity());
+
+        return IsPacketValid(packet, tables);
+    }
 
-        DirectX::XMStoreFloat4x4(&submission.modelMatrix, DirectX::XMMatrixIdentity());
-        DirectX::XMStoreFloat4x4(&submission.normalMatrix, DirectX::XMMatrixIdentity());
+    void Renderer::PushPacket(const RenderPacket& packet)
+    {
+        ValidatePacket(packet);
+        if (s_Packets.Push(packet, s_FrameArena) == InvalidRenderHandle)
+        {
+            OutputDebugStringA("Warning: Frame arena exhausted, dropping submission\n");
+            return;
+        }
+        s_Stats.submissionProcessed++;
+    }
 
-        return submission;
+    void Renderer::PushBucketPacket(SubmissionBucket& bucket, const RenderPacket& packet)
+    {
+        if (!bucket.Push(packet))
+        {
+            OutputDebugStringA("Warning: Submission bucket exhausted, dropping submission\n");
+        }
     }
-    
-    bool RenderSubmission::IsValid()const
+
+    bool Renderer::IsPacketValid(const RenderPacket& packet, const PacketTables& tables)
     {
-        if (isUIElement)
+        Material* material = tables.materials.Get(packet.material);
+        if (packet.IsUIElement())
         {
-            return uiElement != nullptr && material != nullptr;
+            return tables.uiElements.Get(packet.uiElement) != nullptr && material != nullptr;
         }
-        else
+
+        Mesh* mesh = tables.meshes.Get(packet.mesh);
+        return mesh != nullptr && mesh->IsValid() && material != nullptr && tables.models.Get(packet.model) != nullptr;
+    }
+
+    SubmissionBucket& Renderer::AcquireThreadBucket()
+    {
+        //a thread keeps its bucket until the generation moves on in BeginScene
+        thread_local SubmissionBucket* t_Bucket = nullptr;
+        thread_local uint32_t t_Generation = 0;
+
+        const uint32_t generation = s_BucketGeneration.load(std::memory_order_acquire);
+        if (!t_Bucket || t_Generation != generation)
         {
-            return mesh != nullptr && mesh->IsValid() && material != nullptr && sourceModel != nullptr;
+            AcquireBuckets(1, &t_Bucket);
+            t_Generation = generation;
         }
+        return *t_Bucket;
     }
 
-    void Renderer::Init(HWND hwnd, int width, int height)
+    void Renderer::AcquireBuckets(size_t count, SubmissionBucket** outBuckets)
     {
-        RenderCommand::Init(hwnd, width, height);
+        std::lock_guard<std::mutex> lock(s_BucketMutex);
+
+        const size_t first = s_BucketsInUse;
+        while (s_BucketPool.size() < first + count)
+        {
+            s_BucketPool.push_back(std::make_unique<SubmissionBucket>());
+        }
+        for (size_t i = 0; i < count; ++i)
+        {
+            outBuckets[i] = s_BucketPool[first + i].get();
+            outBuckets[i]->Reset();
+        }
+
+        s_BucketsInUse = first + count;
+    }
+
+    void Renderer::MergeSubmissionBuckets()
+    {
+        std::lock_guard<std::mutex> lock(s_BucketMutex);
+
+        for (size_t bucketIndex = 0; bucketIndex < s_BucketsInUse; ++bucketIndex)
+        {
+            SubmissionBucket& bucket = *s_BucketPool[bucketIndex];
+
+            //bucket handles -> frame handles, one range per table
+            const size_t meshBase = 0;
+            const size_t materialBase = meshBase + bucket.tables.meshes.Size();
+            const size_t modelBase = materialBase + bucket.tables.materials.Size();
+            const size_t uiBase = modelBase + bucket.tables.models.Size();
+
+            s_HandleRemap.clear();
+            ReserveTracked(s_HandleRemap, uiBase + bucket.tables.uiElements.Size(), s_Stats.frameHeapAllocations);
+            AppendRemap(bucket.tables.meshes, s_Tables.meshes, s_HandleRemap);
+            AppendRemap(bucket.tables.materials, s_Tables.materials, s_HandleRemap);
+            AppendRemap(bucket.tables.models, s_Tables.models, s_HandleRemap);
+            AppendRemap(bucket.tables.uiElements, s_Tables.uiElements, s_HandleRemap);
+
+            for (uint32_t i = 0; i < bucket.packets.Size(); ++i)
+            {
+                RenderPacket packet = bucket.packets[i];
+                packet.mesh = RemapHandle(packet.mesh, s_HandleRemap, meshBase);
+                packet.material = RemapHandle(packet.material, s_HandleRemap, materialBase);
+                packet.model = RemapHandle(packet.model, s_HandleRemap, modelBase);
+                packet.uiElement = RemapHandle(packet.uiElement, s_HandleRemap, uiBase);
+                PushPacket(packet);
+            }
+
+            s_Stats.modelsSubmitted += bucket.modelsSubmitted;
+            s_Stats.modelsVisible += bucket.modelsVisible;
+            s_Stats.modelsCulled += bucket.modelsCulled;
+            s_Stats.modelsOccluded += bucket.modelsOccluded;
+            s_Stats.modelsTooSmall += bucket.modelsTooSmall;
+            s_Stats.submeshesTooSmall += bucket.submeshesTooSmall;
+            s_Stats.instancesRendered += bucket.instancesSubmitted;
+            s_Stats.instancesCulled += bucket.instancesCulled;
+            s_Stats.submeshesCulled += bucket.submeshesCulled;
+            for (uint32_t level = 0; level < SubmissionBucket::LODStatLevels; ++level)
+            {
+                s_Stats.lodTriangles[level] += bucket.lodTriangles[level];
+            }
+            s_Stats.lodTransitions += bucket.lodTransitions;
+            s_Stats.cullNanoseconds += bucket.cullNanoseconds;
+            s_Stats.frameHeapAllocations += bucket.GetHeapAllocations();
+        }
+
+        s_BucketsInUse = 0;
+        s_BucketGeneration.fetch_add(1, std::memory_order_acq_rel);
+    }
+
+    void Renderer::Init(HWND hwnd, int width, int height, RenderBackendType backend)
+    {
+        RenderCommand::Init(hwnd, width, height, backend);
+
+        //per-draw constant data
+        s_ConstantBufferRing = std::make_shared<ConstantBufferRing>();
+        if (!s_ConstantBufferRing->Initialize())
+        {
+            OutputDebugStringA("Warning: Failed to initialize constant buffer ring\n");
+        }
+
+        //per-frame transforms for batches drawn as instances
+        s_InstanceStream = std::make_shared<InstanceStream>();
+        if (!s_InstanceStream->Initialize())
+        {
+            OutputDebugStringA("Warning: Failed to initialize instance stream, batches will draw per submission\n");
+            s_InstanceStream.reset();
+        }
+
+        //threads for SubmitRange
+        SetSubmissionThreadCount(WorkerPool::GetDefaultWorkerCount());
+
         //Sampler
         SamplerManager::Instance().Initialize();
 
@@ -142,7 +384,7 @@ namespace DXEngine {
         CreateDefaultUIMaterial();
         UpdateUIProjectionMatrix(width, height);
 
-        s_RenderSubmissions.reserve(1000);
+        s_SortEntries.reserve(1000);
         s_RenderBatches.reserve(100);
 
         ResetStats();
@@ -189,16 +431,31 @@ namespace DXEngine {
     {
         OutputDebugStringA("Shutting down Renderer...\n");
 
-        s_RenderSubmissions.clear();
-        s_SortedQueues.clear();
+        s_WorkerPool.reset();
+        s_OcclusionBuffer.reset();
+        {
+            std::lock_guard<std::mutex> lock(s_BucketMutex);
+            s_BucketPool.clear();
+            s_BucketsInUse = 0;
+        }
+        s_BucketGeneration.fetch_add(1, std::memory_order_acq_rel);
+
+        s_Packets.Reset();
+        s_FrameArena.Reset();
+        s_SortEntries.clear();
         s_RenderBatches.clear();
         s_ShaderManager.reset();
         s_LightManager.reset(); 
-        s_CurrentMaterial.reset();
-        s_CurrentShader.reset();
+        s_CurrentMaterial = nullptr;
+        s_CurrentShader = nullptr;
         s_UIQuadModel.reset();
         s_DefaultUIMaterial.reset();
         s_RenderStateStack.clear();
+        s_ConstantBufferRing.reset();
+        s_InstanceStream.reset();
+        s_BatchTransforms.clear();
+        PipelineStateCache::Instance().Clear();
+        InputLayoutCache::Instance().ClearCache();
 
         SamplerManager::Instance().Shutdown();
 
@@ -217,33 +474,100 @@ namespace DXEngine {
 
         RenderCommand::SetCamera(camera);
 
+        //planes once per frame, every model is tested against these
+        const DirectX::XMMATRIX viewProjection = DirectX::XMMatrixMultiply(camera->GetView(), camera->GetProjection());
+        s_FrustumPlanes = FrustumPlanes::FromViewProjection(viewProjection);
+        s_FrustumValid = true;
+
+        //view depth is the third column of the view matrix, screen sizes scale with projection _22
+        DirectX::XMFLOAT4X4 view;
+        DirectX::XMStoreFloat4x4(&view, camera->GetView());
+        s_ViewDepthPlane = { view._13, view._23, view._33, view._43 };
+        s_ProjectionScaleY = camera->GetProjectionMatrix()._22;
+        s_ViewportHalfHeight = 0.5f * static_cast<float>(RenderCommand::GetViewportHeight());
+        if (s_OcclusionBuffer)
+        {
+            s_OcclusionBuffer->BeginFrame(viewProjection);
+        }
+
         UpdateLightCulling(camera);
 
-        // Clear previous frame data
-        s_RenderSubmissions.clear();
-        s_SortedQueues.clear();
+        ResetStats();
+        RenderCommand::ResetStateFilterStats();
+        PipelineStateCache::Instance().BeginFrame();
+        s_FrameCount++;
+
+        // Clear previous frame data, every container keeps its storage
+        s_Packets.Reset();
+        s_FrameArena.Reset();
+        s_Tables.Reset();
+        s_ShaderTable.Reset();
+        s_ShaderLookup.Reset();
+        s_PipelineLookup.Reset();
+        s_SortEntries.clear();
         s_RenderBatches.clear();
-        s_CurrentMaterial.reset();
-        s_CurrentShader.reset();
+        s_CurrentMaterial = nullptr;
+        s_CurrentShader = nullptr;
         s_CurrentMaterialType = MaterialType::Unlit;
 
-        ResetStats();
-        s_FrameCount++;
+        //buckets left over from a frame without EndScene are dropped, threads pick up fresh ones
+        {
+            std::lock_guard<std::mutex> lock(s_BucketMutex);
+            s_BucketsInUse = 0;
+        }
+        s_BucketGeneration.fetch_add(1, std::memory_order_acq_rel);
+
+        if (s_ConstantBufferRing)
+        {
+            s_ConstantBufferRing->BeginFrame();
+        }
+        if (s_InstanceStream)
+        {
+            s_InstanceStream->BeginFrame();
+        }
 
         RenderCommand::Clear();
 
-        // Check for shader hot reload in debug builds
-#ifdef DX_DEBUG
+        // Swap in shader variants compiled since last frame, hot reload checks are config gated
         if (s_ShaderManager)
         {
             s_ShaderManager->Update();
         }
-#endif
     }
 
     void Renderer::EndScene()
     {
+        MergeSubmissionBuckets();
         ProcessRenderQueue();
+
+        const auto& stateStats = RenderCommand::GetStateFilterStats();
+        s_Stats.stateCallsIssued = stateStats.issued;
+        s_Stats.stateCallsFiltered = stateStats.filtered;
+
+        const auto& pipelineCache = PipelineStateCache::Instance();
+        s_Stats.pipelineCacheHits = pipelineCache.GetFrameStats().hits;
+        s_Stats.pipelineCacheMisses = pipelineCache.GetFrameStats().misses;
+        s_Stats.pipelineCreationNanoseconds = pipelineCache.GetFrameStats().creationNanoseconds;
+        s_Stats.pipelinesCached = static_cast<uint32_t>(pipelineCache.GetPipelineCount());
+
+        if (s_ConstantBufferRing)
+        {
+            const auto& ringStats = s_ConstantBufferRing->GetFrameStats();
+            s_Stats.constantBytesUploaded = ringStats.bytesUploaded;
+            s_Stats.constantBuffersCreated = ringStats.buffersCreated;
+            s_Stats.constantBufferMaps = ringStats.maps;
+            s_ConstantBufferRing->EndFrame();
+        }
+        if (s_InstanceStream)
+        {
+            s_Stats.instanceBytesUploaded += s_InstanceStream->GetFrameStats().bytesUploaded;
+        }
+
+        s_Stats.frameArenaBytes = s_FrameArena.GetBytesUsed();
+        s_Stats.frameHeapAllocations += s_FrameArena.GetHeapAllocations() + s_Packets.GetHeapAllocations() +
+            s_Tables.GetHeapAllocations() + s_ShaderTable.GetHeapAllocations() + s_ShaderLookup.GetHeapAllocations() +
+            s_PipelineLookup.GetHeapAllocations();
+
         RenderCommand::Present();
 
         if (sDX_DEBUGInfoEnabled)
@@ -258,25 +582,27 @@ namespace DXEngine {
     }
 
     // 3D Model submission methods
-    void Renderer::Submit(std::shared_ptr<Model> model)
+    void Renderer::Submit(const std::shared_ptr<Model>& model)
     {
         if (!model || !model->IsValid()||!model->IsVisible())
             return;
 
-        s_Stats.modelsSubmitted++;
-        ProcessModelSubmission(model);
+        SubmissionBucket& bucket = AcquireThreadBucket();
+        bucket.modelsSubmitted++;
+        ProcessModelSubmission(model.get(), nullptr, bucket);
     }
 
-    void Renderer::Submit(std::shared_ptr<Model> model, std::shared_ptr<Material> materialOverride)
+    void Renderer::Submit(const std::shared_ptr<Model>& model, const std::shared_ptr<Material>& materialOverride)
     {
         if (!model || !model->IsValid()||!model->IsVisible())
             return;
-        s_Stats.modelsSubmitted++;
-        ProcessModelSubmission(model, materialOverride);
+        SubmissionBucket& bucket = AcquireThreadBucket();
+        bucket.modelsSubmitted++;
+        ProcessModelSubmission(model.get(), materialOverride.get(), bucket);
   
     }
 
-    void Renderer::SubmitMesh(std::shared_ptr<Model> model, size_t meshIndex, std::shared_ptr<Material> materialOverride)
+    void Renderer::SubmitMesh(const std::shared_ptr<Model>& model, size_t meshIndex, const std::shared_ptr<Material>& materialOverride)
     {
         if (!model || !model->IsValid() || !model->IsVisible())
             return;
@@ -284,33 +610,25 @@ namespace DXEngine {
         if (meshIndex >= model->GetMeshCount())
         return;
 
-        auto mesh = model->GetMesh(meshIndex);
+        const auto& mesh = model->GetMesh(meshIndex);
         if (!mesh || !mesh->IsValid())
             return;
 
         //create submission for this specific mesh
+        SubmissionBucket& bucket = AcquireThreadBucket();
         size_t submeshCount = std::max(size_t(1), mesh->GetSubmeshCount());
         for (size_t submeshIndex = 0; submeshIndex < submeshCount; ++submeshIndex)
         {
-            DXEngine::RenderSubmission submission = DXEngine::RenderSubmission::CreateFromModel(model.get(), meshIndex, submeshIndex);
-
-            if (materialOverride)
+            RenderPacket packet;
+            if (BuildModelPacket(model.get(), meshIndex, submeshIndex, materialOverride.get(), bucket.tables, packet))
             {
-                submission.materialOverride = materialOverride;
-                submission.queue = materialOverride->GetRenderQueue();
+                PushBucketPacket(bucket, packet);
             }
-            if (submission.IsValid())
-            {
-                ValidateSubmission(submission);
-                s_RenderSubmissions.push_back(submission);
-                s_Stats.submissionProcessed++;
-            }
-
         }
 
     }
 
-    void Renderer::SubmitSubmesh(std::shared_ptr<Model> model, size_t meshIndex, size_t submeshIndex, std::shared_ptr<Material> materialOverride)
+    void Renderer::SubmitSubmesh(const std::shared_ptr<Model>& model, size_t meshIndex, size_t submeshIndex, const std::shared_ptr<Material>& materialOverride)
     {
         if (!model || !model->IsValid() || !model->IsVisible())
             return;
@@ -318,31 +636,250 @@ namespace DXEngine {
         if (meshIndex >= model->GetMeshCount())
             return;
 
-        auto mesh = model->GetMesh(meshIndex);
+        const auto& mesh = model->GetMesh(meshIndex);
         if (!mesh || !mesh->IsValid())
             return;
 
         if (submeshIndex >= std::max(size_t(1), mesh->GetSubmeshCount()))
             return;
 
-        DXEngine::RenderSubmission submission = RenderSubmission::CreateFromModel(model.get(), meshIndex, submeshIndex);
+        SubmissionBucket& bucket = AcquireThreadBucket();
+        RenderPacket packet;
+        if (BuildModelPacket(model.get(), meshIndex, submeshIndex, materialOverride.get(), bucket.tables, packet))
+        {
+            PushBucketPacket(bucket, packet);
+        }
+
+    }
+
+    void Renderer::SubmitRange(std::span<const std::shared_ptr<Model>> models)
+    {
+        if (models.empty())
+            return;
+
+        SubmissionBucket& bucket = AcquireThreadBucket();
+        const bool culling = s_FrustumCullingEnabled && s_FrustumValid;
+        for (const auto& model : models)
+        {
+            if (model && model->IsValid() && model->IsVisible())
+            {
+                PrepareForSlices(model.get());
+                SelectLODBeforeSlices(model.get(), culling, bucket);
+            }
+        }
+
+        //one bucket per slice, reserved here so the merge order matches the span order
+        thread_local std::vector<SubmissionBucket*> t_SliceBuckets;
+        const size_t sliceCount = (models.size() + SubmitSliceSize - 1) / SubmitSliceSize;
+        t_SliceBuckets.resize(sliceCount);
+        AcquireBuckets(sliceCount, t_SliceBuckets.data());
 
-        if (materialOverride)
+        SubmissionBucket* const* buckets = t_SliceBuckets.data();
+        const std::function<void(uint32_t)> submitSlice = [models, buckets](uint32_t slice)
+            {
+                const size_t begin = slice * SubmitSliceSize;
+                const size_t end = std::min(begin + SubmitSliceSize, models.size());
+                ProcessModelSlice(models.subspan(begin, end - begin), *buckets[slice]);
+            };
+
+        if (s_WorkerPool)
         {
-            submission.materialOverride = materialOverride;
-            submission.queue = materialOverride->GetRenderQueue();
+            s_WorkerPool->ParallelFor(static_cast<uint32_t>(sliceCount), submitSlice);
         }
-        
-        if (submission.IsValid())
+        else
         {
-            ValidateSubmission(submission);
-            s_RenderSubmissions.push_back(submission);
-            s_Stats.submissionProcessed++;
+            for (uint32_t slice = 0; slice < sliceCount; ++slice)
+            {
+                submitSlice(slice);
+            }
         }
+    }
+
+    void Renderer::SubmitScene(const SceneSpatialIndex& scene)
+    {
+        if (scene.Empty())
+            return;
+
+        //the hierarchy rejects whole subtrees without testing their models' bounds
+        thread_local std::vector<Model*> t_Visible;
+        t_Visible.clear();
+
+        const auto notDrawable = [](Model* model) { return !model->IsValid() || !model->IsVisible(); };
+
+        //counted before culling like ProcessModelSlice, the culled ones are the submitted ones the frustum rejected
+        SubmissionBucket& bucket = AcquireThreadBucket();
+        scene.QueryAll(t_Visible);
+        std::erase_if(t_Visible, notDrawable);
+        const size_t submittedCount = t_Visible.size();
+        bucket.modelsSubmitted += static_cast<uint32_t>(submittedCount);
+
+        const bool culling = s_FrustumCullingEnabled && s_FrustumValid;
+        if (culling)
+        {
+            const bool timed = s_PhaseTimingsEnabled;
+            const PhaseClock::time_point cullStart = timed ? PhaseClock::now() : PhaseClock::time_point{};
+            t_Visible.clear();
+            scene.QueryFrustum(s_FrustumPlanes, t_Visible);
+            if (timed)
+            {
+                bucket.cullNanoseconds += ElapsedNanoseconds(cullStart);
+            }
+            std::erase_if(t_Visible, notDrawable);
+            bucket.modelsCulled += static_cast<uint32_t>(submittedCount - t_Visible.size());
+        }
+
+        const size_t largeCount = t_Visible.size();
+        std::erase_if(t_Visible, [](Model* model) { return IsModelTooSmall(model); });
+        bucket.modelsTooSmall += static_cast<uint32_t>(largeCount - t_Visible.size());
+        if (t_Visible.empty())
+            return;
+
+        for (Model* model : t_Visible)
+        {
+            PrepareForSlices(model);
+            SelectLODBeforeSlices(model, false, bucket);
+        }
+
+        thread_local std::vector<SubmissionBucket*> t_SliceBuckets;
+        const size_t sliceCount = (t_Visible.size() + SubmitSliceSize - 1) / SubmitSliceSize;
+        t_SliceBuckets.resize(sliceCount);
+        AcquireBuckets(sliceCount, t_SliceBuckets.data());
+
+        const std::span<Model* const> visible(t_Visible);
+        SubmissionBucket* const* buckets = t_SliceBuckets.data();
+        const std::function<void(uint32_t)> submitSlice = [visible, buckets](uint32_t slice)
+            {
+                const size_t begin = slice * SubmitSliceSize;
+                const size_t end = std::min(begin + SubmitSliceSize, visible.size());
+                SubmissionBucket& sliceBucket = *buckets[slice];
+                std::span<Model* const> models = visible.subspan(begin, end - begin);
+
+                //occlusion is tested per slice so the tests spread over the workers too
+                thread_local std::vector<Model*> t_Unoccluded;
+                if (s_OcclusionBuffer && s_OcclusionBuffer->HasOccluders())
+                {
+                    const bool timed = s_PhaseTimingsEnabled;
+                    const PhaseClock::time_point occlusionStart = timed ? PhaseClock::now() : PhaseClock::time_point{};
+                    t_Unoccluded.clear();
+                    for (Model* model : models)
+                    {
+                        if (!s_OcclusionBuffer->IsOccluded(model->GetWorldBoundingBox()))
+                            t_Unoccluded.push_back(model);
+                    }
+                    sliceBucket.modelsOccluded += static_cast<uint32_t>(models.size() - t_Unoccluded.size());
+                    models = t_Unoccluded;
+                    if (timed)
+                    {
+                        sliceBucket.cullNanoseconds += ElapsedNanoseconds(occlusionStart);
+                    }
+                }
+
+                sliceBucket.modelsVisible += static_cast<uint32_t>(models.size());
+                for (Model* model : models)
+                {
+                    SubmitModelPackets(model, nullptr, sliceBucket);
+                }
+            };
 
+        if (s_WorkerPool)
+        {
+            s_WorkerPool->ParallelFor(static_cast<uint32_t>(sliceCount), submitSlice);
+        }
+        else
+        {
+            for (uint32_t slice = 0; slice < sliceCount; ++slice)
+            {
+                submitSlice(slice);
+            }
+        }
+    }
+
+    void Renderer::EnableOcclusionCulling(bool enable, const OcclusionConfig& config)
+    {
+        s_OcclusionBuffer = enable ? std::make_unique<OcclusionBuffer>(config) : nullptr;
+
+        //enabled mid frame, pick up the current camera so SubmitOccluders works right away
+        const auto& camera = RenderCommand::GetCamera();
+        if (s_OcclusionBuffer && s_FrustumValid && camera)
+        {
+            s_OcclusionBuffer->BeginFrame(DirectX::XMMatrixMultiply(camera->GetView(), camera->GetProjection()));
+        }
+    }
+
+    void Renderer::SubmitOccluders(std::span<const std::shared_ptr<Model>> occluders)
+    {
+        if (!s_OcclusionBuffer || !s_FrustumValid || occluders.empty())
+            return;
+
+        const bool timed = s_PhaseTimingsEnabled;
+        const PhaseClock::time_point occlusionStart = timed ? PhaseClock::now() : PhaseClock::time_point{};
+
+        for (const auto& model : occluders)
+        {
+            //skinned vertices are deformed on the GPU, the rasterizer would only see the bind pose
+            if (!model || !model->IsValid() || !model->IsVisible() || model->IsSkinned())
+                continue;
+            if (s_FrustumCullingEnabled && !IsModelVisible(model.get()))
+                continue;
+
+            //instance transforms are full world matrices, one placement per instance
+            const InstanceData* instances = model->IsInstanced() ? model->GetInstanceData() : nullptr;
+            const size_t placements = instances ? instances->GetInstanceCount() : 1;
+            const DirectX::XMMATRIX modelMatrix = model->GetModelMatrix();
+            const std::shared_ptr<MeshResource>& proxy = model->GetOccluderProxy();
+
+            //one LOD level is enough to occlude, the one the model is drawn with
+            const LODData* lod = model->HasLOD() ? model->GetLODData() : nullptr;
+            const size_t occluderLevel = lod && lod->currentLevel < lod->levels.size() ? lod->currentLevel : 0;
+
+            for (size_t placement = 0; placement < placements; ++placement)
+            {
+                const DirectX::XMMATRIX world = instances ? DirectX::XMLoadFloat4x4(&instances->transforms[placement]) : modelMatrix;
+                if (proxy)
+                {
+                    s_OcclusionBuffer->AddOccluder(*proxy, world);
+                    continue;
+                }
+                for (size_t meshIndex = 0; meshIndex < model->GetMeshCount(); ++meshIndex)
+                {
+                    if (lod)
+                    {
+                        const size_t meshLevel = lod->FindLevel(meshIndex);
+                        if (meshLevel != LODData::NoLevel && meshLevel != occluderLevel)
+                            continue;
+                    }
+
+                    const auto& mesh = model->GetMesh(meshIndex);
+                    if (mesh && mesh->GetResource())
+                    {
+                        s_OcclusionBuffer->AddOccluder(*mesh->GetResource(), world);
+                    }
+                }
+            }
+        }
+        s_OcclusionBuffer->Rasterize(s_WorkerPool.get());
+
+        const OcclusionBuffer::Stats& occlusionStats = s_OcclusionBuffer->GetStats();
+        s_Stats.occludersRasterized = occlusionStats.occluders;
+        s_Stats.occluderTriangles = occlusionStats.triangles;
+        if (timed)
+        {
+            s_Stats.occlusionNanoseconds += ElapsedNanoseconds(occlusionStart);
+        }
+    }
+
+    void Renderer::SetSubmissionThreadCount(uint32_t workerCount)
+    {
+        //workers are restarted, never call this while a SubmitRange is running
+        s_WorkerPool = workerCount > 0 ? std::make_unique<WorkerPool>(workerCount) : nullptr;
+    }
+
+    uint32_t Renderer::GetSubmissionThreadCount()
+    {
+        return s_WorkerPool ? s_WorkerPool->GetThreadCount() : 1;
     }
 
-    void Renderer::RenderImmediate(std::shared_ptr<Model> model, std::shared_ptr<Material> materialOverride)
+    void Renderer::RenderImmediate(const std::shared_ptr<Model>& model, const std::shared_ptr<Material>& materialOverride)
     {
         if (!model || !model->IsValid())
             return;
@@ -356,7 +893,7 @@ namespace DXEngine {
         }
     }
 
-    void Renderer::RenderMeshImmediate(std::shared_ptr<Model> model, size_t meshIndex, std::shared_ptr<Material> materialOverride)
+    void Renderer::RenderMeshImmediate(const std::shared_ptr<Model>& model, size_t meshIndex, const std::shared_ptr<Material>& materialOverride)
     {
         if (!model || !model->IsValid())
             return;
@@ -364,65 +901,50 @@ namespace DXEngine {
         if (meshIndex >= model->GetMeshCount())
             return;
 
-        auto mesh = model->GetMesh(meshIndex);
+        const auto& mesh = model->GetMesh(meshIndex);
         if (!mesh || !mesh->IsValid())
             return;
 
         size_t submeshCount = std::max(size_t(1), mesh->GetSubmeshCount());
         for (size_t submeshIndex = 0; submeshIndex < submeshCount; ++submeshIndex)
         {
-            DXEngine::RenderSubmission submission = RenderSubmission::CreateFromModel(model.get());
-
-            if (materialOverride)
+            RenderPacket packet;
+            if (BuildModelPacket(model.get(), meshIndex, submeshIndex, materialOverride.get(), s_Tables, packet))
             {
-                submission.materialOverride = materialOverride;
-            }
-
-            if (submission.IsValid())
-            {
-                RenderSubmission(submission);
+                DrawPacket(packet);
             }
         }
     }
 
     //UI rendering
-    void Renderer::SubmitUI(std::shared_ptr<UIElement> element)
+    void Renderer::SubmitUI(const std::shared_ptr<UIElement>& element)
     {
         if (!element || !element->IsVisible())
             return;
 
-        DXEngine::RenderSubmission submission = DXEngine::RenderSubmission::CreateFromUIElement(element, s_DefaultUIMaterial);
-
-        if (submission.IsValid())
+        SubmissionBucket& bucket = AcquireThreadBucket();
+        RenderPacket packet;
+        if (BuildUIPacket(element.get(), s_DefaultUIMaterial.get(), bucket.tables, packet))
         {
-            ValidateSubmission(submission);
-            s_RenderSubmissions.push_back(submission);
-            s_Stats.submissionProcessed++;
+            PushBucketPacket(bucket, packet);
         }
     }
 
-    void Renderer::SubmitUI(std::shared_ptr<UIElement> element, std::shared_ptr<Material> materialOverride)
+    void Renderer::SubmitUI(const std::shared_ptr<UIElement>& element, const std::shared_ptr<Material>& materialOverride)
     {
         if (!element || !element->IsVisible())
             return;
 
-        DXEngine::RenderSubmission submission = DXEngine::RenderSubmission::CreateFromUIElement(element, materialOverride);
-        submission.materialOverride = materialOverride;
-
-        if (materialOverride)
+        SubmissionBucket& bucket = AcquireThreadBucket();
+        RenderPacket packet;
+        if (BuildUIPacket(element.get(), materialOverride.get(), bucket.tables, packet))
         {
-            submission.queue = materialOverride->GetRenderQueue();
-        }
-
-        if (submission.IsValid())
-        {
-            ValidateSubmission(submission);
-            s_RenderSubmissions.push_back(submission);
-            s_Stats.submissionProcessed++;
+            packet.queue = materialOverride->GetRenderQueue();
+            PushBucketPacket(bucket, packet);
         }
     }
 
-    void Renderer::RenderUIImmediate(std::shared_ptr<UIElement> element, std::shared_ptr<Material> material)
+    void Renderer::RenderUIImmediate(const std::shared_ptr<UIElement>& element, const std::shared_ptr<Material>& material)
     {
         if (!element || !element->IsVisible())
             return;
@@ -430,11 +952,10 @@ namespace DXEngine {
         PushRenderState();
         SetUIRenderState();
 
-        DXEngine::RenderSubmission submission = DXEngine::RenderSubmission::CreateFromUIElement(element, material);
-
-        if (submission.IsValid())
+        RenderPacket packet;
+        if (BuildUIPacket(element.get(), material.get(), s_Tables, packet))
         {
-            RenderUIElement(submission);
+            RenderUIElement(packet);
         }
 
         PopRenderState();
@@ -443,7 +964,7 @@ namespace DXEngine {
     //core Rendering Pipeline
     void Renderer::ProcessRenderQueue()
     {
-        if (s_RenderSubmissions.empty())
+        if (s_Packets.Empty())
         { 
             OutputDebugStringA("Process RenderQueue() failed");
             return;
@@ -456,149 +977,144 @@ namespace DXEngine {
         }
 
         //sort submission and create batches
+        const bool timed = s_PhaseTimingsEnabled;
+        PhaseClock::time_point phaseStart = timed ? PhaseClock::now() : PhaseClock::time_point{};
         SortSubmissions();
-        CreateRenderBatches();
+        if (timed)
+        {
+            s_Stats.sortNanoseconds += ElapsedNanoseconds(phaseStart);
+            phaseStart = PhaseClock::now();
+        }
 
-        //proces render batches in queue order
-        std::vector<RenderQueue> queueOrder =
+        CreateRenderBatches();
+        if (timed)
         {
-            RenderQueue::Background,
-            RenderQueue::Opaque,
-            RenderQueue::Transparent,
-            RenderQueue::UI,
-            RenderQueue::Overlay
-        };
+            s_Stats.batchNanoseconds += ElapsedNanoseconds(phaseStart);
+            phaseStart = PhaseClock::now();
+        }
 
-        for (RenderQueue queue : queueOrder)
+        //batches are already in queue order, only switch state when the queue changes
+        bool hasQueueState = false;
+        RenderQueue currentQueue = RenderQueue::Opaque;
+        for (const auto& batch : s_RenderBatches)
         {
-            for (const auto& batch : s_RenderBatches)
+            if (batch.IsEmpty())
+                continue;
+
+            if (!hasQueueState || batch.queue != currentQueue)
             {
-                if (batch.queue == queue && !batch.IsEmpty())
-                {
-                    SetRenderStateForQueue(queue);
-                    ProcessRenderBatch(batch);
-                }
+                SetRenderStateForQueue(batch.queue);
+                currentQueue = batch.queue;
+                hasQueueState = true;
             }
+            ProcessRenderBatch(batch);
         }
 
         //restore state
         Set3DRenderState();
 
+        if (timed)
+        {
+            s_Stats.encodeNanoseconds += ElapsedNanoseconds(phaseStart);
+        }
     }
 
     void Renderer::SortSubmissions()
     {
-        //calculate sort keys for all submissions
-        for (auto& submission : s_RenderSubmissions)
-        {
-            submission.sortKey = CalculateDistancetoCamera(submission);
-            submission.batchKey = GenarateBatchKey(submission);
-            s_SortedQueues[submission.queue].push_back(&submission);
-        }
-        //sort each queue appropriately
-        for (auto& [queue, submissions] : s_SortedQueues)
+        const uint32_t packetCount = s_Packets.Size();
+        s_SortEntries.clear();
+        ReserveTracked(s_SortEntries, packetCount, s_Stats.frameHeapAllocations);
+        ReserveTracked(s_SortScratch, packetCount, s_Stats.frameHeapAllocations);
+
+        //build one packed key per packet
+        for (uint32_t i = 0; i < packetCount; ++i)
         {
-            switch (queue)
-            {
-            case RenderQueue::Background:
-            case RenderQueue::Opaque:
-            {
-                // Sort front to back for early Z rejection
-                std::sort(submissions.begin(), submissions.end(), [](const DXEngine::RenderSubmission* a, const DXEngine::RenderSubmission* b)
-                    { return a->sortKey < b->sortKey; });
-                break;
-            }
-            case RenderQueue::Transparent:
+            auto& packet = s_Packets[i];
+            packet.sortKey = CalculateDistancetoCamera(packet);
+
+            if (!packet.IsUIElement())
             {
-                // Sort back to front for proper alpha blending
-                std::sort(submissions.begin(), submissions.end(), [](const DXEngine::RenderSubmission* a, const DXEngine::RenderSubmission* b)
-                    { return a->sortKey > b->sortKey; });
-                break;
-            }
-            case RenderQueue::UI:
-            case RenderQueue::Overlay:
-                break;
+                packet.shader = ResolveShaderHandle(packet.material, packet.mesh, packet.IsInstanced());
+                packet.pipeline = ResolvePipelineHandle(packet.material, packet.mesh, packet.shader, packet.IsInstanced());
             }
+
+            packet.drawKey = GenerateSortKey(packet, i);
+            s_SortEntries.push_back({ packet.drawKey, i });
         }
-    
+
+        //queue, state and depth order all come out of one sort
+        RadixSortDrawKeys(s_SortEntries, s_SortScratch);
     }
 
     void Renderer::CreateRenderBatches()
     {
         s_RenderBatches.clear();
 
-        for (auto& [queue, submissions] : s_SortedQueues)
-        {
-            if (submissions.empty())
-                return;
+        DXEngine::RenderBatch currentBatch;
 
-            //for UI and Overlay ques . create simple batches 
-            
-            if (queue == RenderQueue::UI || queue == RenderQueue::Overlay)
+        auto flushBatch = [&currentBatch]()
             {
-                RenderBatch batch;
-                batch.queue = queue;
-
-                for (auto* submission : submissions)
+                if (!currentBatch.IsEmpty())
                 {
-                    batch.submissions.push_back(*submission);
+                    ReserveTracked(s_RenderBatches, s_RenderBatches.size() + 1, s_Stats.frameHeapAllocations);
+                    s_RenderBatches.push_back(currentBatch);
+                    s_Stats.batchesProcessed++;
                 }
-                s_RenderBatches.push_back(batch);
-                continue;
-            }
+                currentBatch.count = 0;
+            };
 
-            //for 3d queues,, try to batch by material and mesh
-            DXEngine::RenderBatch currentBatch;
-            currentBatch.queue = queue;
+        const uint32_t entryCount = static_cast<uint32_t>(s_SortEntries.size());
+        for (uint32_t entryIndex = 0; entryIndex < entryCount; ++entryIndex)
+        {
+            const auto& packet = s_Packets[s_SortEntries[entryIndex].index];
+            bool canBatch = false;
 
-            for (auto* submission : submissions)
+            if (!currentBatch.IsEmpty() && currentBatch.queue == packet.queue)
             {
-                bool canBatch = false;
-
-                if (!currentBatch.IsEmpty())
+                //UI and Overlay queues keep everything in one batch
+                if (packet.queue == RenderQueue::UI || packet.queue == RenderQueue::Overlay)
                 {
-                    const auto& lastSubmission = currentBatch.submissions.back();
-
-                    //check if we can batch with the previous submisision
-                    if (submission->mesh == lastSubmission.mesh &&
-                        submission->GetEffectiveMaterial() == lastSubmission.GetEffectiveMaterial() &&
-                        submission->instanceTransforms == nullptr &&
-                        lastSubmission.instanceTransforms == nullptr)
-                    {
-                        canBatch = true;
-                    }
-                }
-
-                if (canBatch && currentBatch.submissions.size() < s_InstanceBatchSize)
-                {
-                    currentBatch.submissions.push_back(*submission);
+                    canBatch = true;
                 }
                 else
                 {
-                    //finish current batch and start new one 
-                    if (!currentBatch.IsEmpty())
-                    {
-                        s_RenderBatches.push_back(currentBatch);
-                        s_Stats.batchesProcessed++;
-                    }
-
-                    currentBatch.Clear();
-                    currentBatch.queue = queue;
-                    currentBatch.submissions.push_back(*submission);
-
-                    //set batch properties based on first submission
-                    currentBatch.batchMaterial = submission->GetEffectiveMaterial();
-                    currentBatch.batchMesh = submission->mesh;
-                    currentBatch.IsInstanced = (submission->instanceTransforms != nullptr);
+                    //for 3d queues, batch by material, mesh and submesh so the batch can become one instanced draw
+                    const auto& lastPacket = GetBatchPacket(currentBatch, currentBatch.count - 1);
+                    canBatch = packet.mesh == lastPacket.mesh &&
+                        packet.lodFade == 0.0f &&
+                        lastPacket.lodFade == 0.0f &&
+                        packet.submeshIndex == lastPacket.submeshIndex &&
+                        packet.material == lastPacket.material &&
+                        packet.instanceTransforms == nullptr &&
+                        lastPacket.instanceTransforms == nullptr &&
+                        packet.boneMatrices == nullptr &&
+                        lastPacket.boneMatrices == nullptr &&
+                        currentBatch.count < s_InstanceBatchSize;
                 }
             }
-            //add final batch
-            if (!currentBatch.IsEmpty())
+
+            if (!canBatch)
             {
-                s_RenderBatches.push_back(currentBatch);
-                s_Stats.batchesProcessed++;
+                //finish current batch and start new one
+                flushBatch();
+
+                //set batch properties based on first packet
+                currentBatch.firstEntry = entryIndex;
+                currentBatch.queue = packet.queue;
+                currentBatch.IsInstanced = (packet.instanceTransforms != nullptr);
+                currentBatch.requiresDepthSorting = (packet.queue == RenderQueue::Transparent);
             }
+
+            currentBatch.count++;
         }
+
+        //add final batch
+        flushBatch();
+    }
+
+    const RenderPacket& Renderer::GetBatchPacket(const DXEngine::RenderBatch& batch, uint32_t index)
+    {
+        return s_Packets[s_SortEntries[batch.firstEntry + index].index];
     }
 
     void Renderer::ProcessRenderBatch(const DXEngine::RenderBatch& batch)
@@ -606,14 +1122,34 @@ namespace DXEngine {
         if (batch.IsEmpty())
             return;
 
-        for (const auto& submission : batch.submissions)
+        //identical plain meshes collapse into a single instanced draw
+        if (CanInstanceBatch(batch))
+        {
+            RenderInstancedBatch(batch);
+            return;
+        }
+
+        for (uint32_t i = 0; i < batch.count; ++i)
         {
-            RenderSubmission(submission);
+            DrawPacket(GetBatchPacket(batch, i));
         }
     }
 
+    bool Renderer::CanInstanceBatch(const DXEngine::RenderBatch& batch)
+    {
+        if (!s_InstanceEnabled || !s_InstanceStream || batch.IsInstanced || batch.Size() < 2)
+            return false;
+
+        if (batch.queue == RenderQueue::UI || batch.queue == RenderQueue::Overlay)
+            return false;
+
+        //batches only share mesh, submesh and material, skinned and pre-instanced models never merge
+        const auto& first = GetBatchPacket(batch, 0);
+        return !first.IsUIElement() && !first.IsSkinned() && first.instanceTransforms == nullptr;
+    }
+
     //Submission processing
-    void Renderer::ProcessModelSubmission(std::shared_ptr<Model> model, std::shared_ptr<Material> materialOverride)
+    void Renderer::ProcessModelSubmission(Model* model, Material* materialOverride, SubmissionBucket& bucket)
     {
         if (!model || !model->IsValid())
         {
@@ -622,286 +1158,663 @@ namespace DXEngine {
         }
 
 
-        model->EnsureDefaultMaterials();
+        model->EnsureDefaultMaterials();
+
+        //frustum culling check, then the projected size, then occlusion against the occluders submitted so far
+        const bool occlusion = s_OcclusionBuffer && s_OcclusionBuffer->HasOccluders();
+        if (s_FrustumCullingEnabled || s_ContributionCullingEnabled || occlusion)
+        {
+            const bool timed = s_PhaseTimingsEnabled;
+            const PhaseClock::time_point cullStart = timed ? PhaseClock::now() : PhaseClock::time_point{};
+            const bool visible = !s_FrustumCullingEnabled || IsModelVisible(model);
+            const bool tooSmall = visible && IsModelTooSmall(model);
+            const bool occluded = visible && !tooSmall && occlusion && IsModelOccluded(model);
+            if (timed)
+            {
+                bucket.cullNanoseconds += ElapsedNanoseconds(cullStart);
+            }
+            if (!visible)
+            {
+                bucket.modelsCulled++;
+                return;
+            }
+            if (tooSmall)
+            {
+                bucket.modelsTooSmall++;
+                return;
+            }
+            if (occluded)
+            {
+                bucket.modelsOccluded++;
+                return;
+            }
+        }
+
+        bucket.modelsVisible++;
+        SubmitModelPackets(model, materialOverride, bucket);
+    }
+
+    void Renderer::ProcessModelSlice(std::span<const std::shared_ptr<Model>> models, SubmissionBucket& bucket)
+    {
+        //bounds of the whole slice go into SoA buffers and are culled in one pass
+        thread_local std::vector<Model*> t_Models;
+        thread_local CullingBounds t_Bounds;
+        thread_local std::vector<uint32_t> t_Visible;
+        t_Models.clear();
+        t_Bounds.Clear();
+
+        const bool culling = s_FrustumCullingEnabled && s_FrustumValid;
+        const bool timed = s_PhaseTimingsEnabled && culling;
+        const PhaseClock::time_point cullStart = timed ? PhaseClock::now() : PhaseClock::time_point{};
+
+        for (const auto& model : models)
+        {
+            if (!model || !model->IsValid() || !model->IsVisible())
+                continue;
+
+            bucket.modelsSubmitted++;
+            t_Models.push_back(model.get());
+            if (culling)
+            {
+                BoundingSphere sphere;
+                BoundingBox box;
+                GetModelCullBounds(model.get(), sphere, box);
+                t_Bounds.Add(sphere, box);
+            }
+        }
+
+        const uint32_t modelCount = static_cast<uint32_t>(t_Models.size());
+        uint32_t visibleCount = modelCount;
+        t_Visible.resize(modelCount);
+        if (culling)
+        {
+            visibleCount = CullBounds(s_FrustumPlanes, t_Bounds, 0, modelCount, t_Visible.data());
+            bucket.modelsCulled += modelCount - visibleCount;
+            if (timed)
+            {
+                bucket.cullNanoseconds += ElapsedNanoseconds(cullStart);
+            }
+        }
+        else
+        {
+            for (uint32_t i = 0; i < modelCount; ++i)
+            {
+                t_Visible[i] = i;
+            }
+        }
+
+        //projected size of what the frustum kept, from the spheres gathered for it
+        if (s_ContributionCullingEnabled && s_FrustumValid)
+        {
+            uint32_t largeCount = 0;
+            for (uint32_t i = 0; i < visibleCount; ++i)
+            {
+                const uint32_t index = t_Visible[i];
+                const bool tooSmall = culling ? IsModelTooSmall(t_Models[index], t_Bounds.GetSphere(index)) : IsModelTooSmall(t_Models[index]);
+                if (!tooSmall)
+                    t_Visible[largeCount++] = index;
+            }
+            bucket.modelsTooSmall += visibleCount - largeCount;
+            visibleCount = largeCount;
+        }
+
+        //occlusion only tests what the frustum kept, reusing the boxes gathered for it
+        if (s_OcclusionBuffer && s_OcclusionBuffer->HasOccluders())
+        {
+            const PhaseClock::time_point occlusionStart = s_PhaseTimingsEnabled ? PhaseClock::now() : PhaseClock::time_point{};
+            uint32_t unoccludedCount = 0;
+            for (uint32_t i = 0; i < visibleCount; ++i)
+            {
+                const uint32_t index = t_Visible[i];
+                const BoundingBox box = culling ? t_Bounds.GetBox(index) : t_Models[index]->GetWorldBoundingBox();
+                if (!s_OcclusionBuffer->IsOccluded(box))
+                    t_Visible[unoccludedCount++] = index;
+            }
+            bucket.modelsOccluded += visibleCount - unoccludedCount;
+            visibleCount = unoccludedCount;
+            if (s_PhaseTimingsEnabled)
+            {
+                bucket.cullNanoseconds += ElapsedNanoseconds(occlusionStart);
+            }
+        }
+        bucket.modelsVisible += visibleCount;
+
+        for (uint32_t i = 0; i < visibleCount; ++i)
+        {
+            SubmitModelPackets(t_Models[t_Visible[i]], nullptr, bucket);
+        }
+    }
+
+    void Renderer::SubmitModelPackets(Model* model, Material* materialOverride, SubmissionBucket& bucket)
+    {
+        //instanced models draw only the instances inside the frustum, shared by every submesh
+        const DirectX::XMFLOAT4X4* instanceTransforms = nullptr;
+        uint32_t instanceCount = 0;
+        if (model->IsInstanced() && !CullModelInstances(model, bucket, instanceTransforms, instanceCount))
+            return;
+
+        //models split into several draws test each one, unless the whole model is inside
+        uint32_t planeMask = 0;
+        DirectX::XMMATRIX modelMatrix = DirectX::XMMatrixIdentity();
+        if (ShouldCullSubmeshes(model))
+        {
+            planeMask = FrustumPlanes::AllPlanes;
+            if (s_FrustumPlanes.Classify(model->GetWorldBoundingBox(), planeMask) != CullResult::Intersects)
+                planeMask = 0;
+            else
+                modelMatrix = model->GetModelMatrix();
+        }
 
-        //frustum culling check
-        if (s_FrustumCullingEnabled && !IsModelVisible(model.get(), RenderCommand::GetCamera()))
+        //models with levels draw the selected level's meshes, and the previous level's while fading;
+        //SubmitRange and SubmitScene picked the level before their slices, only Submit selects it here
+        LODData* lod = model->HasLOD() ? model->GetLODData() : nullptr;
+        if (lod && lod->levels.empty())
+            lod = nullptr;
+        if (lod)
+            SelectLODLevel(model, *lod, bucket);
+        const bool fading = lod && lod->IsFading();
+
+        //the model passed the smallest threshold, queues with higher ones still drop their draws
+        float pixelRadius = FLT_MAX;
+        if (s_ContributionCullingEnabled && s_FrustumValid && model->IsContributionCullable())
         {
-            return;
+            BoundingSphere sphere;
+            BoundingBox box;
+            GetModelCullBounds(model, sphere, box);
+            pixelRadius = GetPixelRadius(sphere);
         }
 
         //submit all meshes in that model
         for (size_t meshIndex = 0; meshIndex < model->GetMeshCount(); ++meshIndex)
         {
-            auto mesh = model->GetMesh(meshIndex);
+            const auto& mesh = model->GetMesh(meshIndex);
             if (!mesh || !mesh->IsValid())
                 continue;
 
+            size_t level = 0;
+            float lodFade = 0.0f;
+            if (lod)
+            {
+                const size_t meshLevel = lod->FindLevel(meshIndex);
+                if (meshLevel == lod->currentLevel)
+                {
+                    level = meshLevel;
+                    lodFade = fading ? lod->fadeProgress : 0.0f;
+                }
+                else if (fading && meshLevel == lod->previousLevel)
+                {
+                    level = meshLevel;
+                    lodFade = -lod->fadeProgress;
+                }
+                else if (meshLevel != LODData::NoLevel)
+                {
+                    continue;
+                }
+            }
+            const size_t statLevel = std::min<size_t>(level, SubmissionBucket::LODStatLevels - 1);
+
             //submit all the submeshes
             size_t submeshCount = std::max(size_t(1), mesh->GetSubmeshCount());
             for (size_t submeshIndex = 0; submeshIndex < submeshCount; ++submeshIndex)
             {
-                DXEngine::RenderSubmission submission = DXEngine::RenderSubmission::CreateFromModel(model.get(), meshIndex, submeshIndex);
+                //meshes built without bounds keep an empty box and are always drawn
+                const BoundingBox localBox = planeMask != 0 ? mesh->GetSubmeshBounds(submeshIndex) : BoundingBox();
+                if (localBox.min.x <= localBox.max.x)
+                {
+                    uint32_t submeshMask = planeMask;
+                    const BoundingBox worldBox = TransformBoundingBox(localBox, modelMatrix);
+                    if (s_FrustumPlanes.Classify(worldBox, submeshMask) == CullResult::Outside)
+                    {
+                        bucket.submeshesCulled++;
+                        continue;
+                    }
+                }
 
-                if (materialOverride)
+                if (pixelRadius < s_MaxContributionThreshold)
                 {
-                    submission.materialOverride = materialOverride;
-                    submission.queue = materialOverride->GetRenderQueue();
+                    const Material* material = materialOverride ? materialOverride : model->GetMaterial(meshIndex, submeshIndex).get();
+                    const RenderQueue queue = material ? material->GetRenderQueue() : RenderQueue::Opaque;
+                    if (pixelRadius < GetContributionThreshold(queue, model->CastsShadows()))
+                    {
+                        bucket.submeshesTooSmall++;
+                        continue;
+                    }
                 }
-                if (submission.IsValid())
+
+                RenderPacket packet;
+                if (BuildModelPacket(model, meshIndex, submeshIndex, materialOverride, bucket.tables, packet))
                 {
-                    ValidateSubmission(submission);
-                    s_RenderSubmissions.push_back(submission);
-                    s_Stats.submissionProcessed++;
+                    const uint32_t triangles = static_cast<uint32_t>(mesh->GetSubmeshIndexCount(submeshIndex) / 3);
 
                     //update stats based on features
-                    if (model->IsInstanced())
+                    if (packet.IsInstanced())
                     {
-                        s_Stats.instancesRendered += static_cast<uint32_t>(model->GetInstanceCount());
+                        packet.instanceTransforms = instanceTransforms;
+                        packet.instanceCount = instanceCount;
+                        bucket.instancesSubmitted += instanceCount;
+                        bucket.lodTriangles[statLevel] += triangles * instanceCount;
                     }
+                    else
+                    {
+                        bucket.lodTriangles[statLevel] += triangles;
+                    }
+
+                    packet.lodFade = lodFade;
+                    PushBucketPacket(bucket, packet);
+                }
+            }
+        }
+
+    }
+
+    bool Renderer::ShouldCullSubmeshes(const Model* model)
+    {
+        //skinned vertices leave their bind pose bounds and instanced draws are culled per instance
+        if (!s_FrustumCullingEnabled || !s_FrustumValid || model->IsSkinned() || model->IsInstanced())
+            return false;
+        return model->GetTotalSubmeshCount() > 1;
+    }
+
+    bool Renderer::CullModelInstances(const Model* model, SubmissionBucket& bucket, const DirectX::XMFLOAT4X4*& outTransforms, uint32_t& outCount)
+    {
+        const InstanceData* instanceData = model->GetInstanceData();
+        outTransforms = instanceData ? instanceData->transforms.data() : nullptr;
+        outCount = instanceData ? static_cast<uint32_t>(instanceData->GetInstanceCount()) : 0;
+        if (outCount == 0 || !s_FrustumCullingEnabled || !s_FrustumValid)
+            return true;
+
+        const bool timed = s_PhaseTimingsEnabled;
+        const PhaseClock::time_point cullStart = timed ? PhaseClock::now() : PhaseClock::time_point{};
+
+        //chunks outside are skipped and chunks inside taken whole, only straddling ones test each instance
+        const CullingBounds& bounds = model->GetInstanceCullBounds();
+        const std::vector<BoundingBox>& chunks = model->GetInstanceChunkBounds();
+        thread_local std::vector<uint32_t> t_VisibleInstances;
+        t_VisibleInstances.resize(outCount);
+
+        uint32_t visibleCount = 0;
+        for (uint32_t chunk = 0; chunk < chunks.size(); ++chunk)
+        {
+            const uint32_t begin = chunk * Model::InstanceChunkSize;
+            const uint32_t end = std::min(outCount, begin + Model::InstanceChunkSize);
+            uint32_t planeMask = FrustumPlanes::AllPlanes;
+            const CullResult result = s_FrustumPlanes.Classify(chunks[chunk], planeMask);
+            if (result == CullResult::Inside)
+            {
+                for (uint32_t i = begin; i < end; ++i)
+                {
+                    t_VisibleInstances[visibleCount++] = i;
                 }
             }
+            else if (result == CullResult::Intersects)
+            {
+                visibleCount += CullBounds(s_FrustumPlanes, bounds, begin, end, t_VisibleInstances.data() + visibleCount);
+            }
+        }
+
+        bucket.instancesCulled += outCount - visibleCount;
+        if (visibleCount < outCount && visibleCount > 0)
+        {
+            //compacted copy lives in the bucket arena until the frame is drawn
+            DirectX::XMFLOAT4X4* compacted = bucket.arena.AllocateArray<DirectX::XMFLOAT4X4>(visibleCount);
+            for (uint32_t i = 0; i < visibleCount; ++i)
+            {
+                compacted[i] = instanceData->transforms[t_VisibleInstances[i]];
+            }
+            outTransforms = compacted;
+            outCount = visibleCount;
         }
 
+        if (timed)
+        {
+            bucket.cullNanoseconds += ElapsedNanoseconds(cullStart);
+        }
+        return visibleCount > 0;
     }
 
     //culling and LOD
-    bool Renderer::IsModelVisible(const Model* model, const std::shared_ptr<Camera>& camera)
+    bool Renderer::IsModelVisible(const Model* model)
     {
-        if (!model || !camera)
+        if (!model || !s_FrustumValid)
             return true; // If no model or camera, assume visible to prevent accidental culling
 
-        // Get the model's world bounding sphere
-        BoundingSphere worldSphere = model->GetWorldBoundingSphere();
+        BoundingSphere sphere;
+        BoundingBox box;
+        GetModelCullBounds(model, sphere, box);
+        return s_FrustumPlanes.IsVisible(sphere, box);
+    }
 
-        // Create DirectX bounding sphere
-        DirectX::BoundingSphere dxWorldSphere(
-            DirectX::XMFLOAT3(worldSphere.center.x, worldSphere.center.y, worldSphere.center.z),
-            worldSphere.radius
-        );
+    bool Renderer::IsModelOccluded(const Model* model)
+    {
+        if (!model || !s_OcclusionBuffer || !s_OcclusionBuffer->HasOccluders())
+            return false;
+        return s_OcclusionBuffer->IsOccluded(model->GetWorldBoundingBox());
+    }
 
-        // Get view and projection matrices
-        DirectX::XMMATRIX view = camera->GetView();
-        DirectX::XMMATRIX proj = camera->GetProjection();
+    void Renderer::GetModelCullBounds(const Model* model, BoundingSphere& sphere, BoundingBox& box)
+    {
+        box = model->GetWorldBoundingBox();
+        if (model->IsInstanced())
+        {
+            //the model sphere ignores instance transforms, the box covers every instance
+            sphere = BoundingSphere(box.GetCenter(), box.GetRadius());
+        }
+        else
+        {
+            sphere = model->GetWorldBoundingSphere();
+        }
 
-        // Create frustum in projection space first
-        DirectX::BoundingFrustum frustum(proj);
+        // Add a small bias to the sphere radius to prevent edge cases
+        sphere.radius *= 1.05f;
+    }
 
-        // Transform frustum to world space using inverse view matrix
-        DirectX::XMMATRIX invView = DirectX::XMMatrixInverse(nullptr, view);
-        DirectX::BoundingFrustum worldSpaceFrustum;
-        frustum.Transform(worldSpaceFrustum, invView);
+    float Renderer::GetScreenSize(const BoundingSphere& sphere)
+    {
+        //projected diameter over the viewport height, a camera inside the sphere sees it fill the screen
+        const float depth = s_ViewDepthPlane.x * sphere.center.x + s_ViewDepthPlane.y * sphere.center.y +
+            s_ViewDepthPlane.z * sphere.center.z + s_ViewDepthPlane.w;
+        if (depth <= sphere.radius)
+            return FLT_MAX;
+        return sphere.radius * s_ProjectionScaleY / depth;
+    }
 
-        // Add a small bias to the sphere radius to prevent edge cases
-        dxWorldSphere.Radius *= 1.05f; // 5% larger radius for safety (reduced from 10%)
+    float Renderer::GetPixelRadius(const BoundingSphere& sphere)
+    {
+        //screen size is the radius in NDC, which spans half the viewport height
+        const float screenSize = GetScreenSize(sphere);
+        return screenSize == FLT_MAX ? FLT_MAX : screenSize * s_ViewportHalfHeight;
+    }
 
-        // Check containment
-        DirectX::ContainmentType containment = worldSpaceFrustum.Contains(dxWorldSphere);
+    bool Renderer::IsModelTooSmall(const Model* model)
+    {
+        if (!s_ContributionCullingEnabled || !s_FrustumValid || !model->IsContributionCullable())
+            return false;
 
-        // Log culling decisions in debug mode
-#ifdef DX_DEBUG
-      //  if (containment == DirectX::DISJOINT) {
-      //      std::string debugMsg = "Model culled - Center: (" +
-      //          std::to_string(worldSphere.center.x) + ", " +
-      //          std::to_string(worldSphere.center.y) + ", " +
-      //          std::to_string(worldSphere.center.z) + ") Radius: " +
-      //          std::to_string(worldSphere.radius) + "\n";
-      //      OutputDebugStringA(debugMsg.c_str());
-      //  }
-#endif
+        BoundingSphere sphere;
+        BoundingBox box;
+        GetModelCullBounds(model, sphere, box);
+        return IsModelTooSmall(model, sphere);
+    }
+
+    bool Renderer::IsModelTooSmall(const Model* model, const BoundingSphere& sphere)
+    {
+        //hero models opt out, and without a camera there is no projection to measure against
+        if (!s_ContributionCullingEnabled || !s_FrustumValid || !model->IsContributionCullable())
+            return false;
+
+        const float threshold = model->CastsShadows() ?
+            std::min(s_MinContributionThreshold, s_ShadowContributionThreshold) : s_MinContributionThreshold;
+        if (GetPixelRadius(sphere) >= threshold)
+            return false;
 
-        // Consider both CONTAINS and INTERSECTS as visible
-        return containment != DirectX::DISJOINT;
+        //only small models pay for the material walk
+        return !HasUncullableQueue(model);
     }
 
-    size_t Renderer::SelectLODLevel(const Model* model, const std::shared_ptr<Camera>& camera)
+    float Renderer::GetContributionThreshold(RenderQueue queue, bool castsShadows)
     {
-        if (!model || !camera)
-            return 0;
+        const int index = ContributionQueueIndex(queue);
+        if (index < 0)
+            return 0.0f;
+        const float threshold = s_ContributionThresholds[index];
+        return castsShadows ? std::min(threshold, s_ShadowContributionThreshold) : threshold;
+    }
 
-        //simple distance-based LOD selection
-        DirectX::XMVECTOR cameraPos = camera->GetPos();
-        DirectX::XMVECTOR modelPos = model->GetTranslation();
-        DirectX::XMVECTOR distance = DirectX::XMVector3Length(DirectX::XMVectorSubtract(modelPos, cameraPos));
+    void Renderer::SetContributionThreshold(RenderQueue queue, float pixelRadius)
+    {
+        const int index = ContributionQueueIndex(queue);
+        if (index < 0)
+        {
+            OutputDebugStringA("Renderer: UI and overlay queues are not contribution culled\n");
+            return;
+        }
+        s_ContributionThresholds[index] = std::max(pixelRadius, 0.0f);
+        UpdateContributionLimits();
+    }
+
+    void Renderer::SetShadowCasterContributionThreshold(float pixelRadius)
+    {
+        s_ShadowContributionThreshold = std::max(pixelRadius, 0.0f);
+    }
+
+    void Renderer::UpdateContributionLimits()
+    {
+        s_MinContributionThreshold = *std::min_element(std::begin(s_ContributionThresholds), std::end(s_ContributionThresholds));
+        s_MaxContributionThreshold = *std::max_element(std::begin(s_ContributionThresholds), std::end(s_ContributionThresholds));
+    }
+
+    size_t Renderer::SelectLODLevel(const Model* model, LODData& lod, SubmissionBucket& bucket)
+    {
+        //levels advance once per frame, models drawn by several passes keep the first result
+        if (lod.lastUpdateFrame == s_FrameCount)
+            return lod.currentLevel;
+        const bool seenLastFrame = lod.lastUpdateFrame + 1 == s_FrameCount;
+        lod.lastUpdateFrame = s_FrameCount;
+
+        //a running fade finishes before the level may change again, models coming back into view snap
+        if (lod.IsFading())
+        {
+            const bool advance = seenLastFrame && s_LODFadeFrames > 0;
+            lod.fadeProgress = advance ? lod.fadeProgress + 1.0f / static_cast<float>(s_LODFadeFrames) : 1.0f;
+            if (lod.fadeProgress < 1.0f)
+                return lod.currentLevel;
+            lod.fadeProgress = 1.0f;
+        }
 
-        float distanceValue = DirectX::XMVectorGetX(distance);
+        //instanced models pick one level for every instance from their combined bounds
+        BoundingSphere sphere;
+        BoundingBox box;
+        GetModelCullBounds(model, sphere, box);
+        const float screenSize = GetScreenSize(sphere) * std::exp2(-s_LODBias);
 
-        //LOD Threshholds (configurable)
-        if (distanceValue < 50.0f)return 0;      //high detail
-        else if (distanceValue < 150.0f)return 1;//medium detail
-        else return 2;                           //low Detail
+        const size_t level = lod.SelectLevel(screenSize, s_LODHysteresis);
+        if (level != lod.currentLevel)
+        {
+            bucket.lodTransitions++;
+            lod.previousLevel = lod.currentLevel;
+            lod.currentLevel = level;
+            lod.fadeProgress = (seenLastFrame && s_LODFadeFrames > 1) ? 1.0f / static_cast<float>(s_LODFadeFrames) : 1.0f;
+        }
+        return lod.currentLevel;
+    }
+
+    void Renderer::SelectLODBeforeSlices(Model* model, bool culling, SubmissionBucket& bucket)
+    {
+        LODData* lod = model->HasLOD() ? model->GetLODData() : nullptr;
+        if (!lod || lod->levels.empty())
+            return;
 
+        //models the slices will cull keep last frame's state, so they still snap when they come back into view
+        if (culling && !IsModelVisible(model))
+            return;
+        SelectLODLevel(model, *lod, bucket);
     }
 
     ///Rendering methods
-    void Renderer::RenderSubmission(const DXEngine::RenderSubmission& submission)
+    void Renderer::DrawPacket(const RenderPacket& packet)
     {
-        if (!submission.IsValid()) {
+        if (!IsPacketValid(packet, s_Tables)) {
             OutputDebugStringA("Warning: Attempting to render invalid submission\n");
             return;
         }
 
-        // Track current submission for shader variant selection
-        s_CurrentRenderSubmission = &submission;
-
-        if (submission.isUIElement) {
-            RenderUIElement(submission);
+        if (packet.IsUIElement()) {
+            RenderUIElement(packet);
         }
-        else if (submission.instanceTransforms && submission.instanceCount > 0) {
-            RenderInstanceMesh(submission);
+        else if (packet.IsInstanced()) {
+            RenderInstanceMesh(packet);
         }
-        else if (submission.boneMatrices) {
-            RenderSkinnedMesh(submission);
+        else if (packet.IsSkinned()) {
+            RenderSkinnedMesh(packet);
         }
         else {
-            RenderMesh(submission);
+            RenderMesh(packet);
         }
-
-        // Clear current submission
-        s_CurrentRenderSubmission = nullptr;
     }
-    void Renderer::RenderMesh(const DXEngine::RenderSubmission& submission)
+
+    void Renderer::RenderMesh(const RenderPacket& packet)
     {
-        if (!submission.mesh || !submission.mesh->IsValid())
+        Mesh* mesh = s_Tables.meshes.Get(packet.mesh);
+        if (!mesh || !mesh->IsValid())
             return;
 
-        auto material = submission.GetEffectiveMaterial();
+        Material* material = s_Tables.materials.Get(packet.material);
         if (!material)
             return;
 
-        //Bind Material and Shader
+        //Bind Material
         BindMaterial(material);
-        BindShaderForMaterial(material, submission.mesh);
         //Transform buffers
-        SetupTransformBuffer(submission);
+        SetupTransformBuffer(packet);
 
-        //getShader
-        const void* shaderByteCode = nullptr;
-        size_t byteCodeLength = 0;
-        if (s_CurrentShader)
-        {
-            auto blob = s_CurrentShader->GetByteCode();
-            if (blob)
-            {
-                shaderByteCode = blob->GetBufferPointer();
-                byteCodeLength = blob->GetBufferSize();
-            }
-        }
-        //bind mesh and render
-        submission.mesh->Bind(shaderByteCode, byteCodeLength);
-        submission.mesh->Draw(submission.submeshIndex);
+        //bind pipeline and mesh, render
+        BindPipeline(packet.pipeline, material, mesh, s_ShaderTable.Get(packet.shader));
+        mesh->Draw(packet.submeshIndex);
 
         s_Stats.drawCalls++;
         s_Stats.meshesRendered++;
         s_Stats.submeshesRendered++;
 
-        auto meshResource = submission.mesh->GetResource();
+        const auto& meshResource = mesh->GetResource();
         if (meshResource && meshResource->GetIndexData())
         {
-            uint32_t indexCount = submission.mesh->GetIndexCount();
+            //only the drawn submesh's range, not the whole mesh
+            const uint32_t indexCount = static_cast<uint32_t>(mesh->GetSubmeshIndexCount(packet.submeshIndex));
             s_Stats.trianglesRendered += indexCount / 3;
         }
     }
 
-    void Renderer::RenderInstanceMesh(const DXEngine::RenderSubmission& submission)
+    void Renderer::RenderInstanceMesh(const RenderPacket& packet)
     {
-        if (!submission.mesh || !submission.mesh->IsValid() ||
-            !submission.instanceTransforms || submission.instanceCount == 0)
+        Mesh* mesh = s_Tables.meshes.Get(packet.mesh);
+        if (!mesh || !mesh->IsValid() || !packet.IsInstanced())
             return;
 
-        auto material = submission.GetEffectiveMaterial();
+        Material* material = s_Tables.materials.Get(packet.material);
         if (!material)
             return;
 
-        //Bind material and Shader
+        //Bind material
         BindMaterial(material);
-        BindShaderForMaterial(material,submission.mesh);
 
         //setup Transform and instance buffers
-        SetupTransformBuffer(submission);
-        SetupInstanceBuffer(submission);
-
-        //Get ShaderByteCode
-        const void* shaderByteCode = nullptr;
-        size_t byteCodeLength = 0;
-        if(s_CurrentShader)
-        {
-            auto blob = s_CurrentShader->GetByteCode();
-            if (blob)
-            {
-                shaderByteCode = blob->GetBufferPointer();
-                byteCodeLength = blob->GetBufferSize();
-            }
-        }
+        SetupTransformBuffer(packet);
+        const uint32_t instanceCount = SetupInstanceBuffer(packet);
+        if (instanceCount == 0)
+            return;
 
-        //bind mesh and render instanced
-        submission.mesh->Bind(shaderByteCode, byteCodeLength);
-        submission.mesh->DrawInstanced(static_cast<uint32_t>(submission.instanceCount), submission.submeshIndex);
+        //bind pipeline and mesh, render instanced
+        BindPipeline(packet.pipeline, material, mesh, s_ShaderTable.Get(packet.shader), true);
+        mesh->DrawInstanced(instanceCount, packet.submeshIndex);
 
         //update statistics
         s_Stats.instanceDrawCalls++;
         s_Stats.meshesRendered++;
-        s_Stats.instancesRendered += static_cast<uint32_t>(submission.submeshIndex);
+        s_Stats.instancesRendered += instanceCount;
 
-        auto meshResource = submission.mesh->GetResource();
+        const auto& meshResource = mesh->GetResource();
         if (meshResource && meshResource->GetIndexData())
         {
-            uint32_t indexCount = submission.mesh->GetIndexCount();
-            s_Stats.trianglesRendered += (indexCount / 3) * static_cast<uint32_t>(submission.instanceCount);
+            const uint32_t indexCount = static_cast<uint32_t>(mesh->GetSubmeshIndexCount(packet.submeshIndex));
+            s_Stats.trianglesRendered += (indexCount / 3) * instanceCount;
         }
     }
 
-    void Renderer::RenderSkinnedMesh(const DXEngine::RenderSubmission& submission)
+    void Renderer::RenderInstancedBatch(const DXEngine::RenderBatch& batch)
     {
-        if (!submission.mesh || !submission.mesh->IsValid() || !submission.boneMatrices)
+        const auto& first = GetBatchPacket(batch, 0);
+        Mesh* mesh = s_Tables.meshes.Get(first.mesh);
+        if (!mesh || !mesh->IsValid())
             return;
 
-        auto material = submission.GetEffectiveMaterial();
+        Material* material = s_Tables.materials.Get(first.material);
         if (!material)
             return;
 
-        // Bind material and shader
-        BindMaterial(material);
-        BindShaderForMaterial(material, submission.mesh);
-
-        // Setup transform and skinning buffers
-        SetupTransformBuffer(submission);
-        SetupSkinnedBuffer(submission);
+        //pack the world matrices of the whole batch into this frame's instance stream
+        s_BatchTransforms.clear();
+        ReserveTracked(s_BatchTransforms, batch.count, s_Stats.frameHeapAllocations);
+        for (uint32_t i = 0; i < batch.count; ++i)
+        {
+            s_BatchTransforms.push_back(GetBatchPacket(batch, i).modelMatrix);
+        }
 
-        // Get shader bytecode
-        const void* shaderByteCode = nullptr;
-        size_t byteCodeLength = 0;
-        if (s_CurrentShader)
+        const uint32_t instanceCount = batch.count;
+        UINT streamOffset = 0;
+        if (!s_InstanceStream->Append(s_BatchTransforms.data(), instanceCount, streamOffset))
         {
-            auto blob = s_CurrentShader->GetByteCode();
-            if (blob)
+            //stream unavailable this frame, draw the batch one by one
+            for (uint32_t i = 0; i < batch.count; ++i)
             {
-                shaderByteCode = blob->GetBufferPointer();
-                byteCodeLength = blob->GetBufferSize();
+                DrawPacket(GetBatchPacket(batch, i));
             }
+            return;
+        }
+
+        //the batch draws with the instancing variant, not the shader its packets resolved
+        const RenderHandle shader = ResolveShaderHandle(first.material, first.mesh, true);
+        BindMaterial(material);
+
+        //view, projection and camera come from the transform buffer, the model matrix from the stream
+        SetupTransformBuffer(first);
+        s_InstanceStream->Bind(1, streamOffset);
+
+        BindPipeline(ResolvePipelineHandle(first.material, first.mesh, shader, true), material, mesh, s_ShaderTable.Get(shader), true);
+
+        mesh->DrawInstanced(instanceCount, first.submeshIndex);
+
+        s_Stats.instanceDrawCalls++;
+        s_Stats.meshesRendered += instanceCount;
+        s_Stats.submeshesRendered += instanceCount;
+        s_Stats.instancesRendered += instanceCount;
+        s_Stats.submissionsInstanced += instanceCount;
+
+        const auto& meshResource = mesh->GetResource();
+        if (meshResource && meshResource->GetIndexData())
+        {
+            const uint32_t indexCount = static_cast<uint32_t>(mesh->GetSubmeshIndexCount(first.submeshIndex));
+            s_Stats.trianglesRendered += (indexCount / 3) * instanceCount;
         }
+    }
+
+    void Renderer::RenderSkinnedMesh(const RenderPacket& packet)
+    {
+        Mesh* mesh = s_Tables.meshes.Get(packet.mesh);
+        if (!mesh || !mesh->IsValid() || !packet.IsSkinned())
+            return;
+
+        Material* material = s_Tables.materials.Get(packet.material);
+        if (!material)
+            return;
+
+        // Bind material
+        BindMaterial(material);
 
+        // Setup transform and skinning buffers
+        SetupTransformBuffer(packet);
+        SetupSkinnedBuffer(packet);
 
-        // Bind mesh and render
-        submission.mesh->Bind(shaderByteCode, byteCodeLength);
-        submission.mesh->Draw(submission.submeshIndex);
+        // Bind pipeline and mesh, render
+        BindPipeline(packet.pipeline, material, mesh, s_ShaderTable.Get(packet.shader));
+        mesh->Draw(packet.submeshIndex);
 
         // Update statistics
         s_Stats.drawCalls++;
         s_Stats.meshesRendered++;
         s_Stats.submeshesRendered++;
 
-        auto meshResource = submission.mesh->GetResource();
+        const auto& meshResource = mesh->GetResource();
         if (meshResource && meshResource->GetIndexData())
         {
-            uint32_t indexCount = submission.mesh->GetIndexCount();
+            const uint32_t indexCount = static_cast<uint32_t>(mesh->GetSubmeshIndexCount(packet.submeshIndex));
             s_Stats.trianglesRendered += indexCount / 3;
         }
     }
     
-    void Renderer::RenderUIElement(const DXEngine::RenderSubmission& submission)
+    void Renderer::RenderUIElement(const RenderPacket& packet)
     {
-        if (!submission.uiElement || !s_UIQuadModel)
+        UIElement* element = s_Tables.uiElements.Get(packet.uiElement);
+        if (!element || !s_UIQuadModel)
             return;
 
             //save current render state
@@ -909,35 +1822,35 @@ namespace DXEngine {
             SetUIRenderState();
 
             //get UI element bounds and Properties
-            const UIRect& bounds = submission.uiElement->GetBounds();
+            const UIRect& bounds = element->GetBounds();
 
             DirectX::XMMATRIX scaleMatrix = DirectX::XMMatrixScaling(bounds.width, bounds.height, 1.0f);
             DirectX::XMMATRIX translationMatrix = DirectX::XMMatrixTranslation(bounds.x, bounds.y, 0.0f);
             DirectX::XMMATRIX modelMatrix = scaleMatrix * translationMatrix;
 
             // Determine material to use
-            auto materialToUse = submission.GetEffectiveMaterial();
+            Material* materialToUse = s_Tables.materials.Get(packet.material);
             if (!materialToUse)
-                materialToUse = s_DefaultUIMaterial;
+                materialToUse = s_DefaultUIMaterial.get();
 
             // Handle element-specific properties
-            if (auto button = std::dynamic_pointer_cast<UIButton>(submission.uiElement))
+            if (auto* button = dynamic_cast<UIButton*>(element))
             {
                 UIColor buttonColor = GetButtonColorForState(button);
                 materialToUse->SetDiffuseColor({ buttonColor.r, buttonColor.g, buttonColor.b, buttonColor.a });
             }
-            else if (auto panel = std::dynamic_pointer_cast<UIPanel>(submission.uiElement))
+            else if (auto* panel = dynamic_cast<UIPanel*>(element))
             {
                 UIColor panelColor = GetPanelColor(panel);
                 materialToUse->SetDiffuseColor({ panelColor.r, panelColor.g, panelColor.b, panelColor.a });
             }
-            else if (auto text = std::dynamic_pointer_cast<UIText>(submission.uiElement))
+            else if (auto* text = dynamic_cast<UIText*>(element))
             {
                 UIColor textColor = text->GetColor();
                 materialToUse->SetDiffuseColor({ textColor.r, textColor.g, textColor.b, textColor.a });
             }
 
-            auto mesh = s_UIQuadModel->GetMesh();
+            Mesh* mesh = s_UIQuadModel->GetMesh().get();
             if (!mesh || !mesh->IsValid()) {
                 OutputDebugStringA("Warning: UI quad mesh is invalid\n");
                 PopRenderState();
@@ -946,41 +1859,25 @@ namespace DXEngine {
 
             // Bind Material and shader
             BindMaterial(materialToUse);
-            BindShaderForMaterial(materialToUse,mesh);
+            BindShaderForMaterial(materialToUse, mesh);
 
-            // Setup UI constant buffer (register b5)
-            ConstantBuffer<UIConstantBuffer> uiBuffer;
+            // Setup UI constant buffer (register b4)
             DirectX::XMMATRIX identityView = DirectX::XMMatrixIdentity();
-            s_UIBufferData = std::make_unique<UIConstantBuffer>();
-
-            s_UIBufferData->projection = DirectX::XMMatrixTranspose(modelMatrix * identityView * s_UIProjectionMatrix);
-            s_UIBufferData->screenWidth = static_cast<float>(RenderCommand::GetViewportWidth());
-            s_UIBufferData->screenHeight = static_cast<float>(RenderCommand::GetViewportHeight());
-            s_UIBufferData->time = static_cast<float>(s_FrameCount) / 60.0f;
-            s_UIBufferData->padding = 0.0f;
-
-            uiBuffer.Initialize(s_UIBufferData.get());
-
-            
-            uiBuffer.Update(*s_UIBufferData.get());
-
-            RenderCommand::GetContext()->VSSetConstantBuffers(BindSlot::CB_UI, 1, uiBuffer.GetAddressOf());
-
-            // Render the UI quad
-            const void* shaderByteCode = nullptr;
-            size_t byteCodeLength = 0;
-            if (s_CurrentShader)
+            UIConstantBuffer uiData;
+            uiData.projection = DirectX::XMMatrixTranspose(modelMatrix * identityView * s_UIProjectionMatrix);
+            uiData.screenWidth = static_cast<float>(RenderCommand::GetViewportWidth());
+            uiData.screenHeight = static_cast<float>(RenderCommand::GetViewportHeight());
+            uiData.time = static_cast<float>(s_FrameCount) / 60.0f;
+            uiData.padding = 0.0f;
+
+            if (s_ConstantBufferRing)
             {
-                auto blob = s_CurrentShader->GetByteCode();
-                if (blob)
-                {
-                    shaderByteCode = blob->GetBufferPointer();
-                    byteCodeLength = blob->GetBufferSize();
-                }
+                s_ConstantBufferRing->BindVS(BindSlot::CB_UI, uiData);
             }
 
+            // Render the UI quad
             mesh->EnsureGPUResources();
-            mesh->Bind(shaderByteCode, byteCodeLength);
+            mesh->Bind(s_CurrentShader);
             mesh->Draw();
 
             PopRenderState();
@@ -991,7 +1888,7 @@ namespace DXEngine {
 
     ///Bind Material and Shader managment
 
-    void Renderer::BindMaterial(std::shared_ptr<Material> material)
+    void Renderer::BindMaterial(Material* material)
     {
         if (!material)
         {
@@ -1002,7 +1899,7 @@ namespace DXEngine {
         if (material != s_CurrentMaterial)
         {
             // Bind appropriate samplers for this material
-            SamplerManager::Instance().BindSamplersForMaterial(material.get());
+            SamplerManager::Instance().BindSamplersForMaterial(material);
             material->Bind();
 
 
@@ -1011,42 +1908,111 @@ namespace DXEngine {
         }
     }
 
-    void Renderer::BindShaderForMaterial(std::shared_ptr<Material> material, std::shared_ptr<Mesh> mesh)
+    void Renderer::BindShaderForMaterial(Material* material, Mesh* mesh, ShaderProgram* shader)
     {
         if (!s_ShaderManager || !material)
             return;
 
-        // Get appropriate shader variant based on current mesh and material
-        std::shared_ptr<ShaderProgram> shader = nullptr;
+        //packets resolve their shader while sorting
+        if (!shader)
+        {
+            shader = ResolveShader(material, mesh);
+        }
+
+        if (shader && shader != s_CurrentShader) {
+            shader->Bind();
+            s_CurrentShader = shader;
+            s_Stats.shadersChanged++;
+        }
+    }
+
+    void Renderer::BindPipeline(RenderHandle pipeline, Material* material, Mesh* mesh, ShaderProgram* shader, bool instanced)
+    {
+        const PipelineState* state = PipelineStateCache::Instance().Get(pipeline);
+        if (!state || !shader)
+        {
+            //no prebuilt state, bind the shader and let the mesh look up its input layout
+            BindShaderForMaterial(material, mesh, shader);
+            mesh->Bind(s_CurrentShader, instanced);
+            return;
+        }
+
+        RenderCommand::SetPipelineState(*state);
+        if (shader != s_CurrentShader)
+        {
+            s_CurrentShader = shader;
+            s_Stats.shadersChanged++;
+        }
+        mesh->Bind(nullptr, instanced);
+    }
+
+    ShaderProgram* Renderer::ResolveShader(Material* material, Mesh* mesh, bool instanced)
+    {
+        if (!s_ShaderManager || !material)
+            return nullptr;
+
+        // Get appropriate shader variant based on current mesh and material,
+        // the variant manager owns the programs so a raw pointer is safe for the frame
+        ShaderProgram* shader = nullptr;
 
         // Get vertex layout from the mesh being rendered
         if (mesh && mesh->IsValid()) {
             const auto* vertexData = mesh->GetResource()->GetVertexData();
-            if (vertexData) {
-                const VertexLayout& layout = vertexData->GetLayout();
-                shader = s_ShaderManager->GetShaderForMesh(layout, material.get(), material->GetType());
+            //the instance transform in the layout selects the ENABLE_INSTANCING variant
+            const VertexLayout* layout = instanced ? mesh->GetInstancedLayout() : (vertexData ? &vertexData->GetLayout() : nullptr);
+            if (layout) {
+                shader = s_ShaderManager->GetShaderForMesh(*layout, material, material->GetType()).get();
             }
         }
 
         // Fallback if mesh is invalid or shader creation failed
         if (!shader) {
-            shader = s_ShaderManager->GetFallbackShader(material->GetType());
+            shader = s_ShaderManager->GetFallbackShader(material->GetType()).get();
         }
 
-        if (shader && shader != s_CurrentShader) {
-            shader->Bind();
-            s_CurrentShader = shader;
-            s_Stats.shadersChanged++;
-        }
+        return shader;
+    }
+
+    RenderHandle Renderer::ResolveShaderHandle(RenderHandle material, RenderHandle mesh, bool instanced)
+    {
+        //variant lookup runs once per material, mesh and instancing combination per frame
+        const uint64_t key = (uint64_t(material) << 32) | (uint64_t(mesh) << 1) | (instanced ? 1 : 0);
+        const uint32_t cached = s_ShaderLookup.Find(key);
+        if (cached != FrameHashMap::NotFound)
+            return cached;
+
+        ShaderProgram* shader = ResolveShader(s_Tables.materials.Get(material), s_Tables.meshes.Get(mesh), instanced);
+        return s_ShaderLookup.FindOrAdd(key, s_ShaderTable.Register(shader));
+    }
+
+    RenderHandle Renderer::ResolvePipelineHandle(RenderHandle material, RenderHandle mesh, RenderHandle shader, bool instanced)
+    {
+        //the material also decides the queue, so the shader lookup key covers the whole pipeline
+        const uint64_t key = (uint64_t(material) << 32) | (uint64_t(mesh) << 1) | (instanced ? 1 : 0);
+        const uint32_t cached = s_PipelineLookup.Find(key);
+        if (cached != FrameHashMap::NotFound)
+            return cached;
+
+        const Material* materialPtr = s_Tables.materials.Get(material);
+        const Mesh* meshPtr = s_Tables.meshes.Get(mesh);
+        const ShaderProgram* program = s_ShaderTable.Get(shader);
+        const VertexLayout* layout = meshPtr ? meshPtr->GetLayout(instanced) : nullptr;
+        if (!materialPtr || !program || !layout || !layout->IsFinalized())
+            return InvalidRenderHandle;
+
+        const QueueState state = GetQueueState(materialPtr->GetRenderQueue());
+        const PipelineStateKey pipelineKey{ layout->GetID(), program->GetProgramID(), state.rasterizer, state.blend, state.depth };
+        return s_PipelineLookup.FindOrAdd(key, PipelineStateCache::Instance().GetOrCreate(pipelineKey, *layout, *program));
     }
 
-    void Renderer::SetupTransformBuffer(const DXEngine::RenderSubmission& submission)
+    void Renderer::SetupTransformBuffer(const RenderPacket& packet)
     {
-        ConstantBuffer<TransfomBufferData> vsBuffer;
+        if (!s_ConstantBufferRing)
+            return;
 
-        DirectX::XMMATRIX modelMatrix = DirectX::XMLoadFloat4x4(&submission.modelMatrix);
+        DirectX::XMMATRIX modelMatrix = DirectX::XMLoadFloat4x4(&packet.modelMatrix);
 
-        auto camera = RenderCommand::GetCamera();
+        const auto& camera = RenderCommand::GetCamera();
         if (!camera)
         {
             OutputDebugStringA("Warning: No camera available for transform setup\n");
@@ -1056,45 +2022,53 @@ namespace DXEngine {
         auto view = camera->GetView();
         auto proj = camera->GetProjection();
 
-        s_TransformBufferData = std::make_unique<TransfomBufferData>();
-        s_TransformBufferData->WVP = DirectX::XMMatrixTranspose(modelMatrix * view * proj);
-        s_TransformBufferData->Model = DirectX::XMMatrixTranspose(modelMatrix);
-        s_TransformBufferData->View = DirectX::XMMatrixTranspose(view);
-        s_TransformBufferData->Projection = DirectX::XMMatrixTranspose(proj);
-        s_TransformBufferData->cameraPosition = camera->GetPosition();
-        s_TransformBufferData->time = s_Time;
-        vsBuffer.Initialize(s_TransformBufferData.get());
+        TransfomBufferData transformData;
+        transformData.WVP = DirectX::XMMatrixTranspose(modelMatrix * view * proj);
+        transformData.Model = DirectX::XMMatrixTranspose(modelMatrix);
+        transformData.View = DirectX::XMMatrixTranspose(view);
+        transformData.Projection = DirectX::XMMatrixTranspose(proj);
+        transformData.cameraPosition = camera->GetPosition();
+        transformData.time = s_Time;
+        transformData.lodFade = packet.lodFade;
 
-        vsBuffer.Update(*s_TransformBufferData.get());
-
-        RenderCommand::GetContext()->VSSetConstantBuffers(BindSlot::CB_Transform, 1, vsBuffer.GetAddressOf());
+        s_ConstantBufferRing->BindVS(BindSlot::CB_Transform, transformData);
     }
 
-    void Renderer::SetupInstanceBuffer(const DXEngine::RenderSubmission& submission)
+    uint32_t Renderer::SetupInstanceBuffer(const RenderPacket& packet)
     {
-        if (!submission.instanceTransforms || submission.instanceCount == 0)
-            return;
+        const Model* model = s_Tables.models.Get(packet.model);
+        if (!packet.IsInstanced() || !model)
+            return 0;
 
-        auto instanceBuffer = std::make_unique<RawBuffer>();
-        BufferDesc bufferDesc;
-        bufferDesc.bufferType = BufferType::Vertex;
-        bufferDesc.usageType = UsageType::Dynamic; 
-        bufferDesc.byteWidth = static_cast<UINT>(submission.instanceCount * sizeof(DirectX::XMFLOAT4X4));
-        bufferDesc.initialData = submission.instanceTransforms->data();
+        //a culled subset goes through this frame's instance stream, DrawInstanced gets the compacted count
+        if (packet.instanceCount < model->GetInstanceCount() && s_InstanceStream)
+        {
+            UINT streamOffset = 0;
+            if (s_InstanceStream->Append(packet.instanceTransforms, packet.instanceCount, streamOffset))
+            {
+                s_InstanceStream->Bind(1, streamOffset);
+                return packet.instanceCount;
+            }
+        }
 
-        if (!instanceBuffer->Initialize(bufferDesc))
+        //the model keeps its instance stream alive between frames and only uploads dirty ranges
+        UINT bytesUploaded = 0;
+        InstanceBuffer* instanceBuffer = model->EnsureInstanceBuffer(&bytesUploaded);
+        if (!instanceBuffer)
         {
-            return;
+            OutputDebugStringA("Warning: Failed to prepare instance buffer\n");
+            return 0;
         }
-        UINT stride = sizeof(DirectX::XMFLOAT4X4);
-        UINT offset = 0;
 
-        RenderCommand::GetContext()->IASetVertexBuffers(1, 1, instanceBuffer->GetAddressOf(), &stride, &offset);
+        //the full set, also the fallback when the stream had no room for the subset
+        s_Stats.instanceBytesUploaded += bytesUploaded;
+        instanceBuffer->Bind(1);
+        return static_cast<uint32_t>(model->GetInstanceCount());
     }
 
-   void Renderer::SetupSkinnedBuffer(const DXEngine::RenderSubmission& submission)
+   void Renderer::SetupSkinnedBuffer(const RenderPacket& packet)
    {
-       if (!submission.boneMatrices || submission.boneMatrices->empty())
+       if (!packet.boneMatrices || packet.boneMatrices->empty())
        {
            OutputDebugStringA("SetupSkinnedBuffer: No bone matrices available\n");
            return;
@@ -1104,13 +2078,13 @@ namespace DXEngine {
        BoneMatrixBuffer boneData;
 
        // Clamp to the supported maximum
-       const size_t boneCount = std::min(submission.boneMatrices->size(), size_t(128));
+       const size_t boneCount = std::min(packet.boneMatrices->size(), size_t(128));
 
        // so we can copy them directly
        for (size_t i = 0; i < boneCount; ++i)
        {
            // Matrices are already in the correct format from AnimationEvaluator
-           boneData.boneMatrices[i] = (*submission.boneMatrices)[i];
+           boneData.boneMatrices[i] = (*packet.boneMatrices)[i];
        }
 
        // Initialize remaining matrices to identity
@@ -1122,107 +2096,74 @@ namespace DXEngine {
            boneData.boneMatrices[i] = identity;
        }
 
-       // Create and upload the constant buffer
-       ConstantBuffer<BoneMatrixBuffer> boneBuffer;
-       if (!boneBuffer.Initialize(&boneData))
+       // Upload into the constant ring and bind to vertex shader slot b1 (CB_Bones)
+       if (!s_ConstantBufferRing || !s_ConstantBufferRing->BindVS(BindSlot::CB_Bones, boneData))
        {
-           OutputDebugStringA("SetupSkinnedBuffer: Failed to initialize bone buffer\n");
-           return;
+           OutputDebugStringA("SetupSkinnedBuffer: Failed to upload bone matrices\n");
        }
-
-       boneBuffer.Update(boneData);
-
-       // Bind to vertex shader at slot b1 (CB_Bones)
-       RenderCommand::GetContext()->VSSetConstantBuffers(
-           BindSlot::CB_Bones, 1, boneBuffer.GetAddressOf());
    }
 
-    float Renderer::CalculateDistancetoCamera(const DXEngine::RenderSubmission& submission)
+    float Renderer::CalculateDistancetoCamera(const RenderPacket& packet)
     {
-        auto camera = RenderCommand::GetCamera();
+        const auto& camera = RenderCommand::GetCamera();
         if (!camera)
             return 0.0f;
 
-        if (submission.isUIElement)
+        if (packet.IsUIElement())
         {
             // UI elements use submission order for now
             return 0.0f;
         }
 
         DirectX::XMVECTOR cameraPos = camera->GetPos();
-        DirectX::XMMATRIX modelMatrix = DirectX::XMLoadFloat4x4(&submission.modelMatrix);
+        DirectX::XMMATRIX modelMatrix = DirectX::XMLoadFloat4x4(&packet.modelMatrix);
         DirectX::XMVECTOR modelPos = DirectX::XMVector3Transform(DirectX::XMVectorZero(), modelMatrix);
         DirectX::XMVECTOR distance = DirectX::XMVector3Length(DirectX::XMVectorSubtract(modelPos, cameraPos));
 
         return DirectX::XMVectorGetX(distance);
     }
 
-    uint64_t Renderer::GenarateBatchKey(const DXEngine::RenderSubmission& submission)
+    uint64_t Renderer::GenerateSortKey(const RenderPacket& packet, uint32_t sequence)
     {
-        //create a key for batching similar objects together
-        uint64_t key = 0;
+        const uint32_t queueIndex = DrawKey::QueueIndex(packet.queue);
 
-        // Material type (higher priority)
-        key |= (static_cast<uint64_t>(submission.material ? static_cast<int>(submission.material->GetType()) : 0) << 56);
+        if (packet.IsUIElement() || packet.queue == RenderQueue::UI || packet.queue == RenderQueue::Overlay)
+        {
+            return DrawKey::MakeSequential(queueIndex, sequence);
+        }
 
-        // Material pointer (for exact material matching)
-        key |= (reinterpret_cast<uint64_t>(submission.GetEffectiveMaterial().get()) & 0x00FFFFFFFFFFFFFF);
+        const ShaderProgram* shader = s_ShaderTable.Get(packet.shader);
+        const Material* material = s_Tables.materials.Get(packet.material);
+        const Mesh* mesh = s_Tables.meshes.Get(packet.mesh);
+        const uint32_t shaderID = shader ? shader->GetID() : 0;
+        const uint32_t materialID = material ? material->GetID() : 0;
+        const uint32_t meshID = mesh ? mesh->GetID() : 0;
 
-        return key;
-    }
+        if (packet.queue == RenderQueue::Transparent)
+        {
+            return DrawKey::MakeTransparent(queueIndex, shaderID, materialID, meshID, packet.sortKey);
+        }
 
-    uint64_t Renderer::GenerateSortKey(const DXEngine::RenderSubmission& submission)
-    {
-        // Create a key for depth sorting
-        uint32_t depthInt = static_cast<uint32_t>(submission.sortKey * 1000.0f);
-        return static_cast<uint64_t>(depthInt);
+        return DrawKey::MakeOpaque(queueIndex, shaderID, materialID, meshID,
+            packet.submeshIndex, packet.sortKey);
     }
 
     ///validate submission
-    void Renderer::ValidateSubmission(const DXEngine::RenderSubmission& submission)
+    void Renderer::ValidatePacket(const RenderPacket& packet)
     {
-        if (!submission.IsValid())
+#ifdef DX_DEBUG
+        if (!IsPacketValid(packet, s_Tables))
         {
             OutputDebugStringA("Error: Invalid Render Submission\n");
             return;
         }
-        if (submission.isUIElement)
-        {
-            if (!submission.uiElement)
-            {
-                OutputDebugStringA("Warning: UI submission has null UIElement\n");
-            }
-        }
-        else
-        {
-            if (!submission.mesh)
-            {
-                OutputDebugStringA("Warning: 3D submission has null mesh\n");
-                return;
-            }
-
-            if (!submission.mesh->IsValid())
-            {
-                OutputDebugStringA("Warning: Submission has invalid mesh\n");
-                return;
-            }
-
-            if (!submission.sourceModel)
-            {
-                OutputDebugStringA("Warning: Submission missing source model reference\n");
-            }
-        }
-
-        if (!submission.material)
-        {
-            OutputDebugStringA("Warning: Submission has null material\n");
-            return;
-        }
 
-        if (!submission.material->IsValid())
+        const Material* material = s_Tables.materials.Get(packet.material);
+        if (material && !material->IsValid())
         {
-            OutputDebugStringA(("Warning: Invalid material: " + submission.material->GetName() + "\n").c_str());
+            OutputDebugStringA(("Warning: Invalid material: " + material->GetName() + "\n").c_str());
         }
+#endif
     }
 
     //render State managment
@@ -1230,35 +2171,27 @@ namespace DXEngine {
     {
         s_Stats.renderStateChanges++;
 
+        const QueueState state = GetQueueState(queue);
+        RenderCommand::SetRasterizerMode(state.rasterizer);
+        RenderCommand::SetDepthTestEnabled(state.depth != DepthMode::Disabled);
+        RenderCommand::SetBlendEnabled(state.blend != BlendMode::Opaque);
+    }
+
+    Renderer::QueueState Renderer::GetQueueState(RenderQueue queue)
+    {
         switch (queue)
         {
         case RenderQueue::Background:
-            RenderCommand::SetRasterizerMode(RasterizerMode::SolidFrontCull);
-            RenderCommand::SetDepthTestEnabled(true);
-            RenderCommand::SetBlendEnabled(false);
-            break;
-        case RenderQueue::Opaque:
-            RenderCommand::SetRasterizerMode(s_WireframeEnabled ?
-                RasterizerMode::Wireframe : RasterizerMode::SolidBackCull);
-            RenderCommand::SetDepthTestEnabled(true);
-            RenderCommand::SetBlendEnabled(false);
-            break;
+            return { RasterizerMode::SolidFrontCull, BlendMode::Opaque, DepthMode::LessEqual };
         case RenderQueue::Transparent:
-            RenderCommand::SetRasterizerMode(RasterizerMode::SolidBackCull);
-            RenderCommand::SetDepthTestEnabled(true);
-            RenderCommand::SetBlendEnabled(true);
-            break;
-
+            return { RasterizerMode::SolidBackCull, BlendMode::Alpha, DepthMode::LessEqual };
         case RenderQueue::UI:
-            SetUIRenderState();
-            break;
-
         case RenderQueue::Overlay:
-            RenderCommand::SetRasterizerMode(RasterizerMode::SolidNoCull);
-            RenderCommand::SetDepthTestEnabled(false);
-            RenderCommand::SetBlendEnabled(true);
-            break;
-
+            return { RasterizerMode::SolidNoCull, BlendMode::Alpha, DepthMode::Disabled };
+        case RenderQueue::Opaque:
+        default:
+            return { s_WireframeEnabled ? RasterizerMode::Wireframe : RasterizerMode::SolidBackCull,
+                BlendMode::Opaque, DepthMode::LessEqual };
         }
     }
 
@@ -1355,7 +2288,7 @@ namespace DXEngine {
         }
     }
 
-    UIColor Renderer::GetButtonColorForState(std::shared_ptr<UIButton> button)
+    UIColor Renderer::GetButtonColorForState(const UIButton* button)
     {
         if (!button)
             return UIColor(1.0f, 1.0f, 1.0f, 1.0f);
@@ -1373,7 +2306,7 @@ namespace DXEngine {
         }
     }
 
-    UIColor Renderer::GetPanelColor(std::shared_ptr<UIPanel> panel)
+    UIColor Renderer::GetPanelColor(const UIPanel* panel)
     {
         if (!panel)
             return UIColor(0.5f, 0.5f, 0.5f, 1.0f);
@@ -1429,21 +2362,64 @@ namespace DXEngine {
         // Core rendering stats
         info += "=== Rendering Statistics ===\n";
         info += "Models Submitted: " + std::to_string(s_Stats.modelsSubmitted) + "\n";
+        info += "Models Visible: " + std::to_string(s_Stats.modelsVisible) + "\n";
+        info += "Models Culled: " + std::to_string(s_Stats.modelsCulled) + "\n";
+        if (s_OcclusionBuffer)
+        {
+            info += "Models Occluded: " + std::to_string(s_Stats.modelsOccluded) + " (" +
+                std::to_string(s_Stats.occludersRasterized) + " occluders, " + std::to_string(s_Stats.occluderTriangles) + " triangles)\n";
+        }
+        if (s_ContributionCullingEnabled)
+        {
+            info += "Models Too Small: " + std::to_string(s_Stats.modelsTooSmall) + " (" +
+                std::to_string(s_Stats.submeshesTooSmall) + " submeshes)\n";
+        }
         info += "Total Submissions: " + std::to_string(s_Stats.submissionProcessed) + "\n";
+        info += "Submission Threads: " + std::to_string(GetSubmissionThreadCount()) + "\n";
         info += "Batches Processed: " + std::to_string(s_Stats.batchesProcessed) + "\n";
         info += "Draw Calls: " + std::to_string(s_Stats.drawCalls) + "\n";
         info += "Instanced Draw Calls: " + std::to_string(s_Stats.instanceDrawCalls) + "\n";
         info += "Meshes Rendered: " + std::to_string(s_Stats.meshesRendered) + "\n";
         info += "Submeshes Rendered: " + std::to_string(s_Stats.submeshesRendered) + "\n";
         info += "Instances Rendered: " + std::to_string(s_Stats.instancesRendered) + "\n";
+        info += "Instances Culled: " + std::to_string(s_Stats.instancesCulled) + "\n";
+        info += "Submeshes Culled: " + std::to_string(s_Stats.submeshesCulled) + "\n";
+        info += "Submissions Instanced: " + std::to_string(s_Stats.submissionsInstanced) + "\n";
         info += "UI Elements Rendered: " + std::to_string(s_Stats.uiElementsRendered) + "\n";
-        info += "Triangles Rendered: " + std::to_string(s_Stats.trianglesRendered) + "\n\n";
+        info += "Triangles Rendered: " + std::to_string(s_Stats.trianglesRendered) + "\n";
+        info += "LOD Triangles:";
+        for (uint32_t level = 0; level < SubmissionBucket::LODStatLevels; ++level)
+        {
+            info += " " + std::to_string(s_Stats.lodTriangles[level]);
+        }
+        info += " (" + std::to_string(s_Stats.lodTransitions) + " transitions, bias " + std::to_string(s_LODBias) + ")\n\n";
 
         // Performance stats
         info += "=== Performance Statistics ===\n";
         info += "Material Changes: " + std::to_string(s_Stats.materialsChanged) + "\n";
         info += "Shader Changes: " + std::to_string(s_Stats.shadersChanged) + "\n";
+        info += "Shader Variants: " + std::to_string(ShaderVariantManager::Instance().GetStats().totalVariants) + "\n";
         info += "Render State Changes: " + std::to_string(s_Stats.renderStateChanges) + "\n";
+        info += "State Calls Issued: " + std::to_string(s_Stats.stateCallsIssued) + "\n";
+        info += "State Calls Filtered: " + std::to_string(s_Stats.stateCallsFiltered) + "\n";
+        info += "Constant Bytes Uploaded: " + std::to_string(s_Stats.constantBytesUploaded) + "\n";
+        info += "Constant Buffers Created: " + std::to_string(s_Stats.constantBuffersCreated) + "\n";
+        info += "Constant Buffer Maps: " + std::to_string(s_Stats.constantBufferMaps) + "\n";
+        info += "Instance Bytes Uploaded: " + std::to_string(s_Stats.instanceBytesUploaded) + "\n";
+        info += "Frame Heap Allocations: " + std::to_string(s_Stats.frameHeapAllocations) + "\n";
+        info += "Pipeline Cache Hits/Misses: " + std::to_string(s_Stats.pipelineCacheHits) + " / " +
+            std::to_string(s_Stats.pipelineCacheMisses) + " (" + std::to_string(s_Stats.pipelinesCached) + " cached, " +
+            std::to_string(s_Stats.pipelineCreationNanoseconds / 1000) + " us creating)\n";
+        if (s_PhaseTimingsEnabled)
+        {
+            info += "Cull/Sort/Batch/Encode (us): " + std::to_string(s_Stats.cullNanoseconds / 1000) + " / " +
+                std::to_string(s_Stats.sortNanoseconds / 1000) + " / " + std::to_string(s_Stats.batchNanoseconds / 1000) + " / " +
+                std::to_string(s_Stats.encodeNanoseconds / 1000) + "\n";
+            if (s_OcclusionBuffer)
+            {
+                info += "Occluder Rasterization (us): " + std::to_string(s_Stats.occlusionNanoseconds / 1000) + "\n";
+            }
+        }
 
         // Calculate efficiency metrics
         if (s_Stats.drawCalls > 0)
@@ -1462,8 +2438,19 @@ namespace DXEngine {
 
         // Queue breakdown
         info += "=== Render Queue Breakdown ===\n";
-        for (const auto& [queue, submissions] : s_SortedQueues)
+        uint32_t queueCounts[DrawKey::QueueCount] = {};
+        for (const auto& entry : s_SortEntries)
+        {
+            queueCounts[entry.key >> DrawKey::QueueShift]++;
+        }
+
+        const RenderQueue queues[] = { RenderQueue::Background, RenderQueue::Opaque, RenderQueue::Transparent, RenderQueue::UI, RenderQueue::Overlay };
+        for (RenderQueue queue : queues)
         {
+            uint32_t count = queueCounts[DrawKey::QueueIndex(queue)];
+            if (count == 0)
+                continue;
+
             std::string queueName;
             switch (queue)
             {
@@ -1475,7 +2462,7 @@ namespace DXEngine {
             default: queueName = "Unknown"; break;
             }
 
-            info += queueName + " Queue: " + std::to_string(submissions.size()) + " submissions\n";
+            info += queueName + " Queue: " + std::to_string(count) + " submissions\n";
         }
         info += "\n";
 
@@ -1489,11 +2476,12 @@ namespace DXEngine {
 
         // Memory info (estimated)
         info += "=== Memory Usage (Estimated) ===\n";
-        size_t submissionMemory = s_RenderSubmissions.size() * sizeof(DXEngine::RenderSubmission);
+        size_t submissionMemory = s_Packets.Size() * sizeof(RenderPacket);
         size_t batchMemory = s_RenderBatches.size() * sizeof(RenderBatch);
-        size_t totalMemory = submissionMemory + batchMemory;
+        size_t totalMemory = s_FrameArena.GetCapacity() + batchMemory;
 
-        info += "Submission Storage: " + std::to_string(submissionMemory) + " bytes\n";
+        info += "Packet Storage: " + std::to_string(submissionMemory) + " bytes\n";
+        info += "Frame Arena: " + std::to_string(s_Stats.frameArenaBytes) + " / " + std::to_string(s_FrameArena.GetCapacity()) + " bytes\n";
         info += "Batch Storage: " + std::to_string(batchMemory) + " bytes\n";
         info += "Total Renderer Memory: " + std::to_string(totalMemory) + " bytes\n";
         info += "\n";
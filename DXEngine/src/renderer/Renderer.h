@@ -2,9 +2,15 @@
 #include "RendererCommand.h"
 #include <memory>
 #include <vector>
-#include <map>
+#include <span>
+#include <mutex>
+#include <atomic>
 #include <utils/material/Material.h>
 #include "utils/Buffer.h"
+#include "RenderSort.h"
+#include "RenderPacket.h"
+#include "FrustumCulling.h"
+#include "OcclusionCulling.h"
 
 
 
@@ -13,6 +19,7 @@ namespace DXEngine {
     class ShaderManager;
     class ShaderProgram;
     class Model;
+    struct LODData;
     class Mesh;
     class Camera;
     class UIElement;
@@ -21,76 +28,29 @@ namespace DXEngine {
     class UIPanel;
     struct UIColor;
     class LightManager;
+    class ConstantBufferRing;
+    class InstanceStream;
+    class SceneSpatialIndex;
+    class WorkerPool;
 
-    struct RenderSubmission
-    {
-        // Geometry data
-        std::shared_ptr<Mesh> mesh= nullptr;
-        size_t meshIndex = 0;
-        size_t submeshIndex = 0; 
-
-        std::shared_ptr<Material> material = nullptr;
-        std::shared_ptr<Material> materialOverride = nullptr;
-        
-        // === Transform Data ===
-        DirectX::XMFLOAT4X4 modelMatrix;
-        DirectX::XMFLOAT4X4 normalMatrix;
-
-          //Render state
-        bool visible = true;
-        bool castsShadow = true;
-        bool receivesShadows = true;
-
-            //model reference
-        const Model* sourceModel = nullptr;
-        
-            //render Queue and Sorting
-        RenderQueue queue = RenderQueue::Opaque;
-        float sortKey = 0.0f;
-        uint64_t batchKey = 0;
-
-            //specialized Renderring data
-        const std::vector<DirectX::XMFLOAT4X4>* instanceTransforms = nullptr;
-        size_t instanceCount = 0;
-
-        const std::vector<DirectX::XMFLOAT4X4>* boneMatrices = nullptr;//skeletal animation support
-
-             // UI Element data
-        std::shared_ptr<UIElement> uiElement = nullptr;
-        bool isUIElement = false;
-
-        RenderSubmission() = default;
-        static RenderSubmission CreateFromModel(const Model* model = nullptr, size_t meshIndex = 0, size_t submeshIndex = 0);
-        static RenderSubmission CreateFromUIElement(std::shared_ptr<UIElement> element, std::shared_ptr<Material> material);
-
-
-        bool IsValid()const;
-
-        std::shared_ptr<Material> GetEffectiveMaterial()const
-        {
-            return materialOverride ? materialOverride : material;
-        }
-    };
-
+    //a run of sorted entries drawn with the same mesh and material
     struct RenderBatch
     {
-        std::vector<RenderSubmission> submissions;
-        std::shared_ptr<Material> batchMaterial = nullptr;
-        std::shared_ptr<Mesh> batchMesh = nullptr;
+        uint32_t firstEntry = 0;     //index of the first sorted entry
+        uint32_t count = 0;
         RenderQueue queue = RenderQueue::Opaque;
         bool requiresDepthSorting = false;
         bool IsInstanced = false;
 
-        void Clear() { submissions.clear(); }
-        bool IsEmpty() const { return submissions.empty(); }
-        size_t Size()const { return submissions.size(); }
+        bool IsEmpty() const { return count == 0; }
+        size_t Size()const { return count; }
     };
 
     class Renderer
     {
     public:
         // Core initialization
-        static void Init(HWND hwnd, int width, int height);
+        static void Init(HWND hwnd, int width, int height, RenderBackendType backend = RenderBackendType::D3D11);
         static void InitLightManager();
         static std::shared_ptr<LightManager> GetLightManager() { return s_LightManager; }
         static void SetTime(float time) { s_Time = time; }
@@ -104,24 +64,49 @@ namespace DXEngine {
         static void EndScene();
 
         // 3D Model rendering
-        static void Submit(std::shared_ptr<Model> model);
-        static void Submit(std::shared_ptr<Model> model, std::shared_ptr<Material> materialOverride);
-        static void SubmitMesh(std::shared_ptr<Model> model,size_t meshIndex, std::shared_ptr<Material> materialOverride = nullptr);
-        static void SubmitSubmesh(std::shared_ptr<Model> model,size_t meshIndex,size_t submeshIndex, std::shared_ptr<Material> materialOverride = nullptr);
-
-
-        static void RenderImmediate(std::shared_ptr<Model> model, std::shared_ptr<Material> materialOverride = nullptr);
-        static void RenderMeshImmediate(std::shared_ptr<Model> model, size_t meshIndex, std::shared_ptr<Material> materialOverride = nullptr);
+        static void Submit(const std::shared_ptr<Model>& model);
+        static void Submit(const std::shared_ptr<Model>& model, const std::shared_ptr<Material>& materialOverride);
+        static void SubmitMesh(const std::shared_ptr<Model>& model,size_t meshIndex, const std::shared_ptr<Material>& materialOverride = nullptr);
+        static void SubmitSubmesh(const std::shared_ptr<Model>& model,size_t meshIndex,size_t submeshIndex, const std::shared_ptr<Material>& materialOverride = nullptr);
+
+        // Submits a span of models in parallel. The span is cut into fixed slices, so the
+        // merged packet order does not depend on the number of threads.
+        // Submit may also be called from any thread between BeginScene and EndScene; each
+        // thread records into its own bucket and buckets are merged in EndScene. Direct Submit
+        // calls fill the model's lazy matrix and bounds caches themselves, so models sharing a
+        // transform must not be submitted from two threads right after it moved.
+        static void SubmitRange(std::span<const std::shared_ptr<Model>> models);
+        // Submits the models a scene index reports inside the current frustum. The index is
+        // walked once on the calling thread, packets are then built in parallel slices.
+        static void SubmitScene(const SceneSpatialIndex& scene);
+        static void SetSubmissionThreadCount(uint32_t workerCount);
+        static uint32_t GetSubmissionThreadCount();
+        // Shared with other frame-thread work such as LOD generation, null when submission is serial.
+        // ParallelFor is not reentrant, never call it from inside a submission slice.
+        static WorkerPool* GetWorkerPool() { return s_WorkerPool.get(); }
+
+
+        static void RenderImmediate(const std::shared_ptr<Model>& model, const std::shared_ptr<Material>& materialOverride = nullptr);
+        static void RenderMeshImmediate(const std::shared_ptr<Model>& model, size_t meshIndex, const std::shared_ptr<Material>& materialOverride = nullptr);
 
         // UI rendering
-        static void SubmitUI(std::shared_ptr<UIElement> element);
-        static void SubmitUI(std::shared_ptr<UIElement> element, std::shared_ptr<Material> materialOverride);
-        static void RenderUIImmediate(std::shared_ptr<UIElement> element, std::shared_ptr<Material> material = nullptr);
+        static void SubmitUI(const std::shared_ptr<UIElement>& element);
+        static void SubmitUI(const std::shared_ptr<UIElement>& element, const std::shared_ptr<Material>& materialOverride);
+        static void RenderUIImmediate(const std::shared_ptr<UIElement>& element, const std::shared_ptr<Material>& material = nullptr);
 
         // Render state management
         static void PushRenderState();
         static void PopRenderState();
         static void SetRenderStateForQueue(RenderQueue queue);
+
+        //fixed function state every draw in a queue uses
+        struct QueueState
+        {
+            RasterizerMode rasterizer;
+            BlendMode blend;
+            DepthMode depth;
+        };
+        static QueueState GetQueueState(RenderQueue queue);
         static void SetUIRenderState();
         static void Set3DRenderState();
 
@@ -139,12 +124,26 @@ namespace DXEngine {
             uint32_t materialsChanged = 0;
             uint32_t shadersChanged = 0;
             uint32_t renderStateChanges = 0;
+            uint32_t stateCallsIssued = 0;     //pipeline binds that reached the context
+            uint32_t stateCallsFiltered = 0;   //redundant binds dropped by RenderCommand
 
             //model specific
             uint32_t modelsSubmitted = 0;
+            uint32_t modelsVisible = 0;        //passed frustum and occlusion culling
+            uint32_t modelsCulled = 0;
+            uint32_t modelsOccluded = 0;       //inside the frustum but behind the frame's occluders
+            uint32_t modelsTooSmall = 0;       //projected below every contribution threshold
+            uint32_t submeshesTooSmall = 0;    //draws of kept models in a queue with a higher threshold
+            uint32_t occludersRasterized = 0;
+            uint32_t occluderTriangles = 0;    //after near plane clipping
             uint32_t meshesRendered = 0;
             uint32_t submeshesRendered = 0;
             uint32_t instancesRendered = 0;
+            uint32_t instancesCulled = 0;        //dropped by per-instance culling before upload
+            uint32_t submeshesCulled = 0;        //draws of visible models outside the frustum
+            uint32_t submissionsInstanced = 0;   //non-instanced submissions merged into instanced draws
+            uint32_t lodTriangles[SubmissionBucket::LODStatLevels] = {};   //submitted triangles per LOD level, models without levels count as 0
+            uint32_t lodTransitions = 0;         //models that changed level this frame
 
             //light 
             uint32_t lightsProcessed = 0;
@@ -160,6 +159,25 @@ namespace DXEngine {
 
             //memory stats
             size_t totalMemoryUsed = 0;
+            size_t constantBytesUploaded = 0;
+            uint32_t constantBuffersCreated = 0;
+            uint32_t constantBufferMaps = 0;
+            size_t instanceBytesUploaded = 0;
+            size_t frameArenaBytes = 0;
+            uint32_t frameHeapAllocations = 0;   //renderer owned allocations between BeginScene and EndScene
+
+            //phase timings, only measured while phase timing is enabled
+            uint64_t cullNanoseconds = 0;     //summed over submission threads
+            uint64_t sortNanoseconds = 0;
+            uint64_t batchNanoseconds = 0;
+            uint64_t encodeNanoseconds = 0;   //state binds and draws for every batch
+            uint64_t occlusionNanoseconds = 0; //rasterizing occluders, occludee tests count as culling
+
+            //pipeline state cache
+            uint32_t pipelineCacheHits = 0;
+            uint32_t pipelineCacheMisses = 0;
+            uint64_t pipelineCreationNanoseconds = 0;
+            uint32_t pipelinesCached = 0;
         };
 
         static const RenderStatistics& GetStats() { return s_Stats; }
@@ -171,6 +189,30 @@ namespace DXEngine {
         static void EnableInstancing(bool enable) { s_InstanceEnabled = enable; }
         static void SetInstanceBatchSize(size_t size) { s_InstanceBatchSize = size; }
         static void EnableFrustrumCulling(bool enable) { s_FrustumCullingEnabled = enable; }
+        // Software occlusion: occluders are rasterized into a small CPU depth buffer and every
+        // model submitted after them is tested against it. Call SubmitOccluders after BeginScene
+        // and before the models they hide. Proxies replace an occluder's meshes, skinned
+        // occluders are skipped.
+        static void EnableOcclusionCulling(bool enable, const OcclusionConfig& config = {});
+        static void SubmitOccluders(std::span<const std::shared_ptr<Model>> occluders);
+        static const OcclusionBuffer* GetOcclusionBuffer() { return s_OcclusionBuffer.get(); }
+        static void EnablePhaseTimings(bool enable) { s_PhaseTimingsEnabled = enable; }
+        // Level of detail follows the screen size of a model's bounding sphere. Each step of
+        // bias halves that size (positive is coarser), hysteresis is the relative band a size
+        // must move past a threshold before the level changes back. With fade frames set a
+        // change dithers between both levels over that many frames instead of popping.
+        static void SetLODBias(float bias) { s_LODBias = bias; }
+        static float GetLODBias() { return s_LODBias; }
+        static void SetLODHysteresis(float band) { s_LODHysteresis = band; }
+        static void SetLODCrossFadeFrames(uint32_t frames) { s_LODFadeFrames = frames; }
+        // Contribution culling drops draws whose bounding sphere projects to a smaller radius, in
+        // pixels, than the threshold of the queue they render in. Shadow casters use their own
+        // threshold where it is lower so a shadow can outlast its caster. The model level test
+        // uses the smallest threshold, UI and overlay queues are never culled.
+        static void EnableContributionCulling(bool enable) { s_ContributionCullingEnabled = enable; }
+        static void SetContributionThreshold(RenderQueue queue, float pixelRadius);
+        static void SetShadowCasterContributionThreshold(float pixelRadius);
+        static float GetContributionThreshold(RenderQueue queue, bool castsShadows);
 
     private:
         // Core rendering pipeline
@@ -178,42 +220,71 @@ namespace DXEngine {
         static void CreateRenderBatches();
         static void SortSubmissions();
         static void ProcessRenderBatch(const DXEngine::RenderBatch& batch);
-
-        //Submissiom processing
-        static void ProcessModelSubmission(std::shared_ptr<Model> model, std::shared_ptr<Material> overrideMaterial = nullptr);
+        static bool CanInstanceBatch(const DXEngine::RenderBatch& batch);
+        static const RenderPacket& GetBatchPacket(const DXEngine::RenderBatch& batch, uint32_t index);
+
+        //Submission processing
+        static void ProcessModelSubmission(Model* model, Material* overrideMaterial, SubmissionBucket& bucket);
+        static void ProcessModelSlice(std::span<const std::shared_ptr<Model>> models, SubmissionBucket& bucket);
+        static void SubmitModelPackets(Model* model, Material* overrideMaterial, SubmissionBucket& bucket);
+        static bool ShouldCullSubmeshes(const Model* model);
+        static bool CullModelInstances(const Model* model, SubmissionBucket& bucket, const DirectX::XMFLOAT4X4*& outTransforms, uint32_t& outCount);
+        static bool BuildModelPacket(const Model* model, size_t meshIndex, size_t submeshIndex, Material* materialOverride, PacketTables& tables, RenderPacket& packet);
+        static bool BuildUIPacket(UIElement* element, Material* material, PacketTables& tables, RenderPacket& packet);
+        static void PushPacket(const RenderPacket& packet);
+        static void PushBucketPacket(SubmissionBucket& bucket, const RenderPacket& packet);
+        static bool IsPacketValid(const RenderPacket& packet, const PacketTables& tables);
+
+        //submission buckets
+        static SubmissionBucket& AcquireThreadBucket();
+        static void AcquireBuckets(size_t count, SubmissionBucket** outBuckets);
+        static void MergeSubmissionBuckets();
 
         //culling and Lod
-        static bool IsModelVisible(const Model* model, const std::shared_ptr<Camera>& camera);
-        static size_t SelectLODLevel(const Model* model, const std::shared_ptr<Camera>& camera);
+        static bool IsModelVisible(const Model* model);
+        static bool IsModelOccluded(const Model* model);
+        static void GetModelCullBounds(const Model* model, BoundingSphere& sphere, BoundingBox& box);
+        static float GetScreenSize(const BoundingSphere& sphere);
+        static float GetPixelRadius(const BoundingSphere& sphere);
+        static bool IsModelTooSmall(const Model* model);
+        static bool IsModelTooSmall(const Model* model, const BoundingSphere& sphere);
+        static void UpdateContributionLimits();
+        static size_t SelectLODLevel(const Model* model, LODData& lod, SubmissionBucket& bucket);
+        // runs on the submitting thread before the parallel slices, which then only read the level
+        static void SelectLODBeforeSlices(Model* model, bool culling, SubmissionBucket& bucket);
 
         //Rendering methods
-        static void RenderSubmission(const DXEngine::RenderSubmission& submission);
-        static void RenderMesh(const DXEngine::RenderSubmission& submission);
-        static void RenderInstanceMesh(const DXEngine::RenderSubmission& submission);
-        static void RenderSkinnedMesh(const DXEngine::RenderSubmission& submission);
-        static void RenderUIElement(const DXEngine::RenderSubmission& submission);
+        static void DrawPacket(const RenderPacket& packet);
+        static void RenderMesh(const RenderPacket& packet);
+        static void RenderInstanceMesh(const RenderPacket& packet);
+        static void RenderSkinnedMesh(const RenderPacket& packet);
+        static void RenderUIElement(const RenderPacket& packet);
+        static void RenderInstancedBatch(const DXEngine::RenderBatch& batch);
 
         //material and shader managment
-        static void BindMaterial(std::shared_ptr<Material> material);
-        static void BindShaderForMaterial(std::shared_ptr<Material> material, std::shared_ptr<Mesh> mesh);
-        static void SetupTransformBuffer(const DXEngine::RenderSubmission& submission);
-        static void SetupInstanceBuffer(const DXEngine::RenderSubmission& submission);
-        static void SetupSkinnedBuffer(const DXEngine::RenderSubmission& submission);
+        static void BindMaterial(Material* material);
+        static void BindShaderForMaterial(Material* material, Mesh* mesh, ShaderProgram* shader = nullptr);
+        static ShaderProgram* ResolveShader(Material* material, Mesh* mesh, bool instanced = false);
+        static RenderHandle ResolveShaderHandle(RenderHandle material, RenderHandle mesh, bool instanced);
+        static RenderHandle ResolvePipelineHandle(RenderHandle material, RenderHandle mesh, RenderHandle shader, bool instanced);
+        static void BindPipeline(RenderHandle pipeline, Material* material, Mesh* mesh, ShaderProgram* shader, bool instanced = false);
+        static void SetupTransformBuffer(const RenderPacket& packet);
+        static uint32_t SetupInstanceBuffer(const RenderPacket& packet);
+        static void SetupSkinnedBuffer(const RenderPacket& packet);
 
 
         //sorting and Batching
-        static float CalculateDistancetoCamera(const DXEngine::RenderSubmission& submission);
-        static uint64_t GenarateBatchKey(const DXEngine::RenderSubmission& submission);
-        static uint64_t GenerateSortKey(const DXEngine::RenderSubmission& submission);
+        static float CalculateDistancetoCamera(const RenderPacket& packet);
+        static uint64_t GenerateSortKey(const RenderPacket& packet, uint32_t sequence);
         
         //validation
-        static void ValidateSubmission(const DXEngine::RenderSubmission& submission);
+        static void ValidatePacket(const RenderPacket& packet);
 
         //UI specific
         static void CreateUIQuad();
         static void CreateDefaultUIMaterial();
-        static UIColor GetButtonColorForState(std::shared_ptr<UIButton> button);
-        static UIColor GetPanelColor(std::shared_ptr<UIPanel> button);
+        static UIColor GetButtonColorForState(const UIButton* button);
+        static UIColor GetPanelColor(const UIPanel* panel);
 
         //light culling
         static void UpdateLightCulling(const std::shared_ptr<Camera>& camera);
@@ -223,21 +294,38 @@ namespace DXEngine {
 
         static RenderStatistics s_Stats;
         static std::shared_ptr<ShaderManager> s_ShaderManager;
-        static std::vector<DXEngine::RenderSubmission> s_RenderSubmissions;
-        static const DXEngine::RenderSubmission* s_CurrentRenderSubmission;
-        static std::map<RenderQueue, std::vector<DXEngine::RenderSubmission*>> s_SortedQueues;
+
+        //per-frame packet storage, rewound in BeginScene
+        static FrameArena s_FrameArena;
+        static RenderPacketList s_Packets;
+        static PacketTables s_Tables;
+        static FrameHandleTable<ShaderProgram> s_ShaderTable;
+        static FrameHashMap s_ShaderLookup;   //(material, mesh, instanced) -> shader handle
+        static FrameHashMap s_PipelineLookup; //same key -> pipeline handle
+
+        //submission buckets, merged into the packet list in acquisition order
+        static std::vector<std::unique_ptr<SubmissionBucket>> s_BucketPool;
+        static size_t s_BucketsInUse;
+        static std::mutex s_BucketMutex;
+        static std::atomic<uint32_t> s_BucketGeneration;
+        static std::vector<RenderHandle> s_HandleRemap;
+        static std::unique_ptr<WorkerPool> s_WorkerPool;
+
+        static std::vector<DrawSortEntry> s_SortEntries;
+        static std::vector<DrawSortEntry> s_SortScratch;
         static std::vector<DXEngine::RenderBatch> s_RenderBatches;
 
-        static std::shared_ptr<Material> s_CurrentMaterial;
-        static std::shared_ptr<ShaderProgram> s_CurrentShader;
+        static Material* s_CurrentMaterial;
+        static ShaderProgram* s_CurrentShader;
         static MaterialType s_CurrentMaterialType;
-        static std::shared_ptr<TransfomBufferData> s_TransformBufferData;
+        static std::shared_ptr<ConstantBufferRing> s_ConstantBufferRing;
+        static std::shared_ptr<InstanceStream> s_InstanceStream;
+        static std::vector<DirectX::XMFLOAT4X4> s_BatchTransforms;
 
 
         static std::shared_ptr<Model> s_UIQuadModel;
         static std::shared_ptr<Material> s_DefaultUIMaterial;
         static DirectX::XMMATRIX s_UIProjectionMatrix;
-        static std::shared_ptr<UIConstantBuffer> s_UIBufferData;
 
         static std::shared_ptr<LightManager> s_LightManager;
 
@@ -254,6 +342,21 @@ namespace DXEngine {
         static bool sDX_DEBUGInfoEnabled;
         static bool s_InstanceEnabled;
         static bool s_FrustumCullingEnabled;
+        static FrustumPlanes s_FrustumPlanes;   //world space, extracted in BeginScene
+        static bool s_FrustumValid;
+        static std::unique_ptr<OcclusionBuffer> s_OcclusionBuffer;
+        static bool s_PhaseTimingsEnabled;
+        static float s_LODBias;
+        static float s_LODHysteresis;
+        static uint32_t s_LODFadeFrames;
+        static DirectX::XMFLOAT4 s_ViewDepthPlane;   //view space z of a world point, for screen sizes
+        static float s_ProjectionScaleY;
+        static float s_ViewportHalfHeight;   //pixels from the screen centre to its top edge
+        static bool s_ContributionCullingEnabled;
+        static float s_ContributionThresholds[3];   //background, opaque and transparent, in pixels
+        static float s_ShadowContributionThreshold;
+        static float s_MinContributionThreshold;   //below this for every queue a model is dropped whole
+        static float s_MaxContributionThreshold;   //at or above this no draw is dropped
         static size_t s_InstanceBatchSize;
         
         static uint32_t s_FrameCount;
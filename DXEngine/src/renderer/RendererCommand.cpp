@@ -1,5 +1,9 @@
 #include "dxpch.h"
 #include "RendererCommand.h"
+#include "D3D11RenderBackend.h"
+#include "NullRenderBackend.h"
+#include "NullDevice.h"
+#include "PipelineStateCache.h"
 #include "utils/Sampler.h"
 
 namespace DXEngine {
@@ -9,25 +13,35 @@ namespace DXEngine {
 	Microsoft::WRL::ComPtr<IDXGISwapChain> RenderCommand::s_SwapChain;
 	Microsoft::WRL::ComPtr<ID3D11RenderTargetView> RenderCommand::s_RenderTargetView;
 	Microsoft::WRL::ComPtr<ID3D11DepthStencilView> RenderCommand::s_DepthStencilView;
+	std::unique_ptr<RenderBackend> RenderCommand::s_Backend;
+	RenderBackendType RenderCommand::s_BackendType = RenderBackendType::D3D11;
 	Microsoft::WRL::ComPtr<ID3D11BlendState> RenderCommand::s_TransparencyBlendState;
 	Microsoft::WRL::ComPtr<ID3D11BlendState> RenderCommand::s_UIBlendState;
 	Microsoft::WRL::ComPtr<ID3D11DepthStencilState> RenderCommand::s_DepthStencilState;
+	Microsoft::WRL::ComPtr<ID3D11DepthStencilState> RenderCommand::s_NoDepthStencilState;
 	std::unordered_map<RasterizerMode, Microsoft::WRL::ComPtr<ID3D11RasterizerState>> RenderCommand::s_RasterizerStates;
 	HWND RenderCommand::s_WindowHandle;
 	int RenderCommand::s_ViewportWidth;
 	int RenderCommand::s_ViewportHeight;
 	std::shared_ptr<Camera> RenderCommand::s_Camera;
 	float RenderCommand::s_ClearColor[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+	RenderCommand::BoundState RenderCommand::s_State;
+	RenderCommand::StateFilterStats RenderCommand::s_StateStats;
 
-	void RenderCommand::Init(HWND hwnd, int width, int height)
+	void RenderCommand::Init(HWND hwnd, int width, int height, RenderBackendType backend)
 	{
 		s_WindowHandle = hwnd;
 		s_ViewportWidth = width;
 		s_ViewportHeight = height;
+		s_BackendType = backend;
+		InvalidateStateCache();
 
 		if (!InitializeD3D())
 		{
-			MessageBox(hwnd, L"Failed to initialize Direct3D", L"ERROR", MB_OK | MB_ICONERROR);
+			if (backend == RenderBackendType::Null)
+				OutputDebugStringA("Warning: Failed to create a headless device\n");
+			else
+				MessageBox(hwnd, L"Failed to initialize Direct3D", L"ERROR", MB_OK | MB_ICONERROR);
 		}
 	}
 
@@ -36,15 +50,19 @@ namespace DXEngine {
 		s_Camera.reset();
 		s_RasterizerStates.clear();
 		s_DepthStencilState.Reset();
+		s_NoDepthStencilState.Reset();
 		s_TransparencyBlendState.Reset();
+		s_UIBlendState.Reset();
 		s_DepthStencilView.Reset();
 		s_RenderTargetView.Reset();
 		s_SwapChain.Reset();
+		s_Backend.reset();
 		s_Context.Reset();
+		InvalidateStateCache();
 		s_Device.Reset();
 	}
 
-	bool RenderCommand::InitializeD3D()
+	bool RenderCommand::CreateDeviceAndSwapChain()
 	{
 		using namespace Microsoft::WRL;
 
@@ -94,7 +112,35 @@ namespace DXEngine {
 		if (FAILED(hr)) return false;
 
 		hr = s_Device->CreateRenderTargetView(backBuffer.Get(), nullptr, s_RenderTargetView.GetAddressOf());
-		if (FAILED(hr)) return false;
+		return SUCCEEDED(hr);
+	}
+
+	bool RenderCommand::CreateHeadlessDevice()
+	{
+		// No driver at all, resources are handles and s_Context stays empty
+		HRESULT hr = CreateNullDevice(s_Device.ReleaseAndGetAddressOf());
+		if (FAILED(hr))
+		{
+			PrintError(hr);
+			return false;
+		}
+		return true;
+	}
+
+	bool RenderCommand::InitializeD3D()
+	{
+		using namespace Microsoft::WRL;
+
+		const bool headless = s_BackendType == RenderBackendType::Null;
+		if (!(headless ? CreateHeadlessDevice() : CreateDeviceAndSwapChain()))
+			return false;
+
+		if (headless)
+			s_Backend = std::make_unique<NullRenderBackend>();
+		else
+			s_Backend = std::make_unique<D3D11RenderBackend>(s_Context);
+
+		HRESULT hr = S_OK;
 
 		// Create depth stencil state
 		D3D11_DEPTH_STENCIL_DESC dsDesc = {};
@@ -122,7 +168,7 @@ namespace DXEngine {
 		if (FAILED(hr)) return false;
 
 		// Bind the depth state
-		s_Context->OMSetDepthStencilState(s_DepthStencilState.Get(), 1);
+		SetDepthStencilState(s_DepthStencilState.Get(), 1);
 
 		// Create depth stencil texture
 		ComPtr<ID3D11Texture2D> depthStencil;
@@ -148,7 +194,7 @@ namespace DXEngine {
 		s_Device->CreateDepthStencilView(depthStencil.Get(), &descDSV, s_DepthStencilView.GetAddressOf());
 
 		// Bind depth stencil view to output merger
-		s_Context->OMSetRenderTargets(1u, s_RenderTargetView.GetAddressOf(), s_DepthStencilView.Get());
+		s_Backend->SetRenderTargets(s_RenderTargetView.Get(), s_DepthStencilView.Get());
 
 		// Set viewport
 		SetViewport(0, 0, s_ViewportWidth, s_ViewportHeight);
@@ -186,15 +232,16 @@ namespace DXEngine {
 	}
 	void RenderCommand::Clear()
 	{
-		s_Context->ClearRenderTargetView(s_RenderTargetView.Get(), s_ClearColor);
-		s_Context->ClearDepthStencilView(s_DepthStencilView.Get(), D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, 1.0f, 0u);
+		s_Backend->BeginFrame();
+		s_Backend->ClearRenderTarget(s_RenderTargetView.Get(), s_ClearColor);
+		s_Backend->ClearDepthStencil(s_DepthStencilView.Get(), 1.0f, 0u);
 
 		// Reset shaders
-		s_Context->VSSetShader(nullptr, nullptr, 0);
-		s_Context->PSSetShader(nullptr, nullptr, 0);
+		SetVertexShader(nullptr);
+		SetPixelShader(nullptr);
 
 		// Set render targets
-		s_Context->OMSetRenderTargets(1u, s_RenderTargetView.GetAddressOf(), s_DepthStencilView.Get());
+		s_Backend->SetRenderTargets(s_RenderTargetView.Get(), s_DepthStencilView.Get());
 
 		if (!s_UIBlendState)
 		{
@@ -202,7 +249,7 @@ namespace DXEngine {
 		}
 
 		// Set default blend state
-		s_Context->OMSetBlendState(s_TransparencyBlendState.Get(), nullptr, 0xffffffff);
+		SetBlendState(s_TransparencyBlendState.Get());
 
 		SetRasterizerMode(RasterizerMode::SolidBackCull);
 
@@ -212,7 +259,12 @@ namespace DXEngine {
 
 	void RenderCommand::Present()
 	{
-		s_Context->OMSetDepthStencilState(nullptr, 0);
+		SetDepthStencilState(nullptr, 0);
+		s_Backend->EndFrame();
+
+		if (!s_SwapChain)
+			return;
+
 		HRESULT hr = s_SwapChain->Present(0u, 0u);
 		if (FAILED(hr))
 		{
@@ -228,91 +280,326 @@ namespace DXEngine {
 		vp.Height = static_cast<float>(height);
 		vp.MinDepth = 0.0f;
 		vp.MaxDepth = 1.0f;
-		s_Context->RSSetViewports(1u, &vp);
+		s_Backend->SetViewport(vp);
 	}
 
 	void RenderCommand::SetRasterizerMode(RasterizerMode mode)
 	{
-		auto it = s_RasterizerStates.find(mode);
-		if (it != s_RasterizerStates.end())
+		if (ID3D11RasterizerState* state = GetRasterizerState(mode))
 		{
-			s_Context->RSSetState(it->second.Get());
+			SetRasterizerState(state);
 		}
 	}
 
 	void RenderCommand::SetDepthLessEqual()
 	{
-		s_Context->OMSetDepthStencilState(s_DepthStencilState.Get(), 1);
+		SetDepthStencilState(s_DepthStencilState.Get(), 1);
 	}
 
 	void RenderCommand::SetDepthTestEnabled(bool enabled)
 	{
-		if (enabled)
+		SetDepthStencilState(GetDepthStencilState(enabled ? DepthMode::LessEqual : DepthMode::Disabled), 1);
+	}
+
+	void RenderCommand::SetBlendEnabled(bool enabled)
+	{
+		SetBlendState(GetBlendState(enabled ? BlendMode::Alpha : BlendMode::Opaque));
+	}
+
+	ID3D11RasterizerState* RenderCommand::GetRasterizerState(RasterizerMode mode)
+	{
+		auto it = s_RasterizerStates.find(mode);
+		return it != s_RasterizerStates.end() ? it->second.Get() : nullptr;
+	}
+
+	ID3D11BlendState* RenderCommand::GetBlendState(BlendMode mode)
+	{
+		if (mode == BlendMode::Opaque)
+			return nullptr; // default blend state (no blending)
+
+		if (!s_UIBlendState && s_Device)
 		{
-			s_Context->OMSetDepthStencilState(s_DepthStencilState.Get(), 1);
+			CreateUIBlendState();
 		}
-		else
+		return s_UIBlendState.Get();
+	}
+
+	ID3D11DepthStencilState* RenderCommand::GetDepthStencilState(DepthMode mode)
+	{
+		if (mode == DepthMode::LessEqual)
+			return s_DepthStencilState.Get();
+
+		if (!s_NoDepthStencilState && s_Device)
 		{
-			static Microsoft::WRL::ComPtr<ID3D11DepthStencilState> noDepthState = nullptr;
-			if (!noDepthState)
-			{
-				D3D11_DEPTH_STENCIL_DESC desc = {};
-				desc.DepthEnable = false;
-				desc.DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ZERO;
-				desc.DepthFunc = D3D11_COMPARISON_ALWAYS;
-				desc.StencilEnable = false;
-				desc.StencilReadMask = 0xFF;
-				desc.StencilWriteMask = 0xFF;
-
-				// Proper stencil values
-				desc.FrontFace.StencilFailOp = D3D11_STENCIL_OP_KEEP;
-				desc.FrontFace.StencilDepthFailOp = D3D11_STENCIL_OP_KEEP;
-				desc.FrontFace.StencilPassOp = D3D11_STENCIL_OP_KEEP;
-				desc.FrontFace.StencilFunc = D3D11_COMPARISON_ALWAYS;
-
-				desc.BackFace.StencilFailOp = D3D11_STENCIL_OP_KEEP;
-				desc.BackFace.StencilDepthFailOp = D3D11_STENCIL_OP_KEEP;
-				desc.BackFace.StencilPassOp = D3D11_STENCIL_OP_KEEP;
-				desc.BackFace.StencilFunc = D3D11_COMPARISON_ALWAYS;
-
-				s_Device->CreateDepthStencilState(&desc, noDepthState.GetAddressOf());
-			}
-			s_Context->OMSetDepthStencilState(noDepthState.Get(), 1);
+			D3D11_DEPTH_STENCIL_DESC desc = {};
+			desc.DepthEnable = false;
+			desc.DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ZERO;
+			desc.DepthFunc = D3D11_COMPARISON_ALWAYS;
+			desc.StencilEnable = false;
+			desc.StencilReadMask = 0xFF;
+			desc.StencilWriteMask = 0xFF;
+
+			// Proper stencil values
+			desc.FrontFace.StencilFailOp = D3D11_STENCIL_OP_KEEP;
+			desc.FrontFace.StencilDepthFailOp = D3D11_STENCIL_OP_KEEP;
+			desc.FrontFace.StencilPassOp = D3D11_STENCIL_OP_KEEP;
+			desc.FrontFace.StencilFunc = D3D11_COMPARISON_ALWAYS;
+
+			desc.BackFace.StencilFailOp = D3D11_STENCIL_OP_KEEP;
+			desc.BackFace.StencilDepthFailOp = D3D11_STENCIL_OP_KEEP;
+			desc.BackFace.StencilPassOp = D3D11_STENCIL_OP_KEEP;
+			desc.BackFace.StencilFunc = D3D11_COMPARISON_ALWAYS;
+
+			s_Device->CreateDepthStencilState(&desc, s_NoDepthStencilState.GetAddressOf());
 		}
+		return s_NoDepthStencilState.Get();
+	}
 
+	bool RenderCommand::FilterCall(bool redundant)
+	{
+		if (redundant)
+		{
+			s_StateStats.filtered++;
+			return true;
+		}
+		s_StateStats.issued++;
+		return false;
 	}
 
-	void RenderCommand::SetBlendEnabled(bool enabled)
+	void RenderCommand::InvalidateStateCache()
+	{
+		// no real object lives at an all ones address, so nothing matches until it is bound again
+		memset(&s_State, 0xFF, sizeof(s_State));
+	}
+
+	void RenderCommand::SetVertexBuffers(UINT startSlot, UINT count, ID3D11Buffer* const* buffers, const UINT* strides, const UINT* offsets)
 	{
-		if (enabled)
+		if (count == 0)
+			return;
+
+		const bool tracked = startSlot + count <= MaxTrackedVertexBuffers;
+		bool redundant = tracked;
+		for (UINT i = 0; redundant && i < count; ++i)
 		{
-			if (!s_UIBlendState)
-			{
-				CreateUIBlendState();
-			}
-			s_Context->OMSetBlendState(s_UIBlendState.Get(), nullptr, 0xffffffff);
+			const UINT slot = startSlot + i;
+			redundant = s_State.vertexBuffers[slot] == buffers[i] &&
+				s_State.vertexStrides[slot] == strides[i] && s_State.vertexOffsets[slot] == offsets[i];
 		}
-		else
+		if (FilterCall(redundant))
+			return;
+
+		s_Backend->SetVertexBuffers(startSlot, count, buffers, strides, offsets);
+
+		for (UINT i = 0; tracked && i < count; ++i)
 		{
-			// Set default blend state (no blending)
-			s_Context->OMSetBlendState(nullptr, nullptr, 0xffffffff);
+			const UINT slot = startSlot + i;
+			s_State.vertexBuffers[slot] = buffers[i];
+			s_State.vertexStrides[slot] = strides[i];
+			s_State.vertexOffsets[slot] = offsets[i];
 		}
 	}
 
-	void RenderCommand::SetBlendState(Microsoft::WRL::ComPtr<ID3D11BlendState> blendState)
+	void RenderCommand::SetIndexBuffer(ID3D11Buffer* buffer, DXGI_FORMAT format, UINT offset)
+	{
+		if (FilterCall(s_State.indexBuffer == buffer && s_State.indexFormat == format && s_State.indexOffset == offset))
+			return;
+
+		s_Backend->SetIndexBuffer(buffer, format, offset);
+		s_State.indexBuffer = buffer;
+		s_State.indexFormat = format;
+		s_State.indexOffset = offset;
+	}
+
+	void RenderCommand::SetInputLayout(ID3D11InputLayout* layout)
+	{
+		if (FilterCall(s_State.inputLayout == layout))
+			return;
+
+		s_Backend->SetInputLayout(layout);
+		s_State.inputLayout = layout;
+	}
+
+	void RenderCommand::SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY topology)
+	{
+		if (FilterCall(s_State.topology == topology))
+			return;
+
+		s_Backend->SetPrimitiveTopology(topology);
+		s_State.topology = topology;
+	}
+
+	void RenderCommand::SetVertexShader(ID3D11VertexShader* shader)
+	{
+		if (FilterCall(s_State.vertexShader == shader))
+			return;
+
+		s_Backend->SetVertexShader(shader);
+		s_State.vertexShader = shader;
+	}
+
+	void RenderCommand::SetPixelShader(ID3D11PixelShader* shader)
+	{
+		if (FilterCall(s_State.pixelShader == shader))
+			return;
+
+		s_Backend->SetPixelShader(shader);
+		s_State.pixelShader = shader;
+	}
+
+	void RenderCommand::SetConstantBuffer(ShaderStage stage, UINT slot, ID3D11Buffer* buffer)
+	{
+		if (slot >= MaxTrackedConstantBuffers)
+			return;
+
+		ConstantBufferBinding& binding = s_State.stages[static_cast<int>(stage)].constantBuffers[slot];
+		if (FilterCall(binding.buffer == buffer && binding.numConstants == 0))
+			return;
+
+		s_Backend->SetConstantBuffer(stage, slot, buffer);
+
+		binding = { buffer, 0, 0 };
+	}
+
+	bool RenderCommand::SetConstantBufferRange(ShaderStage stage, UINT slot, ID3D11Buffer* buffer, UINT firstConstant, UINT numConstants)
+	{
+		if (!s_Backend->SupportsConstantBufferRanges() || slot >= MaxTrackedConstantBuffers || numConstants == 0)
+			return false;
+
+		ConstantBufferBinding& binding = s_State.stages[static_cast<int>(stage)].constantBuffers[slot];
+		if (FilterCall(binding.buffer == buffer && binding.firstConstant == firstConstant && binding.numConstants == numConstants))
+			return true;
+
+		if (!s_Backend->SetConstantBufferRange(stage, slot, buffer, firstConstant, numConstants))
+			return false;
+
+		binding = { buffer, firstConstant, numConstants };
+		return true;
+	}
+
+	void RenderCommand::SetShaderResource(ShaderStage stage, UINT slot, ID3D11ShaderResourceView* view)
+	{
+		const bool tracked = slot < MaxTrackedShaderResources;
+		auto& views = s_State.stages[static_cast<int>(stage)].shaderResources;
+		if (FilterCall(tracked && views[slot] == view))
+			return;
+
+		s_Backend->SetShaderResource(stage, slot, view);
+
+		if (tracked)
+			views[slot] = view;
+	}
+
+	void RenderCommand::SetSamplers(ShaderStage stage, UINT startSlot, UINT count, ID3D11SamplerState* const* samplers)
+	{
+		if (count == 0 || startSlot + count > MaxTrackedSamplers)
+			return;
+
+		auto& bound = s_State.stages[static_cast<int>(stage)].samplers;
+		if (FilterCall(std::equal(samplers, samplers + count, bound + startSlot)))
+			return;
+
+		s_Backend->SetSamplers(stage, startSlot, count, samplers);
+
+		std::copy(samplers, samplers + count, bound + startSlot);
+	}
+
+	void RenderCommand::SetRasterizerState(ID3D11RasterizerState* state)
+	{
+		if (FilterCall(s_State.rasterizerState == state))
+			return;
+
+		s_Backend->SetRasterizerState(state);
+		s_State.rasterizerState = state;
+	}
+
+	void RenderCommand::SetDepthStencilState(ID3D11DepthStencilState* state, UINT stencilRef)
+	{
+		if (FilterCall(s_State.depthStencilState == state && s_State.stencilRef == stencilRef))
+			return;
+
+		s_Backend->SetDepthStencilState(state, stencilRef);
+		s_State.depthStencilState = state;
+		s_State.stencilRef = stencilRef;
+	}
+
+	void RenderCommand::SetBlendState(ID3D11BlendState* state)
+	{
+		if (FilterCall(s_State.blendState == state))
+			return;
+
+		s_Backend->SetBlendState(state);
+		s_State.blendState = state;
+	}
+
+	void RenderCommand::SetPipelineState(const PipelineState& state)
+	{
+		SetInputLayout(state.inputLayout.Get());
+		SetVertexShader(state.vertexShader.Get());
+		SetPixelShader(state.pixelShader.Get());
+		SetRasterizerState(state.rasterizerState.Get());
+		SetBlendState(state.blendState.Get());
+		SetDepthStencilState(state.depthStencilState.Get(), state.stencilRef);
+	}
+
+
+	void RenderCommand::Draw(uint32_t vertexCount, uint32_t startVertex)
+	{
+		s_Backend->Draw(vertexCount, startVertex);
+	}
+
+	void RenderCommand::DrawIndexed(uint32_t indexCount, uint32_t startIndex, int32_t baseVertex)
 	{
-		s_Context->OMSetBlendState(blendState.Get(), nullptr, 0xffffffff);
+		s_Backend->DrawIndexed(indexCount, startIndex, baseVertex);
 	}
 
+	void RenderCommand::DrawInstanced(uint32_t vertexCount, uint32_t instanceCount, uint32_t startVertex, uint32_t startInstance)
+	{
+		s_Backend->DrawInstanced(vertexCount, instanceCount, startVertex, startInstance);
+	}
 
-	void RenderCommand::DrawIndexed(uint32_t indexCount)
+	void RenderCommand::DrawIndexedInstanced(uint32_t indexCount, uint32_t instanceCount, uint32_t startIndex,
+		int32_t baseVertex, uint32_t startInstance)
 	{
-		s_Context->DrawIndexed(indexCount, 0, 0);
+		s_Backend->DrawIndexedInstanced(indexCount, instanceCount, startIndex, baseVertex, startInstance);
+	}
+
+	HRESULT RenderCommand::MapBuffer(ID3D11Buffer* buffer, D3D11_MAP mapType, D3D11_MAPPED_SUBRESOURCE& mapped)
+	{
+		return s_Backend->Map(buffer, mapType, mapped);
+	}
+
+	void RenderCommand::UnmapBuffer(ID3D11Buffer* buffer, UINT bytesWritten)
+	{
+		s_Backend->Unmap(buffer, bytesWritten);
+	}
+
+	void RenderCommand::UpdateBuffer(ID3D11Buffer* buffer, const D3D11_BOX* box, const void* data, UINT bytes)
+	{
+		s_Backend->UpdateSubresource(buffer, box, data, bytes);
+	}
+
+	void RenderCommand::EndQuery(ID3D11Query* query)
+	{
+		s_Backend->EndQuery(query);
+	}
+
+	HRESULT RenderCommand::GetQueryData(ID3D11Query* query, UINT flags)
+	{
+		return s_Backend->GetQueryData(query, flags);
 	}
 
 	void RenderCommand::Resize(int newWidth, int newHeight)
 	{
-		s_Context->OMSetRenderTargets(0, nullptr, nullptr);
+		if (!s_SwapChain)
+		{
+			// headless, nothing backs the window size
+			SetViewport(0, 0, newWidth, newHeight);
+			s_ViewportWidth = newWidth;
+			s_ViewportHeight = newHeight;
+			return;
+		}
+
+		s_Backend->SetRenderTargets(nullptr, nullptr);
 		s_RenderTargetView.Reset();
 		s_DepthStencilView.Reset();
 
@@ -370,7 +657,7 @@ namespace DXEngine {
 		if (FAILED(hr)) return;
 
 		// Bind the new views
-		s_Context->OMSetRenderTargets(1, s_RenderTargetView.GetAddressOf(), s_DepthStencilView.Get());
+		s_Backend->SetRenderTargets(s_RenderTargetView.Get(), s_DepthStencilView.Get());
 
 		// Update viewport
 		SetViewport(0, 0, newWidth, newHeight);
@@ -380,12 +667,12 @@ namespace DXEngine {
 		s_ViewportHeight = newHeight;
 	}
 
-	Microsoft::WRL::ComPtr<ID3D11Device> RenderCommand::GetDevice()
+	const Microsoft::WRL::ComPtr<ID3D11Device>& RenderCommand::GetDevice()
 	{
 		return s_Device;
 	}
 
-	Microsoft::WRL::ComPtr<ID3D11DeviceContext> RenderCommand::GetContext()
+	const Microsoft::WRL::ComPtr<ID3D11DeviceContext>& RenderCommand::GetContext()
 	{
 		return s_Context;
 	}
@@ -1,6 +1,8 @@
 #pragma once
 #include "camera/Camera.h"
 #include "dxpch.h"
+#include "RenderBackend.h"
+#include <d3d11_1.h>
 
 namespace DXEngine {
 
@@ -12,10 +14,25 @@ namespace DXEngine {
 		Wireframe,
 	};
 
+	enum class BlendMode
+	{
+		Opaque,   // blending off
+		Alpha,
+	};
+
+	enum class DepthMode
+	{
+		LessEqual,
+		Disabled,
+	};
+
+	struct PipelineState;
+
 	class RenderCommand
 	{
 	public:
-		static void Init(HWND hwnd, int width, int height);
+		// Null runs headless, hwnd may be null and nothing is presented
+		static void Init(HWND hwnd, int width, int height, RenderBackendType backend = RenderBackendType::D3D11);
 		static void Shutdown();
 
 		// Basic rendering commands
@@ -29,18 +46,70 @@ namespace DXEngine {
 		static void SetDepthLessEqual();
 		static void SetDepthTestEnabled(bool enabled);
 		static void SetBlendEnabled(bool enabled);
-		static void SetBlendState(Microsoft::WRL::ComPtr<ID3D11BlendState> blendState);
+
+		// Shared state objects, used to prebuild pipeline states
+		static ID3D11RasterizerState* GetRasterizerState(RasterizerMode mode);
+		static ID3D11BlendState* GetBlendState(BlendMode mode);
+		static ID3D11DepthStencilState* GetDepthStencilState(DepthMode mode);
+
+		// Pipeline bindings. A shadow copy of everything bound through these is kept and
+		// calls that would not change the pipeline are dropped.
+		static void SetVertexBuffers(UINT startSlot, UINT count, ID3D11Buffer* const* buffers, const UINT* strides, const UINT* offsets);
+		static void SetIndexBuffer(ID3D11Buffer* buffer, DXGI_FORMAT format, UINT offset = 0);
+		static void SetInputLayout(ID3D11InputLayout* layout);
+		static void SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY topology);
+		static void SetVertexShader(ID3D11VertexShader* shader);
+		static void SetPixelShader(ID3D11PixelShader* shader);
+		static void SetConstantBuffer(ShaderStage stage, UINT slot, ID3D11Buffer* buffer);
+		// Binds part of a buffer, offsets are in 16 byte constants (requires D3D11.1)
+		static bool SetConstantBufferRange(ShaderStage stage, UINT slot, ID3D11Buffer* buffer, UINT firstConstant, UINT numConstants);
+		static void SetShaderResource(ShaderStage stage, UINT slot, ID3D11ShaderResourceView* view);
+		static void SetSamplers(ShaderStage stage, UINT startSlot, UINT count, ID3D11SamplerState* const* samplers);
+		static void SetRasterizerState(ID3D11RasterizerState* state);
+		static void SetDepthStencilState(ID3D11DepthStencilState* state, UINT stencilRef = 1);
+		static void SetBlendState(ID3D11BlendState* state);
+		// Input layout, shaders and fixed function state in one call, each still filtered
+		static void SetPipelineState(const PipelineState& state);
+
+		// Forget the shadow copy, needed after anything binds through the context directly
+		static void InvalidateStateCache();
+
+		struct StateFilterStats
+		{
+			uint32_t issued = 0;
+			uint32_t filtered = 0;
+		};
+		static const StateFilterStats& GetStateFilterStats() { return s_StateStats; }
+		static void ResetStateFilterStats() { s_StateStats = StateFilterStats{}; }
 
 
 		// Drawing commands
-		static void DrawIndexed(uint32_t indexCount);
+		static void Draw(uint32_t vertexCount, uint32_t startVertex = 0);
+		static void DrawIndexed(uint32_t indexCount, uint32_t startIndex = 0, int32_t baseVertex = 0);
+		static void DrawInstanced(uint32_t vertexCount, uint32_t instanceCount, uint32_t startVertex = 0, uint32_t startInstance = 0);
+		static void DrawIndexedInstanced(uint32_t indexCount, uint32_t instanceCount, uint32_t startIndex = 0,
+			int32_t baseVertex = 0, uint32_t startInstance = 0);
+
+		// Buffer uploads, pass the bytes actually written to UnmapBuffer
+		static HRESULT MapBuffer(ID3D11Buffer* buffer, D3D11_MAP mapType, D3D11_MAPPED_SUBRESOURCE& mapped);
+		static void UnmapBuffer(ID3D11Buffer* buffer, UINT bytesWritten);
+		static void UpdateBuffer(ID3D11Buffer* buffer, const D3D11_BOX* box, const void* data, UINT bytes);
+
+		// Queries used as frame fences
+		static void EndQuery(ID3D11Query* query);
+		static HRESULT GetQueryData(ID3D11Query* query, UINT flags = 0);
 
 		// Window/Swapchain management
 		static void Resize(int newWidth, int newHeight);
 
 		// Device access for creating resources
-		static Microsoft::WRL::ComPtr<ID3D11Device> GetDevice();
-		static Microsoft::WRL::ComPtr<ID3D11DeviceContext> GetContext();
+		static const Microsoft::WRL::ComPtr<ID3D11Device>& GetDevice();
+		// empty on the null backend, context work goes through GetBackend()
+		static const Microsoft::WRL::ComPtr<ID3D11DeviceContext>& GetContext();
+
+		// Where context work goes after state filtering
+		static RenderBackend* GetBackend() { return s_Backend.get(); }
+		static RenderBackendType GetBackendType() { return s_BackendType; }
 
 		// Camera management
 		static void SetCamera(const std::shared_ptr<Camera>& camera);
@@ -53,9 +122,12 @@ namespace DXEngine {
 
 	private:
 		static bool InitializeD3D();
+		static bool CreateDeviceAndSwapChain();
+		static bool CreateHeadlessDevice();
 		static void CreateRasterizerStates();
 		static void PrintError(HRESULT hr);
 		static void CreateUIBlendState();
+		static bool FilterCall(bool redundant);
 
 	private:
 		// D3D11 Core objects
@@ -64,11 +136,14 @@ namespace DXEngine {
 		static Microsoft::WRL::ComPtr<IDXGISwapChain> s_SwapChain;
 		static Microsoft::WRL::ComPtr<ID3D11RenderTargetView> s_RenderTargetView;
 		static Microsoft::WRL::ComPtr<ID3D11DepthStencilView> s_DepthStencilView;
+		static std::unique_ptr<RenderBackend> s_Backend;
+		static RenderBackendType s_BackendType;
 
 		// States
 		static Microsoft::WRL::ComPtr<ID3D11BlendState> s_TransparencyBlendState;
 		static Microsoft::WRL::ComPtr<ID3D11BlendState> s_UIBlendState;
 		static Microsoft::WRL::ComPtr<ID3D11DepthStencilState> s_DepthStencilState;
+		static Microsoft::WRL::ComPtr<ID3D11DepthStencilState> s_NoDepthStencilState;
 		static std::unordered_map<RasterizerMode, Microsoft::WRL::ComPtr<ID3D11RasterizerState>> s_RasterizerStates;
 
 		// Window data
@@ -81,5 +156,49 @@ namespace DXEngine {
 
 		// Clear color
 		static float s_ClearColor[4];
+
+		// Last state handed to the context. Pointers are not owned, the context keeps
+		// bound objects alive so an address cannot be reused while it is still bound.
+		static constexpr UINT MaxTrackedVertexBuffers = 8;
+		static constexpr UINT MaxTrackedConstantBuffers = D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT;
+		static constexpr UINT MaxTrackedShaderResources = 16;
+		static constexpr UINT MaxTrackedSamplers = D3D11_COMMONSHADER_SAMPLER_SLOT_COUNT;
+
+		struct ConstantBufferBinding
+		{
+			ID3D11Buffer* buffer;
+			UINT firstConstant;
+			UINT numConstants;   // 0 = whole buffer
+		};
+
+		struct StageState
+		{
+			ConstantBufferBinding constantBuffers[MaxTrackedConstantBuffers];
+			ID3D11ShaderResourceView* shaderResources[MaxTrackedShaderResources];
+			ID3D11SamplerState* samplers[MaxTrackedSamplers];
+		};
+
+		struct BoundState
+		{
+			ID3D11Buffer* vertexBuffers[MaxTrackedVertexBuffers];
+			UINT vertexStrides[MaxTrackedVertexBuffers];
+			UINT vertexOffsets[MaxTrackedVertexBuffers];
+			ID3D11Buffer* indexBuffer;
+			DXGI_FORMAT indexFormat;
+			UINT indexOffset;
+			ID3D11InputLayout* inputLayout;
+			D3D11_PRIMITIVE_TOPOLOGY topology;
+
+			ID3D11VertexShader* vertexShader;
+			ID3D11PixelShader* pixelShader;
+			StageState stages[2];
+
+			ID3D11RasterizerState* rasterizerState;
+			ID3D11DepthStencilState* depthStencilState;
+			UINT stencilRef;
+			ID3D11BlendState* blendState;
+		};
+		static BoundState s_State;
+		static StateFilterStats s_StateStats;
 	};
 }
\ No newline at end of file
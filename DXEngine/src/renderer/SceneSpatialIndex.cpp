@@ -0,0 +1,799 @@
+#include "dxpch.h"
+#include "SceneSpatialIndex.h"
+#include "models/Model.h"
+#include <algorithm>
+#include <cmath>
+
+namespace DXEngine {
+
+	namespace
+	{
+		// cells are packed 21 bits per axis, coordinates outside that go to the oversized list
+		constexpr int32_t MaxCellCoordinate = (1 << 20) - 1;
+
+		uint64_t PackCell(int32_t x, int32_t y, int32_t z)
+		{
+			constexpr uint64_t mask = (1u << 21) - 1;
+			return ((static_cast<uint64_t>(x) & mask) << 42) | ((static_cast<uint64_t>(y) & mask) << 21) | (static_cast<uint64_t>(z) & mask);
+		}
+
+		// BoundingBox::Expand on an empty box would grow to +-FLT_MAX, models without meshes have one
+		void Merge(BoundingBox& into, const BoundingBox& box)
+		{
+			if (box.min.x <= box.max.x && box.min.y <= box.max.y && box.min.z <= box.max.z)
+				into.Expand(box);
+		}
+
+		float SurfaceArea(const BoundingBox& box)
+		{
+			const float x = box.max.x - box.min.x, y = box.max.y - box.min.y, z = box.max.z - box.min.z;
+			if (x < 0.0f || y < 0.0f || z < 0.0f)
+				return 0.0f;
+			return 2.0f * (x * y + y * z + z * x);
+		}
+
+		float Component(const DirectX::XMFLOAT3& value, int axis)
+		{
+			return axis == 0 ? value.x : (axis == 1 ? value.y : value.z);
+		}
+
+		CullResult ClassifySphere(const BoundingSphere& sphere, const BoundingBox& box)
+		{
+			if (!sphere.Intersects(box))
+				return CullResult::Outside;
+
+			// the corner furthest from the centre decides whether the box is enclosed
+			const float dx = std::max(sphere.center.x - box.min.x, box.max.x - sphere.center.x);
+			const float dy = std::max(sphere.center.y - box.min.y, box.max.y - sphere.center.y);
+			const float dz = std::max(sphere.center.z - box.min.z, box.max.z - sphere.center.z);
+			return dx * dx + dy * dy + dz * dz <= sphere.radius * sphere.radius ? CullResult::Inside : CullResult::Intersects;
+		}
+
+		struct RayData
+		{
+			DirectX::XMFLOAT3 origin;
+			DirectX::XMFLOAT3 inverseDirection;
+		};
+
+		// slab test, distance is where the ray enters the box (0 when it starts inside)
+		bool IntersectRay(const RayData& ray, const BoundingBox& box, float maxDistance, float& distance)
+		{
+			float enter = 0.0f;
+			float exit = maxDistance;
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				const float origin = Component(ray.origin, axis);
+				const float inverse = Component(ray.inverseDirection, axis);
+				float t0 = (Component(box.min, axis) - origin) * inverse;
+				float t1 = (Component(box.max, axis) - origin) * inverse;
+				if (t0 > t1)
+					std::swap(t0, t1);
+				enter = std::max(enter, t0);
+				exit = std::min(exit, t1);
+				if (enter > exit)
+					return false;
+			}
+			distance = enter;
+			return true;
+		}
+	}
+
+	SceneSpatialIndex::SceneSpatialIndex(const SpatialIndexConfig& config)
+		: m_Config(config)
+	{
+		m_Config.maxLeafSize = std::max(m_Config.maxLeafSize, 1u);
+		m_Config.sahBins = std::clamp(m_Config.sahBins, 2u, 64u);
+		if (!(m_Config.dynamicCellSize > 0.0f))
+			m_Config.dynamicCellSize = 16.0f;
+	}
+
+	SpatialHandle SceneSpatialIndex::Insert(const std::shared_ptr<Model>& model, SpatialMobility mobility)
+	{
+		if (!model)
+		{
+			OutputDebugStringA("Warning: Attempting to insert a null model into the spatial index\n");
+			return InvalidSpatialHandle;
+		}
+
+		uint32_t handle;
+		if (!m_FreeHandles.empty())
+		{
+			handle = m_FreeHandles.back();
+			m_FreeHandles.pop_back();
+		}
+		else
+		{
+			handle = static_cast<uint32_t>(m_Entries.size());
+			m_Entries.emplace_back();
+		}
+
+		Entry& entry = m_Entries[handle];
+		entry = Entry{};
+		entry.model = model;
+		entry.mobility = mobility;
+		entry.bounds = model->GetWorldBoundingBox();
+		entry.version = model->GetBoundsVersion();
+
+		if (mobility == SpatialMobility::Static)
+		{
+			//tested linearly until the next build picks it up
+			entry.pending = true;
+			entry.slot = static_cast<uint32_t>(m_PendingStatics.size());
+			m_PendingStatics.push_back(handle);
+		}
+		else
+		{
+			entry.dynamicIndex = static_cast<uint32_t>(m_Dynamics.size());
+			m_Dynamics.push_back(handle);
+			PlaceDynamic(handle);
+		}
+
+		m_ObjectCount++;
+		return handle;
+	}
+
+	void SceneSpatialIndex::Remove(SpatialHandle handle)
+	{
+		if (handle >= m_Entries.size() || !m_Entries[handle].model)
+			return;
+
+		Entry& entry = m_Entries[handle];
+		m_ObjectCount--;
+
+		if (entry.mobility == SpatialMobility::Dynamic)
+		{
+			UnplaceDynamic(handle);
+			const uint32_t moved = m_Dynamics.back();
+			m_Dynamics[entry.dynamicIndex] = moved;
+			m_Entries[moved].dynamicIndex = entry.dynamicIndex;
+			m_Dynamics.pop_back();
+			ReleaseHandle(handle);
+		}
+		else if (entry.pending)
+		{
+			RemovePending(entry.slot);
+			ReleaseHandle(handle);
+		}
+		else
+		{
+			//the BVH still points at this handle, it is reused only after the next build
+			m_ItemModels[entry.slot] = nullptr;
+			m_StaleStatics++;
+			entry.model.reset();
+			entry.invalidated = false;
+			m_RetiredHandles.push_back(handle);
+		}
+	}
+
+	void SceneSpatialIndex::Clear()
+	{
+		*this = SceneSpatialIndex(m_Config);
+	}
+
+	void SceneSpatialIndex::Invalidate(SpatialHandle handle)
+	{
+		if (handle >= m_Entries.size() || !m_Entries[handle].model)
+			return;
+
+		Entry& entry = m_Entries[handle];
+		if (entry.mobility == SpatialMobility::Static && !entry.invalidated)
+		{
+			entry.invalidated = true;
+			m_InvalidatedStatics.push_back(handle);
+		}
+	}
+
+	void SceneSpatialIndex::Update()
+	{
+		//moved statics are refit in place, the tree only loses quality until the next build
+		for (uint32_t handle : m_InvalidatedStatics)
+		{
+			Entry& entry = m_Entries[handle];
+			if (!entry.model || !entry.invalidated)
+				continue;
+
+			entry.invalidated = false;
+			entry.bounds = entry.model->GetWorldBoundingBox();
+			entry.version = entry.model->GetBoundsVersion();
+			if (!entry.pending)
+			{
+				m_ItemBounds[entry.slot] = entry.bounds;
+				RefitItem(entry.slot);
+				m_StaleStatics++;
+				m_Stats.refits++;
+			}
+		}
+		m_InvalidatedStatics.clear();
+
+		const size_t staticCount = m_ItemHandles.size() + m_PendingStatics.size();
+		const size_t changes = m_PendingStatics.size() + m_StaleStatics;
+		const size_t threshold = std::max(static_cast<size_t>(m_Config.minRebuildChanges),
+			static_cast<size_t>(staticCount * m_Config.rebuildFraction));
+		if (changes > 0 && changes >= threshold)
+		{
+			BuildBVH();
+		}
+
+		//dynamics only move cells when their bounds version changed
+		for (uint32_t handle : m_Dynamics)
+		{
+			Entry& entry = m_Entries[handle];
+			const uint64_t version = entry.model->GetBoundsVersion();
+			if (version == entry.version)
+				continue;
+
+			entry.version = version;
+			UnplaceDynamic(handle);
+			entry.bounds = entry.model->GetWorldBoundingBox();
+			PlaceDynamic(handle);
+		}
+
+		m_Stats.staticObjects = m_ObjectCount - m_Dynamics.size();
+		m_Stats.dynamicObjects = m_Dynamics.size();
+		m_Stats.bvhNodes = m_Nodes.size();
+		m_Stats.pendingStatics = m_PendingStatics.size();
+		m_Stats.occupiedCells = m_CellLookup.size();
+		m_Stats.oversizedDynamics = m_Oversized.size();
+	}
+
+	void SceneSpatialIndex::Rebuild()
+	{
+		BuildBVH();
+		m_Stats.bvhNodes = m_Nodes.size();
+		m_Stats.pendingStatics = 0;
+	}
+
+	void SceneSpatialIndex::BuildBVH()
+	{
+		//live items from the old tree plus everything pending
+		std::vector<uint32_t> handles;
+		handles.reserve(m_ItemHandles.size() + m_PendingStatics.size());
+		for (size_t i = 0; i < m_ItemHandles.size(); ++i)
+		{
+			if (m_ItemModels[i])
+				handles.push_back(m_ItemHandles[i]);
+		}
+		handles.insert(handles.end(), m_PendingStatics.begin(), m_PendingStatics.end());
+
+		for (uint32_t handle : m_RetiredHandles)
+		{
+			ReleaseHandle(handle);
+		}
+		m_RetiredHandles.clear();
+		m_PendingStatics.clear();
+		m_StaleStatics = 0;
+		m_Stats.rebuilds++;
+
+		const uint32_t count = static_cast<uint32_t>(handles.size());
+		m_ItemHandles = std::move(handles);
+		m_ItemBounds.resize(count);
+		m_ItemModels.resize(count);
+		m_ItemLeaves.resize(count);
+
+		std::vector<DirectX::XMFLOAT3> centroids(count);
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			const Entry& entry = m_Entries[m_ItemHandles[i]];
+			m_ItemBounds[i] = entry.bounds;
+			centroids[i] = entry.bounds.GetCenter();
+		}
+
+		m_Nodes.clear();
+		m_NodeParents.clear();
+		if (count == 0)
+		{
+			m_ItemModels.clear();
+			return;
+		}
+
+		//a binary tree over n items never needs more than 2n - 1 nodes, no reallocation while building
+		m_Nodes.reserve(2 * static_cast<size_t>(count));
+		m_NodeParents.reserve(2 * static_cast<size_t>(count));
+		BVHNode root;
+		root.first = 0;
+		root.count = count;
+		m_Nodes.push_back(root);
+		m_NodeParents.push_back(NoSlot);
+		SubdivideNode(0, centroids);
+
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			Entry& entry = m_Entries[m_ItemHandles[i]];
+			entry.pending = false;
+			entry.slot = i;
+			m_ItemModels[i] = entry.model.get();
+		}
+	}
+
+	void SceneSpatialIndex::SubdivideNode(uint32_t nodeIndex, std::vector<DirectX::XMFLOAT3>& centroids)
+	{
+		BVHNode& node = m_Nodes[nodeIndex];
+		const uint32_t first = node.first;
+		const uint32_t count = node.count;
+
+		BoundingBox centroidBounds;
+		for (uint32_t i = first; i < first + count; ++i)
+		{
+			Merge(node.bounds, m_ItemBounds[i]);
+			centroidBounds.Expand(centroids[i]);
+		}
+
+		auto makeLeaf = [&]()
+			{
+				for (uint32_t i = first; i < first + count; ++i)
+				{
+					m_ItemLeaves[i] = nodeIndex;
+				}
+			};
+
+		if (count <= m_Config.maxLeafSize)
+		{
+			makeLeaf();
+			return;
+		}
+
+		//binned SAH over all three axes
+		struct Bin
+		{
+			BoundingBox bounds;
+			uint32_t count = 0;
+		};
+		constexpr uint32_t MaxBins = 64;
+		const uint32_t binCount = m_Config.sahBins;
+		Bin bins[MaxBins];
+		float rightArea[MaxBins];
+
+		int bestAxis = -1;
+		uint32_t bestSplit = 0;
+		float bestCost = FLT_MAX;
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			const float lo = Component(centroidBounds.min, axis);
+			const float extent = Component(centroidBounds.max, axis) - lo;
+			if (!(extent > 0.0f))
+				continue;
+
+			const float scale = binCount / extent;
+			std::fill(bins, bins + binCount, Bin{});
+			for (uint32_t i = first; i < first + count; ++i)
+			{
+				const uint32_t bin = std::min(binCount - 1, static_cast<uint32_t>((Component(centroids[i], axis) - lo) * scale));
+				bins[bin].count++;
+				Merge(bins[bin].bounds, m_ItemBounds[i]);
+			}
+
+			//sweep from the right for the area of every suffix, then from the left for the cost
+			BoundingBox sweep;
+			for (uint32_t b = binCount - 1; b > 0; --b)
+			{
+				Merge(sweep, bins[b].bounds);
+				rightArea[b] = SurfaceArea(sweep);
+			}
+
+			sweep = BoundingBox();
+			uint32_t leftCount = 0;
+			for (uint32_t b = 0; b + 1 < binCount; ++b)
+			{
+				Merge(sweep, bins[b].bounds);
+				leftCount += bins[b].count;
+				const uint32_t rightCount = count - leftCount;
+				if (leftCount == 0 || rightCount == 0)
+					continue;
+
+				const float cost = leftCount * SurfaceArea(sweep) + rightCount * rightArea[b + 1];
+				if (cost < bestCost)
+				{
+					bestCost = cost;
+					bestAxis = axis;
+					bestSplit = b + 1;
+				}
+			}
+		}
+
+		//identical centroids cannot be split; otherwise stay a leaf when splitting costs more
+		const float parentArea = SurfaceArea(node.bounds);
+		const bool splitPays = parentArea > 0.0f && 1.0f + bestCost / parentArea < static_cast<float>(count);
+		if (bestAxis < 0 || (!splitPays && count <= m_Config.maxLeafSize * 4))
+		{
+			makeLeaf();
+			return;
+		}
+
+		const float lo = Component(centroidBounds.min, bestAxis);
+		const float scale = binCount / (Component(centroidBounds.max, bestAxis) - lo);
+		uint32_t middle = first;
+		for (uint32_t i = first; i < first + count; ++i)
+		{
+			const uint32_t bin = std::min(binCount - 1, static_cast<uint32_t>((Component(centroids[i], bestAxis) - lo) * scale));
+			if (bin < bestSplit)
+			{
+				std::swap(m_ItemHandles[i], m_ItemHandles[middle]);
+				std::swap(m_ItemBounds[i], m_ItemBounds[middle]);
+				std::swap(centroids[i], centroids[middle]);
+				middle++;
+			}
+		}
+
+		const uint32_t left = static_cast<uint32_t>(m_Nodes.size());
+		node.left = left;
+
+		BVHNode leftNode, rightNode;
+		leftNode.first = first;
+		leftNode.count = middle - first;
+		rightNode.first = middle;
+		rightNode.count = first + count - middle;
+		m_Nodes.push_back(leftNode);
+		m_Nodes.push_back(rightNode);
+		m_NodeParents.push_back(nodeIndex);
+		m_NodeParents.push_back(nodeIndex);
+
+		SubdivideNode(left, centroids);
+		SubdivideNode(left + 1, centroids);
+	}
+
+	void SceneSpatialIndex::RefitItem(uint32_t item)
+	{
+		for (uint32_t nodeIndex = m_ItemLeaves[item]; nodeIndex != NoSlot; nodeIndex = m_NodeParents[nodeIndex])
+		{
+			BVHNode& node = m_Nodes[nodeIndex];
+			BoundingBox bounds;
+			if (node.left == 0)
+			{
+				for (uint32_t i = node.first; i < node.first + node.count; ++i)
+				{
+					Merge(bounds, m_ItemBounds[i]);
+				}
+			}
+			else
+			{
+				Merge(bounds, m_Nodes[node.left].bounds);
+				Merge(bounds, m_Nodes[node.left + 1].bounds);
+			}
+			node.bounds = bounds;
+		}
+	}
+
+	void SceneSpatialIndex::RemovePending(uint32_t index)
+	{
+		const uint32_t moved = m_PendingStatics.back();
+		m_PendingStatics[index] = moved;
+		m_Entries[moved].slot = index;
+		m_PendingStatics.pop_back();
+	}
+
+	void SceneSpatialIndex::PlaceDynamic(uint32_t handle)
+	{
+		Entry& entry = m_Entries[handle];
+		const float cellSize = m_Config.dynamicCellSize;
+		const DirectX::XMFLOAT3 center = entry.bounds.GetCenter();
+		const DirectX::XMFLOAT3 extents = entry.bounds.GetExtents();
+
+		//an object whose centre is in a cell stays inside the cell grown by half a cell per side
+		const float cx = std::floor(center.x / cellSize), cy = std::floor(center.y / cellSize), cz = std::floor(center.z / cellSize);
+		const float limit = static_cast<float>(MaxCellCoordinate);
+		const bool fits = std::max({ extents.x, extents.y, extents.z }) <= cellSize * 0.5f &&
+			std::abs(cx) <= limit && std::abs(cy) <= limit && std::abs(cz) <= limit;
+		if (!fits)
+		{
+			entry.cell = NoSlot;
+			entry.slot = static_cast<uint32_t>(m_Oversized.size());
+			m_Oversized.push_back(handle);
+			return;
+		}
+
+		const int32_t x = static_cast<int32_t>(cx), y = static_cast<int32_t>(cy), z = static_cast<int32_t>(cz);
+		const uint64_t key = PackCell(x, y, z);
+		auto it = m_CellLookup.find(key);
+		uint32_t cellIndex;
+		if (it != m_CellLookup.end())
+		{
+			cellIndex = it->second;
+		}
+		else
+		{
+			if (!m_FreeCells.empty())
+			{
+				cellIndex = m_FreeCells.back();
+				m_FreeCells.pop_back();
+			}
+			else
+			{
+				cellIndex = static_cast<uint32_t>(m_Cells.size());
+				m_Cells.emplace_back();
+			}
+			Cell& cell = m_Cells[cellIndex];
+			cell.x = x;
+			cell.y = y;
+			cell.z = z;
+			m_CellLookup.emplace(key, cellIndex);
+		}
+
+		Cell& cell = m_Cells[cellIndex];
+		entry.cell = cellIndex;
+		entry.slot = static_cast<uint32_t>(cell.entries.size());
+		cell.entries.push_back(handle);
+	}
+
+	void SceneSpatialIndex::UnplaceDynamic(uint32_t handle)
+	{
+		const Entry& entry = m_Entries[handle];
+		std::vector<uint32_t>& list = entry.cell == NoSlot ? m_Oversized : m_Cells[entry.cell].entries;
+
+		const uint32_t moved = list.back();
+		list[entry.slot] = moved;
+		m_Entries[moved].slot = entry.slot;
+		list.pop_back();
+
+		if (entry.cell != NoSlot && list.empty())
+		{
+			const Cell& cell = m_Cells[entry.cell];
+			m_CellLookup.erase(PackCell(cell.x, cell.y, cell.z));
+			m_FreeCells.push_back(entry.cell);
+		}
+	}
+
+	BoundingBox SceneSpatialIndex::GetLooseCellBounds(const Cell& cell) const
+	{
+		const float size = m_Config.dynamicCellSize;
+		const float half = size * 0.5f;
+		return BoundingBox(
+			DirectX::XMFLOAT3(cell.x * size - half, cell.y * size - half, cell.z * size - half),
+			DirectX::XMFLOAT3((cell.x + 1) * size + half, (cell.y + 1) * size + half, (cell.z + 1) * size + half));
+	}
+
+	void SceneSpatialIndex::ReleaseHandle(uint32_t handle)
+	{
+		Entry& entry = m_Entries[handle];
+		entry.model.reset();
+		entry.invalidated = false;
+		m_FreeHandles.push_back(handle);
+	}
+
+	void SceneSpatialIndex::QueryFrustum(const FrustumPlanes& frustum, std::vector<Model*>& out) const
+	{
+		QueryBVHFrustum(frustum, out);
+
+		for (uint32_t handle : m_PendingStatics)
+		{
+			uint32_t mask = FrustumPlanes::AllPlanes;
+			if (frustum.Classify(m_Entries[handle].bounds, mask) != CullResult::Outside)
+				out.push_back(m_Entries[handle].model.get());
+		}
+
+		for (const Cell& cell : m_Cells)
+		{
+			if (cell.entries.empty())
+				continue;
+
+			uint32_t cellMask = FrustumPlanes::AllPlanes;
+			const CullResult result = frustum.Classify(GetLooseCellBounds(cell), cellMask);
+			if (result == CullResult::Outside)
+				continue;
+
+			for (uint32_t handle : cell.entries)
+			{
+				uint32_t mask = cellMask;
+				if (result == CullResult::Inside || frustum.Classify(m_Entries[handle].bounds, mask) != CullResult::Outside)
+					out.push_back(m_Entries[handle].model.get());
+			}
+		}
+
+		for (uint32_t handle : m_Oversized)
+		{
+			uint32_t mask = FrustumPlanes::AllPlanes;
+			if (frustum.Classify(m_Entries[handle].bounds, mask) != CullResult::Outside)
+				out.push_back(m_Entries[handle].model.get());
+		}
+	}
+
+	void SceneSpatialIndex::QueryBVHFrustum(const FrustumPlanes& frustum, std::vector<Model*>& out) const
+	{
+		if (m_Nodes.empty())
+			return;
+
+		//node and the planes still straddled by its parent
+		thread_local std::vector<std::pair<uint32_t, uint32_t>> t_Stack;
+		t_Stack.clear();
+		t_Stack.emplace_back(0u, FrustumPlanes::AllPlanes);
+
+		while (!t_Stack.empty())
+		{
+			auto [nodeIndex, mask] = t_Stack.back();
+			t_Stack.pop_back();
+
+			const BVHNode& node = m_Nodes[nodeIndex];
+			const CullResult result = frustum.Classify(node.bounds, mask);
+			if (result == CullResult::Outside)
+				continue;
+
+			//fully inside, the whole subtree is visible without further tests
+			if (result == CullResult::Inside)
+			{
+				AppendSubtree(node, out);
+				continue;
+			}
+
+			if (node.left != 0)
+			{
+				t_Stack.emplace_back(node.left + 1, mask);
+				t_Stack.emplace_back(node.left, mask);
+				continue;
+			}
+
+			for (uint32_t i = node.first; i < node.first + node.count; ++i)
+			{
+				uint32_t itemMask = mask;
+				if (m_ItemModels[i] && frustum.Classify(m_ItemBounds[i], itemMask) != CullResult::Outside)
+					out.push_back(m_ItemModels[i]);
+			}
+		}
+	}
+
+	void SceneSpatialIndex::AppendSubtree(const BVHNode& node, std::vector<Model*>& out) const
+	{
+		for (uint32_t i = node.first; i < node.first + node.count; ++i)
+		{
+			if (m_ItemModels[i])
+				out.push_back(m_ItemModels[i]);
+		}
+	}
+
+	void SceneSpatialIndex::QuerySphere(const BoundingSphere& sphere, std::vector<Model*>& out) const
+	{
+		if (!m_Nodes.empty())
+		{
+			thread_local std::vector<uint32_t> t_Stack;
+			t_Stack.clear();
+			t_Stack.push_back(0);
+			while (!t_Stack.empty())
+			{
+				const BVHNode& node = m_Nodes[t_Stack.back()];
+				t_Stack.pop_back();
+
+				const CullResult result = ClassifySphere(sphere, node.bounds);
+				if (result == CullResult::Outside)
+					continue;
+				if (result == CullResult::Inside)
+				{
+					AppendSubtree(node, out);
+					continue;
+				}
+				if (node.left != 0)
+				{
+					t_Stack.push_back(node.left + 1);
+					t_Stack.push_back(node.left);
+					continue;
+				}
+
+				for (uint32_t i = node.first; i < node.first + node.count; ++i)
+				{
+					if (m_ItemModels[i] && sphere.Intersects(m_ItemBounds[i]))
+						out.push_back(m_ItemModels[i]);
+				}
+			}
+		}
+
+		for (uint32_t handle : m_PendingStatics)
+		{
+			if (sphere.Intersects(m_Entries[handle].bounds))
+				out.push_back(m_Entries[handle].model.get());
+		}
+
+		for (const Cell& cell : m_Cells)
+		{
+			if (cell.entries.empty())
+				continue;
+
+			const CullResult result = ClassifySphere(sphere, GetLooseCellBounds(cell));
+			if (result == CullResult::Outside)
+				continue;
+
+			for (uint32_t handle : cell.entries)
+			{
+				if (result == CullResult::Inside || sphere.Intersects(m_Entries[handle].bounds))
+					out.push_back(m_Entries[handle].model.get());
+			}
+		}
+
+		for (uint32_t handle : m_Oversized)
+		{
+			if (sphere.Intersects(m_Entries[handle].bounds))
+				out.push_back(m_Entries[handle].model.get());
+		}
+	}
+
+	void SceneSpatialIndex::QueryRay(const Ray& ray, float maxDistance, std::vector<SpatialRayHit>& out) const
+	{
+		RayData data;
+		DirectX::XMStoreFloat3(&data.origin, ray.Origin);
+		DirectX::XMStoreFloat3(&data.inverseDirection, DirectX::XMVectorReciprocal(ray.Direction));
+
+		const size_t firstHit = out.size();
+		float distance = 0.0f;
+
+		if (!m_Nodes.empty())
+		{
+			thread_local std::vector<uint32_t> t_Stack;
+			t_Stack.clear();
+			t_Stack.push_back(0);
+			while (!t_Stack.empty())
+			{
+				const BVHNode& node = m_Nodes[t_Stack.back()];
+				t_Stack.pop_back();
+
+				if (!IntersectRay(data, node.bounds, maxDistance, distance))
+					continue;
+
+				if (node.left != 0)
+				{
+					t_Stack.push_back(node.left + 1);
+					t_Stack.push_back(node.left);
+					continue;
+				}
+
+				for (uint32_t i = node.first; i < node.first + node.count; ++i)
+				{
+					if (m_ItemModels[i] && IntersectRay(data, m_ItemBounds[i], maxDistance, distance))
+						out.push_back({ m_ItemModels[i], distance });
+				}
+			}
+		}
+
+		for (uint32_t handle : m_PendingStatics)
+		{
+			if (IntersectRay(data, m_Entries[handle].bounds, maxDistance, distance))
+				out.push_back({ m_Entries[handle].model.get(), distance });
+		}
+
+		for (const Cell& cell : m_Cells)
+		{
+			if (cell.entries.empty() || !IntersectRay(data, GetLooseCellBounds(cell), maxDistance, distance))
+				continue;
+
+			for (uint32_t handle : cell.entries)
+			{
+				if (IntersectRay(data, m_Entries[handle].bounds, maxDistance, distance))
+					out.push_back({ m_Entries[handle].model.get(), distance });
+			}
+		}
+
+		for (uint32_t handle : m_Oversized)
+		{
+			if (IntersectRay(data, m_Entries[handle].bounds, maxDistance, distance))
+				out.push_back({ m_Entries[handle].model.get(), distance });
+		}
+
+		std::sort(out.begin() + firstHit, out.end(),
+			[](const SpatialRayHit& a, const SpatialRayHit& b) { return a.distance < b.distance; });
+	}
+
+	void SceneSpatialIndex::QueryAll(std::vector<Model*>& out) const
+	{
+		for (Model* model : m_ItemModels)
+		{
+			if (model)
+				out.push_back(model);
+		}
+		for (uint32_t handle : m_PendingStatics)
+		{
+			out.push_back(m_Entries[handle].model.get());
+		}
+		for (uint32_t handle : m_Dynamics)
+		{
+			out.push_back(m_Entries[handle].model.get());
+		}
+	}
+
+	std::string SceneSpatialIndex::GetDebugInfo() const
+	{
+		std::string info = "=== Scene Spatial Index ===\n";
+		info += "Static Objects: " + std::to_string(m_Stats.staticObjects) + "\n";
+		info += "Dynamic Objects: " + std::to_string(m_Stats.dynamicObjects) + "\n";
+		info += "BVH Nodes: " + std::to_string(m_Stats.bvhNodes) + "\n";
+		info += "Pending Statics: " + std::to_string(m_Stats.pendingStatics) + "\n";
+		info += "Occupied Cells: " + std::to_string(m_Stats.occupiedCells) + "\n";
+		info += "Oversized Dynamics: " + std::to_string(m_Stats.oversizedDynamics) + "\n";
+		info += "Rebuilds/Refits: " + std::to_string(m_Stats.rebuilds) + " / " + std::to_string(m_Stats.refits) + "\n";
+		return info;
+	}
+}
@@ -0,0 +1,153 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "FrustumCulling.h"
+#include "picking/Ray.h"
+
+namespace DXEngine {
+
+	class Model;
+
+	using SpatialHandle = uint32_t;
+	constexpr SpatialHandle InvalidSpatialHandle = UINT32_MAX;
+
+	enum class SpatialMobility : uint8_t
+	{
+		Static,     // SAH BVH, refit when invalidated, rebuilt once enough has changed
+		Dynamic     // loose grid, bounds re-read whenever the model's bounds version changes
+	};
+
+	struct SpatialIndexConfig
+	{
+		uint32_t maxLeafSize = 4;           // BVH leaves stop splitting at this many objects
+		uint32_t sahBins = 16;
+		float rebuildFraction = 0.125f;     // pending, removed and refit statics before a full rebuild
+		uint32_t minRebuildChanges = 64;
+		float dynamicCellSize = 16.0f;      // loose cells are twice this wide
+	};
+
+	struct SpatialRayHit
+	{
+		Model* model = nullptr;
+		float distance = 0.0f;              // where the ray enters the world box
+	};
+
+	// Scene level culling structure. Static models live in a bounding volume hierarchy,
+	// moving ones in a loose grid; queries walk both and never touch subtrees outside the
+	// query volume. Call Update once per frame before querying. Queries are const and may
+	// run on several threads at once, edits and Update may not overlap them.
+	class SceneSpatialIndex
+	{
+	public:
+		struct Stats
+		{
+			size_t staticObjects = 0;
+			size_t dynamicObjects = 0;
+			size_t bvhNodes = 0;
+			size_t pendingStatics = 0;      // inserted since the last build, tested linearly
+			size_t occupiedCells = 0;
+			size_t oversizedDynamics = 0;   // too large for a loose cell
+			uint32_t rebuilds = 0;
+			uint32_t refits = 0;
+		};
+
+		explicit SceneSpatialIndex(const SpatialIndexConfig& config = {});
+
+		SpatialHandle Insert(const std::shared_ptr<Model>& model, SpatialMobility mobility);
+		void Remove(SpatialHandle handle);
+		void Clear();
+
+		// Static models are not polled, call this after moving one so Update refits it
+		void Invalidate(SpatialHandle handle);
+		void Update();
+		void Rebuild();
+
+		void QueryFrustum(const FrustumPlanes& frustum, std::vector<Model*>& out) const;
+		void QuerySphere(const BoundingSphere& sphere, std::vector<Model*>& out) const;
+		// Every model whose world box the ray enters before maxDistance, nearest first
+		void QueryRay(const Ray& ray, float maxDistance, std::vector<SpatialRayHit>& out) const;
+		void QueryAll(std::vector<Model*>& out) const;
+
+		size_t Size() const { return m_ObjectCount; }
+		bool Empty() const { return m_ObjectCount == 0; }
+		const Stats& GetStats() const { return m_Stats; }
+		std::string GetDebugInfo() const;
+
+	private:
+		static constexpr uint32_t NoSlot = UINT32_MAX;
+
+		struct Entry
+		{
+			std::shared_ptr<Model> model;
+			BoundingBox bounds;
+			uint64_t version = 0;
+			SpatialMobility mobility = SpatialMobility::Static;
+			uint32_t slot = NoSlot;         // static: BVH item or pending index, dynamic: index in its cell
+			uint32_t cell = NoSlot;         // dynamic only, NoSlot when oversized
+			uint32_t dynamicIndex = NoSlot; // position in m_Dynamics
+			bool pending = false;           // static, not in the BVH yet
+			bool invalidated = false;
+		};
+
+		// first/count cover the whole subtree, so an inside node appends its items as one run
+		struct BVHNode
+		{
+			BoundingBox bounds;
+			uint32_t first = 0;
+			uint32_t count = 0;
+			uint32_t left = 0;              // right child is left + 1, 0 for leaves
+		};
+
+		struct Cell
+		{
+			int32_t x = 0, y = 0, z = 0;
+			std::vector<uint32_t> entries;
+		};
+
+		//static
+		void BuildBVH();
+		void SubdivideNode(uint32_t nodeIndex, std::vector<DirectX::XMFLOAT3>& centroids);
+		void RefitItem(uint32_t item);
+		void RemovePending(uint32_t index);
+		void QueryBVHFrustum(const FrustumPlanes& frustum, std::vector<Model*>& out) const;
+		void AppendSubtree(const BVHNode& node, std::vector<Model*>& out) const;
+
+		//dynamic
+		void PlaceDynamic(uint32_t handle);
+		void UnplaceDynamic(uint32_t handle);
+		BoundingBox GetLooseCellBounds(const Cell& cell) const;
+
+		void ReleaseHandle(uint32_t handle);
+
+	private:
+		SpatialIndexConfig m_Config;
+
+		std::vector<Entry> m_Entries;
+		std::vector<uint32_t> m_FreeHandles;
+		std::vector<uint32_t> m_RetiredHandles;     // removed from the BVH, reusable after the next build
+		size_t m_ObjectCount = 0;
+
+		//static BVH, items are entry handles in leaf order
+		std::vector<BVHNode> m_Nodes;
+		std::vector<uint32_t> m_NodeParents;
+		std::vector<uint32_t> m_ItemHandles;
+		std::vector<uint32_t> m_ItemLeaves;
+		std::vector<BoundingBox> m_ItemBounds;
+		std::vector<Model*> m_ItemModels;           // nullptr once removed
+		std::vector<uint32_t> m_PendingStatics;
+		std::vector<uint32_t> m_InvalidatedStatics;
+		size_t m_StaleStatics = 0;                  // removed or refit since the last build
+
+		//dynamic loose grid
+		std::vector<Cell> m_Cells;
+		std::unordered_map<uint64_t, uint32_t> m_CellLookup;
+		std::vector<uint32_t> m_FreeCells;
+		std::vector<uint32_t> m_Oversized;
+		std::vector<uint32_t> m_Dynamics;
+
+		Stats m_Stats;
+	};
+}
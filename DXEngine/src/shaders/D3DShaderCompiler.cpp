@@ -0,0 +1,43 @@
+#include "dxpch.h"
+#include "D3DShaderCompiler.h"
+
+namespace DXEngine {
+
+	bool D3DShaderCompiler::Compile(const ShaderCompileRequest& request, std::vector<uint8_t>& byteCode, std::string& errors)
+	{
+		Microsoft::WRL::ComPtr<ID3DBlob> shaderBlob;
+		Microsoft::WRL::ComPtr<ID3DBlob> errorBlob;
+
+		HRESULT hr = D3DCompile(
+			request.source.c_str(),
+			request.source.size(),
+			request.filePath.c_str(),
+			nullptr, // Additional defines
+			D3D_COMPILE_STANDARD_FILE_INCLUDE,
+			request.entryPoint.c_str(),
+			request.target.c_str(),
+			request.flags,
+			0,
+			&shaderBlob,
+			&errorBlob
+		);
+
+		if (FAILED(hr) || !shaderBlob)
+		{
+			if (errorBlob)
+			{
+				errors.assign(static_cast<const char*>(errorBlob->GetBufferPointer()), errorBlob->GetBufferSize());
+			}
+			return false;
+		}
+
+		const auto* bytes = static_cast<const uint8_t*>(shaderBlob->GetBufferPointer());
+		byteCode.assign(bytes, bytes + shaderBlob->GetBufferSize());
+		return true;
+	}
+
+	uint64_t D3DShaderCompiler::GetVersion() const
+	{
+		return D3D_COMPILER_VERSION;
+	}
+}
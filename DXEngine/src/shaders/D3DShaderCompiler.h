@@ -0,0 +1,13 @@
+#pragma once
+#include "ShaderCompiler.h"
+
+namespace DXEngine {
+
+	// D3DCompile with the standard file include handler
+	class D3DShaderCompiler : public ShaderCompiler
+	{
+	public:
+		bool Compile(const ShaderCompileRequest& request, std::vector<uint8_t>& byteCode, std::string& errors) override;
+		uint64_t GetVersion() const override;
+	};
+}
@@ -0,0 +1,148 @@
+#include "dxpch.h"
+#include "ShaderArchive.h"
+#include "utils/Hash.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <unordered_map>
+
+namespace DXEngine {
+
+	namespace
+	{
+		constexpr uint32_t ArchiveMagic = 0x41535844;   // "DXSA"
+		constexpr uint32_t ArchiveVersion = 2;
+
+		bool IsRangeValid(uint64_t offset, uint64_t size, size_t fileSize)
+		{
+			return offset <= fileSize && size <= fileSize - offset;
+		}
+	}
+
+	bool ShaderArchive::Open(const std::string& path)
+	{
+		Close();
+		if (!m_File.Open(path))
+			return false;
+
+		const size_t fileSize = m_File.GetSize();
+		FileHeader header = {};
+		if (fileSize >= sizeof(header))
+		{
+			std::memcpy(&header, m_File.GetData(), sizeof(header));
+		}
+
+		bool valid = fileSize >= sizeof(header) && header.magic == ArchiveMagic && header.version == ArchiveVersion &&
+			header.entryCount <= (fileSize - sizeof(FileHeader)) / sizeof(FileEntry);
+
+		const FileEntry* entries = reinterpret_cast<const FileEntry*>(m_File.GetData() + sizeof(FileHeader));
+		for (uint64_t i = 0; valid && i < header.entryCount; ++i)
+		{
+			valid = IsRangeValid(entries[i].vertexShaderOffset, entries[i].vertexShaderSize, fileSize) &&
+				IsRangeValid(entries[i].pixelShaderOffset, entries[i].pixelShaderSize, fileSize) &&
+				(i == 0 || entries[i - 1].key < entries[i].key);
+		}
+
+		if (!valid)
+		{
+			OutputDebugStringA(("Warning: Ignoring invalid shader archive " + path + "\n").c_str());
+			Close();
+			return false;
+		}
+
+		m_EntryCount = header.entryCount;
+		return true;
+	}
+
+	void ShaderArchive::Close()
+	{
+		m_File.Close();
+		m_EntryCount = 0;
+	}
+
+	bool ShaderArchive::Find(const ShaderArchiveKey& key, ShaderArchiveBlobs& blobs) const
+	{
+		const FileEntry* entries = GetEntries();
+		const FileEntry* end = entries + m_EntryCount;
+		const FileEntry* it = std::lower_bound(entries, end, key,
+			[](const FileEntry& entry, const ShaderArchiveKey& value) { return entry.key < value; });
+		if (it == end || !(it->key == key))
+			return false;
+
+		const uint8_t* data = m_File.GetData();
+		blobs.sourceHash = it->sourceHash;
+		blobs.vertexShader = data + it->vertexShaderOffset;
+		blobs.vertexShaderSize = static_cast<size_t>(it->vertexShaderSize);
+		blobs.pixelShader = data + it->pixelShaderOffset;
+		blobs.pixelShaderSize = static_cast<size_t>(it->pixelShaderSize);
+		return true;
+	}
+
+	const ShaderArchive::FileEntry* ShaderArchive::GetEntries() const
+	{
+		return m_File.IsOpen() ? reinterpret_cast<const FileEntry*>(m_File.GetData() + sizeof(FileHeader)) : nullptr;
+	}
+
+	bool ShaderArchive::Write(const std::string& path, std::vector<ShaderArchiveEntry> entries)
+	{
+		std::sort(entries.begin(), entries.end(),
+			[](const ShaderArchiveEntry& a, const ShaderArchiveEntry& b) { return a.key < b.key; });
+		entries.erase(std::unique(entries.begin(), entries.end(),
+			[](const ShaderArchiveEntry& a, const ShaderArchiveEntry& b) { return a.key == b.key; }), entries.end());
+
+		// many layouts compile to the same code, store each distinct blob once
+		std::vector<const std::vector<uint8_t>*> blobs;
+		std::unordered_map<uint64_t, std::vector<size_t>> blobsByHash;
+		std::vector<uint64_t> blobOffsets;
+		uint64_t offset = sizeof(FileHeader) + sizeof(FileEntry) * entries.size();
+
+		auto addBlob = [&](const std::vector<uint8_t>& blob) {
+			auto& candidates = blobsByHash[HashBytes(blob.data(), blob.size())];
+			for (size_t index : candidates)
+			{
+				if (*blobs[index] == blob)
+					return blobOffsets[index];
+			}
+			candidates.push_back(blobs.size());
+			blobs.push_back(&blob);
+			blobOffsets.push_back(offset);
+			offset += blob.size();
+			return blobOffsets.back();
+		};
+
+		std::vector<FileEntry> table(entries.size());
+		for (size_t i = 0; i < entries.size(); ++i)
+		{
+			table[i].key = entries[i].key;
+			table[i].sourceHash = entries[i].sourceHash;
+			table[i].vertexShaderOffset = addBlob(entries[i].vertexShader);
+			table[i].vertexShaderSize = entries[i].vertexShader.size();
+			table[i].pixelShaderOffset = addBlob(entries[i].pixelShader);
+			table[i].pixelShaderSize = entries[i].pixelShader.size();
+		}
+
+		const std::filesystem::path filePath(path);
+		std::error_code ec;
+		if (filePath.has_parent_path())
+		{
+			std::filesystem::create_directories(filePath.parent_path(), ec);
+		}
+
+		std::ofstream file(filePath, std::ios::binary | std::ios::trunc);
+		if (!file)
+		{
+			OutputDebugStringA(("Warning: Failed to write shader archive " + path + "\n").c_str());
+			return false;
+		}
+
+		const FileHeader header{ ArchiveMagic, ArchiveVersion, table.size() };
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(reinterpret_cast<const char*>(table.data()), static_cast<std::streamsize>(sizeof(FileEntry) * table.size()));
+		for (const auto* blob : blobs)
+		{
+			file.write(reinterpret_cast<const char*>(blob->data()), static_cast<std::streamsize>(blob->size()));
+		}
+		return static_cast<bool>(file);
+	}
+}
@@ -0,0 +1,85 @@
+#pragma once
+#include "utils/MappedFile.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace DXEngine {
+
+	// Identifies one variant in the archive, the fields of ShaderVariantKey
+	struct ShaderArchiveKey
+	{
+		uint64_t layoutID = 0;
+		uint32_t materialType = 0;
+		uint32_t features = 0;
+
+		bool operator<(const ShaderArchiveKey& other) const
+		{
+			if (layoutID != other.layoutID) return layoutID < other.layoutID;
+			if (materialType != other.materialType) return materialType < other.materialType;
+			return features < other.features;
+		}
+		bool operator==(const ShaderArchiveKey& other) const
+		{
+			return layoutID == other.layoutID && materialType == other.materialType && features == other.features;
+		}
+	};
+
+	struct ShaderArchiveEntry
+	{
+		ShaderArchiveKey key;
+		uint64_t sourceHash = 0;    // shader files and their includes the code was built from
+		std::vector<uint8_t> vertexShader;
+		std::vector<uint8_t> pixelShader;
+	};
+
+	// Views into the mapped archive, valid until Close
+	struct ShaderArchiveBlobs
+	{
+		uint64_t sourceHash = 0;
+		const uint8_t* vertexShader = nullptr;
+		size_t vertexShaderSize = 0;
+		const uint8_t* pixelShader = nullptr;
+		size_t pixelShaderSize = 0;
+	};
+
+	// Prebuilt variants packed into one file: a header, a key sorted entry table and the
+	// bytecode, identical blobs stored once. Written offline by the ShaderBuilder tool and
+	// memory mapped at runtime, lookups binary search the table.
+	class ShaderArchive
+	{
+	public:
+		bool Open(const std::string& path);
+		void Close();
+		bool IsOpen() const { return m_File.IsOpen(); }
+
+		bool Find(const ShaderArchiveKey& key, ShaderArchiveBlobs& blobs) const;
+		size_t GetEntryCount() const { return static_cast<size_t>(m_EntryCount); }
+
+		static bool Write(const std::string& path, std::vector<ShaderArchiveEntry> entries);
+
+	private:
+		struct FileHeader
+		{
+			uint32_t magic;
+			uint32_t version;
+			uint64_t entryCount;
+		};
+
+		struct FileEntry
+		{
+			ShaderArchiveKey key;
+			uint64_t sourceHash;
+			uint64_t vertexShaderOffset;
+			uint64_t vertexShaderSize;
+			uint64_t pixelShaderOffset;
+			uint64_t pixelShaderSize;
+		};
+
+		const FileEntry* GetEntries() const;
+
+	private:
+		MappedFile m_File;
+		uint64_t m_EntryCount = 0;
+	};
+}
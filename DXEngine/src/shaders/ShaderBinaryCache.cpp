@@ -0,0 +1,268 @@
+#include "dxpch.h"
+#include "ShaderBinaryCache.h"
+#include "utils/Hash.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace DXEngine {
+
+	namespace
+	{
+		constexpr uint32_t CacheMagic = 0x43535844;   // "DXSC"
+		constexpr uint32_t CacheVersion = 1;
+	}
+
+	ShaderBinaryCache::~ShaderBinaryCache()
+	{
+		Close();
+	}
+
+	bool ShaderBinaryCache::Open(const std::string& path)
+	{
+		Close();
+		m_Path = path;
+
+		if (!std::filesystem::exists(m_Path))
+			return true;
+
+		if (!MapFile())
+		{
+			OutputDebugStringA(("Warning: Ignoring unreadable shader cache " + m_Path + "\n").c_str());
+			UnmapFile();
+		}
+		return true;
+	}
+
+	void ShaderBinaryCache::Close()
+	{
+		if (!IsOpen())
+			return;
+
+		Flush();
+		UnmapFile();
+		m_Pending.clear();
+		m_Path.clear();
+	}
+
+	bool ShaderBinaryCache::Find(uint64_t key, const uint8_t*& data, size_t& size) const
+	{
+		// the mapped table is read only, no lock needed
+		const FileEntry* entries = GetMappedEntries();
+		const FileEntry* end = entries + m_MappedEntryCount;
+		const FileEntry* it = std::lower_bound(entries, end, key,
+			[](const FileEntry& entry, uint64_t value) { return entry.key < value; });
+		if (it != end && it->key == key)
+		{
+			data = m_MappedData + it->offset;
+			size = static_cast<size_t>(it->size);
+			return true;
+		}
+
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		auto pending = m_Pending.find(key);
+		if (pending == m_Pending.end())
+			return false;
+
+		data = pending->second.data();
+		size = pending->second.size();
+		return true;
+	}
+
+	void ShaderBinaryCache::Store(uint64_t key, const uint8_t* data, size_t size)
+	{
+		if (!IsOpen() || !data || size == 0)
+			return;
+
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Pending.try_emplace(key, data, data + size);
+	}
+
+	bool ShaderBinaryCache::Flush()
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		if (!IsOpen() || m_Pending.empty())
+			return true;
+
+		// merge the mapped entries with the new ones, sorted by key
+		struct Source
+		{
+			uint64_t key;
+			const uint8_t* data;
+			uint64_t size;
+		};
+		std::vector<Source> sources;
+		sources.reserve(static_cast<size_t>(m_MappedEntryCount) + m_Pending.size());
+
+		const FileEntry* mapped = GetMappedEntries();
+		for (uint64_t i = 0; i < m_MappedEntryCount; ++i)
+		{
+			sources.push_back({ mapped[i].key, m_MappedData + mapped[i].offset, mapped[i].size });
+		}
+		for (const auto& [key, blob] : m_Pending)
+		{
+			sources.push_back({ key, blob.data(), blob.size() });
+		}
+		std::sort(sources.begin(), sources.end(), [](const Source& a, const Source& b) { return a.key < b.key; });
+		sources.erase(std::unique(sources.begin(), sources.end(),
+			[](const Source& a, const Source& b) { return a.key == b.key; }), sources.end());
+
+		std::vector<FileEntry> entries(sources.size());
+		uint64_t offset = sizeof(FileHeader) + sizeof(FileEntry) * entries.size();
+		for (size_t i = 0; i < sources.size(); ++i)
+		{
+			entries[i] = { sources[i].key, offset, sources[i].size };
+			offset += sources[i].size;
+		}
+
+		// write next to the old file, the mapping stays valid while we copy out of it
+		const std::filesystem::path path(m_Path);
+		const std::filesystem::path tempPath = path.string() + ".tmp";
+		std::error_code ec;
+		if (path.has_parent_path())
+		{
+			std::filesystem::create_directories(path.parent_path(), ec);
+		}
+
+		{
+			std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+			if (!file)
+			{
+				OutputDebugStringA(("Warning: Failed to write shader cache " + tempPath.string() + "\n").c_str());
+				return false;
+			}
+
+			const FileHeader header{ CacheMagic, CacheVersion, entries.size() };
+			file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			file.write(reinterpret_cast<const char*>(entries.data()), static_cast<std::streamsize>(sizeof(FileEntry) * entries.size()));
+			for (const auto& source : sources)
+			{
+				file.write(reinterpret_cast<const char*>(source.data), static_cast<std::streamsize>(source.size));
+			}
+			if (!file)
+			{
+				OutputDebugStringA(("Warning: Failed to write shader cache " + tempPath.string() + "\n").c_str());
+				return false;
+			}
+		}
+
+		UnmapFile();
+		std::filesystem::rename(tempPath, path, ec);
+		if (ec)
+		{
+			OutputDebugStringA(("Warning: Failed to replace shader cache " + m_Path + ": " + ec.message() + "\n").c_str());
+			std::filesystem::remove(tempPath, ec);
+			if (!MapFile())
+				UnmapFile();
+			return false;
+		}
+
+		if (!MapFile())
+		{
+			UnmapFile();
+			return false;
+		}
+		m_Pending.clear();
+		return true;
+	}
+
+	size_t ShaderBinaryCache::GetEntryCount() const
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		return static_cast<size_t>(m_MappedEntryCount) + m_Pending.size();
+	}
+
+	uint64_t ShaderBinaryCache::MakeKey(uint64_t sourceHash, const std::string& defines, const std::string& target,
+		const std::string& entryPoint, uint32_t flags, uint64_t compilerVersion)
+	{
+		uint64_t key = HashCombine(sourceHash, HashString(defines));
+		key = HashCombine(key, HashString(target));
+		key = HashCombine(key, HashString(entryPoint));
+		key = HashCombine(key, flags);
+		return HashCombine(key, compilerVersion);
+	}
+
+	bool CompileShaderCached(ShaderCompiler& compiler, ShaderBinaryCache& cache, const std::string& filePath,
+		const std::string& defines, const std::string& target, const std::string& entryPoint, uint32_t flags,
+		CachedCompileResult& result)
+	{
+		result = CachedCompileResult{};
+
+		// the hash covers every file it includes
+		ShaderSource source;
+		if (!LoadShaderSource(filePath, source))
+		{
+			result.errors = "Failed to open shader file: " + filePath;
+			return false;
+		}
+		result.dependencies.push_back(NormalizeShaderPath(filePath));
+		result.dependencies.insert(result.dependencies.end(), source.includes.begin(), source.includes.end());
+
+		const uint64_t cacheKey = ShaderBinaryCache::MakeKey(source.hash, defines, target, entryPoint, flags, compiler.GetVersion());
+
+		const uint8_t* cachedData = nullptr;
+		size_t cachedSize = 0;
+		if (cache.IsOpen() && cache.Find(cacheKey, cachedData, cachedSize))
+		{
+			result.byteCode.assign(cachedData, cachedData + cachedSize);
+			result.cacheHit = true;
+			return true;
+		}
+
+		ShaderCompileRequest request;
+		request.filePath = filePath;
+		request.source = defines + "\n" + source.text;
+		request.target = target;
+		request.entryPoint = entryPoint;
+		request.flags = flags;
+
+		std::string errors;
+		if (!compiler.Compile(request, result.byteCode, errors))
+		{
+			result.errors = "Shader compilation failed for: " + filePath + "\n" + errors;
+			return false;
+		}
+
+		cache.Store(cacheKey, result.byteCode.data(), result.byteCode.size());
+		return true;
+	}
+
+	const ShaderBinaryCache::FileEntry* ShaderBinaryCache::GetMappedEntries() const
+	{
+		return m_MappedData ? reinterpret_cast<const FileEntry*>(m_MappedData + sizeof(FileHeader)) : nullptr;
+	}
+
+	bool ShaderBinaryCache::MapFile()
+	{
+		if (!m_File.Open(m_Path) || m_File.GetSize() < sizeof(FileHeader))
+			return false;
+		m_MappedData = m_File.GetData();
+		const size_t mappedSize = m_File.GetSize();
+
+		// validate the table before anything reads through it
+		FileHeader header;
+		std::memcpy(&header, m_MappedData, sizeof(header));
+		if (header.magic != CacheMagic || header.version != CacheVersion ||
+			header.entryCount > (mappedSize - sizeof(FileHeader)) / sizeof(FileEntry))
+			return false;
+
+		const FileEntry* entries = reinterpret_cast<const FileEntry*>(m_MappedData + sizeof(FileHeader));
+		for (uint64_t i = 0; i < header.entryCount; ++i)
+		{
+			if (entries[i].offset > mappedSize || entries[i].size > mappedSize - entries[i].offset ||
+				(i > 0 && entries[i - 1].key >= entries[i].key))
+				return false;
+		}
+
+		m_MappedEntryCount = header.entryCount;
+		return true;
+	}
+
+	void ShaderBinaryCache::UnmapFile()
+	{
+		m_File.Close();
+		m_MappedData = nullptr;
+		m_MappedEntryCount = 0;
+	}
+}
@@ -0,0 +1,84 @@
+#pragma once
+#include "ShaderCompiler.h"
+#include "utils/MappedFile.h"
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace DXEngine {
+
+	// Content addressed store of compiled bytecode in one file: a header, a key sorted
+	// entry table and the blobs. The file is memory mapped on Open, lookups binary search
+	// the mapped table. New blobs are held in memory until Flush rewrites the file.
+	class ShaderBinaryCache
+	{
+	public:
+		ShaderBinaryCache() = default;
+		~ShaderBinaryCache();
+		ShaderBinaryCache(const ShaderBinaryCache&) = delete;
+		ShaderBinaryCache& operator=(const ShaderBinaryCache&) = delete;
+
+		// A missing or unreadable file opens as an empty cache
+		bool Open(const std::string& path);
+		void Close();   // flushes
+		bool IsOpen() const { return !m_Path.empty(); }
+
+		// data stays valid until the next Flush or Close
+		bool Find(uint64_t key, const uint8_t*& data, size_t& size) const;
+		void Store(uint64_t key, const uint8_t* data, size_t size);
+		bool Flush();
+
+		size_t GetEntryCount() const;
+
+		// Everything that changes the bytecode: source and includes, defines, target, entry point, flags, compiler
+		static uint64_t MakeKey(uint64_t sourceHash, const std::string& defines, const std::string& target,
+			const std::string& entryPoint, uint32_t flags, uint64_t compilerVersion);
+
+	private:
+		struct FileHeader
+		{
+			uint32_t magic;
+			uint32_t version;
+			uint64_t entryCount;
+		};
+
+		struct FileEntry
+		{
+			uint64_t key;
+			uint64_t offset;    // from the start of the file
+			uint64_t size;
+		};
+
+		bool MapFile();
+		void UnmapFile();
+		const FileEntry* GetMappedEntries() const;
+
+	private:
+		std::string m_Path;
+
+		// mapped view of the file on disk
+		MappedFile m_File;
+		const uint8_t* m_MappedData = nullptr;
+		uint64_t m_MappedEntryCount = 0;
+
+		// compiled since the last flush
+		std::unordered_map<uint64_t, std::vector<uint8_t>> m_Pending;
+		mutable std::mutex m_Mutex;
+	};
+
+	struct CachedCompileResult
+	{
+		std::vector<uint8_t> byteCode;
+		std::vector<std::string> dependencies;   // the file itself and everything it includes
+		std::string errors;
+		bool cacheHit = false;
+	};
+
+	// Loads the file, returns the cached bytecode when its key is present and otherwise
+	// compiles with defines prepended and stores the result. The cache may be closed.
+	bool CompileShaderCached(ShaderCompiler& compiler, ShaderBinaryCache& cache, const std::string& filePath,
+		const std::string& defines, const std::string& target, const std::string& entryPoint, uint32_t flags,
+		CachedCompileResult& result);
+}
@@ -0,0 +1,93 @@
+#include "dxpch.h"
+#include "ShaderCompiler.h"
+#include "utils/Hash.h"
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <unordered_set>
+
+namespace DXEngine {
+
+	namespace
+	{
+		bool ReadFileText(const std::filesystem::path& path, std::string& text)
+		{
+			std::ifstream file(path, std::ios::binary);
+			if (!file.is_open())
+				return false;
+
+			text.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+			return true;
+		}
+
+		// Quoted includes only, angle bracket includes are not resolved by the standard handler either
+		void ParseIncludes(const std::string& text, std::vector<std::string>& names)
+		{
+			size_t lineStart = 0;
+			while (lineStart < text.size())
+			{
+				size_t lineEnd = text.find('\n', lineStart);
+				if (lineEnd == std::string::npos)
+					lineEnd = text.size();
+
+				size_t pos = text.find_first_not_of(" \t", lineStart);
+				if (pos < lineEnd && text.compare(pos, 8, "#include") == 0)
+				{
+					const size_t open = text.find('"', pos + 8);
+					const size_t close = open < lineEnd ? text.find('"', open + 1) : std::string::npos;
+					if (close < lineEnd)
+					{
+						names.push_back(text.substr(open + 1, close - open - 1));
+					}
+				}
+				lineStart = lineEnd + 1;
+			}
+		}
+
+		void HashIncludes(const std::filesystem::path& filePath, const std::string& text, uint64_t& hash,
+			std::vector<std::string>& includes, std::unordered_set<std::string>& visited)
+		{
+			std::vector<std::string> names;
+			ParseIncludes(text, names);
+
+			for (const auto& name : names)
+			{
+				const std::filesystem::path includePath = filePath.parent_path() / name;
+				const std::string key = NormalizeShaderPath(includePath.string());
+				if (!visited.insert(key).second)
+					continue;
+
+				std::string includeText;
+				if (!ReadFileText(includePath, includeText))
+				{
+					// the compiler reports the missing file, keep the name in the key
+					hash = HashString(key, hash);
+					continue;
+				}
+
+				includes.push_back(key);
+				hash = HashString(key, hash);
+				hash = HashString(includeText, hash);
+				HashIncludes(includePath, includeText, hash, includes, visited);
+			}
+		}
+	}
+
+	bool LoadShaderSource(const std::string& filePath, ShaderSource& source)
+	{
+		source = ShaderSource{};
+		const std::filesystem::path path(filePath);
+		if (!ReadFileText(path, source.text))
+			return false;
+
+		std::unordered_set<std::string> visited{ NormalizeShaderPath(filePath) };
+		source.hash = HashString(source.text);
+		HashIncludes(path, source.text, source.hash, source.includes, visited);
+		return true;
+	}
+
+	std::string NormalizeShaderPath(const std::string& filePath)
+	{
+		return std::filesystem::path(filePath).lexically_normal().generic_string();
+	}
+}
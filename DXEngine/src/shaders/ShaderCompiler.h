@@ -0,0 +1,44 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace DXEngine {
+
+	struct ShaderCompileRequest
+	{
+		std::string filePath;        // error messages and #include resolution
+		std::string source;          // defines already prepended
+		std::string target;          // vs_5_0, ps_5_0, ...
+		std::string entryPoint = "main";
+		uint32_t flags = 0;          // D3DCOMPILE_* flags
+	};
+
+	// Turns HLSL into bytecode. Kept free of D3D types so the shader cache can run
+	// against a stub compiler. Compile is called from several worker threads at once.
+	class ShaderCompiler
+	{
+	public:
+		virtual ~ShaderCompiler() = default;
+
+		// On failure errors holds the compiler output
+		virtual bool Compile(const ShaderCompileRequest& request, std::vector<uint8_t>& byteCode, std::string& errors) = 0;
+
+		// Part of every cache key, changes when the same input could produce different code
+		virtual uint64_t GetVersion() const = 0;
+	};
+
+	// Source of a shader file plus a hash over it and everything it includes
+	struct ShaderSource
+	{
+		std::string text;
+		uint64_t hash = 0;
+		std::vector<std::string> includes;   // transitive, resolved paths
+	};
+
+	// Follows #include "..." relative to the including file, like D3D_COMPILE_STANDARD_FILE_INCLUDE
+	bool LoadShaderSource(const std::string& filePath, ShaderSource& source);
+
+	// The form paths take in ShaderSource::includes, comparable across spellings
+	std::string NormalizeShaderPath(const std::string& filePath);
+}
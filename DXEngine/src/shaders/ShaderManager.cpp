@@ -74,6 +74,12 @@ namespace DXEngine {
         }
     }
 
+    void ShaderManager::SetFeaturePolicy(ShaderFeaturePolicy policy) {
+        if (m_VariantManager) {
+            m_VariantManager->SetFeaturePolicy(policy);
+        }
+    }
+
     void ShaderManager::ClearShaderCache() {
         if (m_VariantManager) {
             m_VariantManager->ClearCache();
@@ -33,6 +33,7 @@ namespace DXEngine {
 		void EnableHotReload(bool enable);
 		void EnableDynamicVariants(bool enable) { m_DynamicVariantsEnabled = enable; }
 		bool IsDynamicVariantsEnabled() const { return m_DynamicVariantsEnabled; }
+		void SetFeaturePolicy(ShaderFeaturePolicy policy);
 
 		// Cache management
 		void ClearShaderCache();
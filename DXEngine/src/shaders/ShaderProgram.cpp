@@ -1,17 +1,27 @@
 #include "dxpch.h"
 #include "ShaderProgram.h"
+#include "utils/Hash.h"
+#include <atomic>
 namespace DXEngine {
 
+	uint32_t ShaderProgram::GenerateID()
+	{
+		static std::atomic<uint32_t> s_NextID{ 1 };
+		return s_NextID.fetch_add(1, std::memory_order_relaxed);
+	}
+
 	ShaderProgram::ShaderProgram( LPCWSTR vertexShader, LPCWSTR pixelShader)
 
 	{
 		m_VertexShader = std::make_shared<VertexShader>(vertexShader);
 		m_PixelShader = std::make_shared<PixelShader>(pixelShader);
+		ComputeProgramID();
 	}
 
 	ShaderProgram::ShaderProgram(std::shared_ptr<VertexShader> vs, std::shared_ptr<PixelShader> ps)
 		: m_VertexShader(vs), m_PixelShader(ps)
 	{
+		ComputeProgramID();
 	}
 
 	ShaderProgram::ShaderProgram(Microsoft::WRL::ComPtr<ID3DBlob> vsBlob, Microsoft::WRL::ComPtr<ID3DBlob> psBlob)
@@ -22,6 +32,14 @@ namespace DXEngine {
 		if (psBlob) {
 			m_PixelShader = std::make_shared<PixelShader>(psBlob.Get());
 		}
+		ComputeProgramID();
+	}
+
+	void ShaderProgram::ComputeProgramID()
+	{
+		const uint64_t vsID = m_VertexShader ? m_VertexShader->GetByteCodeID() : 0;
+		const uint64_t psID = m_PixelShader ? m_PixelShader->GetByteCodeID() : 0;
+		m_ProgramID = HashCombine(vsID, psID);
 	}
 
 	ShaderProgram::~ShaderProgram()
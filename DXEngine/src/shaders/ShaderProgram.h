@@ -18,9 +18,23 @@ namespace DXEngine {
 		~ShaderProgram();
 
 		ID3DBlob* GetByteCode();
+		//stable identifier used for draw sorting
+		uint32_t GetID() const { return m_ID; }
+		//hash of both stages' bytecode, programs compiled from the same code share it
+		uint64_t GetProgramID() const { return m_ProgramID; }
+		uint64_t GetVertexShaderID() const { return m_VertexShader ? m_VertexShader->GetByteCodeID() : 0; }
+
+		VertexShader* GetVertexShader() const { return m_VertexShader.get(); }
+		PixelShader* GetPixelShader() const { return m_PixelShader.get(); }
 
 		void Bind();
 	private:
+		static uint32_t GenerateID();
+		void ComputeProgramID();
+
+	private:
+		uint32_t m_ID = GenerateID();
+		uint64_t m_ProgramID = 0;
 		std::shared_ptr<VertexShader> m_VertexShader;
 		std::shared_ptr <PixelShader> m_PixelShader;;
 	};
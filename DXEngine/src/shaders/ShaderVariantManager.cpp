@@ -3,6 +3,11 @@
 #include "utils/material/Material.h"
 #include "utils/VertexShader.h"
 #include "utils/PixelShader.h"
+#include "D3DShaderCompiler.h"
+#include "utils/WorkerPool.h"
+#include "renderer/PipelineStateCache.h"
+#include <bit>
+#include <cstring>
 #include <filesystem>
 #include <fstream>
 #include <sstream>
@@ -10,6 +15,35 @@
 
 namespace DXEngine
 {
+	namespace
+	{
+		// features that branch on a material flag under ShaderFeaturePolicy::RuntimeBranches
+		struct RuntimeFeature
+		{
+			ShaderFeature feature;
+			uint32_t materialFlag;
+		};
+
+		constexpr RuntimeFeature RuntimeFeatures[] = {
+			{ ShaderFeature::HasDiffuseTexture, MaterialFlags::HasDiffuseTexture },
+			{ ShaderFeature::HasNormalMap, MaterialFlags::HasNormalMap },
+			{ ShaderFeature::HasSpecularMap, MaterialFlags::HasSpecularMap },
+			{ ShaderFeature::HasEmissiveMap, MaterialFlags::HasEmissiveMap },
+			{ ShaderFeature::HasRoughnessMap, MaterialFlags::HasRoughnessMap },
+			{ ShaderFeature::HasMetallicMap, MaterialFlags::HasMetallicMap },
+			{ ShaderFeature::HasAOMap, MaterialFlags::HasAOMap },
+			{ ShaderFeature::HasOpacityMap, MaterialFlags::HasOpacityMap },
+			{ ShaderFeature::EnableAlphaTest, MaterialFlags::IsTransparent },
+		};
+
+		constexpr uint32_t GetRuntimeFeatureMask()
+		{
+			uint32_t mask = 0;
+			for (const auto& runtime : RuntimeFeatures)
+				mask |= 1u << static_cast<uint32_t>(runtime.feature);
+			return mask;
+		}
+	}
 
 	bool ShaderVariantManager::Initialize(const ShaderVariantConfig& config)
 	{
@@ -27,6 +61,29 @@ namespace DXEngine
 			return false;
 		}
 
+		if (!m_Config.archivePath.empty() && std::filesystem::exists(m_Config.archivePath) &&
+			m_Archive.Open(m_Config.archivePath)) {
+			LogInfo("Shader archive: " + m_Config.archivePath + " (" + std::to_string(m_Archive.GetEntryCount()) + " variants)");
+		}
+		else if (!m_Config.allowRuntimeCompilation) {
+			LogError("Runtime compilation is disabled and no shader archive was loaded from " + m_Config.archivePath);
+		}
+
+		if (!m_Compiler) {
+			m_Compiler = std::make_unique<D3DShaderCompiler>();
+		}
+		if (m_Config.enableDiskCache && m_Config.allowRuntimeCompilation) {
+			m_DiskCache.Open(m_Config.diskCachePath);
+			LogInfo("Shader disk cache: " + m_Config.diskCachePath + " (" + std::to_string(m_DiskCache.GetEntryCount()) + " entries)");
+		}
+		if (m_Config.asyncCompilation && m_Config.allowRuntimeCompilation) {
+			const uint32_t threadCount = m_Config.compileThreadCount > 0 ?
+				m_Config.compileThreadCount : WorkerPool::GetDefaultWorkerCount();
+			if (threadCount > 0) {
+				m_CompileQueue = std::make_unique<TaskQueue>(threadCount);
+			}
+		}
+
 		// Setup common vertex layouts for precompilation
 		m_CommonLayouts = {
 			VertexLayout::CreateBasic(),    // Position, Normal, TexCoord
@@ -39,9 +96,21 @@ namespace DXEngine
 		if (m_Config.precompileCommonVariants)
 		{
 			PrecompileCommonVariants();
+			m_DiskCache.Flush();
+		}
+
+		// pending variants draw with these, build one per material type now rather than
+		// compiling it on the render thread at the first miss
+		if (m_CompileQueue) {
+			for (int type = static_cast<int>(MaterialType::Unlit); type <= static_cast<int>(MaterialType::Glass); ++type) {
+				GetFallbackShader(static_cast<MaterialType>(type));
+			}
 		}
 
 		m_Initialized = true;
+		if (m_Config.enableHotReload) {
+			StartFileWatcher();
+		}
 		LogInfo("ShaderVariantManager initialized successfully");
 		return true;
 	}
@@ -49,12 +118,33 @@ namespace DXEngine
 	{
 		if (!m_Initialized) return;
 
+		// queued compiles are dropped, running ones finish before the cache closes
+		StopFileWatcher();
+		m_CompileQueue.reset();
+
+		if (!m_Config.variantManifestPath.empty()) {
+			SaveVariantManifest(m_Config.variantManifestPath);
+		}
+
 		std::lock_guard<std::mutex> lock(m_CacheMutex);
 
 		m_VariantCache.clear();
 		m_VariantUsage.clear();
-		m_FileTimestamps.clear();
-		m_TrackedFiles.clear();
+		m_FileDependents.clear();
+		{
+			std::lock_guard<std::mutex> watchLock(m_WatchMutex);
+			m_FileTimestamps.clear();
+			m_TrackedFiles.clear();
+			m_ChangedFiles.clear();
+		}
+		{
+			std::lock_guard<std::mutex> completedLock(m_CompletedMutex);
+			m_CompletedVariants.clear();
+		}
+		BumpGeneration();
+		DropPendingCompiles();
+		m_DiskCache.Close();
+		m_Archive.Close();
 
 		m_Initialized = false;
 		LogInfo("ShaderVariantManager shutdown complete");
@@ -65,9 +155,16 @@ namespace DXEngine
 		if (!m_Initialized)return;
 		m_CurrentFrame++;
 
-		//check for hot realod periodicaly(every 60 frames)
-		if (m_Config.enableHotReload && (m_CurrentFrame % 60 == 0)) {
-			CheckForFileChanges();
+		ApplyCompletedVariants();
+
+		// files the watcher saw change since last frame
+		std::vector<std::string> changedFiles;
+		{
+			std::lock_guard<std::mutex> lock(m_WatchMutex);
+			changedFiles.swap(m_ChangedFiles);
+		}
+		for (const auto& file : changedFiles) {
+			ReloadShader(file);
 		}
 	}
 	std::shared_ptr<ShaderProgram> ShaderVariantManager::GetShaderVariant(const VertexLayout& layout, const Material* material, MaterialType materialType)
@@ -78,48 +175,257 @@ namespace DXEngine
 			return nullptr;
 		}
 
-		// Generate variant key
+		// the material's own cache only holds variants of its current type
+		const bool cacheOnMaterial = material && material->GetType() == materialType;
+		const uint32_t generation = GetGeneration();
+		if (cacheOnMaterial)
+		{
+			if (auto cached = material->FindCachedShader(layout.GetID(), generation))
+			{
+				return cached;
+			}
+		}
+
+		bool exact = false;
+		auto shader = ResolveVariant(MakeVariantKey(layout, material, materialType), exact);
+		if (shader && exact && cacheOnMaterial)
+		{
+			material->CacheShader(layout.GetID(), generation, shader);
+		}
+		return shader;
+	}
+
+	ShaderVariantKey ShaderVariantManager::MakeVariantKey(const VertexLayout& layout, const Material* material, MaterialType materialType)
+	{
 		ShaderVariantKey key;
 		key.materialType = materialType;
-		key.vertexLayoutHash = GenerateVertexLayoutHash(layout);
-		key.actualLayout = layout;//store layout for processing
+		key.layoutID = layout.GetID();
 		// Analyze features
 		ShaderFeatureFlags layoutFeatures = AnalyzeVertexLayout(layout);
 		ShaderFeatureFlags materialFeatures = AnalyzeMaterial(material);
-		key.features = CombineFeatures(layoutFeatures, materialFeatures, materialType);
-
-		return GetShaderVariant(key);
+		if (m_Config.featurePolicy == ShaderFeaturePolicy::RuntimeBranches) {
+			// bits the material type forces (transparent alpha test) stay compile time
+			materialFeatures &= ShaderFeatureFlags(~GetRuntimeFeatureMask());
+			materialFeatures.set(static_cast<size_t>(ShaderFeature::RuntimeMaterialFlags));
+		}
+		key.features = static_cast<uint32_t>(CombineFeatures(layoutFeatures, materialFeatures, materialType).to_ulong());
+		return key;
 	}
 	std::shared_ptr<ShaderProgram> ShaderVariantManager::GetShaderVariant(const ShaderVariantKey& key)
 	{
+		bool exact = false;
+		return ResolveVariant(key, exact);
+	}
+
+	std::shared_ptr<ShaderProgram> ShaderVariantManager::ResolveVariant(const ShaderVariantKey& key, bool& exact)
+	{
+		exact = false;
+		bool compileAsync = false;
+		{
+			std::lock_guard<std::mutex> lock(m_CacheMutex);
+
+			// Check cache first
+			auto it = m_VariantCache.find(key);
+			if (it != m_VariantCache.end()) {
+				m_Stats.cacheHits++;
+				m_VariantUsage[key] = m_CurrentFrame; // Update usage
+				exact = true;
+				return it->second;
+			}
+
+			// failed once, the caller falls back until a reload clears it
+			if (m_FailedVariants.count(key)) {
+				return nullptr;
+			}
+
+			// archived variants only need their shader objects created, no point queueing them
+			ShaderArchiveBlobs blobs;
+			const bool archived = m_Archive.IsOpen() &&
+				m_Archive.Find({ key.layoutID, static_cast<uint32_t>(key.materialType), key.features }, blobs) &&
+				IsArchivedCodeCurrent(key.materialType, blobs);
+			compileAsync = m_CompileQueue && !archived;
+
+			if (compileAsync) {
+				auto pending = m_PendingVariants.find(key);
+				if (pending == m_PendingVariants.end()) {
+					m_Stats.cacheMisses++;
+					SubmitVariant(key);
+					pending = m_PendingVariants.find(key);
+				}
+				m_Stats.substitutions++;
+				if (pending->second) {
+					return pending->second;
+				}
+			}
+			else {
+				m_Stats.cacheMisses++;
+			}
+		}
+
+		if (compileAsync) {
+			return GetFallbackShader(key.materialType);
+		}
+
+		// archived or no workers, build on the calling thread
+		VariantBuildResult result;
+		result.key = key;
+		result.epoch = m_CompileEpoch;
+		BuildShaderVariant(result);
+
 		std::lock_guard<std::mutex> lock(m_CacheMutex);
+		ApplyBuildResult(result);
+		exact = result.program != nullptr;
+		return result.program;
+	}
 
-		// Check cache first
-		auto it = m_VariantCache.find(key);
-		if (it != m_VariantCache.end()) {
-			m_Stats.cacheHits++;
-			m_VariantUsage[key] = m_CurrentFrame; // Update usage
-			return it->second;
+	bool ShaderVariantManager::IsVariantPending(const ShaderVariantKey& key) const
+	{
+		std::lock_guard<std::mutex> lock(m_CacheMutex);
+		return m_PendingVariants.count(key) > 0;
+	}
+
+	void ShaderVariantManager::WaitForPendingVariants()
+	{
+		if (m_CompileQueue) {
+			m_CompileQueue->WaitIdle();
+		}
+		ApplyCompletedVariants();
+	}
+
+	std::shared_ptr<ShaderProgram> ShaderVariantManager::FindSubstituteVariant(const ShaderVariantKey& key) const
+	{
+		// same type and layout, every requested feature present, fewest extra ones
+		std::shared_ptr<ShaderProgram> best;
+		int bestExtra = 0;
+		for (const auto& [candidate, program] : m_VariantCache) {
+			if (candidate.materialType != key.materialType || candidate.layoutID != key.layoutID ||
+				(candidate.features & key.features) != key.features) {
+				continue;
+			}
+
+			const int extra = std::popcount(candidate.features & ~key.features);
+			if (!best || extra < bestExtra) {
+				best = program;
+				bestExtra = extra;
+			}
+		}
+		return best;
+	}
+
+	void ShaderVariantManager::SubmitVariant(const ShaderVariantKey& key)
+	{
+		m_PendingVariants.emplace(key, FindSubstituteVariant(key));
+		SubmitBuild(key, 0);
+	}
+
+	void ShaderVariantManager::SubmitBuild(const ShaderVariantKey& key, uint32_t rebuildSerial)
+	{
+		const uint32_t epoch = m_CompileEpoch;
+		m_CompileQueue->Submit([this, key, epoch, rebuildSerial]() {
+			VariantBuildResult result;
+			result.key = key;
+			result.epoch = epoch;
+			result.rebuildSerial = rebuildSerial;
+			BuildShaderVariant(result);
+
+			std::lock_guard<std::mutex> lock(m_CompletedMutex);
+			m_CompletedVariants.push_back(std::move(result));
+		});
+	}
+
+	void ShaderVariantManager::ApplyCompletedVariants()
+	{
+		std::vector<VariantBuildResult> completed;
+		{
+			std::lock_guard<std::mutex> lock(m_CompletedMutex);
+			completed.swap(m_CompletedVariants);
+		}
+
+		std::lock_guard<std::mutex> lock(m_CacheMutex);
+		for (const auto& result : completed) {
+			ApplyBuildResult(result);
+		}
+		m_Stats.pendingCompiles = m_PendingVariants.size();
+	}
+
+	void ShaderVariantManager::ApplyBuildResult(const VariantBuildResult& result)
+	{
+		RecordBuild(result);
+
+		// the cache was dropped while this compiled, a newer request is already queued
+		if (result.epoch != m_CompileEpoch) {
+			return;
+		}
+
+		if (result.rebuildSerial != 0) {
+			// only the latest edit's rebuild may land, the previous variant draws until then
+			auto serial = m_RebuildSerials.find(result.key);
+			if (serial == m_RebuildSerials.end() || serial->second != result.rebuildSerial) {
+				return;
+			}
+			m_RebuildSerials.erase(serial);
+
+			auto cached = m_VariantCache.find(result.key);
+			if (!result.program) {
+				m_Stats.compilationFailures++;
+				LogError("Hot reload failed, keeping the previous variant: " + result.key.ToString());
+			}
+			else if (cached != m_VariantCache.end()) {
+				// pipelines of the old program would otherwise hold its shaders forever
+				if (cached->second && cached->second->GetProgramID() != result.program->GetProgramID()) {
+					PipelineStateCache::Instance().EvictProgram(cached->second->GetProgramID());
+				}
+				cached->second = result.program;
+				m_Stats.hotReloads++;
+				BumpGeneration();
+			}
+			return;
 		}
+		m_PendingVariants.erase(result.key);
 
-		m_Stats.cacheMisses++;
+		if (!result.program) {
+			m_FailedVariants.insert(result.key);
+			m_Stats.compilationFailures++;
+			LogError("Failed to create shader variant: " + result.key.ToString());
+			return;
+		}
 
-		auto variantLayout = CreateShaderVariant(key);
-		if (variantLayout) {
-			m_VariantCache[key] = variantLayout;
-			m_VariantUsage[key] = m_CurrentFrame;
+		if (m_VariantCache.try_emplace(result.key, result.program).second) {
+			m_VariantUsage[result.key] = m_CurrentFrame;
 			m_Stats.totalVariants++;
 
 #ifdef DX_DEBUG
-			LogInfo("Created shader variant: " + key.ToString());
+			LogInfo("Created shader variant: " + result.key.ToString());
 #endif
 		}
-		else {
-			m_Stats.compilationFailures++;
-			LogError("Failed to create shader variant: " + key.ToString());
+	}
+
+	void ShaderVariantManager::RecordBuild(const VariantBuildResult& result)
+	{
+		m_Stats.archiveHits += result.fromArchive ? 1 : 0;
+		m_Stats.diskCacheHits += result.diskCacheHits;
+		m_Stats.diskCacheMisses += result.diskCacheMisses;
+
+		// every file the variant was built from, watched whether or not hot reload is on yet
+		if (result.program) {
+			for (const auto& file : result.dependencies) {
+				m_FileDependents[file].insert(result.key);
+				TrackFile(file);
+			}
 		}
+	}
 
-		return variantLayout;
+	void ShaderVariantManager::BumpGeneration()
+	{
+		m_Generation.fetch_add(1, std::memory_order_acq_rel);
+	}
+
+	void ShaderVariantManager::DropPendingCompiles()
+	{
+		m_CompileEpoch++;
+		m_PendingVariants.clear();
+		m_FailedVariants.clear();
+		m_RebuildSerials.clear();
 	}
 
 	void ShaderVariantManager::PrecompileCommonVariants()
@@ -133,7 +439,7 @@ namespace DXEngine
 			MaterialType::Transparent,
 			MaterialType::UI
 		};
-		size_t variantsCompiled = 0;
+		std::vector<VariantBuildResult> results;
 
 		for (auto& layout : m_CommonLayouts) {
 			layout.Finalize(); // Ensure finalized
@@ -144,28 +450,56 @@ namespace DXEngine
 					continue;
 				}
 
-				ShaderVariantKey key;
-				key.materialType = materialType;
-				key.vertexLayoutHash = GenerateVertexLayoutHash(layout);
-				key.actualLayout = layout; // ADD THIS
-				key.features = CombineFeatures(
-					AnalyzeVertexLayout(layout),
-					ShaderFeatureFlags{},
-					materialType
-				);
-
-				// Now pass the layout from the key
-				if (CreateShaderVariant(key)) {
-					variantsCompiled++;
-				}
+				VariantBuildResult& result = results.emplace_back();
+				result.key = MakeVariantKey(layout, nullptr, materialType);
+				result.epoch = m_CompileEpoch;
+			}
+		}
+
+		// fan out over the compile workers, the results are independent
+		if (m_CompileQueue) {
+			for (auto& result : results) {
+				m_CompileQueue->Submit([this, &result]() { BuildShaderVariant(result); });
+			}
+			m_CompileQueue->WaitIdle();
+		}
+		else {
+			for (auto& result : results) {
+				BuildShaderVariant(result);
+			}
+		}
+
+		size_t variantsCompiled = 0;
+		std::lock_guard<std::mutex> lock(m_CacheMutex);
+		for (const auto& result : results) {
+			ApplyBuildResult(result);
+			if (result.program) {
+				variantsCompiled++;
 			}
 		}
 
 		LogInfo("Precompiled " + std::to_string(variantsCompiled) + " shader variants");
 	}
 
-	std::shared_ptr<ShaderProgram> ShaderVariantManager::CreateShaderVariant(const ShaderVariantKey& key)
+	void ShaderVariantManager::BuildShaderVariant(VariantBuildResult& result)
 	{
+		const ShaderVariantKey& key = result.key;
+
+		// rebuilds after an edit always come from source
+		if (result.rebuildSerial == 0 && LoadFromArchive(result)) {
+			if (m_Config.allowRuntimeCompilation) {
+				// still hot reloadable, record what the archived code was built from
+				auto [vsPath, psPath] = GetShaderPaths(key.materialType);
+				CollectDependencies(vsPath, result);
+				CollectDependencies(psPath, result);
+			}
+			return;
+		}
+		if (!m_Config.allowRuntimeCompilation) {
+			LogError("Shader variant missing from archive: " + key.ToString());
+			return;
+		}
+
 		// Get shader file paths
 		auto [vsPath, psPath] = GetShaderPaths(key.materialType);
 
@@ -178,54 +512,226 @@ namespace DXEngine
 
 			if (!std::filesystem::exists(vsPath) || !std::filesystem::exists(psPath)) {
 				LogError("Fallback shader files not found");
-				return nullptr;
+				return;
 			}
 		}
+		result.vsPath = vsPath;
+		result.psPath = psPath;
 
 		// Generate defines string
-		std::string defines = GenerateDefinesString(key.features,key.actualLayout);
+		std::string defines = GenerateDefinesString(key.GetFeatures());
 
 		// Compile shaders
-		auto vsBlob = CompileShader(vsPath, defines, "vs_5_0", "main");
-		auto psBlob = CompileShader(psPath, defines, "ps_5_0", "main");
+		result.vsBlob = CompileShader(vsPath, defines, "vs_5_0", "main", result);
+		result.psBlob = CompileShader(psPath, defines, "ps_5_0", "main", result);
 
-		if (!vsBlob || !psBlob) {
-			return nullptr;
+		if (!result.vsBlob || !result.psBlob) {
+			return;
 		}
 
 		try {
-			// Create shader objects
-			auto program = std::make_shared<ShaderProgram>(vsBlob, psBlob);
+			// Create shader objects, the device is free threaded
+			result.program = std::make_shared<ShaderProgram>(result.vsBlob, result.psBlob);
+		}
+		catch (const std::exception& e) {
+			LogError("Failed to create shader program: " + std::string(e.what()));
+		}
+	}
 
-			// Track files for hot reload
-			if (m_Config.enableHotReload) {
-				UpdateFileTimestamp(vsPath);
-				UpdateFileTimestamp(psPath);
-			}
+	bool ShaderVariantManager::LoadFromArchive(VariantBuildResult& result)
+	{
+		const ShaderVariantKey& key = result.key;
+		ShaderArchiveBlobs blobs;
+		if (!m_Archive.IsOpen() ||
+			!m_Archive.Find({ key.layoutID, static_cast<uint32_t>(key.materialType), key.features }, blobs)) {
+			return false;
+		}
+		if (!IsArchivedCodeCurrent(key.materialType, blobs)) {
+			LogInfo("Archived variant is older than its shader files, compiling: " + key.ToString());
+			return false;
+		}
+
+		result.vsBlob = CreateBlob(blobs.vertexShader, blobs.vertexShaderSize);
+		result.psBlob = CreateBlob(blobs.pixelShader, blobs.pixelShaderSize);
+		if (!result.vsBlob || !result.psBlob) {
+			return false;
+		}
 
-			return program;
+		try {
+			result.program = std::make_shared<ShaderProgram>(result.vsBlob, result.psBlob);
+			result.fromArchive = true;
 		}
 		catch (const std::exception& e) {
-			LogError("Failed to create shader program: " + std::string(e.what()));
-			return nullptr;
+			LogError("Failed to create archived shader program: " + std::string(e.what()));
+			return false;
 		}
+		return true;
 	}
 
-	Microsoft::WRL::ComPtr<ID3DBlob> ShaderVariantManager::CompileShader(const std::string& filePath, const std::string& defines, const std::string& target, const std::string& entryPoint)
+	bool ShaderVariantManager::IsArchivedCodeCurrent(MaterialType materialType, const ShaderArchiveBlobs& blobs)
 	{
-		// Read shader file
-		std::ifstream file(filePath);
-		if (!file.is_open()) {
-			LogError("Failed to open shader file: " + filePath);
-			return nullptr;
+		// without runtime compilation the archive is all there is, the sources may not even ship
+		if (!m_Config.allowRuntimeCompilation) {
+			return true;
+		}
+		return blobs.sourceHash != 0 && blobs.sourceHash == GetSourceHash(materialType);
+	}
+
+	uint64_t ShaderVariantManager::GetSourceHash(MaterialType materialType)
+	{
+		std::lock_guard<std::mutex> lock(m_SourceHashMutex);
+		auto it = m_SourceHashes.find(materialType);
+		if (it != m_SourceHashes.end()) {
+			return it->second;
+		}
+
+		// the files BuildShaderVariant compiles, the fallback pair when the type has none
+		auto [vsPath, psPath] = GetShaderPaths(materialType);
+		if (!std::filesystem::exists(vsPath) || !std::filesystem::exists(psPath)) {
+			vsPath = m_Config.shaderBasePath + m_Config.fallbackVertexShader;
+			psPath = m_Config.shaderBasePath + m_Config.fallbackPixelShader;
+		}
+
+		// 0 when unreadable, no archive entry matches it
+		uint64_t hash = 0;
+		ShaderSource vsSource;
+		ShaderSource psSource;
+		if (LoadShaderSource(vsPath, vsSource) && LoadShaderSource(psPath, psSource)) {
+			hash = HashCombine(vsSource.hash, psSource.hash);
+		}
+		m_SourceHashes[materialType] = hash;
+		return hash;
+	}
+
+	void ShaderVariantManager::CollectDependencies(const std::string& filePath, VariantBuildResult& result)
+	{
+		ShaderSource source;
+		if (LoadShaderSource(filePath, source)) {
+			result.dependencies.push_back(NormalizeShaderPath(filePath));
+			result.dependencies.insert(result.dependencies.end(), source.includes.begin(), source.includes.end());
+		}
+	}
+
+	bool ShaderVariantManager::BuildShaderArchive(const std::string& path, const std::vector<ShaderVariantKey>& keys)
+	{
+		if (!m_Config.allowRuntimeCompilation) {
+			LogError("Cannot build a shader archive with runtime compilation disabled");
+			return false;
+		}
+
+		// everything is rebuilt from source, nothing may come from the archive being replaced
+		m_Archive.Close();
+		{
+			std::lock_guard<std::mutex> lock(m_SourceHashMutex);
+			m_SourceHashes.clear();
 		}
 
-		std::string source((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
-		file.close();
+		std::unordered_set<ShaderVariantKey, ShaderVariantKeyHash> uniqueKeys(keys.begin(), keys.end());
+		{
+			std::lock_guard<std::mutex> lock(m_CacheMutex);
+			for (const auto& [key, program] : m_VariantCache) {
+				uniqueKeys.insert(key);
+			}
+		}
+		// Initialize prebuilds the fallback of every material type
+		for (int type = static_cast<int>(MaterialType::Unlit); type <= static_cast<int>(MaterialType::Glass); ++type) {
+			uniqueKeys.insert(MakeFallbackKey(static_cast<MaterialType>(type)));
+		}
+
+		std::vector<VariantBuildResult> results(uniqueKeys.size());
+		size_t index = 0;
+		for (const auto& key : uniqueKeys) {
+			results[index++].key = key;
+		}
 
-		// Prepend defines
-		std::string finalSource = defines + "\n" + source;
+		if (m_CompileQueue) {
+			for (auto& result : results) {
+				m_CompileQueue->Submit([this, &result]() { BuildShaderVariant(result); });
+			}
+			m_CompileQueue->WaitIdle();
+		}
+		else {
+			for (auto& result : results) {
+				BuildShaderVariant(result);
+			}
+		}
 
+		std::vector<ShaderArchiveEntry> entries;
+		entries.reserve(results.size());
+		for (const auto& result : results) {
+			if (!result.vsBlob || !result.psBlob) {
+				LogError("Skipping variant that failed to compile: " + result.key.ToString());
+				continue;
+			}
+
+			ShaderArchiveEntry& entry = entries.emplace_back();
+			entry.key = { result.key.layoutID, static_cast<uint32_t>(result.key.materialType), result.key.features };
+			entry.sourceHash = GetSourceHash(result.key.materialType);
+			const auto* vs = static_cast<const uint8_t*>(result.vsBlob->GetBufferPointer());
+			const auto* ps = static_cast<const uint8_t*>(result.psBlob->GetBufferPointer());
+			entry.vertexShader.assign(vs, vs + result.vsBlob->GetBufferSize());
+			entry.pixelShader.assign(ps, ps + result.psBlob->GetBufferSize());
+		}
+
+		const size_t entryCount = entries.size();
+		if (!ShaderArchive::Write(path, std::move(entries))) {
+			LogError("Failed to write shader archive: " + path);
+			return false;
+		}
+
+		LogInfo("Wrote " + std::to_string(entryCount) + " of " + std::to_string(results.size()) + " variants to " + path);
+		return entryCount == results.size();
+	}
+
+	bool ShaderVariantManager::SaveVariantManifest(const std::string& path) const
+	{
+		std::vector<ShaderVariantKey> keys;
+		LoadVariantManifest(path, keys);
+
+		std::unordered_set<ShaderVariantKey, ShaderVariantKeyHash> uniqueKeys(keys.begin(), keys.end());
+		{
+			std::lock_guard<std::mutex> lock(m_CacheMutex);
+			for (const auto& [key, program] : m_VariantCache) {
+				if (uniqueKeys.insert(key).second) {
+					keys.push_back(key);
+				}
+			}
+		}
+
+		std::error_code ec;
+		const std::filesystem::path filePath(path);
+		if (filePath.has_parent_path()) {
+			std::filesystem::create_directories(filePath.parent_path(), ec);
+		}
+
+		std::ofstream file(filePath, std::ios::trunc);
+		if (!file) {
+			return false;
+		}
+		for (const auto& key : keys) {
+			file << static_cast<uint32_t>(key.materialType) << ' ' << key.features << ' ' << key.layoutID << '\n';
+		}
+		return static_cast<bool>(file);
+	}
+
+	bool ShaderVariantManager::LoadVariantManifest(const std::string& path, std::vector<ShaderVariantKey>& keys)
+	{
+		std::ifstream file(path);
+		if (!file) {
+			return false;
+		}
+
+		uint32_t materialType = 0;
+		ShaderVariantKey key;
+		while (file >> materialType >> key.features >> key.layoutID) {
+			key.materialType = static_cast<MaterialType>(materialType);
+			keys.push_back(key);
+		}
+		return true;
+	}
+
+	Microsoft::WRL::ComPtr<ID3DBlob> ShaderVariantManager::CompileShader(const std::string& filePath, const std::string& defines, const std::string& target, const std::string& entryPoint, VariantBuildResult& result)
+	{
 		// Setup compilation flags
 		DWORD shaderFlags = D3DCOMPILE_ENABLE_STRICTNESS;
 
@@ -237,43 +743,68 @@ namespace DXEngine
 			shaderFlags |= D3DCOMPILE_OPTIMIZATION_LEVEL3;
 		}
 
-		Microsoft::WRL::ComPtr<ID3DBlob> shaderBlob;
-		Microsoft::WRL::ComPtr<ID3DBlob> errorBlob;
-
-		HRESULT hr = D3DCompile(
-			finalSource.c_str(),
-			finalSource.size(),
-			filePath.c_str(),
-			nullptr, // Additional defines
-			D3D_COMPILE_STANDARD_FILE_INCLUDE,
-			entryPoint.c_str(),
-			target.c_str(),
-			shaderFlags,
-			0,
-			&shaderBlob,
-			&errorBlob
-		);
-
-		if (FAILED(hr)) {
-			std::string error = "Shader compilation failed for: " + filePath + "\n";
-			if (errorBlob) {
-				error += static_cast<const char*>(errorBlob->GetBufferPointer());
-			}
-			LogError(error);
+		CachedCompileResult compiled;
+		const bool success = CompileShaderCached(*m_Compiler, m_DiskCache, filePath, defines, target, entryPoint,
+			static_cast<uint32_t>(shaderFlags), compiled);
+
+		result.dependencies.insert(result.dependencies.end(), compiled.dependencies.begin(), compiled.dependencies.end());
+		if (!compiled.dependencies.empty()) {
+			(compiled.cacheHit ? result.diskCacheHits : result.diskCacheMisses)++;
+		}
+
+		if (!success) {
+			LogError(compiled.errors);
 			return nullptr;
 		}
+		return CreateBlob(compiled.byteCode.data(), compiled.byteCode.size());
+	}
 
-		return shaderBlob;
+	Microsoft::WRL::ComPtr<ID3DBlob> ShaderVariantManager::CreateBlob(const uint8_t* data, size_t size)
+	{
+		Microsoft::WRL::ComPtr<ID3DBlob> blob;
+		if (FAILED(D3DCreateBlob(size, blob.GetAddressOf()))) {
+			LogError("Failed to allocate shader blob");
+			return nullptr;
+		}
+		std::memcpy(blob->GetBufferPointer(), data, size);
+		return blob;
 	}
 	void ShaderVariantManager::PrecompileVariant(const ShaderVariantKey& key)
 	{
+		{
+			std::lock_guard<std::mutex> lock(m_CacheMutex);
+			if (m_VariantCache.count(key) || m_PendingVariants.count(key) || m_FailedVariants.count(key)) {
+				return;
+			}
+			if (m_CompileQueue) {
+				SubmitVariant(key);
+				return;
+			}
+		}
+
+		VariantBuildResult result;
+		result.key = key;
+		result.epoch = m_CompileEpoch;
+		BuildShaderVariant(result);
+
+		std::lock_guard<std::mutex> lock(m_CacheMutex);
+		ApplyBuildResult(result);
 	}
 	void ShaderVariantManager::ClearCache()
 	{
 		std::lock_guard<std::mutex> lock(m_CacheMutex);
+		// like pruning, the pipelines built from these programs would keep their shaders alive
+		for (const auto& [key, program] : m_VariantCache) {
+			if (program) {
+				PipelineStateCache::Instance().EvictProgram(program->GetProgramID());
+			}
+		}
 		m_VariantCache.clear();
 		m_VariantUsage.clear();
+		m_FileDependents.clear();
 		m_Stats.totalVariants = 0;
+		BumpGeneration();
+		DropPendingCompiles();
 		LogInfo("Shader variant cache cleared");
 	}
 	void ShaderVariantManager::PruneLeastUsedVariants(size_t maxVariants)
@@ -298,57 +829,116 @@ namespace DXEngine
 		size_t toRemove = m_VariantCache.size() - maxVariants;
 		for (size_t i = 0; i < toRemove && i < usageVector.size(); ++i) {
 			const auto& key = usageVector[i].first;
+			auto cached = m_VariantCache.find(key);
+			if (cached != m_VariantCache.end() && cached->second) {
+				PipelineStateCache::Instance().EvictProgram(cached->second->GetProgramID());
+			}
 			m_VariantCache.erase(key);
 			m_VariantUsage.erase(key);
 			m_Stats.totalVariants--;
 		}
+		BumpGeneration();
 
 		LogInfo("Pruned " + std::to_string(toRemove) + " shader variants from cache");
 
 	}
+	void ShaderVariantManager::SetFeaturePolicy(ShaderFeaturePolicy policy)
+	{
+		if (m_Config.featurePolicy == policy) {
+			return;
+		}
+		m_Config.featurePolicy = policy;
+		// every key changes, materials re-resolve through the bumped generation
+		ClearCache();
+		LogInfo(std::string("Shader feature policy: ") +
+			(policy == ShaderFeaturePolicy::RuntimeBranches ? "runtime branches" : "compile time variants"));
+	}
 	void ShaderVariantManager::EnableHotReload(bool enable)
 	{
 		m_Config.enableHotReload = enable;
+		if (enable && m_Initialized) {
+			StartFileWatcher();
+		}
+		else if (!enable) {
+			StopFileWatcher();
+		}
 		LogInfo("Hot reload " + std::string(enable ? "enabled" : "disabled"));
 
 	}
 	void ShaderVariantManager::ReloadShader(const std::string& shaderPath)
 	{
-		std::lock_guard<std::mutex> lock(m_CacheMutex);
+		// archived code is checked against fresh hashes from now on
+		{
+			std::lock_guard<std::mutex> lock(m_SourceHashMutex);
+			m_SourceHashes.clear();
+		}
 
-		// Clear all variants that use this shader
-		auto it = m_VariantCache.begin();
-		while (it != m_VariantCache.end()) {
-			auto [vsPath, psPath] = GetShaderPaths(it->first.materialType);
-			if (vsPath == shaderPath || psPath == shaderPath) {
-				it = m_VariantCache.erase(it);
-				m_Stats.hotReloads++;
-			}
-			else {
-				++it;
+		// only the variants built from this file or something that includes it
+		std::vector<ShaderVariantKey> affected;
+		{
+			std::lock_guard<std::mutex> lock(m_CacheMutex);
+			m_FailedVariants.clear();   // the edit may have fixed them, retried on next request
+			auto it = m_FileDependents.find(NormalizeShaderPath(shaderPath));
+			if (it != m_FileDependents.end()) {
+				for (const auto& key : it->second) {
+					if (m_VariantCache.count(key)) {
+						affected.push_back(key);
+					}
+				}
 			}
 		}
 
-		UpdateFileTimestamp(shaderPath);
-		LogInfo("Reloaded shader: " + shaderPath);
+		RebuildVariants(affected);
+		LogInfo("Reloading shader: " + shaderPath + " (" + std::to_string(affected.size()) + " variants)");
 	}
 	void ShaderVariantManager::ReloadAllShaders()
 	{
-		std::lock_guard<std::mutex> lock(m_CacheMutex);
+		std::vector<ShaderVariantKey> keys;
+		{
+			std::lock_guard<std::mutex> lock(m_CacheMutex);
+			keys.reserve(m_VariantCache.size());
+			for (const auto& [key, program] : m_VariantCache) {
+				keys.push_back(key);
+			}
+		}
 
-		size_t reloadedCount = m_VariantCache.size();
-		m_VariantCache.clear();
-		m_VariantUsage.clear();
-		m_Stats.totalVariants = 0;
-		m_Stats.hotReloads += reloadedCount;
+		RebuildVariants(keys);
+		LogInfo("Reloading all shader variants (" + std::to_string(keys.size()) + " variants)");
 
-		// Update all file timestamps
-		for (const auto& filePath : m_TrackedFiles) {
-			UpdateFileTimestamp(filePath);
+	}
+	void ShaderVariantManager::RebuildVariants(const std::vector<ShaderVariantKey>& keys)
+	{
+		if (keys.empty()) {
+			return;
 		}
 
-		LogInfo("Reloaded all shader variants (" + std::to_string(reloadedCount) + " variants)");
+		std::vector<VariantBuildResult> results;
+		{
+			std::lock_guard<std::mutex> lock(m_CacheMutex);
+			for (const auto& key : keys) {
+				// a newer edit supersedes any rebuild still in flight for the key
+				const uint32_t serial = m_NextRebuildSerial++;
+				m_RebuildSerials[key] = serial;
+
+				if (m_CompileQueue) {
+					SubmitBuild(key, serial);
+					continue;
+				}
+				VariantBuildResult& result = results.emplace_back();
+				result.key = key;
+				result.epoch = m_CompileEpoch;
+				result.rebuildSerial = serial;
+			}
+		}
 
+		// no workers, rebuild on the calling thread
+		for (auto& result : results) {
+			BuildShaderVariant(result);
+		}
+		std::lock_guard<std::mutex> lock(m_CacheMutex);
+		for (const auto& result : results) {
+			ApplyBuildResult(result);
+		}
 	}
 	std::vector<std::string> ShaderVariantManager::GetLoadedVariantNames() const
 	{
@@ -372,14 +962,17 @@ namespace DXEngine
 		info << "Initialized: " << (m_Initialized ? "Yes" : "No") << "\n";
 		info << "Shader Base Path: " << m_Config.shaderBasePath << "\n";
 		info << "Hot Reload: " << (m_Config.enableHotReload ? "Enabled" : "Disabled") << "\n";
+		info << "Feature Policy: " << (m_Config.featurePolicy == ShaderFeaturePolicy::RuntimeBranches ?
+			"Runtime branches" : "Compile time variants") << "\n";
 		info << "\n" << m_Stats.ToString();
 		info << "\nLoaded Variants:\n";
 
 		for (const auto& [key, shader] : m_VariantCache) {
 			info << "  - " << MaterialTypeToString(key.materialType)
-				<< " [Features: " << key.features.to_string() << "]\n";
+				<< " [Features: " << key.GetFeatures().to_string() << "]\n";
 		}
 
+		std::lock_guard<std::mutex> watchLock(m_WatchMutex);
 		info << "\nTracked Files (" << m_TrackedFiles.size() << "):\n";
 		for (const auto& file : m_TrackedFiles) {
 			info << "  - " << file << "\n";
@@ -406,6 +999,8 @@ namespace DXEngine
 			features.set(static_cast<size_t>(ShaderFeature::HasBlendIndices));
 		if (layout.HasAttribute(VertexAttributeType::TexCoord1))
 			features.set(static_cast<size_t>(ShaderFeature::HasSecondUV));
+		if (layout.HasInstanceData())
+			features.set(static_cast<size_t>(ShaderFeature::EnableInstancing));
 
 		return features;
 	}
@@ -516,11 +1111,22 @@ namespace DXEngine
 			return { basePath + "Lit.vs.hlsl", basePath + "Lit.ps.hlsl" };
 		}
 	}
-	std::string ShaderVariantManager::GenerateDefinesString(
-		const ShaderFeatureFlags& features,
-		const VertexLayout& layout)
+	std::string ShaderVariantManager::GenerateDefinesString(const ShaderFeatureFlags& keyFeatures)
 	{
 		std::ostringstream defines;
+		ShaderFeatureFlags features = keyFeatures;
+
+		// runtime features compile in and test their flag, unless the key already forces them on
+		if (keyFeatures.test(static_cast<size_t>(ShaderFeature::RuntimeMaterialFlags))) {
+			uint32_t runtimeFlags = 0;
+			for (const auto& runtime : RuntimeFeatures) {
+				if (!keyFeatures.test(static_cast<size_t>(runtime.feature))) {
+					features.set(static_cast<size_t>(runtime.feature));
+					runtimeFlags |= runtime.materialFlag;
+				}
+			}
+			defines << "#define RUNTIME_MATERIAL_FLAGS " << runtimeFlags << "\n";
+		}
 
 		// ========== CORE TEXTURE FEATURES ==========
 		if (features.test(static_cast<size_t>(ShaderFeature::HasDiffuseTexture)))
@@ -588,72 +1194,89 @@ namespace DXEngine
 
 		return defines.str();
 	}
-	std::string ShaderVariantManager::GenerateVertexLayoutHash(const VertexLayout& layout)
+	void ShaderVariantManager::StartFileWatcher()
 	{
-		std::string hash;
-		for (const auto& attr : layout.GetAttributes()) {
-			hash += std::to_string(static_cast<int>(attr.Type));
-			hash += std::to_string(static_cast<int>(attr.Format));
-			hash += std::to_string(attr.Slot);
-			hash += "_";
+		if (m_WatchThread.joinable()) {
+			return;
 		}
-		return hash;
+		m_WatchStopping = false;
+		m_WatchThread = std::thread(&ShaderVariantManager::WatchFiles, this);
 	}
-	void ShaderVariantManager::CheckForFileChanges()
+	void ShaderVariantManager::StopFileWatcher()
 	{
-		bool needsReload = false;
-		std::vector<std::string> changedFiles;
-
-		for (const auto& [filePath, storedTime] : m_FileTimestamps) {
-			if (HasFileChanged(filePath)) {
-				needsReload = true;
-				changedFiles.push_back(filePath);
-			}
+		if (!m_WatchThread.joinable()) {
+			return;
 		}
-
-		if (needsReload) {
-			LogInfo("Hot reloading shaders due to file changes");
-			for (const auto& file : changedFiles) {
-				ReloadShader(file);
-			}
+		{
+			std::lock_guard<std::mutex> lock(m_WatchMutex);
+			m_WatchStopping = true;
 		}
+		m_WatchWake.notify_all();
+		m_WatchThread.join();
 	}
-	void ShaderVariantManager::UpdateFileTimestamp(const std::string& filePath)
+	void ShaderVariantManager::WatchFiles()
 	{
-		try {
-			if (std::filesystem::exists(filePath)) {
-				auto time = std::filesystem::last_write_time(filePath);
-				m_FileTimestamps[filePath] =
-					std::chrono::duration_cast<std::chrono::milliseconds>(
-						time.time_since_epoch()).count();
-
-				// Add to tracked files if not already tracked
-				if (std::find(m_TrackedFiles.begin(), m_TrackedFiles.end(), filePath) == m_TrackedFiles.end()) {
-					m_TrackedFiles.push_back(filePath);
+		while (true) {
+			{
+				std::unique_lock<std::mutex> lock(m_WatchMutex);
+				m_WatchWake.wait_for(lock, std::chrono::milliseconds(m_Config.hotReloadPollMs),
+					[this]() { return m_WatchStopping; });
+				if (m_WatchStopping) {
+					return;
 				}
 			}
-		}
-		catch (...) {
-			// Ignore filesystem errors
+
+			std::vector<std::string> changedFiles = CheckForFileChanges();
+			if (!changedFiles.empty()) {
+				std::lock_guard<std::mutex> lock(m_WatchMutex);
+				m_ChangedFiles.insert(m_ChangedFiles.end(), changedFiles.begin(), changedFiles.end());
+			}
 		}
 	}
-	bool ShaderVariantManager::HasFileChanged(const std::string& filePath)
+	std::vector<std::string> ShaderVariantManager::CheckForFileChanges()
 	{
-		try {
-			if (!std::filesystem::exists(filePath)) {
-				return false;
-			}
+		std::vector<std::string> files;
+		{
+			std::lock_guard<std::mutex> lock(m_WatchMutex);
+			files = m_TrackedFiles;
+		}
 
-			auto currentTime = std::filesystem::last_write_time(filePath);
-			auto currentTimeMs = std::chrono::duration_cast<std::chrono::milliseconds>(
-				currentTime.time_since_epoch()).count();
+		// stat outside the lock, compiles keep registering files meanwhile
+		std::vector<std::pair<std::string, uint64_t>> times;
+		times.reserve(files.size());
+		for (auto& file : files) {
+			const uint64_t time = GetFileTimestamp(file);
+			times.emplace_back(std::move(file), time);
+		}
 
-			auto it = m_FileTimestamps.find(filePath);
-			return it != m_FileTimestamps.end() && it->second != currentTimeMs;
+		std::vector<std::string> changedFiles;
+		std::lock_guard<std::mutex> lock(m_WatchMutex);
+		for (auto& [file, time] : times) {
+			auto it = m_FileTimestamps.find(file);
+			if (time != 0 && it != m_FileTimestamps.end() && it->second != time) {
+				it->second = time;
+				changedFiles.push_back(std::move(file));
+			}
 		}
-		catch (...) {
-			return false;
+		return changedFiles;
+	}
+	void ShaderVariantManager::TrackFile(const std::string& filePath)
+	{
+		std::lock_guard<std::mutex> lock(m_WatchMutex);
+		if (m_FileTimestamps.count(filePath)) {
+			return;
 		}
+		m_FileTimestamps[filePath] = GetFileTimestamp(filePath);
+		m_TrackedFiles.push_back(filePath);
+	}
+	uint64_t ShaderVariantManager::GetFileTimestamp(const std::string& filePath)
+	{
+		std::error_code ec;
+		auto time = std::filesystem::last_write_time(filePath, ec);
+		if (ec) {
+			return 0;
+		}
+		return std::chrono::duration_cast<std::chrono::milliseconds>(time.time_since_epoch()).count();
 	}
 	std::string ShaderVariantManager::MaterialTypeToString(MaterialType type) const
 	{
@@ -699,6 +1322,43 @@ namespace DXEngine
 			return it->second;
 		}
 
+		const ShaderVariantKey key = MakeFallbackKey(materialType);
+
+		LogWarning("Creating fallback shader for material type: " + MaterialTypeToString(materialType));
+
+		// Try to create the fallback shader
+		VariantBuildResult result;
+		result.key = key;
+		BuildShaderVariant(result);
+		{
+			std::lock_guard<std::mutex> lock(m_CacheMutex);
+			RecordBuild(result);
+		}
+		auto fallbackShader = result.program;
+
+		if (fallbackShader) {
+			m_FallbackShaders[materialType] = fallbackShader;
+			return fallbackShader;
+		}
+
+		// Ultimate fallback: try unlit if we're not already trying it, and remember it so
+		// the failing build is not retried on every miss
+		if (materialType != MaterialType::Unlit) {
+			LogError("Failed to create fallback shader, trying Unlit as last resort");
+			fallbackShader = GetFallbackShader(MaterialType::Unlit);
+			if (fallbackShader) {
+				m_FallbackShaders[materialType] = fallbackShader;
+			}
+			return fallbackShader;
+		}
+
+		// Complete failure
+		LogError("CRITICAL: All fallback shader creation failed!");
+		return nullptr;
+	}
+
+	ShaderVariantKey ShaderVariantManager::MakeFallbackKey(MaterialType materialType)
+	{
 		// Create minimal vertex layout for fallback
 		VertexLayout fallbackLayout;
 		fallbackLayout.Position(); // Only position is guaranteed
@@ -729,29 +1389,9 @@ namespace DXEngine
 		// Create variant key for fallback
 		ShaderVariantKey key;
 		key.materialType = materialType;
-		key.vertexLayoutHash = GenerateVertexLayoutHash(fallbackLayout);
-		key.actualLayout = fallbackLayout;
-		key.features = AnalyzeVertexLayout(fallbackLayout); // Minimal features
-
-		LogWarning("Creating fallback shader for material type: " + MaterialTypeToString(materialType));
-
-		// Try to create the fallback shader
-		auto fallbackShader = CreateShaderVariant(key);
-
-		if (fallbackShader) {
-			m_FallbackShaders[materialType] = fallbackShader;
-			return fallbackShader;
-		}
-
-		// Ultimate fallback: try unlit if we're not already trying it
-		if (materialType != MaterialType::Unlit) {
-			LogError("Failed to create fallback shader, trying Unlit as last resort");
-			return GetFallbackShader(MaterialType::Unlit);
-		}
-
-		// Complete failure
-		LogError("CRITICAL: All fallback shader creation failed!");
-		return nullptr;
+		key.layoutID = fallbackLayout.GetID();
+		key.features = static_cast<uint32_t>(AnalyzeVertexLayout(fallbackLayout).to_ulong()); // Minimal features
+		return key;
 	}
 
 	namespace ShaderVariantUtils {
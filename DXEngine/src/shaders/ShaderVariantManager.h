@@ -1,8 +1,14 @@
 #pragma once
 #include "ShaderProgram.h"
+#include "ShaderCompiler.h"
+#include "ShaderBinaryCache.h"
+#include "ShaderArchive.h"
 #include "utils/Mesh/Utils/VertexAttribute.h"
 #include "utils/material/MaterialTypes.h"
+#include "utils/Hash.h"
+#include "utils/TaskQueue.h"
 #include <unordered_map>
+#include <unordered_set>
 #include <string>
 #include <memory>
 #include <bitset>
@@ -11,6 +17,10 @@
 #include <d3dcompiler.h>
 #include <wrl/client.h>
 #include <mutex>
+#include <atomic>
+#include <thread>
+#include <condition_variable>
+#include <type_traits>
 
 namespace DXEngine
 {
@@ -53,35 +63,46 @@ namespace DXEngine
         HasDetailNormalMap = 24,
         UseDetailTextures = 25,
 
+        // Key built under ShaderFeaturePolicy::RuntimeBranches
+        RuntimeMaterialFlags = 26,
+
         MaxFeatures = 32
     };
 
     using ShaderFeatureFlags = std::bitset<32>;
 
+    // Which material features select a variant. Skinning, instancing, parallax and the vertex
+    // attributes change the shader interface or cost and are always compile time defines.
+    enum class ShaderFeaturePolicy : uint8_t {
+        CompileTimeVariants,    // every feature is a define, one variant per combination
+        RuntimeBranches         // texture presence, alpha test and emissive map branch on MaterialProperties::flags
+    };
+
+    // Plain data, building, comparing and hashing a key never allocates
     struct ShaderVariantKey {
-        MaterialType materialType;
-        ShaderFeatureFlags features;
-        std::string vertexLayoutHash;
-        VertexLayout actualLayout;
+        MaterialType materialType = MaterialType::Lit;
+        uint32_t features = 0;      // ShaderFeatureFlags bits
+        uint64_t layoutID = 0;      // VertexLayout::GetID
+
+        ShaderFeatureFlags GetFeatures() const { return ShaderFeatureFlags(features); }
 
         bool operator==(const ShaderVariantKey& other) const {
             return materialType == other.materialType &&
                 features == other.features &&
-                vertexLayoutHash == other.vertexLayoutHash;
+                layoutID == other.layoutID;
         }
 
         std::string ToString() const {
             return std::to_string(static_cast<int>(materialType)) + "_" +
-                std::to_string(features.to_ulong()) + "_" + vertexLayoutHash;
+                std::to_string(features) + "_" + std::to_string(layoutID);
         }
     };
+    static_assert(std::is_trivially_copyable_v<ShaderVariantKey>, "variant keys must stay plain data");
 
     struct ShaderVariantKeyHash {
         size_t operator()(const ShaderVariantKey& key) const {
-            size_t h1 = std::hash<int>{}(static_cast<int>(key.materialType));
-            size_t h2 = std::hash<unsigned long>{}(key.features.to_ulong());
-            size_t h3 = std::hash<std::string>{}(key.vertexLayoutHash);
-            return h1 ^ (h2 << 1) ^ (h3 << 2);
+            const uint64_t typeAndFeatures = (uint64_t(key.materialType) << 32) | key.features;
+            return static_cast<size_t>(HashCombine(key.layoutID, typeAndFeatures));
         }
     };
 
@@ -90,10 +111,34 @@ namespace DXEngine
     {
         std::string shaderBasePath = "assets/shaders/";
         bool enableHotReload = false;
+        uint32_t hotReloadPollMs = 250;    //file watcher thread interval
         bool enableDebugInfo = false;
         bool enableOptimization = true;
         bool precompileCommonVariants = true;
 
+        //compiled bytecode kept between runs, keyed by source, includes, defines and flags
+        bool enableDiskCache = true;
+        std::string diskCachePath = "cache/shaders.bin";
+
+        //uber shader mode trades a few uniform branches for far fewer variants and shader switches
+        ShaderFeaturePolicy featurePolicy = ShaderFeaturePolicy::CompileTimeVariants;
+
+        //misses compile on worker threads, draws use a substitute until the next Update
+        bool asyncCompilation = true;
+        uint32_t compileThreadCount = 0;   //0 picks one per spare core
+
+        //variants prebuilt by the ShaderBuilder tool, looked up before anything compiles
+        std::string archivePath = "assets/shaders/shaders.pak";
+#ifdef DX_SHIPPING
+        //shipping builds resolve variants from the archive only
+        bool allowRuntimeCompilation = false;
+        std::string variantManifestPath;
+#else
+        bool allowRuntimeCompilation = true;
+        //keys requested this run are merged in here on shutdown, the ShaderBuilder reads it
+        std::string variantManifestPath = "cache/shader_variants.txt";
+#endif
+
         //fall back options
         std::string fallbackVertexShader = "Lit.vs.hlsl";
         std::string fallbackPixelShader = "Lit.ps.hlsl";
@@ -108,10 +153,17 @@ namespace DXEngine
         size_t cacheMisses = 0;
         size_t compilationFailures = 0;
         size_t hotReloads = 0;
+        size_t diskCacheHits = 0;      //per shader stage, bytecode loaded instead of compiled
+        size_t diskCacheMisses = 0;
+        size_t archiveHits = 0;        //variants loaded from the prebuilt archive
+        size_t pendingCompiles = 0;    //queued or compiling as of the last Update
+        size_t substitutions = 0;      //requests answered with another variant while compiling
 
         void Reset()
         {
             totalVariants = cacheHits = cacheMisses = compilationFailures = hotReloads = 0;
+            diskCacheHits = diskCacheMisses = archiveHits = 0;
+            pendingCompiles = substitutions = 0;
 
         }
 
@@ -119,10 +171,17 @@ namespace DXEngine
         {
             float hitRate = (cacheHits + cacheMisses) > 0 ?
                 ((float)(cacheHits) / float(cacheHits + cacheMisses)) * 100.0f : 0.0f;
+            float diskHitRate = (diskCacheHits + diskCacheMisses) > 0 ?
+                ((float)(diskCacheHits) / float(diskCacheHits + diskCacheMisses)) * 100.0f : 0.0f;
 
             return "Shader Stats:\n" +
                 std::string("  Total Variants: ") + std::to_string(totalVariants) + "\n" +
                 std::string("  Cache Hit Rate: ") + std::to_string(hitRate) + "%\n" +
+                std::string("  Disk Cache Hit Rate: ") + std::to_string(diskHitRate) + "% (" +
+                std::to_string(diskCacheHits) + " loaded, " + std::to_string(diskCacheMisses) + " compiled)\n" +
+                std::string("  Archive Hits: ") + std::to_string(archiveHits) + "\n" +
+                std::string("  Pending Compiles: ") + std::to_string(pendingCompiles) +
+                " (" + std::to_string(substitutions) + " substituted draws)\n" +
                 std::string("  Compilation Failures: ") + std::to_string(compilationFailures) + "\n" +
                 std::string("  Hot Reloads: ") + std::to_string(hotReloads) + "\n";
         }
@@ -141,17 +200,22 @@ namespace DXEngine
         // Core functionality
         bool Initialize(const ShaderVariantConfig& config = {});
         void Shutdown();
-        void Update(); // For hot reload checking
+        void Update(); // Frame boundary: swaps in finished compiles, checks for hot reload
 
-        // Main interface - gets shader for specific mesh/material combination
+        // Main interface - gets shader for specific mesh/material combination.
+        // Cached on the material per layout ID, a hit takes no lock and builds no key.
         std::shared_ptr<ShaderProgram> GetShaderVariant(
             const VertexLayout& layout,
             const Material* material,
             MaterialType materialType
         );
 
-        // Direct variant access by key
+        // Direct variant access by key. A miss queues the compile and returns the closest
+        // compiled superset variant or the fallback shader until the next Update.
         std::shared_ptr<ShaderProgram> GetShaderVariant(const ShaderVariantKey& key);
+        bool IsVariantPending(const ShaderVariantKey& key) const;
+        // Blocks until every queued compile is done and swaps the results in
+        void WaitForPendingVariants();
         std::shared_ptr<ShaderProgram> GetFallbackShader(MaterialType materialType = MaterialType::Unlit);
 
         // Precompilation
@@ -162,13 +226,27 @@ namespace DXEngine
         void ClearCache();
         void PruneLeastUsedVariants(size_t maxVariants = 256);
 
-        // Hot reload
+        // Hot reload. Files and their includes are watched on a background thread, a change
+        // recompiles only the variants that depend on it and the old ones draw until it lands.
         void EnableHotReload(bool enable);
         void ReloadShader(const std::string& shaderPath);
         void ReloadAllShaders();
+        // Bumped whenever cached variants are dropped, stale material caches stop matching
+        uint32_t GetGeneration() const { return m_Generation.load(std::memory_order_acquire); }
+
+        // Offline builds: compiles keys plus every cached and fallback variant into one archive
+        bool BuildShaderArchive(const std::string& path, const std::vector<ShaderVariantKey>& keys);
+        // One key per line, SaveVariantManifest merges with what the file already holds
+        bool SaveVariantManifest(const std::string& path) const;
+        static bool LoadVariantManifest(const std::string& path, std::vector<ShaderVariantKey>& keys);
+
+        // Replaces the D3D compiler, call before Initialize
+        void SetCompiler(std::unique_ptr<ShaderCompiler> compiler) { m_Compiler = std::move(compiler); }
 
         // Configuration
         void SetConfig(const ShaderVariantConfig& config) { m_Config = config; }
+        // Changes every key, drops the cached variants
+        void SetFeaturePolicy(ShaderFeaturePolicy policy);
         const ShaderVariantConfig& GetConfig() const { return m_Config; }
 
         // Feature analysis
@@ -179,8 +257,7 @@ namespace DXEngine
             const ShaderFeatureFlags& materialFeatures,
             MaterialType materialType
         );
-
-        std::string GenerateVertexLayoutHash(const VertexLayout& layout);
+        ShaderVariantKey MakeVariantKey(const VertexLayout& layout, const Material* material, MaterialType materialType);
 
 
         // Statistics and debugging
@@ -191,29 +268,70 @@ namespace DXEngine
 
     private:
         ShaderVariantManager() = default;
-        ~ShaderVariantManager() = default;
+        ~ShaderVariantManager() { StopFileWatcher(); }
         ShaderVariantManager(const ShaderVariantManager&) = delete;
         ShaderVariantManager& operator=(const ShaderVariantManager&) = delete;
 
-        // Core compilation pipeline
-        std::shared_ptr<ShaderProgram> CreateShaderVariant(const ShaderVariantKey& key);
+        // Output of one variant compile, built on any thread and applied on the render thread
+        struct VariantBuildResult
+        {
+            ShaderVariantKey key;
+            uint32_t epoch = 0;             // m_CompileEpoch when queued
+            uint32_t rebuildSerial = 0;     // non zero for hot reload rebuilds
+            std::shared_ptr<ShaderProgram> program;
+            std::string vsPath;
+            std::string psPath;
+            Microsoft::WRL::ComPtr<ID3DBlob> vsBlob;
+            Microsoft::WRL::ComPtr<ID3DBlob> psBlob;
+            bool fromArchive = false;
+            uint32_t diskCacheHits = 0;
+            uint32_t diskCacheMisses = 0;
+            std::vector<std::string> dependencies;  // normalized sources and includes
+        };
+
+        // Core compilation pipeline, safe to run on worker threads
+        void BuildShaderVariant(VariantBuildResult& result);
+        bool LoadFromArchive(VariantBuildResult& result);
+        // With runtime compilation on, archived code only counts while its sources are unchanged
+        bool IsArchivedCodeCurrent(MaterialType materialType, const ShaderArchiveBlobs& blobs);
+        uint64_t GetSourceHash(MaterialType materialType);
+        void CollectDependencies(const std::string& filePath, VariantBuildResult& result);
         Microsoft::WRL::ComPtr<ID3DBlob> CompileShader(
             const std::string& filePath,
             const std::string& defines,
             const std::string& target,
-            const std::string& entryPoint = "main"
+            const std::string& entryPoint,
+            VariantBuildResult& result
         );
+        Microsoft::WRL::ComPtr<ID3DBlob> CreateBlob(const uint8_t* data, size_t size);
+
+        // Async variant lookup, exact is false when a substitute is returned
+        std::shared_ptr<ShaderProgram> ResolveVariant(const ShaderVariantKey& key, bool& exact);
+        void ApplyCompletedVariants();
+        void RebuildVariants(const std::vector<ShaderVariantKey>& keys);
 
-       
+        // Caller holds m_CacheMutex
+        std::shared_ptr<ShaderProgram> FindSubstituteVariant(const ShaderVariantKey& key) const;
+        void SubmitVariant(const ShaderVariantKey& key);
+        void SubmitBuild(const ShaderVariantKey& key, uint32_t rebuildSerial);
+        void ApplyBuildResult(const VariantBuildResult& result);
+        void RecordBuild(const VariantBuildResult& result);
+        void BumpGeneration();          // material caches stop matching
+        void DropPendingCompiles();     // in flight results are discarded when they land
+
+        ShaderVariantKey MakeFallbackKey(MaterialType materialType);
 
         // Shader path resolution
         std::pair<std::string, std::string> GetShaderPaths(MaterialType materialType);
-        std::string GenerateDefinesString(const ShaderFeatureFlags& features, const VertexLayout& layout);
+        std::string GenerateDefinesString(const ShaderFeatureFlags& keyFeatures);
 
-        // Hot reload support
-        void CheckForFileChanges();
-        void UpdateFileTimestamp(const std::string& filePath);
-        bool HasFileChanged(const std::string& filePath);
+        // Hot reload support, the watcher thread only touches the m_WatchMutex state
+        void StartFileWatcher();
+        void StopFileWatcher();
+        void WatchFiles();
+        std::vector<std::string> CheckForFileChanges();
+        void TrackFile(const std::string& filePath);
+        static uint64_t GetFileTimestamp(const std::string& filePath);
 
         // Utility functions
         std::string MaterialTypeToString(MaterialType type)const;
@@ -235,15 +353,43 @@ namespace DXEngine
         std::unordered_map<ShaderVariantKey, size_t, ShaderVariantKeyHash> m_VariantUsage;
         size_t m_CurrentFrame = 0;
 
-        // Hot reload support
+        // Hot reload support. File to dependent variants, built from every compile.
+        std::unordered_map<std::string, std::unordered_set<ShaderVariantKey, ShaderVariantKeyHash>> m_FileDependents;
+        std::unordered_map<ShaderVariantKey, uint32_t, ShaderVariantKeyHash> m_RebuildSerials;
+        uint32_t m_NextRebuildSerial = 1;
+
+        std::thread m_WatchThread;
+        mutable std::mutex m_WatchMutex;
+        std::condition_variable m_WatchWake;
+        bool m_WatchStopping = false;
         std::unordered_map<std::string, uint64_t> m_FileTimestamps;
         std::vector<std::string> m_TrackedFiles;
+        std::vector<std::string> m_ChangedFiles;    // drained by Update
 
         // Common vertex layouts for precompilation
         std::vector<VertexLayout> m_CommonLayouts;
 
+        // Compilation and the on-disk bytecode cache
+        std::unique_ptr<ShaderCompiler> m_Compiler;
+        ShaderBinaryCache m_DiskCache;
+        ShaderArchive m_Archive;
+
+        // hash of the files each material type compiles from, dropped when a shader file changes
+        std::unordered_map<MaterialType, uint64_t> m_SourceHashes;
+        std::mutex m_SourceHashMutex;
+
+        // Background compilation. Pending keys map to the variant drawn in their place,
+        // workers only touch m_CompletedVariants.
+        std::unique_ptr<TaskQueue> m_CompileQueue;
+        std::unordered_map<ShaderVariantKey, std::shared_ptr<ShaderProgram>, ShaderVariantKeyHash> m_PendingVariants;
+        std::unordered_set<ShaderVariantKey, ShaderVariantKeyHash> m_FailedVariants;
+        std::vector<VariantBuildResult> m_CompletedVariants;
+        std::mutex m_CompletedMutex;
+        uint32_t m_CompileEpoch = 1;
+
         // Thread safety
         mutable std::mutex m_CacheMutex;
+        std::atomic<uint32_t> m_Generation{ 1 };
 
         bool m_Initialized = false;
 
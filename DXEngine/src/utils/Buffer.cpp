@@ -42,7 +42,7 @@ namespace DXEngine
 			pInitialData = &initialData;
 		}
 			
-		HRESULT hr = RenderCommand::GetDevice()->CreateBuffer(&bufferDesc, pInitialData, m_Buffer.GetAddressOf());
+		HRESULT hr = RenderCommand::GetDevice()->CreateBuffer(&bufferDesc, pInitialData, m_Buffer.ReleaseAndGetAddressOf());
 		return SUCCEEDED(hr);
 	}
 	bool BufferBase::UpdateInternal(const void* data, UINT dataSize, UINT offset)
@@ -60,13 +60,12 @@ namespace DXEngine
 		{
 			//use Map/Unmap for dynamic buffers
 			D3D11_MAPPED_SUBRESOURCE mappedResource;
-			HRESULT hr = RenderCommand::GetContext()->Map(m_Buffer.Get(), 0, 
-				D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
+			HRESULT hr = RenderCommand::MapBuffer(m_Buffer.Get(), D3D11_MAP_WRITE_DISCARD, mappedResource);
 			if (FAILED(hr))
 				return false;
 
 			memcpy(static_cast<char*>(mappedResource.pData) + offset, data, dataSize);
-			RenderCommand::GetContext()->Unmap(m_Buffer.Get(), 0);
+			RenderCommand::UnmapBuffer(m_Buffer.Get(), dataSize);
 			return true;
 		}
 		else
@@ -80,9 +79,9 @@ namespace DXEngine
 			box.front = 0;
 			box.back = 1;
 
-			RenderCommand::GetContext()->UpdateSubresource(m_Buffer.Get(), 0, &box, data, 0, 0);
+			RenderCommand::UpdateBuffer(m_Buffer.Get(), &box, data, dataSize);
 		}
-		return false;
+		return true;
 	}
 	bool BufferBase::ReadData(void* outData, UINT dataSize, UINT offset) const
 	{
@@ -95,13 +94,12 @@ namespace DXEngine
 			return false;
 		}
 		D3D11_MAPPED_SUBRESOURCE mappedResource;
-		HRESULT hr = RenderCommand::GetContext()->Map(m_Buffer.Get(), 0,
-			D3D11_MAP_READ, 0, &mappedResource);
+		HRESULT hr = RenderCommand::MapBuffer(m_Buffer.Get(), D3D11_MAP_READ, mappedResource);
 		if (FAILED(hr))
 			return false;
 
 		memcpy(outData, static_cast<const char*>(mappedResource.pData) + offset, dataSize);
-		RenderCommand::GetContext()->Unmap(m_Buffer.Get(), 0);
+		RenderCommand::UnmapBuffer(m_Buffer.Get(), 0);
 		return true;
 	}
 	D3D11_USAGE BufferBase::GetD3DUsage(UsageType usage) const
@@ -0,0 +1,262 @@
+#include "dxpch.h"
+#include "ConstantBufferRing.h"
+#include <thread>
+
+namespace DXEngine
+{
+	namespace
+	{
+		constexpr UINT MaxRingCapacity = 64 * 1024 * 1024;
+	}
+
+	bool ConstantBufferRing::Initialize(UINT capacity)
+	{
+		Shutdown();
+
+		auto device = RenderCommand::GetDevice();
+		if (!device || !RenderCommand::GetBackend())
+			return false;
+
+		// Suballocation needs constant buffer offsets and NO_OVERWRITE maps on constant buffers
+		D3D11_FEATURE_DATA_D3D11_OPTIONS options = {};
+		if (SUCCEEDED(device->CheckFeatureSupport(D3D11_FEATURE_D3D11_OPTIONS, &options, sizeof(options))))
+		{
+			m_SupportsOffsets = options.ConstantBufferOffsetting && options.MapNoOverwriteOnDynamicConstantBuffer;
+		}
+		m_SupportsOffsets = m_SupportsOffsets && RenderCommand::GetBackend()->SupportsConstantBufferRanges();
+
+		if (!m_SupportsOffsets)
+		{
+			OutputDebugStringA("Warning: Constant buffer offsetting not supported, using per-slot constant buffers\n");
+			return true;
+		}
+
+		D3D11_QUERY_DESC queryDesc = {};
+		queryDesc.Query = D3D11_QUERY_EVENT;
+		for (auto& fence : m_FrameFences)
+		{
+			if (FAILED(device->CreateQuery(&queryDesc, fence.query.GetAddressOf())))
+			{
+				OutputDebugStringA("Warning: Failed to create constant ring frame fence\n");
+				m_SupportsOffsets = false;
+				return true;
+			}
+		}
+
+		return CreateRingBuffer(AlignUp(capacity));
+	}
+
+	void ConstantBufferRing::Shutdown()
+	{
+		m_Buffer.Reset();
+		for (auto& fence : m_FrameFences)
+		{
+			fence = FrameFence{};
+		}
+		for (auto& buffer : m_FallbackBuffers)
+		{
+			buffer.reset();
+		}
+		m_ByteWidth = 0;
+		m_Head = 0;
+		m_Used = 0;
+		m_FrameBytes = 0;
+		m_PendingCapacity = 0;
+		m_FrameIndex = 0;
+		m_SupportsOffsets = false;
+	}
+
+	void ConstantBufferRing::BeginFrame()
+	{
+		m_FrameStats = FrameStats{};
+
+		if (!m_SupportsOffsets)
+			return;
+
+		RetireFrames();
+
+		// The slot this frame will signal is still owned by a frame the GPU has not finished
+		FrameFence& fence = m_FrameFences[m_FrameIndex % MaxFramesInFlight];
+		if (fence.pending)
+		{
+			while (RenderCommand::GetQueryData(fence.query.Get()) == S_FALSE)
+			{
+				std::this_thread::yield();
+			}
+			RetireFrames();
+		}
+
+		if (m_PendingCapacity > m_ByteWidth)
+		{
+			CreateRingBuffer(m_PendingCapacity);
+		}
+		m_PendingCapacity = 0;
+	}
+
+	void ConstantBufferRing::EndFrame()
+	{
+		if (!m_SupportsOffsets)
+			return;
+
+		FrameFence& fence = m_FrameFences[m_FrameIndex % MaxFramesInFlight];
+		fence.bytes = m_FrameBytes;
+		fence.pending = true;
+		RenderCommand::EndQuery(fence.query.Get());
+
+		m_FrameBytes = 0;
+		m_FrameIndex++;
+	}
+
+	bool ConstantBufferRing::BindVS(UINT slot, const void* data, UINT dataSize)
+	{
+		if (!data || dataSize == 0 || slot >= D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT)
+			return false;
+
+		if (!m_SupportsOffsets)
+			return BindFallbackVS(slot, data, dataSize);
+
+		Allocation allocation;
+		if (!Allocate(data, dataSize, allocation))
+			return false;
+
+		return RenderCommand::SetConstantBufferRange(ShaderStage::Vertex, slot, m_Buffer.Get(),
+			allocation.firstConstant, allocation.numConstants);
+	}
+
+	bool ConstantBufferRing::CreateRingBuffer(UINT capacity)
+	{
+		BufferDesc desc;
+		desc.bufferType = BufferType::Constant;
+		desc.usageType = UsageType::Dynamic;
+		desc.byteWidth = capacity;
+
+		if (!InitializeInternal(desc))
+		{
+			OutputDebugStringA("Warning: Failed to create constant ring buffer\n");
+			return false;
+		}
+
+		// a new buffer holds nothing the GPU is still reading
+		for (auto& fence : m_FrameFences)
+		{
+			fence.bytes = 0;
+		}
+		m_Head = 0;
+		m_Used = 0;
+		m_FrameBytes = 0;
+		m_NeedsDiscard = true;
+		m_FrameStats.buffersCreated++;
+		return true;
+	}
+
+	bool ConstantBufferRing::Allocate(const void* data, UINT dataSize, Allocation& outAllocation)
+	{
+		const UINT alignedSize = AlignUp(dataSize);
+
+		if (alignedSize > m_ByteWidth)
+		{
+			UINT newCapacity = std::max(m_ByteWidth * 2, alignedSize);
+			if (!CreateRingBuffer(newCapacity))
+				return false;
+		}
+
+		UINT wrapWaste = (m_Head + alignedSize > m_ByteWidth) ? m_ByteWidth - m_Head : 0;
+		if (m_Used + wrapWaste + alignedSize > m_ByteWidth)
+		{
+			// Everything ahead of the head is still in flight. Let the driver rename the
+			// buffer and grow next frame so the ring can hold the working set.
+			for (auto& fence : m_FrameFences)
+			{
+				fence.bytes = 0;
+			}
+			m_Head = 0;
+			m_Used = 0;
+			m_FrameBytes = 0;
+			m_NeedsDiscard = true;
+			wrapWaste = 0;
+			m_PendingCapacity = std::min(std::max(m_PendingCapacity, m_ByteWidth * 2), MaxRingCapacity);
+		}
+
+		if (wrapWaste > 0)
+		{
+			m_Head = 0;
+		}
+
+		const D3D11_MAP mapType = m_NeedsDiscard ? D3D11_MAP_WRITE_DISCARD : D3D11_MAP_WRITE_NO_OVERWRITE;
+
+		D3D11_MAPPED_SUBRESOURCE mappedResource;
+		HRESULT hr = RenderCommand::MapBuffer(m_Buffer.Get(), mapType, mappedResource);
+		if (FAILED(hr))
+			return false;
+
+		memcpy(static_cast<char*>(mappedResource.pData) + m_Head, data, dataSize);
+		RenderCommand::UnmapBuffer(m_Buffer.Get(), dataSize);
+
+		m_FrameStats.maps++;
+		if (m_NeedsDiscard)
+		{
+			m_FrameStats.discards++;
+			m_NeedsDiscard = false;
+		}
+
+		outAllocation.offset = m_Head;
+		outAllocation.firstConstant = m_Head / 16;
+		outAllocation.numConstants = alignedSize / 16;
+
+		m_Head += alignedSize;
+		m_Used += wrapWaste + alignedSize;
+		m_FrameBytes += wrapWaste + alignedSize;
+		m_FrameStats.bytesUploaded += dataSize;
+		return true;
+	}
+
+	void ConstantBufferRing::RetireFrames()
+	{
+		// fences signal in submission order, so stop at the first one still pending
+		for (UINT i = 0; i < MaxFramesInFlight; ++i)
+		{
+			FrameFence& fence = m_FrameFences[(m_FrameIndex + i) % MaxFramesInFlight];
+			if (!fence.pending)
+				continue;
+
+			if (RenderCommand::GetQueryData(fence.query.Get(), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK)
+				break;
+
+			m_Used -= std::min(m_Used, fence.bytes);
+			fence.bytes = 0;
+			fence.pending = false;
+		}
+	}
+
+	bool ConstantBufferRing::BindFallbackVS(UINT slot, const void* data, UINT dataSize)
+	{
+		auto& buffer = m_FallbackBuffers[slot];
+		const UINT byteWidth = (dataSize + 15) & ~15;
+
+		if (!buffer || buffer->GetByteWidth() < byteWidth)
+		{
+			BufferDesc desc;
+			desc.bufferType = BufferType::Constant;
+			desc.usageType = UsageType::Dynamic;
+			desc.byteWidth = byteWidth;
+
+			buffer = std::make_unique<RawBuffer>();
+			if (!buffer->Initialize(desc))
+			{
+				buffer.reset();
+				return false;
+			}
+			m_FrameStats.buffersCreated++;
+		}
+
+		if (!buffer->Update(data, dataSize))
+			return false;
+
+		m_FrameStats.maps++;
+		m_FrameStats.discards++;
+		m_FrameStats.bytesUploaded += dataSize;
+
+		RenderCommand::SetConstantBuffer(ShaderStage::Vertex, slot, buffer->GetBuffer());
+		return true;
+	}
+}
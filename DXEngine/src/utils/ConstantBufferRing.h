@@ -0,0 +1,88 @@
+#pragma once
+#include "Buffer.h"
+#include <d3d11_1.h>
+#include <array>
+
+namespace DXEngine {
+
+	// Persistent ring of constant memory shared by all per-draw constant data.
+	// Each upload is suballocated from one large dynamic buffer and bound with a
+	// constant offset (D3D11.1), so draws no longer create their own buffers.
+	class ConstantBufferRing : public BufferBase
+	{
+	public:
+		static constexpr UINT Alignment = 256;          // offsets are given in 16-constant units
+		static constexpr UINT MaxFramesInFlight = 3;
+		static constexpr UINT DefaultCapacity = 4 * 1024 * 1024;
+
+		struct FrameStats
+		{
+			size_t bytesUploaded = 0;
+			uint32_t buffersCreated = 0;
+			uint32_t maps = 0;
+			uint32_t discards = 0;
+		};
+
+		ConstantBufferRing() = default;
+		~ConstantBufferRing() override { Shutdown(); }
+
+		bool Initialize(UINT capacity = DefaultCapacity);
+		void Shutdown();
+
+		// frame fencing
+		void BeginFrame();
+		void EndFrame();
+
+		// Copies data into the ring and binds it to the vertex shader slot
+		bool BindVS(UINT slot, const void* data, UINT dataSize);
+
+		template<typename T>
+		bool BindVS(UINT slot, const T& data)
+		{
+			return BindVS(slot, &data, sizeof(T));
+		}
+
+		bool SupportsOffsets() const { return m_SupportsOffsets; }
+		UINT GetCapacity() const { return m_ByteWidth; }
+		const FrameStats& GetFrameStats() const { return m_FrameStats; }
+
+	private:
+		struct Allocation
+		{
+			UINT offset = 0;
+			UINT firstConstant = 0;
+			UINT numConstants = 0;
+		};
+
+		bool CreateRingBuffer(UINT capacity);
+		bool Allocate(const void* data, UINT dataSize, Allocation& outAllocation);
+		void RetireFrames();
+		bool BindFallbackVS(UINT slot, const void* data, UINT dataSize);
+
+		static UINT AlignUp(UINT size) { return (size + Alignment - 1) & ~(Alignment - 1); }
+
+	private:
+		bool m_SupportsOffsets = false;
+
+		// ring state, m_Used includes space lost when wrapping
+		UINT m_Head = 0;
+		UINT m_Used = 0;
+		UINT m_FrameBytes = 0;
+		bool m_NeedsDiscard = true;
+		UINT m_PendingCapacity = 0;
+
+		struct FrameFence
+		{
+			Microsoft::WRL::ComPtr<ID3D11Query> query;
+			UINT bytes = 0;       // ring space consumed by the frame
+			bool pending = false;
+		};
+		std::array<FrameFence, MaxFramesInFlight> m_FrameFences;
+		uint64_t m_FrameIndex = 0;
+
+		// fallback for runtimes without constant buffer offsetting
+		std::array<std::unique_ptr<RawBuffer>, D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT> m_FallbackBuffers;
+
+		FrameStats m_FrameStats;
+	};
+}
@@ -15,6 +15,8 @@ namespace DXEngine {
         DirectX::XMMATRIX Projection;
         DirectX::XMFLOAT3 cameraPosition;
         float time;
+        float lodFade = 0.0f;   // dithered cross-fade, see ApplyLODFade in common.hlsli
+        DirectX::XMFLOAT3 padding = {};
     };
 
     struct BoneMatrixBuffer
@@ -79,6 +79,6 @@ namespace DXEngine {
 
     void CubeMapTexture::Bind(UINT slot)
     {
-        RenderCommand::GetContext()->PSSetShaderResources(slot, 1, skyTextureView.GetAddressOf());
+        RenderCommand::SetShaderResource(ShaderStage::Pixel, slot, skyTextureView.Get());
     }
 }
\ No newline at end of file
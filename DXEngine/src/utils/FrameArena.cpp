@@ -0,0 +1,98 @@
+#include "dxpch.h"
+#include "FrameArena.h"
+
+namespace DXEngine
+{
+	FrameArena::FrameArena(size_t blockSize)
+		: m_BlockSize(blockSize > 0 ? blockSize : DefaultBlockSize)
+	{
+		m_Blocks.reserve(8);
+	}
+
+	void* FrameArena::Allocate(size_t size, size_t alignment)
+	{
+		if (size == 0)
+			return nullptr;
+
+		while (true)
+		{
+			if (m_Current < m_Blocks.size())
+			{
+				Block& block = m_Blocks[m_Current];
+				const uintptr_t base = reinterpret_cast<uintptr_t>(block.memory.get());
+				const uintptr_t aligned = (base + m_Offset + alignment - 1) & ~(uintptr_t(alignment) - 1);
+				const size_t end = static_cast<size_t>(aligned - base) + size;
+
+				if (end <= block.size)
+				{
+					m_BytesUsed += end - m_Offset;
+					m_Offset = end;
+					return reinterpret_cast<void*>(aligned);
+				}
+
+				// move on to the next block, keeping the tail of this one unused
+				if (m_Current + 1 < m_Blocks.size())
+				{
+					m_Current++;
+					m_Offset = 0;
+					continue;
+				}
+			}
+
+			if (!AddBlock(size + alignment))
+				return nullptr;
+
+			m_Current = m_Blocks.size() - 1;
+			m_Offset = 0;
+		}
+	}
+
+	void FrameArena::Reset()
+	{
+		m_HeapAllocations = 0;
+
+		if (m_Blocks.size() > 1)
+		{
+			const size_t total = GetCapacity();
+			m_Blocks.clear();
+			m_BlockSize = std::max(m_BlockSize, total);
+			AddBlock(m_BlockSize);
+		}
+
+		m_Current = 0;
+		m_Offset = 0;
+		m_BytesUsed = 0;
+	}
+
+	size_t FrameArena::GetCapacity() const
+	{
+		size_t capacity = 0;
+		for (const auto& block : m_Blocks)
+		{
+			capacity += block.size;
+		}
+		return capacity;
+	}
+
+	bool FrameArena::AddBlock(size_t minSize)
+	{
+		const size_t size = std::max(m_BlockSize, minSize);
+
+		Block block;
+		block.memory.reset(new (std::nothrow) std::byte[size]);
+		if (!block.memory)
+		{
+			OutputDebugStringA("Warning: Frame arena failed to allocate a block\n");
+			return false;
+		}
+		block.size = size;
+
+		if (m_Blocks.size() == m_Blocks.capacity())
+		{
+			m_HeapAllocations++;
+		}
+		m_Blocks.push_back(std::move(block));
+		m_HeapAllocations++;
+		return true;
+	}
+}
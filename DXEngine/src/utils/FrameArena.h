@@ -0,0 +1,53 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace DXEngine {
+
+	// Linear allocator for data that only lives for one frame. Allocation is a pointer bump,
+	// Reset() rewinds everything at once and no destructors are run.
+	class FrameArena
+	{
+	public:
+		static constexpr size_t DefaultBlockSize = 1024 * 1024;
+
+		explicit FrameArena(size_t blockSize = DefaultBlockSize);
+
+		void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+		template<typename T>
+		T* AllocateArray(size_t count)
+		{
+			static_assert(std::is_trivially_destructible_v<T>, "frame arena memory is never destructed");
+			return static_cast<T*>(Allocate(sizeof(T) * count, alignof(T)));
+		}
+
+		// Rewinds to the first block. If the last frame spilled into more blocks they are
+		// merged into a single one, so a frame of the same size fits without allocating.
+		void Reset();
+
+		size_t GetBytesUsed() const { return m_BytesUsed; }
+		size_t GetCapacity() const;
+		uint32_t GetHeapAllocations() const { return m_HeapAllocations; } // since the last Reset
+
+	private:
+		bool AddBlock(size_t minSize);
+
+	private:
+		struct Block
+		{
+			std::unique_ptr<std::byte[]> memory;
+			size_t size = 0;
+		};
+
+		std::vector<Block> m_Blocks;
+		size_t m_BlockSize = DefaultBlockSize;
+		size_t m_Current = 0;
+		size_t m_Offset = 0;
+		size_t m_BytesUsed = 0;
+		uint32_t m_HeapAllocations = 0;
+	};
+}
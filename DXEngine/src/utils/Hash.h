@@ -0,0 +1,41 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace DXEngine {
+
+	// 64-bit FNV-1a, used for IDs computed once when a resource is created
+	constexpr uint64_t HashSeed = 0xcbf29ce484222325ull;
+
+	inline uint64_t HashBytes(const void* data, size_t size, uint64_t hash = HashSeed)
+	{
+		const auto* bytes = static_cast<const uint8_t*>(data);
+		for (size_t i = 0; i < size; ++i)
+		{
+			hash ^= bytes[i];
+			hash *= 0x100000001b3ull;
+		}
+		return hash;
+	}
+
+	inline uint64_t HashString(std::string_view text, uint64_t hash = HashSeed)
+	{
+		return HashBytes(text.data(), text.size(), hash);
+	}
+
+	template<typename T>
+	inline uint64_t HashValue(const T& value, uint64_t hash = HashSeed)
+	{
+		return HashBytes(&value, sizeof(T), hash);
+	}
+
+	inline uint64_t HashCombine(uint64_t a, uint64_t b)
+	{
+		// splitmix style finalizer over both halves
+		uint64_t x = a ^ (b + 0x9e3779b97f4a7c15ull + (a << 6) + (a >> 2));
+		x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+		x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+		return x ^ (x >> 31);
+	}
+}
@@ -0,0 +1,91 @@
+#include "dxpch.h"
+#include "InstanceBuffer.h"
+
+namespace DXEngine
+{
+	bool InstanceBuffer::Update(const DirectX::XMFLOAT4X4* transforms, size_t count,
+		size_t dirtyBegin, size_t dirtyEnd, UINT* outBytesUploaded)
+	{
+		if (outBytesUploaded)
+			*outBytesUploaded = 0;
+
+		m_Count = count;
+		if (!transforms || count == 0)
+			return IsValid();
+
+		const UINT stride = GetStride();
+
+		// A new buffer is created with the full transform array as initial data
+		if (!m_Buffer || count > m_Capacity)
+		{
+			if (!Grow(transforms, count))
+				return false;
+
+			if (outBytesUploaded)
+				*outBytesUploaded = static_cast<UINT>(count * stride);
+			return true;
+		}
+
+		dirtyEnd = std::min(dirtyEnd, count);
+		if (dirtyBegin >= dirtyEnd)
+		{
+			dirtyBegin = 0;
+			dirtyEnd = count;
+		}
+
+		const UINT offset = static_cast<UINT>(dirtyBegin * stride);
+		const UINT size = static_cast<UINT>((dirtyEnd - dirtyBegin) * stride);
+		if (!UpdateInternal(transforms + dirtyBegin, size, offset))
+			return false;
+
+		if (outBytesUploaded)
+			*outBytesUploaded = size;
+		return true;
+	}
+
+	void InstanceBuffer::Bind(UINT slot) const
+	{
+		if (!m_Buffer)
+			return;
+
+		UINT stride = GetStride();
+		UINT offset = 0;
+		RenderCommand::SetVertexBuffers(slot, 1, m_Buffer.GetAddressOf(), &stride, &offset);
+	}
+
+	bool InstanceBuffer::Grow(const DirectX::XMFLOAT4X4* transforms, size_t count)
+	{
+		size_t newCapacity = std::max(m_Capacity, static_cast<size_t>(MinCapacity));
+		while (newCapacity < count)
+		{
+			newCapacity += newCapacity / 2;
+		}
+
+		// Initial data has to cover the whole buffer, so pad the tail when growing past count
+		std::vector<DirectX::XMFLOAT4X4> initialData;
+		const void* initialPtr = transforms;
+		if (newCapacity > count)
+		{
+			initialData.resize(newCapacity);
+			std::copy(transforms, transforms + count, initialData.begin());
+			initialPtr = initialData.data();
+		}
+
+		// Default usage so partial ranges can go through UpdateSubresource
+		BufferDesc desc;
+		desc.bufferType = BufferType::Vertex;
+		desc.usageType = UsageType::Default;
+		desc.byteWidth = static_cast<UINT>(newCapacity * GetStride());
+		desc.initialData = initialPtr;
+
+		if (!InitializeInternal(desc))
+		{
+			OutputDebugStringA("Warning: Failed to grow instance buffer\n");
+			m_Capacity = 0;
+			return false;
+		}
+
+		m_Capacity = newCapacity;
+		return true;
+	}
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include "Buffer.h"
+#include <DirectXMath.h>
+
+namespace DXEngine {
+
+	// Persistent per-instance transform stream. The GPU copy is kept between frames,
+	// grows geometrically and only the instances that changed are re-uploaded.
+	class InstanceBuffer : public BufferBase
+	{
+	public:
+		static constexpr UINT MinCapacity = 64;
+
+		InstanceBuffer() = default;
+
+		// Uploads [dirtyBegin, dirtyEnd) of transforms; an empty range uploads everything.
+		// Returns false if the GPU buffer could not be (re)created.
+		bool Update(const DirectX::XMFLOAT4X4* transforms, size_t count,
+			size_t dirtyBegin, size_t dirtyEnd, UINT* outBytesUploaded = nullptr);
+
+		void Bind(UINT slot) const;
+
+		UINT GetStride() const { return sizeof(DirectX::XMFLOAT4X4); }
+		size_t GetCapacity() const { return m_Capacity; }
+		size_t GetInstanceCount() const { return m_Count; }
+
+	private:
+		bool Grow(const DirectX::XMFLOAT4X4* transforms, size_t count);
+
+	private:
+		size_t m_Capacity = 0;
+		size_t m_Count = 0;
+	};
+}
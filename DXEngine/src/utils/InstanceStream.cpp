@@ -0,0 +1,113 @@
+#include "dxpch.h"
+#include "InstanceStream.h"
+
+namespace DXEngine
+{
+	namespace
+	{
+		constexpr UINT MaxStreamCapacity = 1024 * 1024; // instances, 64MB of transforms
+	}
+
+	bool InstanceStream::Initialize(UINT capacity)
+	{
+		Shutdown();
+		return CreateStreamBuffer(std::max(capacity, 1u));
+	}
+
+	void InstanceStream::Shutdown()
+	{
+		m_Buffer.Reset();
+		m_Capacity = 0;
+		m_Head = 0;
+		m_NeedsDiscard = true;
+		m_FrameStats = FrameStats{};
+	}
+
+	void InstanceStream::BeginFrame()
+	{
+		m_Head = 0;
+		m_NeedsDiscard = true;
+		m_FrameStats = FrameStats{};
+	}
+
+	bool InstanceStream::Append(const DirectX::XMFLOAT4X4* transforms, UINT count, UINT& outOffset)
+	{
+		outOffset = 0;
+		if (!transforms || count == 0)
+			return false;
+
+		if (count > m_Capacity)
+		{
+			// a single batch never fits, grow; the new buffer starts empty
+			UINT newCapacity = std::max(m_Capacity, 1u);
+			while (newCapacity < count && newCapacity < MaxStreamCapacity)
+			{
+				newCapacity *= 2;
+			}
+			if (count > newCapacity || !CreateStreamBuffer(newCapacity))
+			{
+				OutputDebugStringA("Warning: Failed to grow instance stream\n");
+				return false;
+			}
+		}
+
+		// out of space for this frame, let the driver rename the buffer and start over
+		if (m_Head + count > m_Capacity)
+		{
+			m_Head = 0;
+			m_NeedsDiscard = true;
+		}
+
+		const D3D11_MAP mapType = m_NeedsDiscard ? D3D11_MAP_WRITE_DISCARD : D3D11_MAP_WRITE_NO_OVERWRITE;
+
+		D3D11_MAPPED_SUBRESOURCE mappedResource;
+		HRESULT hr = RenderCommand::MapBuffer(m_Buffer.Get(), mapType, mappedResource);
+		if (FAILED(hr))
+			return false;
+
+		const UINT stride = GetStride();
+		memcpy(static_cast<char*>(mappedResource.pData) + m_Head * stride, transforms, count * stride);
+		RenderCommand::UnmapBuffer(m_Buffer.Get(), count * stride);
+
+		m_FrameStats.maps++;
+		if (m_NeedsDiscard)
+		{
+			m_FrameStats.discards++;
+			m_NeedsDiscard = false;
+		}
+
+		outOffset = m_Head * stride;
+		m_Head += count;
+		m_FrameStats.bytesUploaded += count * stride;
+		return true;
+	}
+
+	void InstanceStream::Bind(UINT slot, UINT offset) const
+	{
+		if (!m_Buffer)
+			return;
+
+		UINT stride = GetStride();
+		RenderCommand::SetVertexBuffers(slot, 1, m_Buffer.GetAddressOf(), &stride, &offset);
+	}
+
+	bool InstanceStream::CreateStreamBuffer(UINT capacity)
+	{
+		BufferDesc desc;
+		desc.bufferType = BufferType::Vertex;
+		desc.usageType = UsageType::Dynamic;
+		desc.byteWidth = capacity * GetStride();
+
+		if (!InitializeInternal(desc))
+		{
+			OutputDebugStringA("Warning: Failed to create instance stream buffer\n");
+			m_Capacity = 0;
+			return false;
+		}
+
+		m_Capacity = capacity;
+		m_Head = 0;
+		m_NeedsDiscard = true;
+		return true;
+	}
+}
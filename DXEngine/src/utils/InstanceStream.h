@@ -0,0 +1,47 @@
+#pragma once
+#include "Buffer.h"
+#include <DirectXMath.h>
+
+namespace DXEngine {
+
+	// Transient per-instance transform stream refilled every frame. Batches append their
+	// transforms into one dynamic vertex buffer and bind it at the returned offset.
+	class InstanceStream : public BufferBase
+	{
+	public:
+		static constexpr UINT DefaultCapacity = 4096; // instances
+
+		struct FrameStats
+		{
+			size_t bytesUploaded = 0;
+			uint32_t maps = 0;
+			uint32_t discards = 0;
+		};
+
+		InstanceStream() = default;
+
+		bool Initialize(UINT capacity = DefaultCapacity);
+		void Shutdown();
+
+		// the first append of a frame discards the previous contents
+		void BeginFrame();
+
+		// Copies count transforms into the stream, outOffset is the byte offset to bind at
+		bool Append(const DirectX::XMFLOAT4X4* transforms, UINT count, UINT& outOffset);
+		void Bind(UINT slot, UINT offset) const;
+
+		UINT GetStride() const { return sizeof(DirectX::XMFLOAT4X4); }
+		UINT GetCapacity() const { return m_Capacity; }
+		const FrameStats& GetFrameStats() const { return m_FrameStats; }
+
+	private:
+		bool CreateStreamBuffer(UINT capacity);
+
+	private:
+		UINT m_Capacity = 0;
+		UINT m_Head = 0;      // in instances
+		bool m_NeedsDiscard = true;
+
+		FrameStats m_FrameStats;
+	};
+}
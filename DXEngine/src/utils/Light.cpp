@@ -302,7 +302,7 @@ namespace DXEngine {
         }
 
         m_LightBuffer.Update(m_SceneData);
-        RenderCommand::GetContext()->PSSetConstantBuffers(BindSlot::CB_Scene_Lights, 1, m_LightBuffer.GetAddressOf());
+        RenderCommand::SetConstantBuffer(ShaderStage::Pixel, BindSlot::CB_Scene_Lights, m_LightBuffer.GetBuffer());
     }
     uint32_t LightManager::GetVisibleLightCount() const
     {
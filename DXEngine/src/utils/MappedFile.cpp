@@ -0,0 +1,91 @@
+#include "dxpch.h"
+#include "MappedFile.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace DXEngine {
+
+	MappedFile::~MappedFile()
+	{
+		Close();
+	}
+
+	bool MappedFile::Open(const std::string& path)
+	{
+		Close();
+
+#ifdef _WIN32
+		HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+			return false;
+		m_FileHandle = file;
+
+		LARGE_INTEGER fileSize = {};
+		if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart <= 0)
+		{
+			Close();
+			return false;
+		}
+
+		HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (!mapping)
+		{
+			Close();
+			return false;
+		}
+		m_MappingHandle = mapping;
+
+		m_Data = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+		m_Size = static_cast<size_t>(fileSize.QuadPart);
+#else
+		const int fd = open(path.c_str(), O_RDONLY);
+		if (fd < 0)
+			return false;
+
+		struct stat info = {};
+		if (fstat(fd, &info) != 0 || info.st_size <= 0)
+		{
+			close(fd);
+			return false;
+		}
+
+		void* view = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+		close(fd);
+		if (view == MAP_FAILED)
+			return false;
+
+		m_Data = static_cast<const uint8_t*>(view);
+		m_Size = static_cast<size_t>(info.st_size);
+#endif
+		if (!m_Data)
+		{
+			Close();
+			return false;
+		}
+		return true;
+	}
+
+	void MappedFile::Close()
+	{
+#ifdef _WIN32
+		if (m_Data)
+			UnmapViewOfFile(m_Data);
+		if (m_MappingHandle)
+			CloseHandle(static_cast<HANDLE>(m_MappingHandle));
+		if (m_FileHandle)
+			CloseHandle(static_cast<HANDLE>(m_FileHandle));
+#else
+		if (m_Data)
+			munmap(const_cast<uint8_t*>(m_Data), m_Size);
+#endif
+		m_Data = nullptr;
+		m_Size = 0;
+		m_FileHandle = nullptr;
+		m_MappingHandle = nullptr;
+	}
+}
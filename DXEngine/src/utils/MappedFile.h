@@ -0,0 +1,30 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace DXEngine {
+
+	// Read only view of a whole file, unmapped on Close or destruction
+	class MappedFile
+	{
+	public:
+		MappedFile() = default;
+		~MappedFile();
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		bool Open(const std::string& path);
+		void Close();
+
+		bool IsOpen() const { return m_Data != nullptr; }
+		const uint8_t* GetData() const { return m_Data; }
+		size_t GetSize() const { return m_Size; }
+
+	private:
+		const uint8_t* m_Data = nullptr;
+		size_t m_Size = 0;
+		void* m_FileHandle = nullptr;
+		void* m_MappingHandle = nullptr;
+	};
+}
@@ -6,12 +6,20 @@
 #include <sstream>
 #include <algorithm>
 #include "utils/Mesh/Utils/InputManager.h"
+#include "shaders/ShaderProgram.h"
+#include <atomic>
 
 
 namespace DXEngine {
 
    // ===== Mesh Implementation =====
 
+    uint32_t Mesh::GenerateID()
+    {
+        static std::atomic<uint32_t> s_NextID{ 1 };
+        return s_NextID.fetch_add(1, std::memory_order_relaxed);
+    }
+
     Mesh::Mesh(std::shared_ptr<MeshResource> resource)
         : m_Resource(resource)
         , m_GPUResourcesDirty(true)
@@ -85,7 +93,28 @@ namespace DXEngine {
         return m_Materials[submeshIndex];
     }
 
-    void Mesh::Bind(const void* shaderByteCode, size_t byteCodeLength) const
+    const VertexLayout* Mesh::GetInstancedLayout() const
+    {
+        if (!m_InstancedLayout && m_Resource && m_Resource->GetVertexData())
+        {
+            m_InstancedLayout = std::make_unique<VertexLayout>(
+                VertexLayout::CreateInstanced(m_Resource->GetVertexData()->GetLayout()));
+        }
+        return m_InstancedLayout.get();
+    }
+
+    const VertexLayout* Mesh::GetLayout(bool instanced) const
+    {
+        // instanced draws read the transform stream bound to slot 1
+        if (instanced)
+            return GetInstancedLayout();
+
+        if (m_Resource && m_Resource->GetVertexData())
+            return &m_Resource->GetVertexData()->GetLayout();
+        return nullptr;
+    }
+
+    void Mesh::Bind(const ShaderProgram* shader, bool instanced) const
     {
         if (!EnsureGPUResources())
             return;
@@ -93,24 +122,27 @@ namespace DXEngine {
         // Bind vertex buffers and index buffer
         m_Buffers.Bind();
 
-        // Set up input layout if shader bytecode is provided
-        if (shaderByteCode && byteCodeLength > 0 && m_Resource)
+        // Set up input layout if a shader is provided
+        VertexShader* vertexShader = shader ? shader->GetVertexShader() : nullptr;
+        if (vertexShader && vertexShader->GetByteCode())
         {
-            const VertexData* vertexData = m_Resource->GetVertexData();
-            if (vertexData)
+            const VertexLayout* layout = GetLayout(instanced);
+            if (layout)
             {
-                auto inputLayout = InputLayoutCache::Instance().GetInputLayout(
-                    vertexData->GetLayout(), shaderByteCode, byteCodeLength);
+                ID3DBlob* byteCode = vertexShader->GetByteCode();
+                ID3D11InputLayout* inputLayout = InputLayoutCache::Instance().GetInputLayout(
+                    *layout, vertexShader->GetByteCodeID(),
+                    byteCode->GetBufferPointer(), byteCode->GetBufferSize());
 
                 if (inputLayout)
                 {
-                    RenderCommand::GetContext()->IASetInputLayout(inputLayout.Get());
+                    RenderCommand::SetInputLayout(inputLayout);
                 }
                 else
                 {
                     // CRITICAL: Input layout creation failed!
                     OutputDebugStringA("ERROR: Failed to create input layout - vertex layout doesn't match shader!\n");
-                    OutputDebugStringA(("Vertex Layout: " + vertexData->GetLayout().GetDebugString() + "\n").c_str());
+                    OutputDebugStringA(("Vertex Layout: " + layout->GetDebugString() + "\n").c_str());
                     return; // Don't proceed with rendering
                 }
             }
@@ -126,7 +158,7 @@ namespace DXEngine {
         case PrimitiveTopology::LineStrip: topology = D3D11_PRIMITIVE_TOPOLOGY_LINESTRIP; break;
         case PrimitiveTopology::PointList: topology = D3D11_PRIMITIVE_TOPOLOGY_POINTLIST; break;
         }
-        RenderCommand::GetContext()->IASetPrimitiveTopology(topology);
+        RenderCommand::SetPrimitiveTopology(topology);
     }
 
     void Mesh::Draw(size_t submeshIndex) const
@@ -143,7 +175,7 @@ namespace DXEngine {
 
             if (m_Buffers.GetIndexCount() > 0)
             {
-                RenderCommand::GetContext()->DrawIndexed(
+                RenderCommand::DrawIndexed(
                     submesh.indexCount,
                     submesh.indexStart,
                     submesh.vertexStart
@@ -151,7 +183,7 @@ namespace DXEngine {
             }
             else
             {
-                RenderCommand::GetContext()->Draw(
+                RenderCommand::Draw(
                     submesh.vertexCount,
                     submesh.vertexStart
                 );
@@ -162,7 +194,7 @@ namespace DXEngine {
             // Draw entire mesh
             if (m_Buffers.GetIndexCount() > 0)
             {
-                RenderCommand::GetContext()->DrawIndexed(
+                RenderCommand::DrawIndexed(
                     static_cast<UINT>(m_Buffers.GetIndexCount()),
                     0,
                     0
@@ -170,7 +202,7 @@ namespace DXEngine {
             }
             else
             {
-                RenderCommand::GetContext()->Draw(
+                RenderCommand::Draw(
                     static_cast<UINT>(m_Buffers.GetVertexCount()),
                     0
                 );
@@ -222,7 +254,7 @@ namespace DXEngine {
 
             if (m_Buffers.GetIndexCount() > 0)
             {
-                RenderCommand::GetContext()->DrawIndexedInstanced(
+                RenderCommand::DrawIndexedInstanced(
                     submesh.indexCount,
                     instanceCount,
                     submesh.indexStart,
@@ -232,7 +264,7 @@ namespace DXEngine {
             }
             else
             {
-                RenderCommand::GetContext()->DrawInstanced(
+                RenderCommand::DrawInstanced(
                     submesh.vertexCount,
                     instanceCount,
                     submesh.vertexStart,
@@ -244,7 +276,7 @@ namespace DXEngine {
         {
             if (m_Buffers.GetIndexCount() > 0)
             {
-                RenderCommand::GetContext()->DrawIndexedInstanced(
+                RenderCommand::DrawIndexedInstanced(
                     static_cast<UINT>(m_Buffers.GetIndexCount()),
                     instanceCount,
                     0,
@@ -254,7 +286,7 @@ namespace DXEngine {
             }
             else
             {
-                RenderCommand::GetContext()->DrawInstanced(
+                RenderCommand::DrawInstanced(
                     static_cast<UINT>(m_Buffers.GetVertexCount()),
                     instanceCount,
                     0,
@@ -294,6 +326,20 @@ namespace DXEngine {
         return m_Resource ? m_Resource->GetBoundingBox() : emptyBox;
     }
 
+    BoundingBox Mesh::GetSubmeshBounds(size_t submeshIndex) const
+    {
+        if (m_Resource && submeshIndex < m_Resource->GetSubMeshCount())
+            return m_Resource->GetSubMesh(submeshIndex).bounds;
+        return GetBoundingBox();
+    }
+
+    size_t Mesh::GetSubmeshIndexCount(size_t submeshIndex) const
+    {
+        if (m_Resource && submeshIndex < m_Resource->GetSubMeshCount())
+            return m_Resource->GetSubMesh(submeshIndex).indexCount;
+        return (m_Resource && m_Resource->GetIndexData()) ? m_Resource->GetIndexData()->GetIndexCount() : 0;
+    }
+
     const BoundingSphere& Mesh::GetBoundingSphere() const
     {
         static BoundingSphere emptySphere;
@@ -352,6 +398,7 @@ namespace DXEngine {
     void Mesh::InvalidateGPUResources()
     {
         m_GPUResourcesDirty = true;
+        m_InstancedLayout.reset();
     }
 
     void Mesh::EnsureMaterialSlots()
@@ -11,6 +11,7 @@
 namespace DXEngine {
 	class Material;
 	class InputLayout;
+	class ShaderProgram;
       
     // Main Mesh class - represents a renderable mesh
     class Mesh
@@ -19,6 +20,9 @@ namespace DXEngine {
         explicit Mesh(std::shared_ptr<MeshResource> resource);
         virtual ~Mesh() = default;
 
+        //stable identifier used for draw sorting
+        uint32_t GetID() const { return m_ID; }
+
         // Resource management
         const std::shared_ptr<MeshResource>& GetResource() const { return m_Resource; }
         void SetResource(std::shared_ptr<MeshResource> resource);
@@ -27,6 +31,8 @@ namespace DXEngine {
         bool EnsureGPUResources()const;
         void ReleaseGPUResources();
         const MeshBuffers& GetBuffers() const { return m_Buffers; }
+        const VertexLayout* GetInstancedLayout() const;  // vertex layout + per-instance transform on slot 1
+        const VertexLayout* GetLayout(bool instanced = false) const;
 
         // Material management
         void SetMaterial(std::shared_ptr<Material> material);
@@ -35,7 +41,8 @@ namespace DXEngine {
         const std::vector<std::shared_ptr<Material>>& GetMaterials() const { return m_Materials; }
 
         // Rendering
-        void Bind(const void* shaderByteCode = nullptr, size_t byteCodeLength = 0) const;
+        // without a shader only buffers and topology are bound (the pipeline state supplies the input layout)
+        void Bind(const ShaderProgram* shader = nullptr, bool instanced = false) const;
         void Draw(size_t submeshIndex = 0) const;
         void DrawAll() const;  // Draw all submeshes
         void DrawInstanced(uint32_t instanceCount, size_t submeshIndex = 0) const;
@@ -50,6 +57,10 @@ namespace DXEngine {
         // Bounding information
         const BoundingBox& GetBoundingBox() const;
         const BoundingSphere& GetBoundingSphere() const;
+        // Local box of one submesh, the whole mesh's box when it has no submeshes
+        BoundingBox GetSubmeshBounds(size_t submeshIndex) const;
+        // Indices drawn for one submesh, the whole index buffer when it has no submeshes
+        size_t GetSubmeshIndexCount(size_t submeshIndex) const;
 
         // Debug
         std::string GetDebugInfo() const;
@@ -67,14 +78,17 @@ namespace DXEngine {
         virtual void OnMaterialChanged(size_t submeshIndex);
 
     private:
+        static uint32_t GenerateID();
         void InvalidateGPUResources();
         void EnsureMaterialSlots();
 
     private:
+        uint32_t m_ID = GenerateID();
         std::shared_ptr<MeshResource> m_Resource;
         mutable MeshBuffers m_Buffers;
         std::vector<std::shared_ptr<Material>> m_Materials;
         mutable bool m_GPUResourcesDirty = true;
+        mutable std::unique_ptr<VertexLayout> m_InstancedLayout;
     };
 
    
@@ -108,6 +122,18 @@ namespace DXEngine {
             void OptimizeVertexCache(IndexData& indices);
             void OptimizeVertexFetch(VertexData& vertices, IndexData& indices);
 
+            // Mesh simplification
+            struct SimplifyOptions
+            {
+                float targetRatio = 0.5f;   // fraction of the triangles to keep
+                float maxError = 0.01f;     // largest allowed deviation, relative to the mesh extent
+            };
+
+            // Quadric error edge collapse onto existing vertices, so attributes stay exact. UV, normal
+            // and skinning seams and submesh boundaries keep their shape, and every submesh keeps its
+            // slot and material index. Returns null for non indexed or non triangle list meshes.
+            std::shared_ptr<MeshResource> SimplifyMesh(const MeshResource& source, const SimplifyOptions& options = {});
+
             // Validation
             bool ValidateMesh(const MeshResource& resource, std::string& errorMessage);
         }
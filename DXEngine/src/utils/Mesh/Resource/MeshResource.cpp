@@ -140,6 +140,7 @@ namespace DXEngine
     void MeshResource::AddSubMesh(const SubMesh& submesh)
     {
         m_SubMeshes.push_back(submesh);
+        ComputeSubMeshBounds(m_SubMeshes.back());
     }
 
     void MeshResource::AddSubMesh(const std::string& name, uint32_t indexStart, uint32_t indexCount, uint32_t materialIndex)
@@ -197,9 +198,49 @@ namespace DXEngine
         m_BoundingSphere = BoundingSphere(center, sqrtf(maxRadiusSquared));
         m_BoundsDirty = false;
 
+        ComputeSubMeshBounds();
         OnBoundsChanged();
     }
 
+    void MeshResource::ComputeSubMeshBounds()
+    {
+        for (SubMesh& submesh : m_SubMeshes)
+        {
+            ComputeSubMeshBounds(submesh);
+        }
+    }
+
+    void MeshResource::ComputeSubMeshBounds(SubMesh& submesh) const
+    {
+        submesh.bounds = BoundingBox();
+        if (!m_VertexData || !m_VertexData->GetLayout().FindAttribute(VertexAttributeType::Position))
+            return;
+
+        const size_t vertexCount = m_VertexData->GetVertexCount();
+        auto expand = [&](size_t vertex)
+            {
+                if (vertex < vertexCount)
+                    submesh.bounds.Expand(m_VertexData->GetAttribute<DirectX::XMFLOAT3>(vertex, VertexAttributeType::Position));
+            };
+
+        //indices are relative to vertexStart, the same base vertex the draw uses
+        if (m_IndexData && submesh.indexCount > 0)
+        {
+            const size_t indexEnd = std::min(static_cast<size_t>(submesh.indexStart) + submesh.indexCount, m_IndexData->GetIndexCount());
+            for (size_t i = submesh.indexStart; i < indexEnd; ++i)
+            {
+                expand(static_cast<size_t>(submesh.vertexStart) + m_IndexData->GetIndex(i));
+            }
+        }
+        else
+        {
+            for (size_t i = 0; i < submesh.vertexCount; ++i)
+            {
+                expand(static_cast<size_t>(submesh.vertexStart) + i);
+            }
+        }
+    }
+
     void MeshResource::SetBounds(const BoundingBox& box, const BoundingSphere& sphere)
     {
         m_BoundingBox = box;
@@ -113,6 +113,9 @@ namespace DXEngine
 		const BoundingSphere& GetBoundingSphere() const { return m_BoundingSphere; }
 		void ComputeBounds();
 		void SetBounds(const BoundingBox& box, const BoundingSphere& sphere);
+		// SubMesh::bounds from the vertices each submesh references; ComputeBounds and
+		// AddSubMesh run it, so loaded meshes always carry per-submesh bounds
+		void ComputeSubMeshBounds();
 
 		// Utility methods
 		bool IsValid() const;
@@ -151,6 +154,7 @@ namespace DXEngine
 
 	private:
 		void InvalidateBounds();
+		void ComputeSubMeshBounds(SubMesh& submesh) const;
 
 	private:
 		std::string m_Name;
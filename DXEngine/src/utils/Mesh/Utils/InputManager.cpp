@@ -15,20 +15,22 @@ namespace DXEngine {
         return instance;
     }
 
-    Microsoft::WRL::ComPtr<ID3D11InputLayout> InputLayoutCache::GetInputLayout(
+    ID3D11InputLayout* InputLayoutCache::GetInputLayout(
         const VertexLayout& vertexLayout,
+        uint64_t shaderID,
         const void* shaderByteCode,
         size_t byteCodeLength)
     {
-        // Create cache key
-        LayoutKey key;
-        key.vertexLayoutHash = std::hash<std::string>{}(vertexLayout.GetDebugString());
-        key.shaderHash = std::hash<std::string>{}(std::string((const char*)shaderByteCode, byteCodeLength));
+        assert(vertexLayout.IsFinalized() && "Layout must be finalized");
 
         // Check cache
+        const LayoutKey key{ vertexLayout.GetID(), shaderID };
         auto it = m_Cache.find(key);
         if (it != m_Cache.end())
-            return it->second;
+            return it->second.Get();
+
+        if (!shaderByteCode || byteCodeLength == 0)
+            return nullptr;
 
         // Create new input layout
         auto elements = vertexLayout.CreateD3D11InputElements();
@@ -50,7 +52,7 @@ namespace DXEngine {
 
         // Cache and return
         m_Cache[key] = inputLayout;
-        return inputLayout;
+        return inputLayout.Get();
     }
 
     void InputLayoutCache::ClearCache()
@@ -1,6 +1,7 @@
 #pragma once
 #include "VertexAttribute.h"
 #include "renderer/RendererCommand.h"
+#include "utils/Hash.h"
 #include <memory>
 #include <unordered_map>
 #include <functional>
@@ -13,25 +14,28 @@ namespace DXEngine {
     public:
         static InputLayoutCache& Instance();
 
-        // Get or create input layout for vertex layout + shader combination
-        Microsoft::WRL::ComPtr<ID3D11InputLayout> GetInputLayout(
+        // Get or create input layout for vertex layout + shader combination. Keyed by the
+        // layout ID and the vertex shader bytecode ID, the bytecode is only read on a miss.
+        ID3D11InputLayout* GetInputLayout(
             const VertexLayout& vertexLayout,
+            uint64_t shaderID,
             const void* shaderByteCode,
             size_t byteCodeLength);
 
         void ClearCache();
+        size_t GetCacheSize() const { return m_Cache.size(); }
 
     private:
         InputLayoutCache() = default;
 
         struct LayoutKey
         {
-            size_t vertexLayoutHash;
-            size_t shaderHash;
+            uint64_t vertexLayoutID;
+            uint64_t shaderID;
 
             bool operator==(const LayoutKey& other) const
             {
-                return vertexLayoutHash == other.vertexLayoutHash && shaderHash == other.shaderHash;
+                return vertexLayoutID == other.vertexLayoutID && shaderID == other.shaderID;
             }
         };
 
@@ -39,7 +43,7 @@ namespace DXEngine {
         {
             size_t operator()(const LayoutKey& key) const
             {
-                return key.vertexLayoutHash ^ (key.shaderHash << 1);
+                return static_cast<size_t>(HashCombine(key.vertexLayoutID, key.shaderID));
             }
         };
 
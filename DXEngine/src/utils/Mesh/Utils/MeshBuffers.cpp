@@ -165,10 +165,13 @@ namespace DXEngine
             maxSlot = std::max(maxSlot, slot);
         }
 
-        // Create arrays for binding
-        std::vector<ID3D11Buffer*> buffers(maxSlot + 1, nullptr);
-        std::vector<UINT> strides(maxSlot + 1, 0);
-        std::vector<UINT> offsets(maxSlot + 1, 0);
+        if (startSlot + maxSlot >= D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT)
+            return;
+
+        // Create arrays for binding, on the stack since this runs for every draw
+        ID3D11Buffer* buffers[D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT] = {};
+        UINT strides[D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT] = {};
+        UINT offsets[D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT] = {};
 
         for (const auto& [slot, data] : m_VertexBuffers)
         {
@@ -177,20 +180,14 @@ namespace DXEngine
             offsets[slot] = data.offset;
         }
 
-        RenderCommand::GetContext()->IASetVertexBuffers(
-            startSlot,
-            static_cast<UINT>(buffers.size()),
-            buffers.data(),
-            strides.data(),
-            offsets.data()
-        );
+        RenderCommand::SetVertexBuffers(startSlot, maxSlot + 1, buffers, strides, offsets);
     }
 
     void MeshBuffers::BindIndexBuffer() const
     {
         if (!m_IndexBuffer)
             return;
-        RenderCommand::GetContext()->IASetIndexBuffer(m_IndexBuffer->GetBuffer(), m_IndexBuffer->GetFormat(), 0);
+        RenderCommand::SetIndexBuffer(m_IndexBuffer->GetBuffer(), m_IndexBuffer->GetFormat(), 0);
     }
 
     void MeshBuffers::Release()
@@ -0,0 +1,653 @@
+#include "dxpch.h"
+#include "utils/Mesh/Mesh.h"
+#include "utils/Mesh/Resource/MeshResource.h"
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+namespace DXEngine
+{
+    namespace MeshUtils
+    {
+        namespace
+        {
+            constexpr uint32_t NoVertex = ~0u;
+
+            // Manifold vertices go anywhere, border and seam vertices only slide along their own
+            // open edge loop, locked vertices (corners, submesh junctions, complex fans) stay put
+            enum VertexKind : uint8_t { Manifold, Border, Seam, Locked, KindCount };
+
+            constexpr bool CanCollapse[KindCount][KindCount] = {
+                { true,  true,  true,  true  },
+                { false, true,  false, false },
+                { false, false, true,  false },
+                { false, false, false, false },
+            };
+
+            // edges between these kinds appear in two triangles, only one half is considered
+            constexpr bool HasOpposite[KindCount][KindCount] = {
+                { true,  true,  true,  false },
+                { true,  false, true,  false },
+                { true,  true,  true,  false },
+                { false, false, false, false },
+            };
+
+            // open edges weigh this much more than faces, keeps borders and seams in shape
+            constexpr float EdgeQuadricWeight = 10.0f;
+
+            struct Position
+            {
+                float x, y, z;
+            };
+
+            // symmetric 4x4 plane quadric, error(p) = p^T A p + 2 b.p + c, w is the summed area
+            struct Quadric
+            {
+                float a00, a11, a22, a01, a02, a12;
+                float b0, b1, b2, c;
+                float w;
+            };
+
+            Quadric PlaneQuadric(float a, float b, float c, float d, float weight)
+            {
+                Quadric q;
+                q.a00 = a * a * weight;
+                q.a11 = b * b * weight;
+                q.a22 = c * c * weight;
+                q.a01 = a * b * weight;
+                q.a02 = a * c * weight;
+                q.a12 = b * c * weight;
+                q.b0 = a * d * weight;
+                q.b1 = b * d * weight;
+                q.b2 = c * d * weight;
+                q.c = d * d * weight;
+                q.w = weight;
+                return q;
+            }
+
+            void AddQuadric(Quadric& q, const Quadric& r)
+            {
+                q.a00 += r.a00; q.a11 += r.a11; q.a22 += r.a22;
+                q.a01 += r.a01; q.a02 += r.a02; q.a12 += r.a12;
+                q.b0 += r.b0; q.b1 += r.b1; q.b2 += r.b2;
+                q.c += r.c;
+                q.w += r.w;
+            }
+
+            // mean squared distance to the accumulated planes
+            float QuadricError(const Quadric& q, const Position& p)
+            {
+                const float rx = q.a00 * p.x + 2.0f * (q.a01 * p.y + q.a02 * p.z + q.b0);
+                const float ry = q.a11 * p.y + 2.0f * (q.a12 * p.z + q.b1);
+                const float rz = q.a22 * p.z + 2.0f * q.b2;
+                const float error = std::fabs(p.x * rx + p.y * ry + p.z * rz + q.c);
+                return q.w > 0.0f ? error / q.w : 0.0f;
+            }
+
+            Position Add(const Position& a, const Position& b) { return { a.x + b.x, a.y + b.y, a.z + b.z }; }
+            Position Sub(const Position& a, const Position& b) { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+            Position Cross(const Position& a, const Position& b) { return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x }; }
+            float Dot(const Position& a, const Position& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+
+            // per vertex lists in one array: for every corner the other two vertices in winding order
+            struct VertexFans
+            {
+                struct Corner
+                {
+                    uint32_t next;
+                    uint32_t prev;
+                    uint32_t triangle;
+                };
+
+                std::vector<uint32_t> offsets;
+                std::vector<Corner> corners;
+
+                void Build(const std::vector<uint32_t>& indices, size_t vertexCount, const uint32_t* remap = nullptr)
+                {
+                    offsets.assign(vertexCount + 1, 0);
+                    for (uint32_t index : indices)
+                    {
+                        offsets[(remap ? remap[index] : index) + 1]++;
+                    }
+                    for (size_t i = 0; i < vertexCount; ++i)
+                    {
+                        offsets[i + 1] += offsets[i];
+                    }
+
+                    corners.resize(indices.size());
+                    std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+                    for (size_t i = 0; i < indices.size(); i += 3)
+                    {
+                        for (int e = 0; e < 3; ++e)
+                        {
+                            const uint32_t vertex = indices[i + e];
+                            const uint32_t slot = fill[remap ? remap[vertex] : vertex]++;
+                            corners[slot] = { indices[i + (e + 1) % 3], indices[i + (e + 2) % 3], static_cast<uint32_t>(i / 3) };
+                        }
+                    }
+                }
+
+                bool HasEdge(uint32_t from, uint32_t to) const
+                {
+                    for (uint32_t i = offsets[from]; i < offsets[from + 1]; ++i)
+                    {
+                        if (corners[i].next == to)
+                            return true;
+                    }
+                    return false;
+                }
+            };
+
+            struct Collapse
+            {
+                uint32_t v0;      // moves onto v1
+                uint32_t v1;
+                float error;
+                bool bidirectional;
+            };
+
+            // groups vertices sharing a position, remap points at the first one and wedge links
+            // every vertex of a position into a cycle
+            void BuildPositionRemap(const std::vector<Position>& positions, std::vector<uint32_t>& remap, std::vector<uint32_t>& wedge)
+            {
+                const size_t vertexCount = positions.size();
+                size_t tableSize = 1;
+                while (tableSize < vertexCount * 2)
+                    tableSize <<= 1;
+
+                std::vector<uint32_t> table(tableSize, NoVertex);
+                remap.resize(vertexCount);
+                wedge.resize(vertexCount);
+
+                for (uint32_t v = 0; v < vertexCount; ++v)
+                {
+                    uint32_t bits[3];
+                    std::memcpy(bits, &positions[v], sizeof(bits));
+                    uint32_t hash = (bits[0] * 73856093u) ^ (bits[1] * 19349663u) ^ (bits[2] * 83492791u);
+
+                    size_t slot = hash & (tableSize - 1);
+                    while (table[slot] != NoVertex && std::memcmp(&positions[table[slot]], &positions[v], sizeof(Position)) != 0)
+                    {
+                        slot = (slot + 1) & (tableSize - 1);
+                    }
+                    if (table[slot] == NoVertex)
+                        table[slot] = v;
+
+                    const uint32_t leader = table[slot];
+                    remap[v] = leader;
+                    wedge[v] = v;
+                    if (leader != v)
+                    {
+                        wedge[v] = wedge[leader];
+                        wedge[leader] = v;
+                    }
+                }
+            }
+
+            void ClassifyVertices(const VertexFans& fans, const std::vector<uint32_t>& remap, const std::vector<uint32_t>& wedge,
+                const std::vector<uint8_t>& sharedBySubmeshes, std::vector<uint8_t>& kinds, std::vector<uint32_t>& openOut)
+            {
+                const size_t vertexCount = remap.size();
+                std::vector<uint32_t> openIn(vertexCount, NoVertex);
+                openOut.assign(vertexCount, NoVertex);
+
+                //an open edge has no reverse half, a vertex with several in one direction marks itself
+                for (uint32_t v = 0; v < vertexCount; ++v)
+                {
+                    for (uint32_t i = fans.offsets[v]; i < fans.offsets[v + 1]; ++i)
+                    {
+                        const uint32_t target = fans.corners[i].next;
+                        if (fans.HasEdge(target, v))
+                            continue;
+                        openOut[v] = openOut[v] == NoVertex ? target : v;
+                        openIn[target] = openIn[target] == NoVertex ? v : target;
+                    }
+                }
+
+                kinds.assign(vertexCount, Locked);
+                for (uint32_t v = 0; v < vertexCount; ++v)
+                {
+                    if (remap[v] != v)
+                    {
+                        kinds[v] = kinds[remap[v]];
+                        continue;
+                    }
+
+                    const auto single = [&](uint32_t value, uint32_t self) { return value != NoVertex && value != self; };
+                    uint8_t kind = Locked;
+                    if (wedge[v] == v)
+                    {
+                        if (openIn[v] == NoVertex && openOut[v] == NoVertex)
+                            kind = Manifold;
+                        else if (single(openIn[v], v) && single(openOut[v], v))
+                            kind = Border;
+                    }
+                    else if (wedge[wedge[v]] == v)
+                    {
+                        //two wedges whose open edges run in opposite directions along the same positions
+                        const uint32_t w = wedge[v];
+                        if (single(openIn[v], v) && single(openOut[v], v) && single(openIn[w], w) && single(openOut[w], w) &&
+                            remap[openIn[v]] == remap[openOut[w]] && remap[openOut[v]] == remap[openIn[w]])
+                            kind = Seam;
+                    }
+
+                    if (sharedBySubmeshes[v])
+                        kind = Locked;
+                    kinds[v] = kind;
+                }
+            }
+
+            void ComputeQuadrics(const std::vector<uint32_t>& indices, const std::vector<Position>& positions, const std::vector<uint32_t>& remap,
+                const std::vector<uint8_t>& kinds, const VertexFans& fans, std::vector<Quadric>& quadrics)
+            {
+                quadrics.assign(positions.size(), Quadric{});
+                for (size_t i = 0; i < indices.size(); i += 3)
+                {
+                    const uint32_t tri[3] = { indices[i], indices[i + 1], indices[i + 2] };
+                    const Position& p0 = positions[tri[0]];
+                    Position normal = Cross(Sub(positions[tri[1]], p0), Sub(positions[tri[2]], p0));
+                    const float length = std::sqrt(Dot(normal, normal));
+                    if (length <= 0.0f)
+                        continue;
+                    normal = { normal.x / length, normal.y / length, normal.z / length };
+
+                    const Quadric face = PlaneQuadric(normal.x, normal.y, normal.z, -Dot(normal, p0), length * 0.5f);
+                    for (uint32_t vertex : tri)
+                    {
+                        AddQuadric(quadrics[remap[vertex]], face);
+                    }
+
+                    //planes through open border and seam edges, perpendicular to the face
+                    for (int e = 0; e < 3; ++e)
+                    {
+                        const uint32_t a = tri[e];
+                        const uint32_t b = tri[(e + 1) % 3];
+                        if ((kinds[a] != Border && kinds[a] != Seam && kinds[b] != Border && kinds[b] != Seam) || fans.HasEdge(b, a))
+                            continue;
+
+                        const Position edge = Sub(positions[b], positions[a]);
+                        const float edgeLength = std::sqrt(Dot(edge, edge));
+                        Position side = Cross(edge, normal);
+                        const float sideLength = std::sqrt(Dot(side, side));
+                        if (sideLength <= 0.0f)
+                            continue;
+                        side = { side.x / sideLength, side.y / sideLength, side.z / sideLength };
+
+                        const Quadric border = PlaneQuadric(side.x, side.y, side.z, -Dot(side, positions[a]), edgeLength * EdgeQuadricWeight);
+                        AddQuadric(quadrics[remap[a]], border);
+                        AddQuadric(quadrics[remap[b]], border);
+                    }
+                }
+            }
+
+            // orders collapses by error with two 16 bit radix passes, errors are non-negative floats
+            void SortCollapses(const std::vector<Collapse>& collapses, std::vector<uint32_t>& order, std::vector<uint32_t>& scratch)
+            {
+                const size_t count = collapses.size();
+                order.resize(count);
+                scratch.resize(count);
+
+                std::vector<uint32_t> keys(count);
+                for (size_t i = 0; i < count; ++i)
+                {
+                    std::memcpy(&keys[i], &collapses[i].error, sizeof(uint32_t));
+                    scratch[i] = static_cast<uint32_t>(i);
+                }
+
+                std::vector<uint32_t> histogram(1 << 16);
+                for (int shift = 0; shift < 32; shift += 16)
+                {
+                    std::fill(histogram.begin(), histogram.end(), 0u);
+                    for (uint32_t key : keys)
+                    {
+                        histogram[(key >> shift) & 0xFFFF]++;
+                    }
+                    uint32_t sum = 0;
+                    for (auto& bucket : histogram)
+                    {
+                        const uint32_t bucketCount = bucket;
+                        bucket = sum;
+                        sum += bucketCount;
+                    }
+                    for (uint32_t index : scratch)
+                    {
+                        order[histogram[(keys[index] >> shift) & 0xFFFF]++] = index;
+                    }
+                    std::swap(order, scratch);
+                }
+                std::swap(order, scratch);
+            }
+
+            // true when moving r0 onto r1 turns a face around r0 by more than about 75 degrees, either
+            // in this step or away from the normal the face had in the source mesh; the second check
+            // keeps small turns from adding up over passes until the face points backwards. A face that
+            // drifted across the surface may still match its own source face, so it must also face the
+            // same side as the source vertex normals at its new corners
+            bool HasTriangleFlips(const VertexFans& positionFans, const std::vector<Position>& positions, const std::vector<Position>& faceNormals,
+                const std::vector<Position>& vertexNormals, const std::vector<uint32_t>& remap, const std::vector<uint32_t>& collapseRemap,
+                uint32_t r0, uint32_t r1)
+            {
+                const Position& from = positions[r0];
+                const Position& to = positions[r1];
+                for (uint32_t i = positionFans.offsets[r0]; i < positionFans.offsets[r0 + 1]; ++i)
+                {
+                    const uint32_t b = remap[collapseRemap[positionFans.corners[i].next]];
+                    const uint32_t c = remap[collapseRemap[positionFans.corners[i].prev]];
+                    if (b == r1 || c == r1 || b == c)
+                        continue;
+
+                    const Position before = Cross(Sub(positions[b], from), Sub(positions[c], from));
+                    const Position after = Cross(Sub(positions[b], to), Sub(positions[c], to));
+                    const float afterLength = std::sqrt(Dot(after, after));
+                    if (Dot(before, after) <= 0.25f * std::sqrt(Dot(before, before)) * afterLength)
+                        return true;
+                    if (Dot(faceNormals[positionFans.corners[i].triangle], after) <= 0.25f * afterLength)
+                        return true;
+                    if (Dot(Add(vertexNormals[r1], Add(vertexNormals[b], vertexNormals[c])), after) < 0.0f)
+                        return true;
+                }
+                return false;
+            }
+        }
+
+        std::shared_ptr<MeshResource> SimplifyMesh(const MeshResource& source, const SimplifyOptions& options)
+        {
+            const VertexData* vertexData = source.GetVertexData();
+            const IndexData* indexData = source.GetIndexData();
+            if (!vertexData || !source.HasIndices() || source.GetTopology() != PrimitiveTopology::TriangleList)
+                return nullptr;
+
+            const VertexLayout& layout = vertexData->GetLayout();
+            const VertexAttribute* positionAttribute = layout.FindAttribute(VertexAttributeType::Position);
+            if (!positionAttribute || (positionAttribute->Format != DataFormat::Float3 && positionAttribute->Format != DataFormat::Float4))
+                return nullptr;
+
+            //positions normalized to a unit box, so errors are relative to the mesh extent
+            const size_t vertexCount = vertexData->GetVertexCount();
+            const uint32_t positionStride = layout.GetStride(positionAttribute->Slot);
+            const uint8_t* positionBytes = static_cast<const uint8_t*>(vertexData->GetVertexData(positionAttribute->Slot)) + positionAttribute->Offset;
+            std::vector<Position> positions(vertexCount);
+            Position lower = { FLT_MAX, FLT_MAX, FLT_MAX };
+            Position upper = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+            for (size_t v = 0; v < vertexCount; ++v)
+            {
+                std::memcpy(&positions[v], positionBytes + v * positionStride, sizeof(Position));
+                lower = { std::min(lower.x, positions[v].x), std::min(lower.y, positions[v].y), std::min(lower.z, positions[v].z) };
+                upper = { std::max(upper.x, positions[v].x), std::max(upper.y, positions[v].y), std::max(upper.z, positions[v].z) };
+            }
+            const float extent = std::max({ upper.x - lower.x, upper.y - lower.y, upper.z - lower.z });
+            const float scale = extent > 0.0f ? 1.0f / extent : 1.0f;
+            for (auto& p : positions)
+            {
+                p = { (p.x - lower.x) * scale, (p.y - lower.y) * scale, (p.z - lower.z) * scale };
+            }
+
+            //triangles in absolute vertex indices, grouped by submesh; indices outside every submesh are never drawn
+            const auto& submeshes = source.GetSubMeshes();
+            const size_t groupCount = std::max<size_t>(1, submeshes.size());
+            std::vector<uint32_t> indices;
+            std::vector<uint32_t> groupTriangles(groupCount, 0);
+            std::vector<uint32_t> vertexGroup(vertexCount, NoVertex);
+            std::vector<uint8_t> sharedBySubmeshes(vertexCount, 0);
+            indices.reserve(indexData->GetIndexCount());
+            for (size_t group = 0; group < groupCount; ++group)
+            {
+                size_t start = 0;
+                size_t end = indexData->GetIndexCount();
+                uint32_t baseVertex = 0;
+                if (!submeshes.empty())
+                {
+                    start = submeshes[group].indexStart;
+                    end = std::min(end, start + submeshes[group].indexCount);
+                    baseVertex = submeshes[group].vertexStart;
+                }
+
+                for (size_t i = start; i + 2 < end; i += 3)
+                {
+                    const uint32_t tri[3] = { baseVertex + indexData->GetIndex(i), baseVertex + indexData->GetIndex(i + 1), baseVertex + indexData->GetIndex(i + 2) };
+                    if (tri[0] >= vertexCount || tri[1] >= vertexCount || tri[2] >= vertexCount ||
+                        tri[0] == tri[1] || tri[1] == tri[2] || tri[0] == tri[2])
+                        continue;
+
+                    for (uint32_t vertex : tri)
+                    {
+                        indices.push_back(vertex);
+                        if (vertexGroup[vertex] == NoVertex)
+                            vertexGroup[vertex] = static_cast<uint32_t>(group);
+                        else if (vertexGroup[vertex] != group)
+                            sharedBySubmeshes[vertex] = 1;
+                    }
+                    groupTriangles[group]++;
+                }
+            }
+            std::vector<uint32_t> triangleGroup;
+            triangleGroup.reserve(indices.size() / 3);
+            for (size_t group = 0; group < groupCount; ++group)
+            {
+                triangleGroup.insert(triangleGroup.end(), groupTriangles[group], static_cast<uint32_t>(group));
+            }
+
+            //unit normals of the source triangles, a zero normal never passes the flip test
+            std::vector<Position> faceNormals(indices.size() / 3);
+            for (size_t t = 0; t < faceNormals.size(); ++t)
+            {
+                const Position& p0 = positions[indices[t * 3]];
+                const Position normal = Cross(Sub(positions[indices[t * 3 + 1]], p0), Sub(positions[indices[t * 3 + 2]], p0));
+                const float length = std::sqrt(Dot(normal, normal));
+                faceNormals[t] = length > 0.0f ? Position{ normal.x / length, normal.y / length, normal.z / length } : Position{ 0.0f, 0.0f, 0.0f };
+            }
+
+            //a position shared by submeshes through one vertex stays, through separate wedges it is a seam
+            std::vector<uint32_t> remap, wedge;
+            BuildPositionRemap(positions, remap, wedge);
+            for (uint32_t v = 0; v < vertexCount; ++v)
+            {
+                if (sharedBySubmeshes[v])
+                    sharedBySubmeshes[remap[v]] = 1;
+            }
+
+            //area weighted source normals per position, collapses only ever land on source positions
+            std::vector<Position> vertexNormals(vertexCount, Position{ 0.0f, 0.0f, 0.0f });
+            for (size_t t = 0; t < faceNormals.size(); ++t)
+            {
+                const Position& p0 = positions[indices[t * 3]];
+                const Position normal = Cross(Sub(positions[indices[t * 3 + 1]], p0), Sub(positions[indices[t * 3 + 2]], p0));
+                for (int corner = 0; corner < 3; ++corner)
+                {
+                    vertexNormals[remap[indices[t * 3 + corner]]] = Add(vertexNormals[remap[indices[t * 3 + corner]]], normal);
+                }
+            }
+
+            VertexFans fans;
+            fans.Build(indices, vertexCount);
+            std::vector<uint8_t> kinds;
+            std::vector<uint32_t> openOut;
+            ClassifyVertices(fans, remap, wedge, sharedBySubmeshes, kinds, openOut);
+
+            std::vector<Quadric> quadrics;
+            ComputeQuadrics(indices, positions, remap, kinds, fans, quadrics);
+
+            const size_t targetTriangles = static_cast<size_t>(static_cast<double>(indices.size() / 3) * std::clamp(options.targetRatio, 0.0f, 1.0f));
+            const float errorLimit = options.maxError * options.maxError;
+
+            std::vector<Collapse> collapses;
+            std::vector<uint32_t> order, scratch;
+            std::vector<uint32_t> collapseRemap(vertexCount);
+            std::vector<uint8_t> collapseLocked(vertexCount);
+            VertexFans positionFans;
+
+            //each pass collapses an independent set of the cheapest edges, then rebuilds adjacency
+            while (indices.size() / 3 > targetTriangles)
+            {
+                if (!collapses.empty() || !order.empty())
+                    fans.Build(indices, vertexCount);
+                positionFans.Build(indices, vertexCount, remap.data());
+
+                collapses.clear();
+                for (size_t i = 0; i < indices.size(); i += 3)
+                {
+                    for (int e = 0; e < 3; ++e)
+                    {
+                        const uint32_t i0 = indices[i + e];
+                        const uint32_t i1 = indices[i + (e + 1) % 3];
+                        if (remap[i0] == remap[i1])
+                            continue;
+
+                        const uint8_t k0 = kinds[i0];
+                        const uint8_t k1 = kinds[i1];
+                        if (!CanCollapse[k0][k1] && !CanCollapse[k1][k0])
+                            continue;
+                        if (HasOpposite[k0][k1] && remap[i1] > remap[i0])
+                            continue;
+                        //border and seam vertices only move along their own open edge
+                        if (k0 == k1 && (k0 == Border || k0 == Seam) && openOut[i0] != i1)
+                            continue;
+
+                        const bool forward = CanCollapse[k0][k1];
+                        const bool bidirectional = forward && CanCollapse[k1][k0];
+                        collapses.push_back({ forward ? i0 : i1, forward ? i1 : i0, 0.0f, bidirectional });
+                    }
+                }
+                if (collapses.empty())
+                    break;
+
+                for (auto& collapse : collapses)
+                {
+                    collapse.error = QuadricError(quadrics[remap[collapse.v0]], positions[collapse.v1]);
+                    if (collapse.bidirectional)
+                    {
+                        const float reverse = QuadricError(quadrics[remap[collapse.v1]], positions[collapse.v0]);
+                        if (reverse < collapse.error)
+                        {
+                            std::swap(collapse.v0, collapse.v1);
+                            collapse.error = reverse;
+                        }
+                    }
+                }
+                SortCollapses(collapses, order, scratch);
+
+                //aim for the remaining reduction in this pass, but stop well past the error the goal implies
+                const size_t triangleGoal = indices.size() / 3 - targetTriangles;
+                const size_t collapseGoal = std::max<size_t>(1, triangleGoal / 2);
+                const float errorGoal = collapseGoal < order.size() ? 1.5f * collapses[order[collapseGoal]].error : FLT_MAX;
+
+                for (uint32_t v = 0; v < vertexCount; ++v)
+                {
+                    collapseRemap[v] = v;
+                }
+                std::fill(collapseLocked.begin(), collapseLocked.end(), uint8_t(0));
+
+                size_t trianglesRemoved = 0;
+                for (uint32_t index : order)
+                {
+                    const Collapse& collapse = collapses[index];
+                    if (collapse.error > errorLimit)
+                        break;
+                    if (collapse.error > errorGoal && trianglesRemoved > triangleGoal / 2)
+                        break;
+
+                    const uint32_t i0 = collapse.v0;
+                    const uint32_t i1 = collapse.v1;
+                    const uint32_t r0 = remap[i0];
+                    const uint32_t r1 = remap[i1];
+                    if (collapseLocked[r0] || collapseLocked[r1])
+                        continue;
+                    if (HasTriangleFlips(positionFans, positions, faceNormals, vertexNormals, remap, collapseRemap, r0, r1))
+                        continue;
+
+                    //the other wedge of a seam follows along the opposite side
+                    collapseRemap[i0] = i1;
+                    if (kinds[i0] == Seam)
+                        collapseRemap[wedge[i0]] = wedge[i1];
+
+                    AddQuadric(quadrics[r1], quadrics[r0]);
+                    collapseLocked[r0] = 1;
+                    collapseLocked[r1] = 1;
+
+                    trianglesRemoved += kinds[i0] == Border ? 1 : 2;
+                    if (trianglesRemoved >= triangleGoal)
+                        break;
+                }
+                if (trianglesRemoved == 0)
+                    break;
+
+                //drop the triangles that collapsed to a line, keeping every triangle's submesh and source normal
+                size_t written = 0;
+                for (size_t t = 0; t < triangleGroup.size(); ++t)
+                {
+                    const uint32_t a = collapseRemap[indices[t * 3]];
+                    const uint32_t b = collapseRemap[indices[t * 3 + 1]];
+                    const uint32_t c = collapseRemap[indices[t * 3 + 2]];
+                    if (a == b || b == c || a == c)
+                        continue;
+                    indices[written * 3] = a;
+                    indices[written * 3 + 1] = b;
+                    indices[written * 3 + 2] = c;
+                    faceNormals[written] = faceNormals[t];
+                    triangleGroup[written++] = triangleGroup[t];
+                }
+                indices.resize(written * 3);
+                triangleGroup.resize(written);
+                faceNormals.resize(written);
+            }
+
+            //compact the vertices still referenced, in first use order
+            std::vector<uint32_t> vertexMap(vertexCount, NoVertex);
+            std::vector<uint32_t> kept;
+            for (uint32_t& index : indices)
+            {
+                if (vertexMap[index] == NoVertex)
+                {
+                    vertexMap[index] = static_cast<uint32_t>(kept.size());
+                    kept.push_back(index);
+                }
+                index = vertexMap[index];
+            }
+
+            auto vertices = std::make_unique<VertexData>(layout);
+            vertices->Resize(kept.size());
+            std::vector<uint32_t> slots;
+            for (const auto& attribute : layout.GetAttributes())
+            {
+                if (!attribute.PerInstance && std::find(slots.begin(), slots.end(), attribute.Slot) == slots.end())
+                    slots.push_back(attribute.Slot);
+            }
+            for (uint32_t slot : slots)
+            {
+                const uint32_t stride = layout.GetStride(slot);
+                const uint8_t* from = static_cast<const uint8_t*>(vertexData->GetVertexData(slot));
+                uint8_t* to = static_cast<uint8_t*>(vertices->GetVertexData(slot));
+                for (size_t v = 0; v < kept.size(); ++v)
+                {
+                    std::memcpy(to + v * stride, from + static_cast<size_t>(kept[v]) * stride, stride);
+                }
+            }
+
+            auto simplifiedIndices = std::make_unique<IndexData>();
+            if (kept.size() > 65535)
+            {
+                simplifiedIndices->SetIndices(indices);
+            }
+            else
+            {
+                simplifiedIndices->SetIndices(std::vector<uint16_t>(indices.begin(), indices.end()));
+            }
+
+            auto result = std::make_shared<MeshResource>(source.GetName());
+            result->SetTopology(PrimitiveTopology::TriangleList);
+            result->SetVertexData(std::move(vertices));
+            result->SetIndexData(std::move(simplifiedIndices));
+
+            //every source submesh keeps its slot so materials still line up, indices are absolute now
+            uint32_t indexStart = 0;
+            for (size_t group = 0; group < submeshes.size(); ++group)
+            {
+                const uint32_t indexCount = static_cast<uint32_t>(3 * std::count(triangleGroup.begin(), triangleGroup.end(), static_cast<uint32_t>(group)));
+                result->AddSubMesh(submeshes[group].name, indexStart, indexCount, submeshes[group].materialIndex);
+                indexStart += indexCount;
+            }
+            result->ComputeBounds();
+            return result;
+        }
+    }
+}
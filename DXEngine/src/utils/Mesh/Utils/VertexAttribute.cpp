@@ -4,6 +4,7 @@
 #include <sstream>
 #include <algorithm>
 #include "utils/Mesh/Resource/MeshResource.h"
+#include "utils/Hash.h"
 
 namespace DXEngine
 {
@@ -125,15 +126,43 @@ namespace DXEngine
         return *this;
     }
 
+    VertexLayout& VertexLayout::InstanceTransform(uint32_t slot)
+    {
+        // one float4 row per semantic index, stepped once per instance
+        for (uint32_t row = 0; row < 4; ++row)
+        {
+            AddAttribute(VertexAttribute(VertexAttributeType::Custom, DataFormat::Float4, "INSTANCE_TRANSFORM", row, slot, true));
+        }
+        return *this;
+    }
+
     void VertexLayout::Finalize()
     {
         if (m_Finalized)
             return;
 
         CalculateOffsetsAndStrides();
+        m_ID = ComputeID();
         m_Finalized = true;
     }
 
+    uint64_t VertexLayout::ComputeID() const
+    {
+        uint64_t hash = HashValue(static_cast<uint32_t>(m_Attributes.size()));
+        for (const auto& attr : m_Attributes)
+        {
+            hash = HashValue(attr.Type, hash);
+            hash = HashValue(attr.Format, hash);
+            hash = HashString(attr.SemanticName, hash);
+            hash = HashValue(attr.SemanticIndex, hash);
+            hash = HashValue(attr.Offset, hash);
+            hash = HashValue(attr.Slot, hash);
+            hash = HashValue(attr.PerInstance, hash);
+        }
+        //0 is reserved for layouts that are not finalized
+        return hash ? hash : 1;
+    }
+
     uint32_t VertexLayout::GetStride(uint32_t slot) const
     {
         auto it = m_SlotStrides.find(slot);
@@ -169,6 +198,12 @@ namespace DXEngine
         return FindAttribute(type, slot) != nullptr;
     }
 
+    bool VertexLayout::HasInstanceData() const
+    {
+        return std::any_of(m_Attributes.begin(), m_Attributes.end(),
+            [](const VertexAttribute& attr) { return attr.PerInstance; });
+    }
+
     const VertexAttribute* VertexLayout::FindAttribute(VertexAttributeType type, uint32_t slot) const
     {
         auto it = std::find_if(m_Attributes.begin(), m_Attributes.end(),
@@ -280,6 +315,17 @@ namespace DXEngine
         return layout;
     }
 
+    VertexLayout VertexLayout::CreateInstanced(const VertexLayout& base, uint32_t instanceSlot)
+    {
+        VertexLayout layout;
+        for (const auto& attr : base.GetAttributes())
+        {
+            layout.AddAttribute(attr);
+        }
+        layout.InstanceTransform(instanceSlot)
+              .Finalize();
+        return layout;
+    }
 
     //VertexData implementation
     VertexData::VertexData(const VertexLayout& layout) : m_Layout(layout)
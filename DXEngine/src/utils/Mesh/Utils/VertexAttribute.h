@@ -92,6 +92,7 @@ namespace DXEngine
 		VertexLayout& Color(uint32_t index = 0, DataFormat format = DataFormat::Float4, uint32_t slot = 0);
 		VertexLayout& BlendData(DataFormat indicesFormat = DataFormat::UByte4,
 								DataFormat weightsFormat = DataFormat::Float4, uint32_t slot = 0);
+		VertexLayout& InstanceTransform(uint32_t slot = 1);   // per-instance world matrix, INSTANCE_TRANSFORM0..3
 
 		void Finalize();
 
@@ -99,10 +100,13 @@ namespace DXEngine
 		uint32_t GetStride(uint32_t slot = 0) const;
 		uint32_t GetAttributeCount() const { return static_cast<uint32_t>(m_Attributes.size()); }
 		bool IsFinalized() const { return m_Finalized; }
+		// content hash computed by Finalize, equal layouts share an ID. 0 until finalized
+		uint64_t GetID() const { return m_ID; }
 
 		std::vector<D3D11_INPUT_ELEMENT_DESC> CreateD3D11InputElements() const;
 
 		bool HasAttribute(VertexAttributeType type, uint32_t slot = 0) const;
+		bool HasInstanceData() const;
 		const VertexAttribute* FindAttribute(VertexAttributeType type, uint32_t slot = 0) const;
 
 		std::string GetDebugString() const;
@@ -112,14 +116,17 @@ namespace DXEngine
 		static VertexLayout CreateUI();             // Position + TexCoord + Color
 		static VertexLayout CreateSkinned();        // Position + Normal + Tangent + TexCoord + Blend data
 		static VertexLayout CreateParticle();       // Position + Color + Size (for point sprites)
+		static VertexLayout CreateInstanced(const VertexLayout& base, uint32_t instanceSlot = 1); // base + instance transform
 
 
 
 	private:
 		void CalculateOffsetsAndStrides();
+		uint64_t ComputeID() const;
 	private:
 		std::vector<VertexAttribute> m_Attributes;
 		std::unordered_map<uint32_t, uint32_t> m_SlotStrides;  // Stride per input slot
+		uint64_t m_ID = 0;
 		bool m_Finalized = false;
 	};
 
@@ -1,5 +1,6 @@
 #include "dxpch.h"
 #include "PixelShader.h"
+#include "utils/Hash.h"
 
 namespace DXEngine {
 
@@ -9,6 +10,7 @@ namespace DXEngine {
 		//	filename, nullptr, nullptr, "main", "ps_5_0", 0, 0, &pShaderBlob, NULL);
 		D3DReadFileToBlob(filename, &m_ShaderByteCode);
 		RenderCommand:: GetDevice()->CreatePixelShader(m_ShaderByteCode->GetBufferPointer(), m_ShaderByteCode->GetBufferSize(), NULL, &m_pPixelShader);
+		m_ByteCodeID = HashBytes(m_ShaderByteCode->GetBufferPointer(), m_ShaderByteCode->GetBufferSize());
 	}
 
 	PixelShader::PixelShader(ID3DBlob* shaderBlob)
@@ -23,6 +25,7 @@ namespace DXEngine {
 		if (FAILED(hr)) {
 			throw std::runtime_error("Failed to create pixel shader from blob");
 		}
+		m_ByteCodeID = HashBytes(shaderBlob->GetBufferPointer(), shaderBlob->GetBufferSize());
 	}
 
 	PixelShader::~PixelShader()
@@ -33,6 +36,6 @@ namespace DXEngine {
 
 	void PixelShader::Bind()
 	{
-		RenderCommand::GetContext()->PSSetShader(m_pPixelShader.Get(), nullptr, 0);
+		RenderCommand::SetPixelShader(m_pPixelShader.Get());
 	}
 }
\ No newline at end of file
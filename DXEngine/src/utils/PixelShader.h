@@ -15,10 +15,15 @@ namespace DXEngine {
 		~PixelShader();
 		void Bind();
 
+		ID3D11PixelShader* GetShader() const { return m_pPixelShader.Get(); }
+		// hash of the bytecode, computed once at creation
+		uint64_t GetByteCodeID() const { return m_ByteCodeID; }
+
 	private:
 		HRESULT hr;
 		Microsoft::WRL::ComPtr<ID3DBlob> m_ShaderByteCode;
 		Microsoft::WRL::ComPtr<ID3D11PixelShader> m_pPixelShader;
+		uint64_t m_ByteCodeID = 0;
 
 	};
 
@@ -53,8 +53,8 @@ namespace DXEngine {
 		}
 
 		// Bind samplers (bind at least slots 0 and 1)
-		RenderCommand::GetContext()->PSSetSamplers(0, 3, pixelSamplers);
-		RenderCommand::GetContext()->VSSetSamplers(0, 3, vertexSamplers);
+		RenderCommand::SetSamplers(ShaderStage::Pixel, 0, 3, pixelSamplers);
+		RenderCommand::SetSamplers(ShaderStage::Vertex, 0, 3, vertexSamplers);
 	}
 	Microsoft::WRL::ComPtr<ID3D11SamplerState> SamplerManager::CreateSampler(const SamplerDesc& desc)
 	{
@@ -108,7 +108,7 @@ namespace DXEngine {
 		   m_ShadowSampler.Get()       // s1 - shadowSampler
 		};
 
-		RenderCommand::GetContext()->PSSetSamplers(0, 2, samplers);
+		RenderCommand::SetSamplers(ShaderStage::Pixel, 0, 2, samplers);
 
 	}
 	void SamplerManager::BindVertexShaderSamplers()
@@ -119,7 +119,7 @@ namespace DXEngine {
 			m_ShadowSampler.Get()
 		};
 
-		RenderCommand::GetContext()->VSSetSamplers(0, 2, samplers);
+		RenderCommand::SetSamplers(ShaderStage::Vertex, 0, 2, samplers);
 
 	}
 	void SamplerManager::CreateStandardSampler()
@@ -258,11 +258,11 @@ namespace DXEngine {
 		ID3D11SamplerState* sampler = m_SamplerState.Get();
 
 		if (pixelShader) {
-			RenderCommand::GetContext()->PSSetSamplers(slot, 1, &sampler);
+			RenderCommand::SetSamplers(ShaderStage::Pixel, slot, 1, &sampler);
 		}
 
 		if (vertexShader) {
-			RenderCommand::GetContext()->VSSetSamplers(slot, 1, &sampler);
+			RenderCommand::SetSamplers(ShaderStage::Vertex, slot, 1, &sampler);
 		}
 	}
 	void Sampler::Release()
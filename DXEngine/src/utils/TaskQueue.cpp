@@ -0,0 +1,92 @@
+#include "dxpch.h"
+#include "TaskQueue.h"
+
+namespace DXEngine
+{
+	TaskQueue::TaskQueue(uint32_t workerCount)
+	{
+		m_Workers.reserve(workerCount);
+		for (uint32_t i = 0; i < workerCount; ++i)
+		{
+			m_Workers.emplace_back(&TaskQueue::WorkerLoop, this);
+		}
+	}
+
+	TaskQueue::~TaskQueue()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_Stopping = true;
+			m_Jobs.clear();
+		}
+		m_WorkReady.notify_all();
+
+		for (auto& worker : m_Workers)
+		{
+			worker.join();
+		}
+	}
+
+	void TaskQueue::Submit(std::function<void()> job)
+	{
+		if (m_Workers.empty())
+		{
+			job();
+			return;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_Jobs.push_back(std::move(job));
+		}
+		m_WorkReady.notify_one();
+	}
+
+	void TaskQueue::WaitIdle()
+	{
+		std::unique_lock<std::mutex> lock(m_Mutex);
+		while (RunOne(lock))
+		{
+		}
+		m_WorkDone.wait(lock, [this]() { return m_Jobs.empty() && m_RunningJobs == 0; });
+	}
+
+	size_t TaskQueue::GetPendingCount() const
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		return m_Jobs.size() + m_RunningJobs;
+	}
+
+	void TaskQueue::WorkerLoop()
+	{
+		std::unique_lock<std::mutex> lock(m_Mutex);
+		while (true)
+		{
+			m_WorkReady.wait(lock, [this]() { return m_Stopping || !m_Jobs.empty(); });
+			if (m_Stopping)
+				return;
+
+			RunOne(lock);
+		}
+	}
+
+	bool TaskQueue::RunOne(std::unique_lock<std::mutex>& lock)
+	{
+		if (m_Jobs.empty())
+			return false;
+
+		auto job = std::move(m_Jobs.front());
+		m_Jobs.pop_front();
+		m_RunningJobs++;
+
+		lock.unlock();
+		job();
+		lock.lock();
+
+		if (--m_RunningJobs == 0 && m_Jobs.empty())
+		{
+			m_WorkDone.notify_all();
+		}
+		return true;
+	}
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace DXEngine {
+
+	// Long lived worker threads draining a FIFO of independent jobs. Unlike WorkerPool
+	// the caller does not wait, Submit returns immediately and WaitIdle blocks on demand.
+	class TaskQueue
+	{
+	public:
+		explicit TaskQueue(uint32_t workerCount);
+		~TaskQueue();   // drops jobs that have not started, waits for running ones
+
+		TaskQueue(const TaskQueue&) = delete;
+		TaskQueue& operator=(const TaskQueue&) = delete;
+
+		void Submit(std::function<void()> job);
+
+		// runs queued jobs on the calling thread too, returns once the queue is drained
+		void WaitIdle();
+
+		uint32_t GetWorkerCount() const { return static_cast<uint32_t>(m_Workers.size()); }
+		size_t GetPendingCount() const;
+
+	private:
+		void WorkerLoop();
+		bool RunOne(std::unique_lock<std::mutex>& lock);
+
+	private:
+		std::vector<std::thread> m_Workers;
+
+		mutable std::mutex m_Mutex;
+		std::condition_variable m_WorkReady;
+		std::condition_variable m_WorkDone;
+
+		std::deque<std::function<void()>> m_Jobs;
+		uint32_t m_RunningJobs = 0;
+		bool m_Stopping = false;
+	};
+}
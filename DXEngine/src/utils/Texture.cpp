@@ -37,11 +37,11 @@ namespace DXEngine {
     {
         if (vertexShader)
         {
-            RenderCommand::GetContext()->VSSetShaderResources(slot, 1, m_TextureView.GetAddressOf());
+            RenderCommand::SetShaderResource(ShaderStage::Vertex, slot, m_TextureView.Get());
         }
         if (pixelShader)
         {
-            RenderCommand::GetContext()->PSSetShaderResources(slot, 1, m_TextureView.GetAddressOf());
+            RenderCommand::SetShaderResource(ShaderStage::Pixel, slot, m_TextureView.Get());
         }
     }
 
@@ -14,6 +14,6 @@ namespace DXEngine {
 
 	void Topology::Bind()
 	{
-		RenderCommand::GetContext()->IASetPrimitiveTopology(type);
+		RenderCommand::SetPrimitiveTopology(type);
 	}
 }
\ No newline at end of file
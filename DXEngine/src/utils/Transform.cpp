@@ -6,6 +6,7 @@ namespace DXEngine {
 	Transform::Transform()
 	{
 		m_WorldTransform = DirectX::XMMatrixIdentity();
+		m_InverseTranspose = DirectX::XMMatrixIdentity();
 		m_Translation = DirectX::XMVectorSet(0.0f, 0.0f, 0.0f, 0.0f);
 		m_Scale = DirectX::XMVectorSet(1.0f, 1.0f, 1.0f, 0.0f);
 		m_Rotation = DirectX::XMQuaternionIdentity();
@@ -14,6 +15,8 @@ namespace DXEngine {
 	void Transform::SetTranslation(const DirectX::XMFLOAT3& translation)
 	{
 		m_Translation = DirectX::XMVectorSet(translation.x, translation.y, translation.z, 1.0f);
+		m_MatricesDirty = true;
+		m_Version++;
 	}
 
 	const DirectX::XMVECTOR& Transform::GetTranslation() const
@@ -24,6 +27,8 @@ namespace DXEngine {
 	void Transform::SetScale(const DirectX::XMFLOAT3& scale)
 	{
 		m_Scale = DirectX::XMVectorSet(scale.x, scale.y, scale.z, 1.0f);
+		m_MatricesDirty = true;
+		m_Version++;
 	}
 
 	const DirectX::XMVECTOR& Transform::GetScale() const
@@ -34,10 +39,14 @@ namespace DXEngine {
 	void Transform::SetRotation(const DirectX::XMVECTOR& rotation)
 	{
 		m_Rotation = DirectX::XMQuaternionNormalize(rotation);
+		m_MatricesDirty = true;
+		m_Version++;
 	}
 	void Transform::SetRotation(float pitch, float yaw, float roll)
 	{
 		m_Rotation = DirectX::XMQuaternionRotationRollPitchYaw(pitch, yaw, roll);
+		m_MatricesDirty = true;
+		m_Version++;
 	}
 
 	const DirectX::XMVECTOR& Transform::GetRotation() const
@@ -47,9 +56,25 @@ namespace DXEngine {
 
 	DirectX::XMMATRIX Transform::GetTransform() const
 	{
-		return DirectX::XMMatrixScalingFromVector(m_Scale) *
+		if (m_MatricesDirty)
+			UpdateMatrices();
+		return m_WorldTransform;
+	}
+
+	DirectX::XMMATRIX Transform::GetInverseTranspose() const
+	{
+		if (m_MatricesDirty)
+			UpdateMatrices();
+		return m_InverseTranspose;
+	}
+
+	void Transform::UpdateMatrices() const
+	{
+		m_WorldTransform = DirectX::XMMatrixScalingFromVector(m_Scale) *
 				DirectX::XMMatrixRotationQuaternion(m_Rotation) *
 				DirectX::XMMatrixTranslationFromVector(m_Translation);
+		m_InverseTranspose = DirectX::XMMatrixTranspose(DirectX::XMMatrixInverse(nullptr, m_WorldTransform));
+		m_MatricesDirty = false;
 	}
 
 
@@ -15,16 +15,28 @@ namespace DXEngine {
 		void SetRotation(const DirectX::XMVECTOR& rotation);
 		void SetRotation(float pitch, float yaw, float roll);
 		const DirectX::XMVECTOR& GetRotation()const;
+		//world matrix and its inverse transpose are rebuilt on the first read after a setter, that read
+		//writes the cache so it must not race other readers; SubmitRange and SubmitScene read every
+		//submitted transform once on the calling thread before their slices run
 		DirectX::XMMATRIX GetTransform() const;
+		DirectX::XMMATRIX GetInverseTranspose() const;
+		//bumped by every setter, lets spatial structures notice a move without comparing matrices
+		uint32_t GetVersion() const { return m_Version; }
 
 
 		void Bind();
 
 	private:
-		DirectX::XMMATRIX m_WorldTransform;
+		void UpdateMatrices() const;
+
+	private:
+		mutable DirectX::XMMATRIX m_WorldTransform;
+		mutable DirectX::XMMATRIX m_InverseTranspose;
+		mutable bool m_MatricesDirty = false;
 		DirectX::XMVECTOR m_Scale;
 		DirectX::XMVECTOR m_Translation;
 		DirectX::XMVECTOR m_Rotation;
+		uint32_t m_Version = 0;
 
 
 	};
@@ -38,10 +38,10 @@ namespace DXEngine
 		void SetPressedColor(const UIColor& color) { m_PressedColor = color; }
 		void SetTextColor(const UIColor& color) { m_TextColor = color; }
 		
-		UIColor GetHoverColor() { return m_HoverColor; }
-		UIColor GetNormalColor() { return m_NormalColor; }
-		UIColor GetPressedColor(){ return m_PressedColor; }
-		UIColor GetTextColor() { return m_TextColor; }
+		UIColor GetHoverColor() const { return m_HoverColor; }
+		UIColor GetNormalColor() const { return m_NormalColor; }
+		UIColor GetPressedColor() const { return m_PressedColor; }
+		UIColor GetTextColor() const { return m_TextColor; }
 
 
 		//state of the button
@@ -1,5 +1,6 @@
 #include "dxpch.h"
 #include "VertexShader.h"
+#include "utils/Hash.h"
 
 namespace DXEngine {
 
@@ -18,6 +19,7 @@ namespace DXEngine {
 			//PrintError(hr);
 		}
 		RenderCommand:: GetDevice()->CreateVertexShader(m_ShaderByteCode->GetBufferPointer(), m_ShaderByteCode->GetBufferSize(), NULL, &m_pVertexShader);
+		m_ByteCodeID = HashBytes(m_ShaderByteCode->GetBufferPointer(), m_ShaderByteCode->GetBufferSize());
 	}
 
 	VertexShader::VertexShader(ID3DBlob* shaderBlob)
@@ -34,6 +36,7 @@ namespace DXEngine {
 		if (FAILED(hr)) {
 			throw std::runtime_error("Failed to create vertex shader from blob");
 		}
+		m_ByteCodeID = HashBytes(shaderBlob->GetBufferPointer(), shaderBlob->GetBufferSize());
 	}
 
 	VertexShader::~VertexShader()
@@ -44,7 +47,7 @@ namespace DXEngine {
 
 	void VertexShader::Bind()
 	{
-		RenderCommand::GetContext()->VSSetShader(m_pVertexShader.Get(), nullptr, 0);
+		RenderCommand::SetVertexShader(m_pVertexShader.Get());
 	}
 
 	ID3DBlob* VertexShader::GetByteCode()
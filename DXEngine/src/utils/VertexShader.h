@@ -14,6 +14,9 @@ namespace DXEngine {
 		void Bind();
 
 		ID3DBlob* GetByteCode();
+		ID3D11VertexShader* GetShader() const { return m_pVertexShader.Get(); }
+		// hash of the bytecode, computed once at creation
+		uint64_t GetByteCodeID() const { return m_ByteCodeID; }
 
 	private:
 		//void PrintError(HRESULT vhr);
@@ -22,6 +25,7 @@ namespace DXEngine {
 		HRESULT hr;
 		Microsoft::WRL::ComPtr<ID3D11VertexShader> m_pVertexShader;
 		Microsoft::WRL::ComPtr<ID3DBlob> m_ShaderByteCode;
+		uint64_t m_ByteCodeID = 0;
 
 	};
 }
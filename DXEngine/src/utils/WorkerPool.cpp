@@ -0,0 +1,105 @@
+#include "dxpch.h"
+#include "WorkerPool.h"
+
+namespace DXEngine
+{
+	WorkerPool::WorkerPool(uint32_t workerCount)
+	{
+		m_Workers.reserve(workerCount);
+		for (uint32_t i = 0; i < workerCount; ++i)
+		{
+			m_Workers.emplace_back(&WorkerPool::WorkerLoop, this);
+		}
+	}
+
+	WorkerPool::~WorkerPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_Stopping = true;
+		}
+		m_WorkReady.notify_all();
+
+		for (auto& worker : m_Workers)
+		{
+			worker.join();
+		}
+	}
+
+	uint32_t WorkerPool::GetDefaultWorkerCount()
+	{
+		// leave the calling thread its own core
+		const uint32_t hardwareThreads = std::thread::hardware_concurrency();
+		return hardwareThreads > 1 ? std::min(hardwareThreads - 1, 15u) : 0;
+	}
+
+	void WorkerPool::ParallelFor(uint32_t count, const std::function<void(uint32_t)>& task)
+	{
+		if (count == 0)
+			return;
+
+		if (m_Workers.empty() || count == 1)
+		{
+			for (uint32_t i = 0; i < count; ++i)
+			{
+				task(i);
+			}
+			return;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_Task = &task;
+			m_TaskCount = count;
+			m_NextIndex.store(0, std::memory_order_relaxed);
+			m_ActiveWorkers = static_cast<uint32_t>(m_Workers.size());
+			m_Generation++;
+		}
+		m_WorkReady.notify_all();
+
+		RunTasks();
+
+		// the task is owned by the caller, wait until no worker can still touch it
+		std::unique_lock<std::mutex> lock(m_Mutex);
+		m_WorkDone.wait(lock, [this]() { return m_ActiveWorkers == 0; });
+		m_Task = nullptr;
+	}
+
+	void WorkerPool::WorkerLoop()
+	{
+		uint64_t seenGeneration = 0;
+		while (true)
+		{
+			{
+				std::unique_lock<std::mutex> lock(m_Mutex);
+				m_WorkReady.wait(lock, [this, seenGeneration]() { return m_Stopping || m_Generation != seenGeneration; });
+				if (m_Stopping)
+					return;
+				seenGeneration = m_Generation;
+			}
+
+			RunTasks();
+
+			bool lastWorker = false;
+			{
+				std::lock_guard<std::mutex> lock(m_Mutex);
+				lastWorker = --m_ActiveWorkers == 0;
+			}
+			if (lastWorker)
+			{
+				m_WorkDone.notify_one();
+			}
+		}
+	}
+
+	void WorkerPool::RunTasks()
+	{
+		const auto& task = *m_Task;
+		const uint32_t count = m_TaskCount;
+		for (uint32_t index = m_NextIndex.fetch_add(1, std::memory_order_relaxed); index < count;
+			index = m_NextIndex.fetch_add(1, std::memory_order_relaxed))
+		{
+			task(index);
+		}
+	}
+}
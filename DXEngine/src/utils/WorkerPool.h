@@ -0,0 +1,49 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace DXEngine {
+
+	// Fixed set of worker threads for frame-local parallel loops. The thread calling
+	// ParallelFor takes part in the work and returns once every index has run.
+	class WorkerPool
+	{
+	public:
+		explicit WorkerPool(uint32_t workerCount);
+		~WorkerPool();
+
+		WorkerPool(const WorkerPool&) = delete;
+		WorkerPool& operator=(const WorkerPool&) = delete;
+
+		void ParallelFor(uint32_t count, const std::function<void(uint32_t)>& task);
+
+		// workers plus the calling thread
+		uint32_t GetThreadCount() const { return static_cast<uint32_t>(m_Workers.size()) + 1; }
+
+		static uint32_t GetDefaultWorkerCount();
+
+	private:
+		void WorkerLoop();
+		void RunTasks();
+
+	private:
+		std::vector<std::thread> m_Workers;
+
+		std::mutex m_Mutex;
+		std::condition_variable m_WorkReady;
+		std::condition_variable m_WorkDone;
+
+		const std::function<void(uint32_t)>* m_Task = nullptr;
+		uint32_t m_TaskCount = 0;
+		uint64_t m_Generation = 0;
+		uint32_t m_ActiveWorkers = 0;
+		bool m_Stopping = false;
+
+		std::atomic<uint32_t> m_NextIndex{ 0 };
+	};
+}
@@ -5,9 +5,16 @@
 #include "shaders/ShaderManager.h"
 #include "renderer/RendererCommand.h"
 #include <algorithm>
+#include <atomic>
 
 namespace DXEngine {
 
+	uint32_t Material::GenerateID()
+	{
+		static std::atomic<uint32_t> s_NextID{ 1 };
+		return s_NextID.fetch_add(1, std::memory_order_relaxed);
+	}
+
 	Material::Material(const std::string& name, MaterialType type)
 		: m_Name(name),m_Type(type),m_RenderQueue(RenderQueue::Opaque)
 	{
@@ -78,7 +85,7 @@ namespace DXEngine {
 
 		if (m_ConstantBufferInitialized)
 		{
-			RenderCommand::GetContext()->PSSetConstantBuffers(BindSlot::CB_Material, 1, m_ConstantBuffer.GetAddressOf());
+			RenderCommand::SetConstantBuffer(ShaderStage::Pixel, BindSlot::CB_Material, m_ConstantBuffer.GetBuffer());
 		}
 
 		// Bind all available textures
@@ -118,6 +125,7 @@ namespace DXEngine {
 		{
 			m_Type = type;
 			m_PropertiesDirty = true;
+			InvalidateShaderCache();
 
 			switch (type)
 			{
@@ -179,6 +187,7 @@ namespace DXEngine {
 		if (metallic > 0.1f && m_Type == MaterialType::Lit)
 		{
 			m_Type = MaterialType::PBR;
+			InvalidateShaderCache();
 		}
 	}
 
@@ -337,6 +346,7 @@ namespace DXEngine {
 
 	void Material::SetFlag(MaterialFlags flag, bool enabled)
 	{
+		const uint32_t previous = m_Properties.flags;
 		if (enabled)
 		{
 			m_Properties.flags |= flag;
@@ -348,6 +358,10 @@ namespace DXEngine {
 		}
 		m_PropertiesDirty = true;
 
+		if (m_Properties.flags != previous)
+		{
+			InvalidateShaderCache();
+		}
 	}
 
 	bool Material::HasFlag(MaterialFlags flag) const
@@ -358,6 +372,40 @@ namespace DXEngine {
 	void Material::UpdateTextureFlags()
 	{
 		m_PropertiesDirty = true;
+		//texture slots feed the variant too (detail normal has no flag of its own)
+		InvalidateShaderCache();
+	}
+
+	void Material::InvalidateShaderCache()
+	{
+		m_VariantVersion++;
+		m_ShaderCache.clear();
+	}
+
+	std::shared_ptr<ShaderProgram> Material::FindCachedShader(uint64_t layoutID, uint32_t generation) const
+	{
+		for (const auto& entry : m_ShaderCache)
+		{
+			if (entry.layoutID == layoutID)
+			{
+				return entry.generation == generation ? entry.shader : nullptr;
+			}
+		}
+		return nullptr;
+	}
+
+	void Material::CacheShader(uint64_t layoutID, uint32_t generation, std::shared_ptr<ShaderProgram> shader) const
+	{
+		for (auto& entry : m_ShaderCache)
+		{
+			if (entry.layoutID == layoutID)
+			{
+				entry.generation = generation;
+				entry.shader = std::move(shader);
+				return;
+			}
+		}
+		m_ShaderCache.push_back({ layoutID, generation, std::move(shader) });
 	}
 
 	void Material::InitializeConstantBuffer()
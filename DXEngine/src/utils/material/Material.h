@@ -5,6 +5,7 @@
 #include "utils/Sampler.h"
 #include <string>
 #include <memory>
+#include <vector>
 
 namespace DXEngine {
 
@@ -25,6 +26,9 @@ namespace DXEngine {
 		MaterialType GetType()const { return m_Type; }
 		void SetType(MaterialType type);
 
+		//stable identifier used for draw sorting
+		uint32_t GetID()const { return m_ID; }
+
 		const std::string& GetName()const { return m_Name; }
 		void SetName(const std::string& name) { m_Name = name; }
 
@@ -101,15 +105,26 @@ namespace DXEngine {
 		void SetFlag(MaterialFlags flag, bool enabled);
 		bool HasFlag(MaterialFlags flag) const;
 
+		//bumped when anything that selects the shader variant changes (type, flags, textures)
+		uint32_t GetVariantVersion() const { return m_VariantVersion; }
+
+		//resolved shader variants per vertex layout ID, filled by ShaderVariantManager on the render thread.
+		//cleared when the variant version changes, entries from an older reload generation never match.
+		std::shared_ptr<ShaderProgram> FindCachedShader(uint64_t layoutID, uint32_t generation) const;
+		void CacheShader(uint64_t layoutID, uint32_t generation, std::shared_ptr<ShaderProgram> shader) const;
+
 		std::string GetDebugInfo() const;
 
 	private:
+		static uint32_t GenerateID();
 		void UpdateTextureFlags();
+		void InvalidateShaderCache();
 		void InitializeConstantBuffer();
 		void UpdateConstantBuffer();
 
 
 	private:
+		uint32_t m_ID = GenerateID();
 		std::string m_Name;
 		MaterialType m_Type;
 		RenderQueue m_RenderQueue;
@@ -119,6 +134,15 @@ namespace DXEngine {
 		
 		bool m_ConstantBufferInitialized = false;
 		bool m_PropertiesDirty = true;
+
+		struct ShaderCacheEntry
+		{
+			uint64_t layoutID;
+			uint32_t generation;
+			std::shared_ptr<ShaderProgram> shader;
+		};
+		uint32_t m_VariantVersion = 1;
+		mutable std::vector<ShaderCacheEntry> m_ShaderCache;
 	};
 
 
@@ -2,6 +2,8 @@
 
 float4 main(StandardVertexOutput input) : SV_Target
 {
+    ApplyLODFade(input.position, input.lodFade);
+
     // ========================================================================
     // TEXTURE SAMPLING
     // ========================================================================
@@ -35,7 +37,8 @@ float4 main(StandardVertexOutput input) : SV_Target
     float3 finalEmissive = emissiveColor.rgb;
     
 #if HAS_EMISSIVE_MAP
-    finalEmissive *= emissiveSample;
+    if (USE_EMISSIVE_MAP)
+        finalEmissive *= emissiveSample;
 #endif
     
 #if HAS_VERTEX_COLOR_ATTRIBUTE
@@ -117,7 +120,8 @@ float4 main(StandardVertexOutput input) : SV_Target
     finalAlpha = saturate(finalAlpha);
     
 #if ENABLE_ALPHA_TEST
-    clip(finalAlpha - 0.5);
+    if (USE_ALPHA_TEST)
+        clip(finalAlpha - 0.5);
 #endif
     
     return float4(finalColor, finalAlpha);
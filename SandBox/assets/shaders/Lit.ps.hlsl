@@ -2,6 +2,8 @@
 
 float4 main(StandardVertexOutput input) : SV_Target
 {
+    ApplyLODFade(input.position, input.lodFade);
+
    float3 V = normalize(input.viewDir);
 
 #if ENABLE_PARALLAX_MAPPING && HAS_HEIGHT_MAP && HAS_TANGENT_ATTRIBUTE
@@ -186,7 +188,8 @@ float4 main(StandardVertexOutput input) : SV_Target
     // ========================================================================
     
 #if ENABLE_ALPHA_TEST
-    clip(finalAlpha - 0.5); // Discard pixels below threshold
+    if (USE_ALPHA_TEST)
+        clip(finalAlpha - 0.5); // Discard pixels below threshold
 #endif
     
     return float4(color, finalAlpha);
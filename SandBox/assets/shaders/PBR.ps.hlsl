@@ -2,6 +2,8 @@
 
 float4 main(StandardVertexOutput input) : SV_Target
 {
+    ApplyLODFade(input.position, input.lodFade);
+
     float3 V = normalize(input.viewDir);
     
     // ========== PARALLAX MAPPING PREPROCESSING ==========
@@ -47,22 +49,25 @@ float4 main(StandardVertexOutput input) : SV_Target
         
         // Check if we're using specular workflow or metallic workflow
         // If we have dedicated metallic/roughness maps, use specular as packed data
-#if !HAS_METALLIC_MAP && !HAS_ROUGHNESS_MAP
+        if (!USE_METALLIC_MAP && !USE_ROUGHNESS_MAP)
+        {
             // Packed PBR workflow - extract from channels
             occlusionValue *= specularSample.r;      // Red = AO
             roughnessValue *= specularSample.g;      // Green = Roughness
             metallicValue *= specularSample.b;       // Blue = Metallic
-#endif
+        }
 #endif
     
     // ========== DEDICATED PBR TEXTURES ==========
     // These override packed specular map values if present
     
 #if HAS_ROUGHNESS_MAP
+    if (USE_ROUGHNESS_MAP)
         roughnessValue *= SampleRoughnessMap(input.texCoord);
 #endif
     
 #if HAS_METALLIC_MAP
+    if (USE_METALLIC_MAP)
         metallicValue *= SampleMetallicMap(input.texCoord);
 #endif
     
@@ -72,8 +77,8 @@ float4 main(StandardVertexOutput input) : SV_Target
     
     // ========== EMISSIVE TEXTURE ==========
 #if HAS_EMISSIVE_MAP
-        float3 emissiveSample = SampleEmissiveMap(input.texCoord);
-        emissiveValue *= emissiveSample;
+    if (USE_EMISSIVE_MAP)
+        emissiveValue *= SampleEmissiveMap(input.texCoord);
 #endif
     
     // ========== OPACITY TEXTURE ==========
@@ -130,7 +135,8 @@ float4 main(StandardVertexOutput input) : SV_Target
     // Convert albedo to linear space if using sRGB textures
     // Most texture formats store colors in sRGB, but lighting calculations need linear
 #if HAS_DIFFUSE_TEXTURE
-    baseColor.rgb = pow(abs(baseColor.rgb), 2.2); // sRGB to Linear
+    if (USE_DIFFUSE_TEXTURE)
+        baseColor.rgb = pow(abs(baseColor.rgb), 2.2); // sRGB to Linear
 #endif
     
     // Proper F0 calculation for metallic workflow
@@ -234,7 +240,8 @@ float4 main(StandardVertexOutput input) : SV_Target
     // ========================================================================
     
 #if ENABLE_EMISSIVE || HAS_EMISSIVE_MAP
-    color += emissiveValue;
+    if (ENABLE_EMISSIVE || USE_EMISSIVE_MAP)
+        color += emissiveValue;
 #endif
     
     // ========================================================================
@@ -269,7 +276,8 @@ float4 main(StandardVertexOutput input) : SV_Target
     // ========================================================================
     
 #if ENABLE_ALPHA_TEST
-    clip(finalAlpha - 0.5);
+    if (USE_ALPHA_TEST)
+        clip(finalAlpha - 0.5);
 #endif
     
     return float4(color, finalAlpha);
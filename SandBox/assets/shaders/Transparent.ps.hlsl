@@ -2,6 +2,8 @@
 
 float4 main(StandardVertexOutput input) : SV_Target
 {
+    ApplyLODFade(input.position, input.lodFade);
+
         // ========== APPLY PARALLAX MAPPING ==========
 #if ENABLE_PARALLAX_MAPPING && HAS_HEIGHT_MAP && HAS_TANGENT_ATTRIBUTE
     float3 V = normalize(input.viewDir);
@@ -181,7 +183,8 @@ float4 main(StandardVertexOutput input) : SV_Target
     // ========================================================================
     
 #if ENABLE_ALPHA_TEST
-    clip(finalAlpha - 0.1); // Lower threshold for transparency
+    if (USE_ALPHA_TEST)
+        clip(finalAlpha - 0.1); // Lower threshold for transparency
 #endif
     
     return float4(color, finalAlpha);
@@ -6,8 +6,11 @@ float4 main(UIVertexOutput input) : SV_Target
     
     // Sample diffuse texture if available and we have texture coordinates
 #if HAS_DIFFUSE_TEXTURE && HAS_TEXCOORDS_ATTRIBUTE
-    float4 texColor = diffuseTexture.Sample(standardSampler, input.texCoord);
-    finalColor *= texColor;
+    if (USE_DIFFUSE_TEXTURE)
+    {
+        float4 texColor = diffuseTexture.Sample(standardSampler, input.texCoord);
+        finalColor *= texColor;
+    }
 #endif
     
     // UI elements can have vertex colors too
@@ -20,7 +23,8 @@ float4 main(UIVertexOutput input) : SV_Target
     
     // Alpha test for UI elements (useful for text rendering)
 #if ENABLE_ALPHA_TEST
-    clip(finalColor.a - 0.1); // Lower threshold for UI
+    if (USE_ALPHA_TEST)
+        clip(finalColor.a - 0.1); // Lower threshold for UI
 #endif
     
     // UI elements don't need complex lighting, just return the color
@@ -2,14 +2,19 @@
 
 float4 main(StandardVertexOutput input) : SV_Target
 {
+    ApplyLODFade(input.position, input.lodFade);
+
     float4 baseColor = diffuseColor;
     float opacityValue = 1.0;
     
     // Sample diffuse texture if available
 #if HAS_DIFFUSE_TEXTURE && HAS_TEXCOORDS_ATTRIBUTE
-    float4 texColor = SampleDiffuseTexture(input.texCoord);
-    baseColor *= texColor;
-    opacityValue = SampleOpacityMap(input.texCoord);
+    if (USE_DIFFUSE_TEXTURE)
+    {
+        float4 texColor = SampleDiffuseTexture(input.texCoord);
+        baseColor *= texColor;
+        opacityValue = SampleOpacityMap(input.texCoord);
+    }
 #endif
     
     // Modulate with vertex colors if available
@@ -31,7 +36,8 @@ float4 main(StandardVertexOutput input) : SV_Target
     // Apply material alpha
     baseColor.a *= alpha * opacityValue;
 #if ENABLE_ALPHA_TEST
-    clip(baseColor.a - 0.5);
+    if (USE_ALPHA_TEST)
+        clip(baseColor.a - 0.5);
 #endif
     
     return baseColor;
@@ -5,12 +5,17 @@ StandardVertexOutput main(StandardVertexInput input)
     StandardVertexOutput output;
     
     // Transform position (always required)
+    float4x4 world = GetWorldMatrix(input);
+    output.worldPos = mul(float4(input.position, 1.0), world);
+#if ENABLE_INSTANCING
+    output.position = mul(output.worldPos, mul(View, Projection));
+#else
     output.position = mul(float4(input.position, 1.0), WVP);
-    output.worldPos = mul(float4(input.position, 1.0), Model);
+#endif
     
     // Transform normal only if we have normal attribute
 #if HAS_NORMAL_ATTRIBUTE
-    output.normal = mul(input.normal, (float3x3)Model);
+    output.normal = mul(input.normal, (float3x3)world);
 #endif
     
     // Pass through texture coordinates if available
@@ -20,7 +25,7 @@ StandardVertexOutput main(StandardVertexInput input)
     
     // Transform tangent if available
 #if HAS_TANGENT_ATTRIBUTE
-    output.tangent = float4(mul(input.tangent.xyz, (float3x3)Model), input.tangent.w);
+    output.tangent = float4(mul(input.tangent.xyz, (float3x3)world), input.tangent.w);
 #endif
 
     // Pass through vertex color if available
@@ -31,6 +36,7 @@ StandardVertexOutput main(StandardVertexInput input)
     // Calculate view direction and time (always available)
     output.viewDir = CameraPosition - output.worldPos.xyz;
     output.time = Time;
+    output.lodFade = LodFade;
     
     return output;
 }
\ No newline at end of file
@@ -104,6 +104,12 @@
 #define ENABLE_EMISSIVE 0
 #endif
 
+// Uber shader mode: material flag bits whose feature is compiled in but branched on
+// per draw, see ShaderFeaturePolicy. 0 keeps every feature a pure compile time switch.
+#ifndef RUNTIME_MATERIAL_FLAGS
+#define RUNTIME_MATERIAL_FLAGS 0
+#endif
+
 // Custom vertex input override
 #ifndef CUSTOM_VERTEX_INPUT
 #define CUSTOM_VERTEX_INPUT 0
@@ -115,13 +121,33 @@ static const float TWO_PI = 6.28318530718;
 static const float MIN_ROUGHNESS = 0.04;
 static const float EPSILON = 0.0001;
 
-// === MATERIAL FLAGS ===
+// === MATERIAL FLAGS === (MaterialFlags in MaterialTypes.h)
 #define HAS_DIFFUSE_TEXTURE_FLAG   0x01
 #define HAS_NORMAL_MAP_FLAG        0x02
 #define HAS_SPECULAR_MAP_FLAG      0x04
 #define HAS_EMISSIVE_MAP_FLAG      0x08
-#define CASTS_SHADOWS_FLAG         0x40
-#define RECEIVES_SHADOWS_FLAG      0x80
+#define HAS_ROUGHNESS_MAP_FLAG     0x10
+#define HAS_METALLIC_MAP_FLAG      0x20
+#define HAS_AO_MAP_FLAG            0x40
+#define HAS_OPACITY_MAP_FLAG       0x200
+#define IS_TRANSPARENT_FLAG        0x4000
+#define CASTS_SHADOWS_FLAG         0x10000
+#define RECEIVES_SHADOWS_FLAG      0x20000
+
+// Feature compiled in and, when it is a runtime feature, enabled on the material.
+// Folds to the plain define when RUNTIME_MATERIAL_FLAGS is 0.
+#define MATERIAL_FEATURE(enabled, flag) \
+    ((enabled) && ((RUNTIME_MATERIAL_FLAGS & (flag)) == 0 || (flags & (flag)) != 0))
+
+#define USE_DIFFUSE_TEXTURE MATERIAL_FEATURE(HAS_DIFFUSE_TEXTURE, HAS_DIFFUSE_TEXTURE_FLAG)
+#define USE_NORMAL_MAP      MATERIAL_FEATURE(HAS_NORMAL_MAP, HAS_NORMAL_MAP_FLAG)
+#define USE_SPECULAR_MAP    MATERIAL_FEATURE(HAS_SPECULAR_MAP, HAS_SPECULAR_MAP_FLAG)
+#define USE_EMISSIVE_MAP    MATERIAL_FEATURE(HAS_EMISSIVE_MAP, HAS_EMISSIVE_MAP_FLAG)
+#define USE_ROUGHNESS_MAP   MATERIAL_FEATURE(HAS_ROUGHNESS_MAP, HAS_ROUGHNESS_MAP_FLAG)
+#define USE_METALLIC_MAP    MATERIAL_FEATURE(HAS_METALLIC_MAP, HAS_METALLIC_MAP_FLAG)
+#define USE_AO_MAP          MATERIAL_FEATURE(HAS_AO_MAP, HAS_AO_MAP_FLAG)
+#define USE_OPACITY_MAP     MATERIAL_FEATURE(HAS_OPACITY_MAP, HAS_OPACITY_MAP_FLAG)
+#define USE_ALPHA_TEST      MATERIAL_FEATURE(ENABLE_ALPHA_TEST, IS_TRANSPARENT_FLAG)
 
 cbuffer TransformBuffer : register(b0)
 {
@@ -131,6 +157,8 @@ cbuffer TransformBuffer : register(b0)
     float4x4 Projection;
     float3 CameraPosition;
     float Time;
+    float LodFade;
+    float3 TransformPadding;
 };
 
 cbuffer cb_BoneMatrices : register(b1)
@@ -261,6 +289,14 @@ struct StandardVertexInput
     uint4 blendIndices : BLENDINDICES;
     float4 blendWeights : BLENDWEIGHT;
 #endif
+
+#if ENABLE_INSTANCING
+    // per-instance world matrix rows, slot 1
+    float4 instanceRow0 : INSTANCE_TRANSFORM0;
+    float4 instanceRow1 : INSTANCE_TRANSFORM1;
+    float4 instanceRow2 : INSTANCE_TRANSFORM2;
+    float4 instanceRow3 : INSTANCE_TRANSFORM3;
+#endif
 };
 
 struct StandardVertexOutput
@@ -284,6 +320,7 @@ struct StandardVertexOutput
 #endif
     float3 viewDir : VIEWDIR;
     float time : TIME;
+    nointerpolation float lodFade : LODFADE;
 };
 
 //(Unlit, basic Lit,...)
@@ -364,11 +401,13 @@ float3 GetScaledTexCoord(float2 uv)
 float4 SampleDiffuseTexture(float2 uv)
 {
 #if HAS_DIFFUSE_TEXTURE
-    float2 scaledUV = uv * textureScale + textureOffset;
-    return diffuseTexture.Sample(standardSampler, scaledUV);
-#else
-    return float4(1.0, 1.0, 1.0, 1.0);
+    [branch] if (USE_DIFFUSE_TEXTURE)
+    {
+        float2 scaledUV = uv * textureScale + textureOffset;
+        return diffuseTexture.Sample(standardSampler, scaledUV);
+    }
 #endif
+    return float4(1.0, 1.0, 1.0, 1.0);
 }
 
 // Add validation in SampleNormalMap
@@ -402,51 +441,61 @@ float3 SampleNormalMap(float2 uv)
 float3 SampleSpecularMap(float2 uv)
 {
 #if HAS_SPECULAR_MAP
-    float2 scaledUV = uv * textureScale + textureOffset;
-    return specularTexture.Sample(standardSampler, scaledUV).rgb;
-#else
-    return float3(1.0, 1.0, 1.0);
+    [branch] if (USE_SPECULAR_MAP)
+    {
+        float2 scaledUV = uv * textureScale + textureOffset;
+        return specularTexture.Sample(standardSampler, scaledUV).rgb;
+    }
 #endif
+    return float3(1.0, 1.0, 1.0);
 }
 
 float3 SampleEmissiveMap(float2 uv)
 {
 #if HAS_EMISSIVE_MAP
-    float2 scaledUV = uv * textureScale + textureOffset;
-    return emissiveTexture.Sample(standardSampler, scaledUV).rgb;
-#else
-    return float3(0.0, 0.0, 0.0);
+    [branch] if (USE_EMISSIVE_MAP)
+    {
+        float2 scaledUV = uv * textureScale + textureOffset;
+        return emissiveTexture.Sample(standardSampler, scaledUV).rgb;
+    }
 #endif
+    return float3(0.0, 0.0, 0.0);
 }
 
 float SampleRoughnessMap(float2 uv)
 {
 #if HAS_ROUGHNESS_MAP
-    float2 scaledUV = uv * textureScale + textureOffset;
-    return roughnessTexture.Sample(standardSampler, scaledUV).r;
-#else
-    return roughness;
+    [branch] if (USE_ROUGHNESS_MAP)
+    {
+        float2 scaledUV = uv * textureScale + textureOffset;
+        return roughnessTexture.Sample(standardSampler, scaledUV).r;
+    }
 #endif
+    return roughness;
 }
 
 float SampleMetallicMap(float2 uv)
 {
 #if HAS_METALLIC_MAP
-    float2 scaledUV = uv * textureScale + textureOffset;
-    return metallicTexture.Sample(standardSampler, scaledUV).r;
-#else
-    return metallic;
+    [branch] if (USE_METALLIC_MAP)
+    {
+        float2 scaledUV = uv * textureScale + textureOffset;
+        return metallicTexture.Sample(standardSampler, scaledUV).r;
+    }
 #endif
+    return metallic;
 }
 
 float SampleAOMap(float2 uv)
 {
 #if HAS_AO_MAP
-    float2 scaledUV = uv * textureScale + textureOffset;
-    return aoTexture.Sample(standardSampler, scaledUV).r;
-#else
-    return 1.0; // No occlusion by default
+    [branch] if (USE_AO_MAP)
+    {
+        float2 scaledUV = uv * textureScale + textureOffset;
+        return aoTexture.Sample(standardSampler, scaledUV).r;
+    }
 #endif
+    return 1.0; // No occlusion by default
 }
 
 float SampleHeightMap(float2 uv)
@@ -462,11 +511,13 @@ float SampleHeightMap(float2 uv)
 float SampleOpacityMap(float2 uv)
 {
 #if HAS_OPACITY_MAP
-    float2 scaledUV = uv * textureScale + textureOffset;
-    return opacityTexture.Sample(standardSampler, scaledUV).r;
-#else
-    return 1.0; // Fully opaque by default
+    [branch] if (USE_OPACITY_MAP)
+    {
+        float2 scaledUV = uv * textureScale + textureOffset;
+        return opacityTexture.Sample(standardSampler, scaledUV).r;
+    }
 #endif
+    return 1.0; // Fully opaque by default
 }
 
 // ========== NEW: DETAIL TEXTURE SAMPLING ==========
@@ -511,37 +562,39 @@ float3 CalculateWorldNormal(float3 vertexNormal, float4 tangent, float2 texCoord
 #endif
     
 #if HAS_NORMAL_MAP && HAS_TANGENT_ATTRIBUTE
-    // Sample base normal map (in tangent space)
-    float3 tangentNormal = SampleNormalMap(texCoord);
+    [branch] if (USE_NORMAL_MAP)
+    {
+        // Sample base normal map (in tangent space)
+        float3 tangentNormal = SampleNormalMap(texCoord);
     
-    // Blend with detail normal if available
+        // Blend with detail normal if available
 #if HAS_DETAIL_NORMAL_MAP && HAS_DETAIL_TEXTURES
-    float3 detailNormal = SampleDetailNormal(texCoord);
-    tangentNormal = BlendNormals(tangentNormal, detailNormal);
+        float3 detailNormal = SampleDetailNormal(texCoord);
+        tangentNormal = BlendNormals(tangentNormal, detailNormal);
 #endif
     
-    // Build TBN matrix - ensure all vectors are normalized
-    float3 T = normalize(tangent.xyz);
-    float3 N_normalized = normalize(N);
+        // Build TBN matrix - ensure all vectors are normalized
+        float3 T = normalize(tangent.xyz);
+        float3 N_normalized = normalize(N);
     
-    // Gram-Schmidt process to ensure T is perpendicular to N
-    T = normalize(T - dot(T, N_normalized) * N_normalized);
+        // Gram-Schmidt process to ensure T is perpendicular to N
+        T = normalize(T - dot(T, N_normalized) * N_normalized);
     
-    // Calculate bitangent with correct handedness
-    float3 B = cross(N_normalized, T) * tangent.w;
-    B = normalize(B);
+        // Calculate bitangent with correct handedness
+        float3 B = cross(N_normalized, T) * tangent.w;
+        B = normalize(B);
     
-    // Construct TBN matrix (tangent space to world space)
-    float3x3 TBN = float3x3(T, B, N_normalized);
+        // Construct TBN matrix (tangent space to world space)
+        float3x3 TBN = float3x3(T, B, N_normalized);
     
-    // Transform normal from tangent space to world space
-    float3 worldNormal = mul(tangentNormal, TBN);
+        // Transform normal from tangent space to world space
+        float3 worldNormal = mul(tangentNormal, TBN);
     
-    // Final normalization
-    return normalize(worldNormal);
-#else
-    return N;
+        // Final normalization
+        return normalize(worldNormal);
+    }
 #endif
+    return N;
 }
 
 // ========== NEW: PARALLAX OCCLUSION MAPPING ==========
@@ -877,11 +930,41 @@ float3 ToneMapExposure(float3 color, float exposure)
     return saturate(mapped);
 }
 
+// world matrix for the vertex, the instance stream replaces Model when instancing
+float4x4 GetWorldMatrix(StandardVertexInput input)
+{
+#if ENABLE_INSTANCING
+    return float4x4(input.instanceRow0, input.instanceRow1, input.instanceRow2, input.instanceRow3);
+#else
+    return Model;
+#endif
+}
+
 float3 ApplyGamma(float3 color, float gamma)
 {
     return pow(saturate(color), 1.0f / gamma);
 }
 
+// LOD cross-fade: the incoming level (fade > 0) keeps the pixels under a 4x4 ordered dither
+// threshold and the outgoing level (fade < 0) the rest, so both together cover every pixel once
+static const float LodDitherPattern[16] =
+{
+     0.0,  8.0,  2.0, 10.0,
+    12.0,  4.0, 14.0,  6.0,
+     3.0, 11.0,  1.0,  9.0,
+    15.0,  7.0, 13.0,  5.0
+};
+
+void ApplyLODFade(float4 screenPosition, float fade)
+{
+    if (fade == 0.0)
+        return;
+
+    uint2 pixel = uint2(screenPosition.xy) & 3;
+    float threshold = (LodDitherPattern[pixel.y * 4 + pixel.x] + 0.5) / 16.0;
+    clip(fade > 0.0 ? fade - threshold : threshold + fade);
+}
+
 StandardVertexOutput StandardVertexShader(StandardVertexInput input)
 {
     StandardVertexOutput output;
@@ -973,15 +1056,20 @@ StandardVertexOutput StandardVertexShader(StandardVertexInput input)
 
 #else  
     // NON-SKINNED TRANSFORMATION (Standard pipeline)
-    output.worldPos = mul(localPos, Model);
+    float4x4 world = GetWorldMatrix(input);
+    output.worldPos = mul(localPos, world);
+#if ENABLE_INSTANCING
+    output.position = mul(output.worldPos, mul(View, Projection));
+#else
     output.position = mul(localPos, WVP);
+#endif
     
 #if HAS_NORMAL_ATTRIBUTE
-    output.normal = normalize(mul(localNormal, (float3x3)Model));
+    output.normal = normalize(mul(localNormal, (float3x3)world));
 #endif
     
 #if HAS_TANGENT_ATTRIBUTE
-    output.tangent = float4(normalize(mul(localTangent, (float3x3)Model)), input.tangent.w);
+    output.tangent = float4(normalize(mul(localTangent, (float3x3)world)), input.tangent.w);
 #endif
     
 #endif  // End HAS_SKINNING_ATTRIBUTES
@@ -1007,6 +1095,7 @@ StandardVertexOutput StandardVertexShader(StandardVertexInput input)
     
     // Pass time for animated effects
     output.time = Time;
+    output.lodFade = LodFade;
     
     return output;
 }
@@ -0,0 +1,103 @@
+#include "renderer/Renderer.h"
+#include "shaders/ShaderVariantManager.h"
+#include "models/Model.h"
+#include "models/ModelLoader.h"
+#include "utils/Mesh/Mesh.h"
+#include "utils/material/Material.h"
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+
+namespace
+{
+	// Every layout and material the models can draw with, instanced layouts included
+	size_t CollectModelVariants(const std::string& modelDirectory, std::vector<DXEngine::ShaderVariantKey>& keys)
+	{
+		auto& variants = DXEngine::ShaderVariantManager::Instance();
+		DXEngine::ModelLoader loader;
+		loader.EnableCaching(false);
+
+		size_t modelCount = 0;
+		std::error_code ec;
+		for (const auto& file : std::filesystem::recursive_directory_iterator(modelDirectory, ec))
+		{
+			const std::string path = file.path().string();
+			if (!file.is_regular_file() || !DXEngine::ModelLoaderUtils::IsValidModelFile(path))
+				continue;
+
+			auto model = loader.LoadModel(path);
+			if (!model)
+			{
+				std::fprintf(stderr, "Skipping %s: %s\n", path.c_str(), loader.GetLastError().c_str());
+				continue;
+			}
+			modelCount++;
+
+			for (size_t meshIndex = 0; meshIndex < model->GetMeshCount(); ++meshIndex)
+			{
+				const auto& mesh = model->GetMesh(meshIndex);
+				if (!mesh)
+					continue;
+
+				for (bool instanced : { false, true })
+				{
+					const DXEngine::VertexLayout* layout = mesh->GetLayout(instanced);
+					if (!layout)
+						continue;
+
+					for (const auto& material : mesh->GetMaterials())
+					{
+						if (material)
+							keys.push_back(variants.MakeVariantKey(*layout, material.get(), material->GetType()));
+					}
+				}
+			}
+		}
+		return modelCount;
+	}
+}
+
+// ShaderBuilder [--models <dir>] [--manifest <file>] [--out <file>]
+// Packs every shader variant the game can request into one archive so shipping builds never
+// compile. Keys come from the models under --models, the manifest the game records on
+// shutdown, and the variants the engine precompiles itself. Runs from SandBox like the game.
+int main(int argc, char** argv)
+{
+	const char* modelDirectory = "assets/models";
+	const char* manifestPath = "cache/shader_variants.txt";
+	const char* archivePath = "assets/shaders/shaders.pak";
+	for (int i = 1; i < argc; ++i)
+	{
+		if (std::strcmp(argv[i], "--models") == 0 && i + 1 < argc)
+			modelDirectory = argv[++i];
+		else if (std::strcmp(argv[i], "--manifest") == 0 && i + 1 < argc)
+			manifestPath = argv[++i];
+		else if (std::strcmp(argv[i], "--out") == 0 && i + 1 < argc)
+			archivePath = argv[++i];
+	}
+
+	// a headless device, models create their buffers and textures through it
+	DXEngine::Renderer::Init(nullptr, 1, 1, DXEngine::RenderBackendType::Null);
+	auto& variants = DXEngine::ShaderVariantManager::Instance();
+
+	std::vector<DXEngine::ShaderVariantKey> keys;
+	const size_t modelCount = CollectModelVariants(modelDirectory, keys);
+	std::printf("%zu models, %zu mesh/material variants\n", modelCount, keys.size());
+
+	const size_t modelKeys = keys.size();
+	if (DXEngine::ShaderVariantManager::LoadVariantManifest(manifestPath, keys))
+		std::printf("%zu variants recorded in %s\n", keys.size() - modelKeys, manifestPath);
+
+	const bool built = variants.BuildShaderArchive(archivePath, keys);
+	std::printf("%s\n", variants.GetStats().ToString().c_str());
+
+	DXEngine::Renderer::Shutdown();
+
+	if (!built)
+	{
+		std::fprintf(stderr, "Failed to build %s\n", archivePath);
+		return 1;
+	}
+	std::printf("Shader archive written to %s\n", archivePath);
+	return 0;
+}
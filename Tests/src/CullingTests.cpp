@@ -0,0 +1,175 @@
+#include "CullingTests.h"
+#include "renderer/FrustumCullingKernels.h"
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace Tests {
+
+	namespace
+	{
+		using namespace DXEngine;
+
+		int s_Failures = 0;
+
+		void Check(bool condition, const char* test, const char* what)
+		{
+			if (!condition)
+			{
+				std::printf("  FAILED %s: %s\n", test, what);
+				s_Failures++;
+			}
+		}
+
+		// objects scattered around and through the view volume, boxes a little smaller than
+		// their spheres so the two tests disagree now and then
+		struct RandomScene
+		{
+			std::vector<BoundingSphere> spheres;
+			std::vector<BoundingBox> boxes;
+			CullingBounds bounds;
+
+			RandomScene(uint32_t count, uint32_t seed)
+			{
+				std::mt19937 random(seed);
+				std::uniform_real_distribution<float> position(-150.0f, 150.0f);
+				std::uniform_real_distribution<float> size(0.1f, 12.0f);
+				std::uniform_real_distribution<float> fill(0.3f, 0.7f);
+				for (uint32_t i = 0; i < count; ++i)
+				{
+					const BoundingSphere sphere({ position(random), position(random), position(random) }, size(random));
+					const float extent = sphere.radius * fill(random);
+					const BoundingBox box(
+						{ sphere.center.x - extent, sphere.center.y - extent, sphere.center.z - extent },
+						{ sphere.center.x + extent, sphere.center.y + extent, sphere.center.z + extent });
+					spheres.push_back(sphere);
+					boxes.push_back(box);
+					bounds.Add(sphere, box);
+				}
+			}
+
+			std::vector<uint32_t> Expected(const FrustumPlanes& frustum, uint32_t begin, uint32_t end) const
+			{
+				std::vector<uint32_t> visible;
+				for (uint32_t i = begin; i < end; ++i)
+				{
+					if (frustum.IsVisible(spheres[i], boxes[i]))
+						visible.push_back(i);
+				}
+				return visible;
+			}
+		};
+
+		FrustumPlanes MakeFrustum(std::mt19937& random)
+		{
+			std::uniform_real_distribution<float> position(-60.0f, 60.0f);
+			const DirectX::XMVECTOR eye = DirectX::XMVectorSet(position(random), position(random), position(random), 1.0f);
+			const DirectX::XMVECTOR target = DirectX::XMVectorSet(position(random), position(random), position(random), 1.0f);
+			const DirectX::XMMATRIX view = DirectX::XMMatrixLookAtLH(eye, target, DirectX::XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+			const DirectX::XMMATRIX projection = DirectX::XMMatrixPerspectiveFovLH(DirectX::XM_PIDIV4, 16.0f / 9.0f, 0.5f, 120.0f);
+			return FrustumPlanes::FromViewProjection(DirectX::XMMatrixMultiply(view, projection));
+		}
+
+		void TestMatchesScalar()
+		{
+			const char* test = "CullBounds matches IsVisible";
+			RandomScene scene(10000, 7);
+			std::mt19937 random(11);
+			std::vector<uint32_t> visible(scene.spheres.size());
+
+			for (int camera = 0; camera < 16; ++camera)
+			{
+				const FrustumPlanes frustum = MakeFrustum(random);
+
+				// whole batches, then ranges that start and end inside a batch
+				const uint32_t ranges[][2] = { { 0, 10000 }, { 3, 9995 }, { 8, 13 }, { 5000, 5001 }, { 20, 20 } };
+				for (const auto& range : ranges)
+				{
+					const uint32_t count = CullBounds(frustum, scene.bounds, range[0], range[1], visible.data());
+					const std::vector<uint32_t> expected = scene.Expected(frustum, range[0], range[1]);
+					Check(count == expected.size() && std::equal(expected.begin(), expected.end(), visible.begin()),
+						test, "same visible indices in the same order");
+				}
+			}
+		}
+
+		void TestAVXKernel()
+		{
+			const char* test = "AVX kernel matches IsVisible";
+			if (!CullKernels::HasAVX())
+			{
+				std::printf("  no AVX on this CPU, 8 wide kernel not tested\n");
+				return;
+			}
+
+			RandomScene scene(10000, 13);
+			std::vector<float> centerX, centerY, centerZ, radius, minX, minY, minZ, maxX, maxY, maxZ;
+			for (size_t i = 0; i < scene.spheres.size(); ++i)
+			{
+				centerX.push_back(scene.spheres[i].center.x);
+				centerY.push_back(scene.spheres[i].center.y);
+				centerZ.push_back(scene.spheres[i].center.z);
+				radius.push_back(scene.spheres[i].radius);
+				minX.push_back(scene.boxes[i].min.x);
+				minY.push_back(scene.boxes[i].min.y);
+				minZ.push_back(scene.boxes[i].min.z);
+				maxX.push_back(scene.boxes[i].max.x);
+				maxY.push_back(scene.boxes[i].max.y);
+				maxZ.push_back(scene.boxes[i].max.z);
+			}
+			const CullKernels::BoundsArrays arrays = { centerX.data(), centerY.data(), centerZ.data(), radius.data(),
+				minX.data(), minY.data(), minZ.data(), maxX.data(), maxY.data(), maxZ.data() };
+
+			std::mt19937 random(17);
+			std::vector<uint32_t> visible(scene.spheres.size());
+			for (int camera = 0; camera < 16; ++camera)
+			{
+				const FrustumPlanes frustum = MakeFrustum(random);
+				CullKernels::PlaneCorner corners[FrustumPlanes::Count];
+				CullKernels::GetPlaneCorners(frustum, corners);
+
+				// 9997 objects from 3: 1249 batches, the last 2 are left to the caller
+				uint32_t count = 0;
+				const uint32_t stopped = CullKernels::CullBoundsAVX(corners, arrays, 3, 10000, visible.data(), count);
+				Check(stopped == 3 + 1249 * 8, test, "stops after the last whole batch");
+
+				const std::vector<uint32_t> expected = scene.Expected(frustum, 3, stopped);
+				Check(count == expected.size() && std::equal(expected.begin(), expected.end(), visible.begin()),
+					test, "same visible indices in the same order");
+			}
+		}
+
+		void TestKnownCases()
+		{
+			const char* test = "known cases";
+			const DirectX::XMMATRIX projection = DirectX::XMMatrixPerspectiveFovLH(DirectX::XM_PIDIV2, 1.0f, 1.0f, 100.0f);
+			const FrustumPlanes frustum = FrustumPlanes::FromViewProjection(projection);
+
+			// camera at the origin looking down +z
+			CullingBounds bounds;
+			bounds.Add(BoundingSphere({ 0.0f, 0.0f, 50.0f }, 1.0f), BoundingBox({ -1.0f, -1.0f, 49.0f }, { 1.0f, 1.0f, 51.0f }));
+			bounds.Add(BoundingSphere({ 0.0f, 0.0f, -50.0f }, 1.0f), BoundingBox({ -1.0f, -1.0f, -51.0f }, { 1.0f, 1.0f, -49.0f }));
+			bounds.Add(BoundingSphere({ 200.0f, 0.0f, 50.0f }, 1.0f), BoundingBox({ 199.0f, -1.0f, 49.0f }, { 201.0f, 1.0f, 51.0f }));
+			bounds.Add(BoundingSphere({ 0.0f, 0.0f, 100.5f }, 1.0f), BoundingBox({ -1.0f, -1.0f, 99.5f }, { 1.0f, 1.0f, 101.5f }));
+			bounds.Add(BoundingSphere({ 0.0f, 0.0f, 150.0f }, 1.0f), BoundingBox({ -1.0f, -1.0f, 149.0f }, { 1.0f, 1.0f, 151.0f }));
+
+			uint32_t visible[5];
+			const uint32_t count = CullBounds(frustum, bounds, 0, 5, visible);
+			Check(count == 2 && visible[0] == 0 && visible[1] == 3, test, "in front and across the far plane only");
+		}
+	}
+
+	int RunCullingTests()
+	{
+		s_Failures = 0;
+		std::printf("=== Frustum culling ===\n");
+
+		TestMatchesScalar();
+		TestAVXKernel();
+		TestKnownCases();
+
+		std::printf("%s\n", s_Failures == 0 ? "  all passed" : "  some checks failed");
+		return s_Failures;
+	}
+}
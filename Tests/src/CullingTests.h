@@ -0,0 +1,8 @@
+#pragma once
+
+namespace Tests {
+
+	// CullBounds, and the AVX kernel on its own where the CPU has it, against the single
+	// object FrustumPlanes::IsVisible on random bounds. Returns the number of failed checks.
+	int RunCullingTests();
+}
@@ -0,0 +1,257 @@
+#include "MeshSimplifierTests.h"
+#include "utils/Mesh/Mesh.h"
+#include "utils/Mesh/Resource/MeshResource.h"
+#include <cmath>
+#include <cstdio>
+#include <memory>
+
+namespace Tests {
+
+	namespace
+	{
+		using namespace DXEngine;
+
+		int s_Failures = 0;
+
+		void Check(bool condition, const char* test, const char* what)
+		{
+			if (!condition)
+			{
+				std::printf("  FAILED %s: %s\n", test, what);
+				s_Failures++;
+			}
+		}
+
+		// CreateSphere duplicates the u = 0 / u = 1 column and the pole rows, so the source has
+		// UV seams; the northern rings go to material 0 and the southern ones to material 1
+		std::unique_ptr<MeshResource> MakeSphere()
+		{
+			auto sphere = MeshResource::CreateSphere("Sphere", 1.0f, 64);
+			const uint32_t indexCount = static_cast<uint32_t>(sphere->GetIndexData()->GetIndexCount());
+			sphere->AddSubMesh("North", 0, indexCount / 2, 0);
+			sphere->AddSubMesh("South", indexCount / 2, indexCount - indexCount / 2, 1);
+			return sphere;
+		}
+
+		struct Corner
+		{
+			DirectX::XMFLOAT3 position;
+			DirectX::XMFLOAT3 normal;
+			DirectX::XMFLOAT2 texCoord;
+		};
+
+		Corner GetCorner(const MeshResource& mesh, const SubMesh& submesh, size_t i)
+		{
+			const VertexData& vertices = *mesh.GetVertexData();
+			const size_t vertex = submesh.vertexStart + mesh.GetIndexData()->GetIndex(i);
+			return {
+				vertices.GetAttribute<DirectX::XMFLOAT3>(vertex, VertexAttributeType::Position),
+				vertices.GetAttribute<DirectX::XMFLOAT3>(vertex, VertexAttributeType::Normal),
+				vertices.GetAttribute<DirectX::XMFLOAT2>(vertex, VertexAttributeType::TexCoord0) };
+		}
+
+		// cross product of the edges against the summed corner normals, 0 for degenerate faces
+		// such as the pole fans, whose wedges are only a rounding error apart
+		int FaceOrientation(const Corner& a, const Corner& b, const Corner& c)
+		{
+			const float ux = b.position.x - a.position.x, uy = b.position.y - a.position.y, uz = b.position.z - a.position.z;
+			const float vx = c.position.x - a.position.x, vy = c.position.y - a.position.y, vz = c.position.z - a.position.z;
+			const float nx = uy * vz - uz * vy, ny = uz * vx - ux * vz, nz = ux * vy - uy * vx;
+			const float length = std::sqrt(nx * nx + ny * ny + nz * nz);
+			if (length < 1e-6f)
+				return 0;
+
+			const float dot = nx * (a.normal.x + b.normal.x + c.normal.x) + ny * (a.normal.y + b.normal.y + c.normal.y) +
+				nz * (a.normal.z + b.normal.z + c.normal.z);
+			return dot > 0.0f ? 1 : -1;
+		}
+
+		size_t TriangleCount(const MeshResource& mesh)
+		{
+			return mesh.GetIndexData() ? mesh.GetIndexData()->GetIndexCount() / 3 : 0;
+		}
+
+		std::shared_ptr<MeshResource> Simplify(const MeshResource& source, float ratio)
+		{
+			MeshUtils::SimplifyOptions options;
+			options.targetRatio = ratio;
+			options.maxError = 1.0f;
+			return MeshUtils::SimplifyMesh(source, options);
+		}
+
+		void TestTargetRatio()
+		{
+			const char* test = "target ratio";
+			auto sphere = MakeSphere();
+			const size_t sourceTriangles = TriangleCount(*sphere);
+
+			for (float ratio : { 0.5f, 0.25f, 0.1f })
+			{
+				auto simplified = Simplify(*sphere, ratio);
+				Check(simplified != nullptr, test, "sphere can be simplified");
+				if (!simplified)
+					continue;
+
+				// collapses remove one or two triangles at a time, the budget is reached within 10%
+				const float reached = static_cast<float>(TriangleCount(*simplified)) / static_cast<float>(sourceTriangles);
+				Check(reached <= ratio * 1.1f && reached >= ratio * 0.9f, test, "triangle count within 10% of the target");
+			}
+
+			MeshUtils::SimplifyOptions tight;
+			tight.targetRatio = 0.1f;
+			tight.maxError = 1e-6f;
+			auto bounded = MeshUtils::SimplifyMesh(*sphere, tight);
+			Check(bounded && TriangleCount(*bounded) > sourceTriangles / 2, test, "error bound stops a curved surface early");
+		}
+
+		void TestSubmeshRanges()
+		{
+			const char* test = "submesh ranges";
+			auto sphere = MakeSphere();
+			auto simplified = Simplify(*sphere, 0.2f);
+			if (!simplified)
+			{
+				Check(false, test, "sphere can be simplified");
+				return;
+			}
+
+			const std::vector<SubMesh>& submeshes = simplified->GetSubMeshes();
+			Check(submeshes.size() == 2, test, "every submesh is kept");
+			if (submeshes.size() != 2)
+				return;
+			Check(submeshes[0].materialIndex == 0 && submeshes[1].materialIndex == 1, test, "material slots are kept");
+
+			const size_t indexCount = simplified->GetIndexData()->GetIndexCount();
+			const size_t vertexCount = simplified->GetVertexData()->GetVertexCount();
+			Check(submeshes[0].indexStart == 0 && submeshes[1].indexStart == submeshes[0].indexCount &&
+				submeshes[1].indexStart + submeshes[1].indexCount == indexCount, test, "ranges are packed in order");
+			Check(submeshes[0].indexCount % 3 == 0 && submeshes[1].indexCount % 3 == 0, test, "ranges hold whole triangles");
+			Check(submeshes[0].indexCount > 0 && submeshes[1].indexCount > 0, test, "no submesh is emptied");
+
+			bool inRange = true, grouped = true;
+			for (size_t s = 0; s < submeshes.size(); ++s)
+			{
+				const SubMesh& submesh = submeshes[s];
+				for (size_t i = submesh.indexStart; i < submesh.indexStart + submesh.indexCount && i < indexCount; ++i)
+				{
+					const size_t vertex = submesh.vertexStart + simplified->GetIndexData()->GetIndex(i);
+					inRange = inRange && vertex < vertexCount;
+					if (vertex >= vertexCount)
+						continue;
+
+					// the equator is the submesh boundary, neither half may reach across it
+					const float y = simplified->GetVertexData()->GetAttribute<DirectX::XMFLOAT3>(vertex, VertexAttributeType::Position).y;
+					grouped = grouped && (s == 0 ? y >= -1e-5f : y <= 1e-5f);
+				}
+			}
+			Check(inRange, test, "indices stay inside the vertex buffer");
+			Check(grouped, test, "triangles stay in their own submesh");
+		}
+
+		void TestSeams()
+		{
+			const char* test = "uv seams";
+			auto sphere = MakeSphere();
+			auto simplified = Simplify(*sphere, 0.15f);
+			if (!simplified)
+			{
+				Check(false, test, "sphere can be simplified");
+				return;
+			}
+
+			// a wedge on one side of the seam merged into the other would stretch a face across
+			// the whole texture, and collapsing onto existing vertices never invents a new UV;
+			// the poles are left out, every u meets there
+			const auto poleOrU = [](const Corner& corner, bool lowest)
+				{
+					if (corner.texCoord.y == 0.0f || corner.texCoord.y == 1.0f)
+						return lowest ? 1.0f : 0.0f;
+					return corner.texCoord.x;
+				};
+			bool noStretch = true;
+			for (const SubMesh& submesh : simplified->GetSubMeshes())
+			{
+				for (size_t i = submesh.indexStart; i + 2 < submesh.indexStart + submesh.indexCount; i += 3)
+				{
+					const Corner a = GetCorner(*simplified, submesh, i);
+					const Corner b = GetCorner(*simplified, submesh, i + 1);
+					const Corner c = GetCorner(*simplified, submesh, i + 2);
+					const float minU = std::fmin(poleOrU(a, true), std::fmin(poleOrU(b, true), poleOrU(c, true)));
+					const float maxU = std::fmax(poleOrU(a, false), std::fmax(poleOrU(b, false), poleOrU(c, false)));
+					noStretch = noStretch && maxU - minU < 0.5f;
+				}
+			}
+			Check(noStretch, test, "no face spans the u seam");
+
+			const VertexData& source = *sphere->GetVertexData();
+			const VertexData& result = *simplified->GetVertexData();
+			bool exact = true;
+			for (size_t v = 0; v < result.GetVertexCount() && exact; ++v)
+			{
+				const DirectX::XMFLOAT3 position = result.GetAttribute<DirectX::XMFLOAT3>(v, VertexAttributeType::Position);
+				const DirectX::XMFLOAT2 texCoord = result.GetAttribute<DirectX::XMFLOAT2>(v, VertexAttributeType::TexCoord0);
+				bool found = false;
+				for (size_t s = 0; s < source.GetVertexCount() && !found; ++s)
+				{
+					const DirectX::XMFLOAT3 p = source.GetAttribute<DirectX::XMFLOAT3>(s, VertexAttributeType::Position);
+					const DirectX::XMFLOAT2 t = source.GetAttribute<DirectX::XMFLOAT2>(s, VertexAttributeType::TexCoord0);
+					found = p.x == position.x && p.y == position.y && p.z == position.z && t.x == texCoord.x && t.y == texCoord.y;
+				}
+				exact = found;
+			}
+			Check(exact, test, "every vertex keeps a source position and UV pair");
+		}
+
+		void TestNoFlips()
+		{
+			const char* test = "winding";
+			auto sphere = MakeSphere();
+
+			int sourceOrientation = 0;
+			for (const SubMesh& submesh : sphere->GetSubMeshes())
+			{
+				for (size_t i = submesh.indexStart; i + 2 < submesh.indexStart + submesh.indexCount; i += 3)
+				{
+					const int orientation = FaceOrientation(GetCorner(*sphere, submesh, i), GetCorner(*sphere, submesh, i + 1), GetCorner(*sphere, submesh, i + 2));
+					sourceOrientation = sourceOrientation == 0 ? orientation : sourceOrientation;
+				}
+			}
+
+			for (float ratio : { 0.3f, 0.05f })
+			{
+				auto simplified = Simplify(*sphere, ratio);
+				if (!simplified)
+				{
+					Check(false, test, "sphere can be simplified");
+					continue;
+				}
+
+				size_t flipped = 0;
+				for (const SubMesh& submesh : simplified->GetSubMeshes())
+				{
+					for (size_t i = submesh.indexStart; i + 2 < submesh.indexStart + submesh.indexCount; i += 3)
+					{
+						const int orientation = FaceOrientation(GetCorner(*simplified, submesh, i),
+							GetCorner(*simplified, submesh, i + 1), GetCorner(*simplified, submesh, i + 2));
+						flipped += orientation == -sourceOrientation ? 1 : 0;
+					}
+				}
+				Check(flipped == 0, test, "no face turns against its source normals");
+			}
+		}
+	}
+
+	int RunMeshSimplifierTests()
+	{
+		s_Failures = 0;
+		std::printf("=== Mesh simplifier ===\n");
+
+		TestTargetRatio();
+		TestSubmeshRanges();
+		TestSeams();
+		TestNoFlips();
+
+		std::printf("%s\n", s_Failures == 0 ? "  all passed" : "  some checks failed");
+		return s_Failures;
+	}
+}
@@ -0,0 +1,8 @@
+#pragma once
+
+namespace Tests {
+
+	// MeshUtils::SimplifyMesh on a UV mapped sphere split into two submeshes: triangle
+	// budget, submesh ranges, seams and winding. Returns the number of failed checks.
+	int RunMeshSimplifierTests();
+}
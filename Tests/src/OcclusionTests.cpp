@@ -0,0 +1,198 @@
+#include "OcclusionTests.h"
+#include "renderer/OcclusionCulling.h"
+#include "utils/WorkerPool.h"
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace Tests {
+
+	namespace
+	{
+		using namespace DXEngine;
+
+		int s_Failures = 0;
+
+		void Check(bool condition, const char* test, const char* what)
+		{
+			if (!condition)
+			{
+				std::printf("  FAILED %s: %s\n", test, what);
+				s_Failures++;
+			}
+		}
+
+		// camera at the origin looking down +z, 90 degree vertical field of view, so at depth z
+		// the screen spans z vertically and z * aspect horizontally either way
+		DirectX::XMMATRIX Projection(const OcclusionBuffer& buffer)
+		{
+			const float aspect = static_cast<float>(buffer.GetWidth()) / static_cast<float>(buffer.GetHeight());
+			return DirectX::XMMatrixPerspectiveFovLH(DirectX::XM_PIDIV2, aspect, 1.0f, 100.0f);
+		}
+
+		std::unique_ptr<MeshResource> MakeQuad(float width, float height)
+		{
+			auto quad = MeshResource::CreateQuad("Quad", width, height);
+			quad->ComputeBounds();
+			return quad;
+		}
+
+		BoundingBox Box(float x, float y, float z, float halfSize)
+		{
+			return BoundingBox({ x - halfSize, y - halfSize, z - halfSize }, { x + halfSize, y + halfSize, z + halfSize });
+		}
+
+		void TestQuadInFront()
+		{
+			const char* test = "quad in front";
+			OcclusionBuffer buffer;
+			auto wall = MakeQuad(8.0f, 8.0f);
+
+			buffer.BeginFrame(Projection(buffer));
+			buffer.AddOccluder(*wall, DirectX::XMMatrixTranslation(0.0f, 0.0f, 10.0f));
+			buffer.Rasterize();
+
+			Check(buffer.HasOccluders(), test, "depth was written");
+			Check(buffer.IsOccluded(Box(0.0f, 0.0f, 30.0f, 2.0f)), test, "box behind the quad is hidden");
+			Check(!buffer.IsOccluded(Box(0.0f, 0.0f, 5.0f, 0.5f)), test, "box in front of the quad is visible");
+			Check(!buffer.IsOccluded(Box(12.0f, 0.0f, 30.0f, 4.0f)), test, "box only partly behind the quad is visible");
+			Check(!buffer.IsOccluded(Box(40.0f, 0.0f, 30.0f, 2.0f)), test, "box beside the quad is visible");
+			Check(!buffer.IsOccluded(Box(0.0f, 0.0f, 10.0f, 1.0f)), test, "box through the quad is visible");
+		}
+
+		void TestNearPlaneClip()
+		{
+			const char* test = "near plane clip";
+			OcclusionBuffer buffer;
+
+			// ground at y = -1 reaching from behind the camera to z = 100; without clipping
+			// its triangles would have vertices at w < 0 and be dropped
+			auto ground = MakeQuad(200.0f, 110.0f);
+			const DirectX::XMMATRIX world = DirectX::XMMatrixMultiply(DirectX::XMMatrixRotationX(DirectX::XM_PIDIV2),
+				DirectX::XMMatrixTranslation(0.0f, -1.0f, 45.0f));
+
+			buffer.BeginFrame(Projection(buffer));
+			buffer.AddOccluder(*ground, world);
+			buffer.Rasterize();
+
+			Check(buffer.GetStats().triangles > 2, test, "clipped triangles became polygons");
+			Check(buffer.IsOccluded(BoundingBox({ -1.0f, -5.0f, 18.0f }, { 1.0f, -3.0f, 22.0f })), test, "box under the ground is hidden");
+			Check(!buffer.IsOccluded(BoundingBox({ -1.0f, 0.0f, 18.0f }, { 1.0f, 2.0f, 22.0f })), test, "box above the ground is visible");
+
+			bool depthInRange = true;
+			for (uint32_t y = 0; y < buffer.GetHeight(); ++y)
+			{
+				for (uint32_t x = 0; x < buffer.GetWidth(); ++x)
+				{
+					const float depth = buffer.GetDepth(x, y);
+					depthInRange = depthInRange && depth >= 0.0f && depth <= 1.0f;
+				}
+			}
+			Check(depthInRange, test, "every depth stays in [0, 1]");
+		}
+
+		void TestOddPyramidLevels()
+		{
+			const char* test = "odd pyramid levels";
+
+			// 320 x 48 halves to 20 x 3, 10 x 2, 5 x 1, 3 x 1, 2 x 1: a full screen box is tested
+			// on the 3 x 1 level, which only sees the last column and row through the odd levels
+			OcclusionConfig config;
+			config.width = 320;
+			config.height = 48;
+			OcclusionBuffer buffer(config);
+			const float aspect = 320.0f / 48.0f;
+			const BoundingBox everything({ -500.0f, -80.0f, 50.0f }, { 500.0f, 80.0f, 60.0f });
+
+			// quad edges given in NDC at depth 10, the last pixel column or row is left open
+			const auto cover = [&](float left, float right, float bottom, float top)
+				{
+					auto wall = MakeQuad((right - left) * 10.0f * aspect, (top - bottom) * 10.0f);
+					buffer.BeginFrame(Projection(buffer));
+					buffer.AddOccluder(*wall, DirectX::XMMatrixTranslation((left + right) * 5.0f * aspect, (top + bottom) * 5.0f, 10.0f));
+					buffer.Rasterize();
+					return buffer.IsOccluded(everything);
+				};
+
+			Check(cover(-1.5f, 1.5f, -1.5f, 1.5f), test, "fully covered screen hides the box");
+			Check(!cover(-1.5f, 0.994f, -1.5f, 1.5f), test, "open last column keeps the box visible");
+			Check(!cover(-1.5f, 1.5f, -0.96f, 1.5f), test, "open last row keeps the box visible");
+		}
+
+		void TestTriangleBudget()
+		{
+			const char* test = "triangle budget";
+			OcclusionConfig config;
+			config.maxTriangles = 2;
+			OcclusionBuffer buffer(config);
+			auto nearWall = MakeQuad(8.0f, 8.0f);
+			auto farWall = MakeQuad(8.0f, 8.0f);
+
+			// queued far first, the nearest occluder still wins the budget
+			buffer.BeginFrame(Projection(buffer));
+			buffer.AddOccluder(*farWall, DirectX::XMMatrixTranslation(20.0f, 0.0f, 20.0f));
+			buffer.AddOccluder(*nearWall, DirectX::XMMatrixTranslation(-5.0f, 0.0f, 10.0f));
+			buffer.Rasterize();
+
+			Check(buffer.GetStats().occluders == 1, test, "one occluder fits");
+			Check(buffer.GetStats().trianglesSkipped == 2, test, "the far quad's triangles are skipped");
+			Check(buffer.IsOccluded(Box(-10.0f, 0.0f, 20.0f, 1.0f)), test, "behind the near quad is hidden");
+			Check(!buffer.IsOccluded(Box(40.0f, 0.0f, 40.0f, 1.0f)), test, "behind the skipped quad is visible");
+		}
+
+		void TestParallelMatchesSerial()
+		{
+			const char* test = "parallel tiles";
+			std::mt19937 random(5);
+			std::uniform_real_distribution<float> position(-30.0f, 30.0f);
+			std::uniform_real_distribution<float> depth(5.0f, 80.0f);
+			std::uniform_real_distribution<float> size(1.0f, 12.0f);
+
+			std::vector<std::unique_ptr<MeshResource>> walls;
+			std::vector<DirectX::XMMATRIX> worlds;
+			for (int i = 0; i < 64; ++i)
+			{
+				walls.push_back(MakeQuad(size(random), size(random)));
+				worlds.push_back(DirectX::XMMatrixTranslation(position(random), position(random) * 0.5f, depth(random)));
+			}
+
+			OcclusionBuffer serial, parallel;
+			WorkerPool pool(3);
+			for (OcclusionBuffer* buffer : { &serial, &parallel })
+			{
+				buffer->BeginFrame(Projection(*buffer));
+				for (size_t i = 0; i < walls.size(); ++i)
+				{
+					buffer->AddOccluder(*walls[i], worlds[i]);
+				}
+				buffer->Rasterize(buffer == &parallel ? &pool : nullptr);
+			}
+
+			bool same = true;
+			for (uint32_t y = 0; y < serial.GetHeight(); ++y)
+			{
+				for (uint32_t x = 0; x < serial.GetWidth(); ++x)
+				{
+					same = same && serial.GetDepth(x, y) == parallel.GetDepth(x, y);
+				}
+			}
+			Check(same, test, "same depth buffer on a worker pool");
+		}
+	}
+
+	int RunOcclusionTests()
+	{
+		s_Failures = 0;
+		std::printf("=== Occlusion culling ===\n");
+
+		TestQuadInFront();
+		TestNearPlaneClip();
+		TestOddPyramidLevels();
+		TestTriangleBudget();
+		TestParallelMatchesSerial();
+
+		std::printf("%s\n", s_Failures == 0 ? "  all passed" : "  some checks failed");
+		return s_Failures;
+	}
+}
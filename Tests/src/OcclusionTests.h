@@ -0,0 +1,8 @@
+#pragma once
+
+namespace Tests {
+
+	// OcclusionBuffer rasterizing quads in front of a fixed camera, then testing boxes
+	// against the depth pyramid. Returns the number of failed checks.
+	int RunOcclusionTests();
+}
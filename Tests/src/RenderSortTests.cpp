@@ -0,0 +1,117 @@
+#include "RenderSortTests.h"
+#include "renderer/RenderSort.h"
+#include <algorithm>
+#include <cstdio>
+#include <functional>
+#include <random>
+#include <vector>
+
+namespace Tests {
+
+	namespace
+	{
+		using namespace DXEngine;
+
+		int s_Failures = 0;
+
+		void Check(bool condition, const char* test, const char* what)
+		{
+			if (!condition)
+			{
+				std::printf("  FAILED %s: %s\n", test, what);
+				s_Failures++;
+			}
+		}
+
+		// entries carry their submission position as the index, like the renderer's
+		std::vector<DrawSortEntry> MakeEntries(size_t count, const std::function<uint64_t()>& makeKey)
+		{
+			std::vector<DrawSortEntry> entries(count);
+			for (size_t i = 0; i < count; ++i)
+			{
+				entries[i].key = makeKey();
+				entries[i].index = static_cast<uint32_t>(i);
+			}
+			return entries;
+		}
+
+		bool SortsLikeStableSort(std::vector<DrawSortEntry> entries)
+		{
+			std::vector<DrawSortEntry> expected = entries;
+			std::stable_sort(expected.begin(), expected.end(),
+				[](const DrawSortEntry& a, const DrawSortEntry& b) { return a.key < b.key; });
+
+			// scratch left over from a larger earlier frame must not leak into the result
+			std::vector<DrawSortEntry> scratch(entries.size() + 17, DrawSortEntry{ ~0ull, ~0u });
+			RadixSortDrawKeys(entries, scratch);
+
+			return entries.size() == expected.size() && std::equal(entries.begin(), entries.end(), expected.begin(),
+				[](const DrawSortEntry& a, const DrawSortEntry& b) { return a.key == b.key && a.index == b.index; });
+		}
+
+		void TestTrivialCounts()
+		{
+			const char* test = "trivial counts";
+			std::mt19937_64 random(1);
+			Check(SortsLikeStableSort({}), test, "no entries");
+			Check(SortsLikeStableSort(MakeEntries(1, [&] { return random(); })), test, "one entry");
+			Check(SortsLikeStableSort(MakeEntries(2, [&] { return random(); })), test, "two entries");
+		}
+
+		void TestRandomKeys()
+		{
+			const char* test = "random keys";
+			std::mt19937_64 random(2);
+			// below, at and above the size where the radix passes take over
+			for (size_t count : { size_t(100), size_t(2048), size_t(2049), size_t(100000) })
+			{
+				Check(SortsLikeStableSort(MakeEntries(count, [&] { return random(); })), test, "matches std::stable_sort");
+			}
+		}
+
+		void TestDuplicateKeys()
+		{
+			const char* test = "duplicate keys";
+			std::mt19937_64 random(3);
+			for (size_t count : { size_t(1000), size_t(50000) })
+			{
+				// a handful of distinct keys, equal ones must keep their submission order whether
+				// one pass or all eight run
+				Check(SortsLikeStableSort(MakeEntries(count, [&] { return (random() % 16) << 40; })),
+					test, "equal keys stay in submission order, one pass");
+				Check(SortsLikeStableSort(MakeEntries(count, [&] { return (random() % 16) * 0x0101010101010101ull; })),
+					test, "equal keys stay in submission order, every pass");
+
+				std::vector<DrawSortEntry> same = MakeEntries(count, [] { return 0x2000000000000042ull; });
+				Check(SortsLikeStableSort(same), test, "all keys equal leaves the order untouched");
+			}
+		}
+
+		void TestTopByteOnly()
+		{
+			const char* test = "top byte only";
+			std::mt19937_64 random(4);
+			for (size_t count : { size_t(500), size_t(20000) })
+			{
+				// seven of eight passes see one byte value and are skipped
+				Check(SortsLikeStableSort(MakeEntries(count, [&] { return (random() & 0xFF) << 56; })), test, "sorted on the top byte");
+				Check(SortsLikeStableSort(MakeEntries(count, [&] { return ((random() & 0xFF) << 56) | 0x00FFFFFFFFFFFFFFull; })),
+					test, "sorted with identical low bytes set");
+			}
+		}
+	}
+
+	int RunRenderSortTests()
+	{
+		s_Failures = 0;
+		std::printf("=== Draw key sort ===\n");
+
+		TestTrivialCounts();
+		TestRandomKeys();
+		TestDuplicateKeys();
+		TestTopByteOnly();
+
+		std::printf("%s\n", s_Failures == 0 ? "  all passed" : "  some checks failed");
+		return s_Failures;
+	}
+}
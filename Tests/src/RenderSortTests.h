@@ -0,0 +1,8 @@
+#pragma once
+
+namespace Tests {
+
+	// RadixSortDrawKeys against std::stable_sort on the key, across both the comparison
+	// and the radix path. Returns the number of failed checks.
+	int RunRenderSortTests();
+}
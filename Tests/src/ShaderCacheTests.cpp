@@ -0,0 +1,186 @@
+#include "ShaderCacheTests.h"
+#include "StubShaderCompiler.h"
+#include "shaders/ShaderBinaryCache.h"
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+
+namespace Tests {
+
+	namespace
+	{
+		namespace fs = std::filesystem;
+
+		int s_Failures = 0;
+
+		void Check(bool condition, const char* test, const char* what)
+		{
+			if (!condition)
+			{
+				std::printf("  FAILED %s: %s\n", test, what);
+				s_Failures++;
+			}
+		}
+
+		void WriteFile(const fs::path& path, const std::string& text)
+		{
+			std::ofstream file(path, std::ios::binary | std::ios::trunc);
+			file << text;
+		}
+
+		struct Scratch
+		{
+			fs::path directory;
+			fs::path shader;
+			fs::path include;
+			fs::path cache;
+
+			explicit Scratch(const char* name)
+			{
+				directory = fs::temp_directory_path() / "DXEngineTests" / name;
+				std::error_code ec;
+				fs::remove_all(directory, ec);
+				fs::create_directories(directory);
+
+				shader = directory / "Lit.hlsl";
+				include = directory / "Common.hlsli";
+				cache = directory / "shaders.cache";
+				WriteFile(include, "float4 Tint() { return 1; }\n");
+				WriteFile(shader, "#include \"Common.hlsli\"\nfloat4 main() : SV_Target { return Tint(); }\n");
+			}
+
+			~Scratch()
+			{
+				std::error_code ec;
+				fs::remove_all(directory, ec);
+			}
+		};
+
+		bool Compile(StubShaderCompiler& compiler, DXEngine::ShaderBinaryCache& cache, const Scratch& scratch,
+			DXEngine::CachedCompileResult& result)
+		{
+			return DXEngine::CompileShaderCached(compiler, cache, scratch.shader.string(), "#define LIT 1",
+				"ps_5_0", "main", 0, result);
+		}
+
+		void TestMissThenHit()
+		{
+			const char* test = "miss then hit";
+			Scratch scratch("MissThenHit");
+			StubShaderCompiler compiler;
+			DXEngine::CachedCompileResult first, second, reopened;
+
+			{
+				DXEngine::ShaderBinaryCache cache;
+				cache.Open(scratch.cache.string());
+				Check(Compile(compiler, cache, scratch, first), test, "first compile succeeds");
+				Check(!first.cacheHit, test, "first request misses");
+				Check(first.dependencies.size() == 2, test, "shader and include are dependencies");
+
+				Check(Compile(compiler, cache, scratch, second), test, "second compile succeeds");
+				Check(second.cacheHit, test, "second request hits the pending entry");
+				Check(second.byteCode == first.byteCode, test, "hit returns the stored bytecode");
+				Check(compiler.GetCompileCount() == 1, test, "compiled once");
+			}
+
+			// Close flushed the entry, the reopened file serves it from the mapping
+			DXEngine::ShaderBinaryCache cache;
+			cache.Open(scratch.cache.string());
+			Check(cache.GetEntryCount() == 1, test, "flushed file holds one entry");
+			Check(Compile(compiler, cache, scratch, reopened) && reopened.cacheHit, test, "reopened cache hits");
+			Check(reopened.byteCode == first.byteCode, test, "mapped bytecode matches");
+			Check(compiler.GetCompileCount() == 1, test, "still compiled once");
+		}
+
+		void TestIncludeEdit()
+		{
+			const char* test = "include edit";
+			Scratch scratch("IncludeEdit");
+			StubShaderCompiler compiler;
+			DXEngine::ShaderBinaryCache cache;
+			cache.Open(scratch.cache.string());
+
+			DXEngine::CachedCompileResult before, after, again;
+			Compile(compiler, cache, scratch, before);
+			cache.Flush();
+
+			// only the included file changes, the shader file itself is untouched
+			WriteFile(scratch.include, "float4 Tint() { return 0.5; }\n");
+			Check(Compile(compiler, cache, scratch, after), test, "compile after edit succeeds");
+			Check(!after.cacheHit, test, "edited include misses");
+			Check(after.byteCode != before.byteCode, test, "new bytecode differs");
+			Check(compiler.GetCompileCount() == 2, test, "recompiled");
+
+			Check(Compile(compiler, cache, scratch, again) && again.cacheHit, test, "new entry hits");
+			Check(again.byteCode == after.byteCode, test, "hit returns the edited bytecode");
+		}
+
+		void TestCompileFailure()
+		{
+			const char* test = "compile failure";
+			Scratch scratch("CompileFailure");
+			WriteFile(scratch.include, "FAIL\n");
+			StubShaderCompiler compiler;
+			DXEngine::ShaderBinaryCache cache;
+			cache.Open(scratch.cache.string());
+
+			DXEngine::CachedCompileResult result;
+			Check(!Compile(compiler, cache, scratch, result), test, "compile fails");
+			Check(!result.errors.empty(), test, "errors are reported");
+			Check(result.dependencies.size() == 2, test, "dependencies known for hot reload");
+			Check(cache.GetEntryCount() == 0, test, "nothing stored");
+		}
+
+		// Open must not trust the file, a bad one opens as an empty cache and gets rewritten
+		void TestDamagedFile(const char* test, const char* name, bool truncate)
+		{
+			Scratch scratch(name);
+			StubShaderCompiler compiler;
+			DXEngine::CachedCompileResult original, result;
+
+			{
+				DXEngine::ShaderBinaryCache cache;
+				cache.Open(scratch.cache.string());
+				Compile(compiler, cache, scratch, original);
+			}
+
+			const uintmax_t size = fs::file_size(scratch.cache);
+			if (truncate)
+			{
+				// header and table intact, the blob they point at is cut off
+				fs::resize_file(scratch.cache, size - 4);
+			}
+			else
+			{
+				WriteFile(scratch.cache, std::string(static_cast<size_t>(size), '\x5a'));
+			}
+
+			{
+				DXEngine::ShaderBinaryCache cache;
+				Check(cache.Open(scratch.cache.string()), test, "damaged file still opens");
+				Check(cache.GetEntryCount() == 0, test, "damaged file opens empty");
+				Check(Compile(compiler, cache, scratch, result) && !result.cacheHit, test, "request misses");
+				Check(result.byteCode == original.byteCode, test, "recompiled bytecode matches");
+			}
+
+			DXEngine::ShaderBinaryCache cache;
+			cache.Open(scratch.cache.string());
+			Check(cache.GetEntryCount() == 1, test, "rewritten file is valid again");
+		}
+	}
+
+	int RunShaderCacheTests()
+	{
+		s_Failures = 0;
+		std::printf("=== Shader binary cache ===\n");
+
+		TestMissThenHit();
+		TestIncludeEdit();
+		TestCompileFailure();
+		TestDamagedFile("corrupt file", "CorruptFile", false);
+		TestDamagedFile("truncated file", "TruncatedFile", true);
+
+		std::printf("%s\n", s_Failures == 0 ? "  all passed" : "  some checks failed");
+		return s_Failures;
+	}
+}
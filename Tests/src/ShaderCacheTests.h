@@ -0,0 +1,8 @@
+#pragma once
+
+namespace Tests {
+
+	// ShaderBinaryCache driven through CompileShaderCached with a stub compiler, in a
+	// scratch directory under the system temp path. Returns the number of failed checks.
+	int RunShaderCacheTests();
+}
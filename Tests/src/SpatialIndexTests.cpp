@@ -0,0 +1,213 @@
+#include "SpatialIndexTests.h"
+#include "models/Model.h"
+#include "renderer/SceneSpatialIndex.h"
+#include "utils/Mesh/Mesh.h"
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace Tests {
+
+	namespace
+	{
+		using namespace DXEngine;
+
+		int s_Failures = 0;
+
+		void Check(bool condition, const char* test, const char* what)
+		{
+			if (!condition)
+			{
+				std::printf("  FAILED %s: %s\n", test, what);
+				s_Failures++;
+			}
+		}
+
+		FrustumPlanes MakeFrustum(std::mt19937& random)
+		{
+			std::uniform_real_distribution<float> position(-80.0f, 80.0f);
+			const DirectX::XMVECTOR eye = DirectX::XMVectorSet(position(random), position(random), position(random), 1.0f);
+			const DirectX::XMVECTOR target = DirectX::XMVectorSet(position(random), position(random), position(random), 1.0f);
+			const DirectX::XMMATRIX view = DirectX::XMMatrixLookAtLH(eye, target, DirectX::XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+			const DirectX::XMMATRIX projection = DirectX::XMMatrixPerspectiveFovLH(DirectX::XM_PIDIV4, 16.0f / 9.0f, 0.5f, 120.0f);
+			return FrustumPlanes::FromViewProjection(DirectX::XMMatrixMultiply(view, projection));
+		}
+
+		// models scattered through and around the cameras' reach, a few too large for a loose cell
+		struct RandomScene
+		{
+			std::mt19937 random;
+			std::vector<std::shared_ptr<Model>> statics;
+			std::vector<std::shared_ptr<Model>> dynamics;
+			std::vector<SpatialHandle> staticHandles;
+			std::vector<SpatialHandle> dynamicHandles;
+			SceneSpatialIndex index;
+
+			explicit RandomScene(uint32_t seed)
+				: random(seed)
+			{
+			}
+
+			std::shared_ptr<Model> MakeModel()
+			{
+				std::uniform_real_distribution<float> size(0.5f, 6.0f);
+				auto model = std::make_shared<Model>(Mesh::CreateCube(random() % 16 == 0 ? 48.0f : size(random)));
+				Move(*model);
+				return model;
+			}
+
+			void Move(Model& model)
+			{
+				std::uniform_real_distribution<float> position(-150.0f, 150.0f);
+				model.SetTranslation({ position(random), position(random), position(random) });
+			}
+
+			void Add(SpatialMobility mobility)
+			{
+				auto model = MakeModel();
+				const SpatialHandle handle = index.Insert(model, mobility);
+				auto& models = mobility == SpatialMobility::Static ? statics : dynamics;
+				auto& handles = mobility == SpatialMobility::Static ? staticHandles : dynamicHandles;
+				models.push_back(model);
+				handles.push_back(handle);
+			}
+
+			std::vector<Model*> Expected(const FrustumPlanes& frustum) const
+			{
+				std::vector<Model*> visible;
+				for (const auto* models : { &statics, &dynamics })
+				{
+					for (const auto& model : *models)
+					{
+						uint32_t mask = FrustumPlanes::AllPlanes;
+						if (frustum.Classify(model->GetWorldBoundingBox(), mask) != CullResult::Outside)
+							visible.push_back(model.get());
+					}
+				}
+				std::sort(visible.begin(), visible.end());
+				return visible;
+			}
+
+			bool Matches(const FrustumPlanes& frustum) const
+			{
+				std::vector<Model*> visible;
+				index.QueryFrustum(frustum, visible);
+				std::sort(visible.begin(), visible.end());
+				return visible == Expected(frustum);
+			}
+		};
+
+		void CheckCameras(RandomScene& scene, const char* test, const char* what)
+		{
+			std::mt19937 random(scene.random());
+			bool matches = true;
+			for (int camera = 0; camera < 16; ++camera)
+			{
+				matches = matches && scene.Matches(MakeFrustum(random));
+			}
+			Check(matches, test, what);
+		}
+
+		void TestStaticAndDynamic()
+		{
+			const char* test = "query matches brute force";
+			RandomScene scene(3);
+			for (int i = 0; i < 600; ++i)
+			{
+				scene.Add(i % 3 == 0 ? SpatialMobility::Dynamic : SpatialMobility::Static);
+			}
+			scene.index.Update();
+			CheckCameras(scene, test, "freshly built BVH and grid");
+
+			std::vector<Model*> all;
+			scene.index.QueryAll(all);
+			Check(all.size() == 600 && scene.index.Size() == 600, test, "QueryAll returns every model");
+		}
+
+		void TestMovedModels()
+		{
+			const char* test = "query after moving models";
+			RandomScene scene(5);
+			for (int i = 0; i < 600; ++i)
+			{
+				scene.Add(i % 2 == 0 ? SpatialMobility::Dynamic : SpatialMobility::Static);
+			}
+			scene.index.Update();
+
+			for (int frame = 0; frame < 8; ++frame)
+			{
+				// dynamics are polled, half of them move every frame and some cross cells
+				for (size_t i = 0; i < scene.dynamics.size(); i += 2)
+				{
+					scene.Move(*scene.dynamics[(i + frame) % scene.dynamics.size()]);
+				}
+
+				// a few statics move and are invalidated, enough over the frames to force a rebuild
+				for (size_t i = frame; i < scene.statics.size(); i += 23)
+				{
+					scene.Move(*scene.statics[i]);
+					scene.index.Invalidate(scene.staticHandles[i]);
+				}
+				scene.index.Update();
+				CheckCameras(scene, test, "moved dynamics and refit statics");
+			}
+			Check(scene.index.GetStats().refits > 0, test, "static models were refit");
+		}
+
+		void TestInsertAndRemove()
+		{
+			const char* test = "query after edits";
+			RandomScene scene(7);
+			for (int i = 0; i < 400; ++i)
+			{
+				scene.Add(i % 4 == 0 ? SpatialMobility::Dynamic : SpatialMobility::Static);
+			}
+			scene.index.Update();
+
+			// removals leave holes in the BVH and grid cells
+			for (auto* list : { &scene.statics, &scene.dynamics })
+			{
+				auto& handles = list == &scene.statics ? scene.staticHandles : scene.dynamicHandles;
+				for (size_t i = list->size(); i-- > 0;)
+				{
+					if (i % 5 == 0)
+					{
+						scene.index.Remove(handles[i]);
+						list->erase(list->begin() + i);
+						handles.erase(handles.begin() + i);
+					}
+				}
+			}
+			scene.index.Update();
+			CheckCameras(scene, test, "removed models");
+
+			// too few new statics after a clean build, they stay in the pending list
+			scene.index.Rebuild();
+			for (int i = 0; i < 30; ++i)
+			{
+				scene.Add(i % 2 == 0 ? SpatialMobility::Dynamic : SpatialMobility::Static);
+			}
+			scene.index.Update();
+			CheckCameras(scene, test, "pending statics");
+			Check(scene.index.GetStats().pendingStatics > 0, test, "new statics are pending");
+			Check(scene.index.Size() == scene.statics.size() + scene.dynamics.size(), test, "size follows the edits");
+
+			scene.index.Rebuild();
+			CheckCameras(scene, test, "after a full rebuild");
+		}
+	}
+
+	int RunSpatialIndexTests()
+	{
+		s_Failures = 0;
+		std::printf("=== Scene spatial index ===\n");
+
+		TestStaticAndDynamic();
+		TestMovedModels();
+		TestInsertAndRemove();
+
+		std::printf("%s\n", s_Failures == 0 ? "  all passed" : "  some checks failed");
+		return s_Failures;
+	}
+}
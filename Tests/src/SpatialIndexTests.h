@@ -0,0 +1,8 @@
+#pragma once
+
+namespace Tests {
+
+	// SceneSpatialIndex frustum queries against testing every model, for static models in
+	// the BVH and moving ones in the loose grid. Returns the number of failed checks.
+	int RunSpatialIndexTests();
+}
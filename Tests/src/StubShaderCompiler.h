@@ -0,0 +1,49 @@
+#pragma once
+#include "shaders/ShaderCompiler.h"
+#include <atomic>
+#include <fstream>
+#include <iterator>
+
+namespace Tests {
+
+	// Stands in for D3DCompile: the "bytecode" is the target, the source and the text of
+	// every file it includes, so any input change changes the output. FAIL anywhere in
+	// that text is a compile error.
+	class StubShaderCompiler : public DXEngine::ShaderCompiler
+	{
+	public:
+		bool Compile(const DXEngine::ShaderCompileRequest& request, std::vector<uint8_t>& byteCode, std::string& errors) override
+		{
+			m_CompileCount++;
+
+			// includes resolve like the standard handler, relative to the including file
+			std::string text = request.source;
+			DXEngine::ShaderSource source;
+			if (DXEngine::LoadShaderSource(request.filePath, source))
+			{
+				for (const auto& include : source.includes)
+				{
+					std::ifstream file(include, std::ios::binary);
+					text.append(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+				}
+			}
+
+			if (text.find("FAIL") != std::string::npos)
+			{
+				errors = request.filePath + ": stub compile error";
+				return false;
+			}
+
+			const std::string output = request.target + ":" + text;
+			byteCode.assign(output.begin(), output.end());
+			return true;
+		}
+
+		uint64_t GetVersion() const override { return 1; }
+
+		uint32_t GetCompileCount() const { return m_CompileCount; }
+
+	private:
+		std::atomic<uint32_t> m_CompileCount{ 0 };
+	};
+}
@@ -0,0 +1,25 @@
+#include "CullingTests.h"
+#include "MeshSimplifierTests.h"
+#include "OcclusionTests.h"
+#include "RenderSortTests.h"
+#include "ShaderCacheTests.h"
+#include "SpatialIndexTests.h"
+#include <cstdio>
+
+// Tests, exits with the number of failed checks. Needs no GPU or assets.
+int main()
+{
+	int failures = 0;
+	failures += Tests::RunShaderCacheTests();
+	failures += Tests::RunCullingTests();
+	failures += Tests::RunOcclusionTests();
+	failures += Tests::RunSpatialIndexTests();
+	failures += Tests::RunMeshSimplifierTests();
+	failures += Tests::RunRenderSortTests();
+
+	if (failures > 0)
+	{
+		std::fprintf(stderr, "%d check(s) failed\n", failures);
+	}
+	return failures;
+}